@@ -0,0 +1,232 @@
+#include "linuxstudio/component_catalog.hpp"
+#include "linuxstudio/core.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief 软件包目录基准
+ *
+ * 生成合成的 Packages 文件（默认 10 万个包，每个 6 个依赖），分别在独立子进程中测量
+ * 加载耗时与 RSS 增量：
+ * - map：逐行解析为 std::map<std::string, Component>（目录之前的做法）；
+ * - catalog cold：ComponentCatalog 解析、驻留字符串并写出缓存映像；
+ * - catalog cached：缓存有效时直接 mmap 映像。
+ * 最后抽查目录中的依赖与 map 解析的结果一致。
+ *
+ * 用法：catalog_bench [包数]
+ */
+
+using LinuxStudio::Component;
+using LinuxStudio::ComponentCatalog;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+long rssKb() {
+    long kb = 0;
+    if (FILE* f = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        while (std::fgets(line, sizeof(line), f)) {
+            if (std::strncmp(line, "VmRSS:", 6) == 0) {
+                kb = std::atol(line + 6);
+                break;
+            }
+        }
+        std::fclose(f);
+    }
+    return kb;
+}
+
+std::string packageName(std::size_t i) {
+    return "pkg-" + std::to_string(i);
+}
+
+/**
+ * @brief 生成合成的 Packages 文件
+ */
+bool writePackages(const std::string& path, std::size_t count) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        return false;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string depends;
+        for (std::size_t d = 1; d <= 6; ++d) {
+            std::size_t dep = (i * 31 + d * 7919) % count;
+            depends += (depends.empty() ? "" : ", ") + packageName(dep) +
+                       (d % 2 ? " (>= 1.0)" : " | " + packageName((dep + 1) % count));
+        }
+        std::fprintf(f,
+                     "Package: %s\n"
+                     "Version: 1.%zu.%zu-1\n"
+                     "Architecture: amd64\n"
+                     "Maintainer: Bench Maintainers <bench@example.org>\n"
+                     "Installed-Size: %zu\n"
+                     "Depends: %s\n"
+                     "Filename: pool/main/p/%s/%s_1.0_amd64.deb\n"
+                     "Description: synthetic package number %zu for catalog benchmarks\n"
+                     " This package exists only to give the parser realistic stanza sizes.\n"
+                     " It has no files and is never installed.\n"
+                     "\n",
+                     packageName(i).c_str(), i % 10, i % 7, 100 + i % 5000, depends.c_str(),
+                     packageName(i).c_str(), packageName(i).c_str(), i);
+    }
+    return std::fclose(f) == 0;
+}
+
+/**
+ * @brief 目录之前的做法：逐行解析为 std::map
+ */
+void parseToMap(const std::string& path, std::map<std::string, Component>& components) {
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (!f) {
+        return;
+    }
+    char buffer[4096];
+    Component current;
+    auto commit = [&]() {
+        if (!current.name.empty()) {
+            std::string name = current.name;
+            components.emplace(std::move(name), std::move(current));
+        }
+        current = Component();
+    };
+    while (std::fgets(buffer, sizeof(buffer), f)) {
+        std::string line(buffer);
+        if (!line.empty() && line.back() == '\n') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            commit();
+        } else if (line.compare(0, 9, "Package: ") == 0) {
+            current.name = line.substr(9);
+        } else if (line.compare(0, 9, "Version: ") == 0) {
+            current.version = line.substr(9);
+        } else if (line.compare(0, 13, "Description: ") == 0) {
+            current.description = line.substr(13);
+        } else if (line.compare(0, 9, "Depends: ") == 0) {
+            // 每组取第一个候选，去掉版本约束
+            std::size_t pos = 9;
+            while (pos < line.size()) {
+                std::size_t end = line.find(',', pos);
+                std::string group = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+                std::size_t start = group.find_first_not_of(' ');
+                std::size_t stop = group.find_first_of(" |(", start);
+                current.dependencies.push_back(group.substr(start, stop == std::string::npos ? std::string::npos : stop - start));
+                pos = end == std::string::npos ? line.size() : end + 1;
+            }
+        }
+    }
+    commit();
+    std::fclose(f);
+}
+
+/**
+ * @brief 在子进程中运行一次测量并打印一行结果
+ */
+template <typename Fn>
+bool measure(const char* label, Fn fn) {
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        long before = rssKb();
+        Clock::time_point start = Clock::now();
+        std::string detail = fn();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        long grown = rssKb() - before;
+        std::printf("  %-16s %10.1f ms %10.1f MB RSS  %s\n", label, ms, grown / 1024.0, detail.c_str());
+        std::fflush(stdout);
+        _exit(detail.compare(0, 6, "error:") == 0 ? 1 : 0);
+    }
+    int status = 0;
+    return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? static_cast<std::size_t>(std::atol(argv[1])) : 100000;
+    if (count == 0) {
+        std::fprintf(stderr, "usage: catalog_bench [packages]\n");
+        return 1;
+    }
+
+    char dir[] = "/tmp/xkl-bench-XXXXXX";
+    if (!mkdtemp(dir)) {
+        return 1;
+    }
+    const std::string packages = std::string(dir) + "/Packages";
+    const std::string cache = std::string(dir) + "/catalog.bin";
+    if (!writePackages(packages, count)) {
+        std::fprintf(stderr, "cannot write %s\n", packages.c_str());
+        return 1;
+    }
+    FILE* f = std::fopen(packages.c_str(), "r");
+    std::fseek(f, 0, SEEK_END);
+    std::printf("%zu packages, %.1f MB Packages file\n\n", count, std::ftell(f) / 1048576.0);
+    std::fclose(f);
+
+    bool ok = true;
+    ok = measure("map", [&]() {
+        std::map<std::string, Component> components;
+        parseToMap(packages, components);
+        return std::to_string(components.size()) + " entries";
+    }) && ok;
+
+    ok = measure("catalog cold", [&]() {
+        ComponentCatalog catalog(cache);
+        if (!catalog.load({packages}, true) || catalog.fromCache()) {
+            return std::string("error: build failed");
+        }
+        char detail[64];
+        std::snprintf(detail, sizeof(detail), "%.1f MB image", catalog.imageBytes() / 1048576.0);
+        return std::string(detail);
+    }) && ok;
+
+    ok = measure("catalog cached", [&]() {
+        ComponentCatalog catalog(cache);
+        if (!catalog.load({packages}, false) || !catalog.fromCache()) {
+            return std::string("error: cache not used");
+        }
+        return std::to_string(catalog.size()) + " names";
+    }) && ok;
+
+    // 抽查：依赖与 map 解析一致
+    std::map<std::string, Component> components;
+    parseToMap(packages, components);
+    ComponentCatalog catalog(cache);
+    std::size_t mismatches = 0;
+    if (!catalog.load({packages}, false)) {
+        mismatches = count;
+    }
+    for (std::size_t i = 0; i < count && mismatches < count; i += 97) {
+        const Component& expected = components[packageName(i)];
+        std::uint32_t id = catalog.find(packageName(i));
+        if (id == ComponentCatalog::kInvalidId) {
+            ++mismatches;
+            continue;
+        }
+        LinuxStudio::ComponentView view = catalog.view(id);
+        bool same = view.version() == expected.version && view.dependencyCount() == expected.dependencies.size();
+        for (std::size_t d = 0; same && d < view.dependencyCount(); ++d) {
+            same = catalog.view(view.dependency(d)).name() == expected.dependencies[d];
+        }
+        mismatches += same ? 0 : 1;
+    }
+    std::printf("\nspot check: %zu mismatches\n", mismatches);
+
+    unlink(packages.c_str());
+    unlink(cache.c_str());
+    rmdir(dir);
+    return ok && mismatches == 0 ? 0 : 1;
+}
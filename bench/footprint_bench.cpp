@@ -0,0 +1,182 @@
+#include "linuxstudio/concurrent_map.hpp"
+#include "linuxstudio/core.hpp"
+#include "linuxstudio/string_pool.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief 内存占用基准
+ *
+ * 1. xkl 二进制大小与只读命令的峰值 RSS（子进程的 ru_maxrss），
+ *    --budget-kb 给定时任一命令超出即返回 1（ctest 中的 footprint_budget 用它防止回退）；
+ * 2. 组件/插件注册表（ShardedMap<std::string, Component>）在不同条目数下的堆占用，
+ *    与按 StringPool 驻留、依赖存为整数 ID 的紧凑表示对比。
+ *
+ * 用法：footprint_bench [xkl 路径] [--budget-kb N]
+ */
+
+using LinuxStudio::Component;
+using LinuxStudio::ShardedMap;
+using LinuxStudio::StringPool;
+
+namespace {
+
+/**
+ * @brief 运行一条命令（输出丢弃），返回峰值 RSS（KB），失败返回 -1
+ */
+long peakRssKb(const std::string& binary, const std::vector<const char*>& args) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(binary.c_str()));
+        for (const char* arg : args) {
+            argv.push_back(const_cast<char*>(arg));
+        }
+        argv.push_back(nullptr);
+        execv(binary.c_str(), argv.data());
+        _exit(127);
+    }
+    if (pid < 0) {
+        return -1;
+    }
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) == 127) {
+        return -1;
+    }
+    return usage.ru_maxrss;
+}
+
+/**
+ * @brief 当前已分配的堆字节数
+ */
+std::size_t heapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return mallinfo2().uordblks;
+#else
+    return static_cast<std::size_t>(mallinfo().uordblks);
+#endif
+}
+
+Component makeComponent(std::size_t i, std::size_t count) {
+    Component comp("lib" + std::to_string(i) + "-dev", "Development files for library number " + std::to_string(i));
+    comp.version = "1." + std::to_string(i % 10) + ".0-1";
+    comp.installed = true;
+    for (std::size_t d = 1; d <= 3; ++d) {
+        comp.dependencies.push_back("lib" + std::to_string((i * 7 + d * 13) % count) + "-dev");
+    }
+    return comp;
+}
+
+/**
+ * @brief 紧凑表示：字符串驻留在 arena，条目与依赖只存 ID
+ */
+struct CompactRecord {
+    std::uint32_t name;
+    std::uint32_t version;
+    std::uint32_t description;
+    std::uint32_t firstDependency;
+    std::uint32_t dependencyCount;
+    bool installed;
+};
+
+void registryFootprint(std::size_t count) {
+    std::size_t before = heapBytes();
+    {
+        ShardedMap<std::string, Component> registry;
+        ShardedMap<std::string, Component>::MapType entries;
+        for (std::size_t i = 0; i < count; ++i) {
+            Component comp = makeComponent(i, count);
+            entries.emplace(comp.name, comp);
+        }
+        registry.replaceAll(entries);
+        entries.clear();
+        std::size_t mapBytes = heapBytes() - before;
+
+        std::size_t compactBefore = heapBytes();
+        StringPool pool;
+        std::vector<CompactRecord> records;
+        std::vector<std::uint32_t> dependencies;
+        records.reserve(count);
+        registry.forEach([&](const std::string&, const Component& comp) {
+            CompactRecord record;
+            record.name = pool.intern(comp.name);
+            record.version = pool.intern(comp.version);
+            record.description = pool.intern(comp.description);
+            record.firstDependency = static_cast<std::uint32_t>(dependencies.size());
+            record.dependencyCount = static_cast<std::uint32_t>(comp.dependencies.size());
+            record.installed = comp.installed;
+            for (const auto& dep : comp.dependencies) {
+                dependencies.push_back(pool.intern(dep));
+            }
+            records.push_back(record);
+        });
+        std::size_t compactBytes = heapBytes() - compactBefore;
+
+        std::printf("  %8zu %14zu %10.0f %14zu %10.0f\n", count, mapBytes,
+                    static_cast<double>(mapBytes) / count, compactBytes,
+                    static_cast<double>(compactBytes) / count);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string binary = XKL_BINARY;
+    long budgetKb = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--budget-kb") == 0 && i + 1 < argc) {
+            budgetKb = std::atol(argv[++i]);
+        } else {
+            binary = argv[i];
+        }
+    }
+
+    struct stat st;
+    if (stat(binary.c_str(), &st) != 0) {
+        std::fprintf(stderr, "xkl binary not found: %s\n", binary.c_str());
+        return 1;
+    }
+    std::printf("binary: %s (%lld KB)\n\n", binary.c_str(), static_cast<long long>(st.st_size / 1024));
+
+    const std::vector<std::vector<const char*>> commands = {
+        {"--version"},
+        {"status"},
+        {"plugin", "list"},
+        {"component", "list"},
+        {"scene", "list"},
+    };
+    bool failed = false;
+    std::printf("  %-20s %12s\n", "command", "peak RSS KB");
+    for (const auto& args : commands) {
+        std::string label;
+        for (const char* arg : args) {
+            label += (label.empty() ? "" : " ") + std::string(arg);
+        }
+        long rss = peakRssKb(binary, args);
+        bool over = budgetKb > 0 && rss > budgetKb;
+        failed = failed || over || rss < 0;
+        std::printf("  %-20s %12ld%s\n", label.c_str(), rss, over ? "  over budget" : "");
+    }
+
+    std::printf("\nregistry heap (ShardedMap<std::string, Component> vs interned records):\n");
+    std::printf("  %8s %14s %10s %14s %10s\n", "entries", "map bytes", "per entry", "compact bytes", "per entry");
+    for (std::size_t count : {32, 1000, 100000}) {
+        registryFootprint(count);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 离线安装包（.xklb）
+ *
+ * 一个文件装下场景需要的全部构件（锁文件、.deb、wheel、插件文件），供无网络的设备安装。
+ * 布局（整数均为小端）：
+ *   头部 16 字节   "XKLBNDL1" 帧大小 压缩算法
+ *   成员数据       每个成员是若干独立压缩的帧：<压缩后长度 u32><原始长度 u32><数据>，
+ *                  两个长度相等表示该帧未压缩（已压缩的 .deb 常见）
+ *   索引           Entry 数组（按成员名排序）+ 成员名字符串表
+ *   尾部 32 字节   索引位置、成员数、字符串表大小、"XKLINDX1"
+ * 读取时只映射文件、不解析索引：按名查找是对映射内存的二分查找，
+ * 成员逐帧解压直接写到目标位置，不需要先把整个包解开。
+ *
+ * 成员名约定：scene.lock、deb/<包名>=<版本>、wheel/<sha256>、plugin/<插件>/<相对路径>
+ * 成员名会拼成解压路径，写入与打开时都拒绝绝对路径、空路径段与 . / .. 路径段（见 safeName）。
+ */
+class Bundle {
+public:
+    static constexpr const char* kExtension = ".xklb";
+
+    enum class Codec : std::uint8_t {
+        None = 0,
+        Zlib = 1,
+        Zstd = 2
+    };
+
+    /**
+     * @brief 索引项（磁盘格式，直接映射）
+     */
+    struct Entry {
+        std::uint64_t offset;        // 第一帧在文件中的位置
+        std::uint64_t size;          // 原始大小
+        std::uint64_t stored;        // 所有帧（含帧头）占用的字节
+        std::uint32_t nameOffset;    // 成员名在字符串表中的位置
+        std::uint32_t nameLength;
+        std::uint32_t frames;
+        std::uint32_t mode;          // 权限位
+        unsigned char sha256[32];    // 原始内容的摘要
+    };
+
+    struct Report {
+        std::size_t members = 0;
+        std::uint64_t bytes = 0;     // 原始大小合计
+        std::uint64_t stored = 0;    // 包文件大小
+        double seconds = 0;
+    };
+
+    /**
+     * @brief 本次构建默认使用的压缩算法（有 zstd 用 zstd，其次 zlib）
+     */
+    static Codec defaultCodec();
+
+    static const char* codecName(Codec codec);
+
+    /**
+     * @brief 成员名能否安全地拼到目标目录下：非空、不以 / 开头，每一段都非空且不是 . 或 ..，不含 NUL
+     */
+    static bool safeName(std::string_view name);
+
+    // ---- 写入 ----
+
+    /**
+     * @brief 登记一个成员（内容在 write 时读取）
+     * @param name 包内名称
+     * @param source 源文件路径
+     */
+    void add(const std::string& name, const std::string& source);
+
+    /**
+     * @brief 多线程压缩并写出包文件（先写临时文件，完成后 rename）
+     * @return 任一成员名不安全、源文件不可读或写入失败返回 false
+     */
+    bool write(const std::string& path, Report& report) const;
+
+    // ---- 读取 ----
+
+    Bundle() = default;
+    ~Bundle();
+    Bundle(const Bundle&) = delete;
+    Bundle& operator=(const Bundle&) = delete;
+
+    /**
+     * @brief 映射包文件并检查头部、尾部与索引范围
+     * @return 不是有效的包、成员名不安全或压缩算法不受支持返回 false
+     */
+    bool open(const std::string& path);
+
+    Codec codec() const { return codec_; }
+    std::size_t size() const { return count_; }
+    const Entry& entry(std::size_t index) const { return entries_[index]; }
+    std::string_view name(const Entry& entry) const;
+
+    /**
+     * @brief 成员内容的 SHA256（十六进制）
+     */
+    static std::string digest(const Entry& entry);
+
+    /**
+     * @brief 按成员名查找
+     * @return 不存在返回 nullptr
+     */
+    const Entry* find(std::string_view name) const;
+
+    /**
+     * @brief 成员名以 prefix 开头的所有索引项（名称有序，是一段连续区间）
+     */
+    std::vector<const Entry*> list(std::string_view prefix) const;
+
+    /**
+     * @brief 逐帧解压成员到文件，同时校验摘要；先写 path 所在目录的临时文件，校验通过后 rename
+     * 可由多个线程同时对不同成员调用
+     */
+    bool extract(const Entry& entry, const std::string& path) const;
+
+    /**
+     * @brief 解压较小的成员到内存（如锁文件）
+     */
+    bool read(const Entry& entry, std::string& content) const;
+
+private:
+    struct Source {
+        std::string name;
+        std::string path;
+    };
+    std::vector<Source> sources_;
+
+    const unsigned char* map_ = nullptr;
+    std::size_t mapSize_ = 0;
+    Codec codec_ = Codec::None;
+    std::uint32_t frameSize_ = 0;
+    const Entry* entries_ = nullptr;
+    std::size_t count_ = 0;
+    const char* names_ = nullptr;
+
+    /**
+     * @brief 依次解压成员的每一帧，交给 sink；同时计算摘要并与索引比对
+     */
+    template <typename Sink>
+    bool decode(const Entry& entry, Sink&& sink) const;
+};
+
+} // namespace LinuxStudio
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief Shell 补全索引
+ * 预生成的紧凑文本索引（/opt/linuxstudio/data/completion.idx），每行一个分区：
+ *   分区名<TAB>候选1 候选2 ...
+ * `xkl __complete` 只读取该文件，不初始化 CoreEngine。
+ * 注册表变化时由各管理器按分区增量更新。
+ */
+class CompletionIndex {
+public:
+    // 分区名
+    static const char* const kCommands;            // 顶层命令
+    static const char* const kScenes;              // 场景名
+    static const char* const kPlugins;             // 可安装的插件
+    static const char* const kPluginsInstalled;    // 已安装的插件
+    static const char* const kComponentsInstalled; // 已安装的组件
+    static const char* const kRecipes;             // 源码构建配方
+
+    /**
+     * @brief 索引文件路径（可用 XKL_COMPLETION_INDEX 覆盖）
+     */
+    static std::string indexPath();
+
+    /**
+     * @brief 更新单个分区，内容未变化时不写文件
+     * @param section 分区名
+     * @param words 候选词
+     * @return 成功（或无需更新）返回 true
+     */
+    static bool updateSection(const std::string& section, std::vector<std::string> words);
+
+    /**
+     * @brief 重建静态分区（命令树、场景、构建配方）
+     * 动态分区由调用方通过 updateSection 写入
+     */
+    static bool rebuildStatic();
+
+    /**
+     * @brief 补全入口：输出候选词，每行一个
+     * @param words xkl 之后的参数，最后一个为正在输入的词（可为空）
+     * @return 进程退出码
+     */
+    static int complete(const std::vector<std::string>& words);
+
+    /**
+     * @brief 生成 shell 补全脚本
+     * @param shell bash / zsh / fish
+     * @param script 输出脚本内容
+     * @return 不支持的 shell 返回 false
+     */
+    static bool generateScript(const std::string& shell, std::string& script);
+};
+
+} // namespace LinuxStudio
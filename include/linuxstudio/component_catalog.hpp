@@ -0,0 +1,164 @@
+#pragma once
+
+#include "core.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LinuxStudio {
+
+class ComponentCatalog;
+
+/**
+ * @brief 目录条目的只读视图
+ * 只有目录指针和 ID，按值传递；字符串直接指向目录映像，目录存活期间有效
+ */
+class ComponentView {
+public:
+    ComponentView() : catalog_(nullptr), id_(0) {}
+
+    std::uint32_t id() const { return id_; }
+    std::string_view name() const;
+    std::string_view version() const;
+    std::string_view description() const;
+    bool installed() const;
+
+    /**
+     * @brief 是否有实际条目（仅被其他包依赖引用的虚包名没有）
+     */
+    bool available() const;
+
+    /**
+     * @brief 是否为虚包（没有实际条目、由其他包 Provides 的名字）
+     */
+    bool isVirtual() const;
+
+    std::size_t dependencyCount() const;
+
+    /**
+     * @brief 第 i 个依赖的 ID（Depends/Pre-Depends 每组取已安装的候选，否则取第一个）
+     * 虚包的依赖即各个提供者
+     */
+    std::uint32_t dependency(std::size_t i) const;
+
+    /**
+     * @brief 冲突项（Conflicts 中不带版本约束的包）
+     */
+    std::size_t conflictCount() const;
+    std::uint32_t conflict(std::size_t i) const;
+
+    /**
+     * @brief 复制为完整的 Component 结构（兼容旧接口，会分配内存）
+     */
+    Component toComponent() const;
+
+private:
+    friend class ComponentCatalog;
+    ComponentView(const ComponentCatalog* catalog, std::uint32_t id) : catalog_(catalog), id_(id) {}
+
+    const ComponentCatalog* catalog_;
+    std::uint32_t id_;
+};
+
+/**
+ * @brief 软件包目录
+ *
+ * 从 dpkg 状态文件和 apt 列表构建，只读。构建时字符串驻留在 StringPool 中，
+ * 随后压成一个连续映像：
+ *   文件头 | 条目表（按包名排序，ID 即下标）| 依赖/冲突 ID 表 | 字符串区
+ * 映像缓存在磁盘上，源文件（路径、大小、mtime）不变时直接 mmap，不再解析。
+ * 依赖以 ID 引用，解析依赖关系时无需字符串比较。
+ */
+class ComponentCatalog {
+public:
+    static constexpr const char* kDefaultCachePath = "/opt/linuxstudio/data/catalog.bin";
+    static constexpr std::uint32_t kInvalidId = 0xFFFFFFFFu;
+
+    explicit ComponentCatalog(const std::string& cachePath = kDefaultCachePath);
+    ~ComponentCatalog();
+
+    ComponentCatalog(const ComponentCatalog&) = delete;
+    ComponentCatalog& operator=(const ComponentCatalog&) = delete;
+
+    /**
+     * @brief 默认数据源：/var/lib/dpkg/status 与 /var/lib/apt/lists/ 下的 Packages 文件
+     */
+    static std::vector<std::string> defaultSources();
+
+    /**
+     * @brief 加载目录：缓存有效时映射缓存，否则解析源文件并写回缓存
+     * @param sources Packages 格式的源文件，同名包以先出现的为准（dpkg 状态文件放在最前面）
+     * @param refresh 忽略已有缓存
+     * @return 没有任何可读的源文件且没有缓存时返回 false
+     */
+    bool load(const std::vector<std::string>& sources = defaultSources(), bool refresh = false);
+
+    /**
+     * @brief 包名个数（含仅被依赖引用的名字），有效 ID 为 [0, size())
+     */
+    std::size_t size() const { return count_; }
+
+    /**
+     * @brief 按包名查找（二分查找）
+     * @return 不存在返回 kInvalidId
+     */
+    std::uint32_t find(std::string_view name) const;
+
+    ComponentView view(std::uint32_t id) const { return ComponentView(this, id); }
+
+    /**
+     * @brief 按包名顺序遍历有实际条目的包
+     */
+    void forEach(const std::function<void(const ComponentView&)>& visitor) const;
+
+    /**
+     * @brief 在包名和简介中搜索关键词（区分大小写）
+     */
+    std::vector<ComponentView> search(std::string_view keyword) const;
+
+    /**
+     * @brief 源文件指纹（可作为依赖解析等派生缓存的键）
+     */
+    std::uint64_t fingerprint() const { return fingerprint_; }
+
+    /**
+     * @brief 映像字节数（目录占用的全部内存）
+     */
+    std::size_t imageBytes() const { return imageSize_; }
+
+    /**
+     * @brief 本次加载是否直接使用了缓存
+     */
+    bool fromCache() const { return fromCache_; }
+
+private:
+    friend class ComponentView;
+
+    struct Record;
+
+    std::string cachePath_;
+    std::string built_;          // 本进程构建的映像（未映射缓存时使用）
+    void* mapping_;
+    std::size_t mappingSize_;
+    std::size_t imageSize_;
+    const Record* records_;
+    const std::uint32_t* deps_;
+    const char* strings_;
+    std::uint32_t count_;
+    std::uint64_t fingerprint_;
+    bool fromCache_;
+
+    void reset();
+    bool mapCache(std::uint64_t fingerprint);
+    bool attach(const char* image, std::size_t size, std::uint64_t fingerprint);
+    static std::uint64_t fingerprintSources(const std::vector<std::string>& sources);
+    static std::string build(const std::vector<std::string>& sources, std::uint64_t fingerprint);
+
+    const Record& record(std::uint32_t id) const;
+    std::string_view string(std::uint32_t offset) const { return std::string_view(strings_ + offset); }
+};
+
+} // namespace LinuxStudio
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 分片并发有序映射
+ *
+ * 键按哈希分到 N 个分片，每个分片保存一份不可变的 std::map 快照：
+ * - 读操作原子地取得快照指针后直接查找，不加锁，与写操作互不阻塞；
+ * - 写操作持有分片互斥锁，复制快照、修改后原子替换（写时复制，RCU 风格），
+ *   旧快照在最后一个读者释放后自动回收。
+ * 适合读多写少的注册表；所有公开方法均线程安全。
+ */
+template <typename Key, typename Value, std::size_t ShardCount = 16>
+class ShardedMap {
+public:
+    using MapType = std::map<Key, Value>;
+    using Snapshot = std::shared_ptr<const MapType>;
+
+    ShardedMap() {
+        for (auto& shard : shards_) {
+            shard.snapshot = std::make_shared<const MapType>();
+        }
+    }
+
+    ShardedMap(const ShardedMap&) = delete;
+    ShardedMap& operator=(const ShardedMap&) = delete;
+
+    /**
+     * @brief 查找键（不插入）
+     * @param key 键
+     * @param value 找到时输出值的副本
+     * @return 找到返回 true
+     */
+    bool find(const Key& key, Value& value) const {
+        Snapshot snapshot = load(shardFor(key));
+        auto it = snapshot->find(key);
+        if (it == snapshot->end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    bool contains(const Key& key) const {
+        Snapshot snapshot = load(shardFor(key));
+        return snapshot->find(key) != snapshot->end();
+    }
+
+    /**
+     * @brief 在快照上读取一个条目，不复制值
+     * @param reader 回调，仅在找到时调用
+     * @return 找到返回 true
+     */
+    bool read(const Key& key, const std::function<void(const Value&)>& reader) const {
+        Snapshot snapshot = load(shardFor(key));
+        auto it = snapshot->find(key);
+        if (it == snapshot->end()) {
+            return false;
+        }
+        reader(it->second);
+        return true;
+    }
+
+    void insertOrAssign(const Key& key, const Value& value) {
+        update(key, [&value](Value& current, bool) { current = value; return true; });
+    }
+
+    /**
+     * @brief 原子的读-改-写
+     * @param mutate 回调 (值, 是否已存在)，返回 false 表示放弃修改
+     * @return 修改被提交返回 true
+     */
+    bool update(const Key& key, const std::function<bool(Value&, bool)>& mutate) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.writeMutex);
+        Snapshot current = load(shard);
+        auto it = current->find(key);
+        bool existed = it != current->end();
+        Value value = existed ? it->second : Value();
+        if (!mutate(value, existed)) {
+            return false;
+        }
+        auto next = std::make_shared<MapType>(*current);
+        (*next)[key] = std::move(value);
+        store(shard, std::move(next));
+        return true;
+    }
+
+    bool erase(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.writeMutex);
+        Snapshot current = load(shard);
+        if (current->find(key) == current->end()) {
+            return false;
+        }
+        auto next = std::make_shared<MapType>(*current);
+        next->erase(key);
+        store(shard, std::move(next));
+        return true;
+    }
+
+    /**
+     * @brief 整体替换内容（批量加载用，每个分片只替换一次）
+     */
+    void replaceAll(const MapType& entries) {
+        std::array<std::shared_ptr<MapType>, ShardCount> next;
+        for (auto& map : next) {
+            map = std::make_shared<MapType>();
+        }
+        for (const auto& pair : entries) {
+            next[indexFor(pair.first)]->emplace(pair.first, pair.second);
+        }
+        for (std::size_t i = 0; i < ShardCount; ++i) {
+            std::lock_guard<std::mutex> lock(shards_[i].writeMutex);
+            store(shards_[i], std::move(next[i]));
+        }
+    }
+
+    /**
+     * @brief 按键顺序遍历（各分片快照多路归并，遍历期间不持锁）
+     */
+    void forEach(const std::function<void(const Key&, const Value&)>& visitor) const {
+        std::array<Snapshot, ShardCount> snapshots;
+        std::array<typename MapType::const_iterator, ShardCount> heads;
+        for (std::size_t i = 0; i < ShardCount; ++i) {
+            snapshots[i] = load(shards_[i]);
+            heads[i] = snapshots[i]->begin();
+        }
+        for (;;) {
+            std::size_t best = ShardCount;
+            for (std::size_t i = 0; i < ShardCount; ++i) {
+                if (heads[i] != snapshots[i]->end() &&
+                    (best == ShardCount || heads[i]->first < heads[best]->first)) {
+                    best = i;
+                }
+            }
+            if (best == ShardCount) {
+                return;
+            }
+            visitor(heads[best]->first, heads[best]->second);
+            ++heads[best];
+        }
+    }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (const auto& shard : shards_) {
+            total += load(shard)->size();
+        }
+        return total;
+    }
+
+private:
+    struct Shard {
+        std::mutex writeMutex;
+        Snapshot snapshot;
+    };
+
+    std::array<Shard, ShardCount> shards_;
+
+    static std::size_t indexFor(const Key& key) {
+        return std::hash<Key>()(key) % ShardCount;
+    }
+
+    Shard& shardFor(const Key& key) { return shards_[indexFor(key)]; }
+    const Shard& shardFor(const Key& key) const { return shards_[indexFor(key)]; }
+
+    static Snapshot load(const Shard& shard) {
+        return std::atomic_load_explicit(&shard.snapshot, std::memory_order_acquire);
+    }
+
+    static void store(Shard& shard, std::shared_ptr<MapType> next) {
+        std::atomic_store_explicit(&shard.snapshot, Snapshot(std::move(next)),
+                                   std::memory_order_release);
+    }
+};
+
+} // namespace LinuxStudio
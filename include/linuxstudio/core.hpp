@@ -9,6 +9,8 @@ namespace LinuxStudio {
 // 前向声明
 class ComponentManager;
 class PluginManager;
+class MirrorManager;
+class PythonEnvManager;
 class Logger;
 
 /**
@@ -25,6 +27,19 @@ struct SystemInfo {
     std::map<std::string, std::string> installedPackages;  
 };
 
+/**
+ * @brief 进程内存占用
+ */
+struct MemoryFootprint {
+    long long rssKB;              // 当前常驻内存
+    long long peakRssKB;          // 常驻内存峰值
+    long long binaryBytes;        // 可执行文件大小
+    long long budgetMB;           // 内存预算（0 表示不限制）
+    bool embedded;                // 嵌入式构建
+
+    MemoryFootprint() : rssKB(0), peakRssKB(0), binaryBytes(0), budgetMB(0), embedded(false) {}
+};
+
 /**
  * @brief 场景类型枚举
  */
@@ -65,6 +80,7 @@ struct Plugin {
     std::string description;      
     bool enabled;                 
     std::string installedAt;      
+    std::vector<std::string> wheels;  
     
     Plugin() : enabled(false) {}
     Plugin(const std::string& n, const std::string& desc) 
@@ -100,6 +116,11 @@ public:
      */
     const SystemInfo& getSystemInfo() const { return systemInfo_; }
     
+    /**
+     * @brief 读取当前进程的内存占用与可执行文件大小
+     */
+    MemoryFootprint getMemoryFootprint() const;
+    
     /**
      * @brief 根据场景推荐组件
      * @param scene 场景类型
@@ -117,11 +138,26 @@ public:
      */
     PluginManager& getPluginManager();
     
+    /**
+     * @brief 获取镜像管理器
+     */
+    MirrorManager& getMirrorManager();
+    
+    /**
+     * @brief 获取 Python 环境管理器
+     */
+    PythonEnvManager& getPythonEnvManager();
+    
     /**
      * @brief 获取日志器
      */
     Logger& getLogger();
     
+    /**
+     * @brief 配置文件路径（$XKL_CONFIG 或 /etc/linuxstudio/config.yaml）
+     */
+    const std::string& getConfigPath() const { return configPath_; }
+    
     /**
      * @brief 获取版本号
      */
@@ -135,7 +171,10 @@ private:
     SystemInfo systemInfo_;
     std::unique_ptr<ComponentManager> componentMgr_;
     std::unique_ptr<PluginManager> pluginMgr_;
+    std::unique_ptr<MirrorManager> mirrorMgr_;
+    std::unique_ptr<PythonEnvManager> pythonEnvMgr_;
     std::unique_ptr<Logger> logger_;
+    std::string configPath_;
     bool initialized_;
 };
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "component_catalog.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 依赖解析结果
+ */
+struct Resolution {
+    std::vector<std::string> roots;                               // 解析时使用的根（包名）
+    std::vector<std::string> missing;                             // 目录中找不到的包（根或待装包的依赖）
+    std::vector<std::vector<std::string>> levels;                 // 待安装包的拓扑层：按层顺序执行，同层之间无依赖可并行
+    std::vector<std::vector<std::string>> cycles;                 // 待安装包中的依赖环（整环放在同一层）
+    std::vector<std::pair<std::string, std::string>> conflicts;   // (待安装包, 与之冲突的包)
+    std::map<std::string, std::vector<std::string>> dependencies; // 各个根的直接依赖
+    std::uint64_t closureSize = 0;                                // 传递闭包大小（含已安装的包）
+    std::uint64_t installedCount = 0;                             // 闭包中已安装的包
+    bool fromCache = false;
+
+    /**
+     * @brief 待安装的包数
+     */
+    std::size_t pendingCount() const;
+
+    /**
+     * @brief 没有冲突，也没有缺失的包
+     */
+    bool ok() const { return missing.empty() && conflicts.empty(); }
+};
+
+/**
+ * @brief 依赖解析器
+ *
+ * 在软件包目录上按整数 ID 计算传递闭包（虚包选已安装的提供者，否则取第一个），
+ * 对待安装的子图做 Tarjan 强连通分量分解，缩点后按最长路径分层，
+ * 第 0 层不依赖任何待装包。结果按 (目录指纹, 注册表版本, 根) 缓存在磁盘上，
+ * 系统软件包或组件注册表没有变化时再次解析直接读取缓存。
+ */
+class DependencyResolver {
+public:
+    static constexpr const char* kDefaultCacheDir = "/opt/linuxstudio/data/resolve";
+
+    /**
+     * @param catalog 软件包目录
+     * @param registryVersion 组件注册表版本（参与缓存键）
+     * @param cacheDir 缓存目录
+     */
+    DependencyResolver(const ComponentCatalog& catalog, std::uint64_t registryVersion,
+                       const std::string& cacheDir = kDefaultCacheDir);
+
+    /**
+     * @brief 追加目录之外的依赖（组件注册表中声明的 Component::dependencies）
+     */
+    void addDependencies(const std::string& package, const std::vector<std::string>& dependencies);
+
+    /**
+     * @brief 解析一组根
+     * @param roots 包名
+     * @param refresh 忽略缓存
+     * @param fullClosure 已安装的包也展开并参与分层（生成锁文件时需要完整闭包）
+     */
+    Resolution resolve(const std::vector<std::string>& roots, bool refresh = false, bool fullClosure = false);
+
+private:
+    const ComponentCatalog& catalog_;
+    std::uint64_t registryVersion_;
+    std::string cacheDir_;
+    std::map<std::uint32_t, std::vector<std::uint32_t>> extraDependencies_;
+    std::uint64_t extraHash_;
+
+    std::uint32_t choose(std::uint32_t id) const;
+    void dependenciesOf(std::uint32_t id, std::vector<std::uint32_t>& out) const;
+    Resolution compute(const std::vector<std::string>& roots, bool fullClosure) const;
+    std::uint64_t cacheKey(const std::vector<std::string>& roots, bool fullClosure) const;
+    std::string cachePath(const std::vector<std::string>& roots, bool fullClosure) const;
+    bool loadCache(const std::string& path, std::uint64_t key, Resolution& result) const;
+    void saveCache(const std::string& path, std::uint64_t key, const Resolution& result) const;
+};
+
+} // namespace LinuxStudio
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 磁盘占用统计
+ *
+ * 多线程遍历目录树（getdents64 + statx），按实际占用块计算；
+ * 同一次统计内硬链接只计一次。结果增量缓存：
+ * - 目录按 mtime 判断，未变化的目录不再读取目录项；
+ * - 软件包按 /var/lib/dpkg/info/<包>.list 的 mtime 判断（升级时会重写）。
+ * 原地修改文件大小不会改变目录 mtime，需要时用 refresh 强制全量扫描。
+ */
+class DiskUsage {
+public:
+    struct Totals {
+        std::uint64_t bytes = 0;
+        std::uint64_t files = 0;
+        std::uint64_t linkedBytes = 0;  // bytes 中有多个硬链接的文件（删除后不一定释放）
+
+        Totals& operator+=(const Totals& other) {
+            bytes += other.bytes;
+            files += other.files;
+            linkedBytes += other.linkedBytes;
+            return *this;
+        }
+    };
+
+    static constexpr const char* kDefaultCachePath = "/opt/linuxstudio/data/du.cache";
+
+    /**
+     * @param cachePath 缓存文件路径
+     * @param refresh 忽略已有缓存
+     */
+    explicit DiskUsage(const std::string& cachePath = kDefaultCachePath, bool refresh = false);
+    ~DiskUsage();
+
+    DiskUsage(const DiskUsage&) = delete;
+    DiskUsage& operator=(const DiskUsage&) = delete;
+
+    /**
+     * @brief 统计若干目录树（不存在的路径忽略，树之间的硬链接也只计一次）
+     */
+    Totals measureTrees(const std::vector<std::string>& roots);
+
+    /**
+     * @brief 统计软件包拥有的文件
+     * @param packages 包名
+     * @return 包名 -> 占用
+     */
+    std::map<std::string, Totals> measurePackages(const std::vector<std::string>& packages);
+
+    /**
+     * @brief 展开包名模式（以 * 结尾表示前缀匹配），只返回已安装的包
+     */
+    std::vector<std::string> matchPackages(const std::vector<std::string>& patterns);
+
+    /**
+     * @brief 软件包安装的文件（不含目录与配置文件，配置文件允许本地修改）
+     */
+    std::vector<std::string> packageFiles(const std::string& package);
+
+    /**
+     * @brief 软件包登记的全部路径（含目录与配置文件）以及它在 /var/lib/dpkg/info 中的元数据文件
+     */
+    std::vector<std::string> packageContents(const std::string& package);
+
+    /**
+     * @brief 丢弃某个目录树的缓存记录（目录即将被删除时调用）
+     */
+    void forget(const std::string& path);
+
+    /**
+     * @brief 写回缓存（析构时自动调用）
+     */
+    bool save();
+
+    /**
+     * @brief 格式化字节数（如 "1.5 GB"）
+     */
+    static std::string formatBytes(std::uint64_t bytes);
+
+    /**
+     * @brief 解析配置中的大小（如 512K、8M、1G；无后缀为字节）
+     * @return 格式不符返回 false
+     */
+    static bool parseBytes(const std::string& text, std::uint64_t& bytes);
+
+private:
+    struct DirRecord {
+        std::int64_t mtimeNs = 0;
+        std::uint64_t bytes = 0;   // 目录自身 + 无其他硬链接的文件
+        std::uint64_t files = 0;
+        std::vector<std::string> subdirs;
+        std::vector<std::pair<std::pair<std::uint64_t, std::uint64_t>, std::uint64_t>> hardlinks;  // ((dev, ino), 字节)
+    };
+
+    struct PackageRecord {
+        std::int64_t listMtimeNs = 0;
+        Totals totals;
+    };
+
+    std::string cachePath_;
+    bool refresh_;
+    bool dirty_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, DirRecord> dirs_;
+    std::set<std::string> visitedDirs_;
+    std::vector<std::string> measuredRoots_;
+    std::map<std::string, PackageRecord> packages_;
+    std::map<std::string, std::string> dpkgLists_;  // 包名 -> .list 路径
+    bool dpkgIndexed_;
+
+    void loadCache();
+    void indexDpkg();
+    bool underMeasuredRoot(const std::string& path) const;
+    bool readDirectory(const std::string& path, std::int64_t mtimeNs, std::uint64_t dirBytes,
+                       DirRecord& record);
+    Totals measurePackage(const std::string& listPath);
+};
+
+} // namespace LinuxStudio
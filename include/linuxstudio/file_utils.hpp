@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 文件系统工具
+ * 目录遍历与删除直接走系统调用（getdents64 / statx / unlinkat），不经过 shell
+ */
+class FileUtils {
+public:
+    /**
+     * @brief 回收区：与插件、Python 环境位于同一文件系统，移入只需一次 rename
+     */
+    static constexpr const char* kTrashPath = "/opt/linuxstudio/.trash";
+
+    /**
+     * @brief 回收区路径（环境变量 XKL_TRASH_DIR 可覆盖 kTrashPath，测试用）
+     */
+    static std::string trashPath();
+
+    /**
+     * @brief 设置后台删除进程的可执行文件（xkl 启动时设为自身，以 __purge-trash 参数运行）
+     * 未设置时（测试程序、其他链接本库的程序）discard 在调用线程同步清空回收区，不启动任何进程
+     */
+    static void setPurger(const std::string& binary);
+
+    /**
+     * @brief 读取整个文件（read 系统调用，不经过 iostream）
+     * @param path 文件路径
+     * @param content 文件内容
+     * @return 文件无法读取返回 false
+     */
+    static bool readFile(const std::string& path, std::string& content);
+
+    /**
+     * @brief 按行读取文件（去掉行尾换行符）
+     * @param path 文件路径
+     * @param lines 各行内容
+     * @return 文件无法读取返回 false
+     */
+    static bool readLines(const std::string& path, std::vector<std::string>& lines);
+
+    /**
+     * @brief 经临时文件原子替换写入
+     * @param path 目标路径
+     * @param content 文件内容
+     * @return 成功返回 true
+     */
+    static bool writeFileAtomic(const std::string& path, const std::string& content);
+
+    /**
+     * @brief 文件的放置方式
+     */
+    enum class Placement {
+        Failed,
+        Hardlinked,
+        Reflinked,
+        Copied
+    };
+
+    /**
+     * @brief 把文件放到 dst（已存在时先删除）：硬链接 > reflink > 复制
+     * 跨文件系统或硬链接数达到上限时，在支持的文件系统（btrfs/xfs）上共享数据块，否则复制内容
+     * @param mode 新建文件的权限位（reflink 与复制时使用）
+     */
+    static Placement placeFile(const std::string& src, const std::string& dst, unsigned mode);
+
+    /**
+     * @brief 文件变更标记（inode、大小、纳秒级 mtime），用于判断文件自上次记录以来是否变化
+     * @param path 路径（目录的标记随其中条目的增删而变化）
+     * @return 文件不存在返回空串
+     */
+    static std::string changeMarker(const std::string& path);
+
+    /**
+     * @brief 按行切分（与逐行 getline 一致：末尾换行不产生空行）
+     */
+    static void splitLines(const std::string& content, std::vector<std::string>& lines);
+
+    /**
+     * @brief 按空白切分字段
+     */
+    static std::vector<std::string> splitFields(const std::string& line);
+
+    /**
+     * @brief 读取已打开目录的全部目录项（跳过 . 与 ..）
+     * @param fd 目录描述符
+     * @param visitor 对每个目录项调用 (名字, d_type)
+     * @return 读取出错返回 false
+     */
+    static bool readEntries(int fd, const std::function<void(const char*, unsigned char)>& visitor);
+
+    /**
+     * @brief 多线程遍历目录树
+     * @param roots 起始目录
+     * @param visitor 每个目录调用一次（可并发），填入需要继续遍历的子目录完整路径
+     */
+    static void walkParallel(const std::vector<std::string>& roots,
+                             const std::function<void(const std::string&, std::vector<std::string>&)>& visitor);
+
+    /**
+     * @brief 适合 I/O 密集任务的线程数（多于 CPU 核心数）
+     */
+    static unsigned ioThreads();
+
+    /**
+     * @brief 多线程处理 [0, count)：工作线程按原子计数领取下标
+     * 调用方先把大任务排在前面，避免最后只剩一个线程在处理大文件
+     */
+    static void parallelFor(size_t count, const std::function<void(size_t)>& work);
+
+    /**
+     * @brief 并行删除文件或目录树，不跟随符号链接
+     * @param path 路径
+     * @param reclaimedBytes 输出释放的字节数（仍有其他硬链接的文件不计），可为空
+     * @return 全部删除返回 true
+     */
+    static bool removeTree(const std::string& path, std::uint64_t* reclaimedBytes = nullptr);
+
+    /**
+     * @brief 丢弃目录：rename 进回收区后立即返回，由后台进程删除（见 setPurger）
+     * rename 失败（如跨文件系统）时退化为同步删除
+     * @param path 路径
+     * @param reclaimedBytes 输出将释放的字节数，可为空
+     * @return 目录已从原位置移除返回 true
+     */
+    static bool discard(const std::string& path, std::uint64_t* reclaimedBytes = nullptr);
+
+    /**
+     * @brief 清空回收区（后台删除进程的入口，多个进程并发调用时排队执行）
+     * @return 释放的字节数
+     */
+    static std::uint64_t purgeTrash();
+};
+
+} // namespace LinuxStudio
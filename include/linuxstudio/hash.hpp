@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace LinuxStudio {
+
+/**
+ * @brief SHA-256 摘要
+ * 用于内容寻址存储（wheel 仓库等），与 pip 的 --hash=sha256 一致
+ */
+class Sha256 {
+public:
+    Sha256();
+
+    void update(const void* data, std::size_t size);
+
+    /**
+     * @brief 结束计算，返回 64 位十六进制小写摘要
+     */
+    std::string hexDigest();
+
+    /**
+     * @brief 计算文件摘要
+     * @param path 文件路径
+     * @param hex 输出十六进制摘要
+     * @return 文件无法读取返回 false
+     */
+    static bool hashFile(const std::string& path, std::string& hex);
+
+private:
+    std::uint32_t state_[8];
+    std::uint64_t length_;
+    unsigned char block_[64];
+    std::size_t blockSize_;
+
+    void transform(const unsigned char* block);
+};
+
+/**
+ * @brief XXH64 非加密哈希
+ * 单核每秒可处理数 GB，用于大文件的完整性校验（检测损坏，不防刻意碰撞）
+ */
+class Xxh64 {
+public:
+    explicit Xxh64(std::uint64_t seed = 0);
+
+    void update(const void* data, std::size_t size);
+
+    /**
+     * @brief 当前摘要（不影响后续 update）
+     */
+    std::uint64_t digest() const;
+
+    /**
+     * @brief 16 位十六进制小写摘要
+     */
+    std::string hexDigest() const;
+
+    /**
+     * @brief 计算文件摘要（顺序读、大缓冲区，适合多线程同时调用）
+     * @param path 文件路径
+     * @param hex 输出十六进制摘要
+     * @param size 输出读取的字节数，可为空
+     * @return 文件无法读取返回 false
+     */
+    static bool hashFile(const std::string& path, std::string& hex, std::uint64_t* size = nullptr);
+
+private:
+    std::uint64_t acc_[4];
+    std::uint64_t seed_;
+    std::uint64_t length_;
+    unsigned char stripe_[32];
+    std::size_t stripeSize_;
+};
+
+} // namespace LinuxStudio
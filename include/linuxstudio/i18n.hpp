@@ -1,20 +1,341 @@
 #pragma once
-#include <string>
-#include <map>
-#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 
 namespace LinuxStudio {
 
 /**
- * @brief 简单的国际化类
- * 支持中文和英文
+ * @brief 翻译目录（编译期）
+ * 每一项为 X(英文原文, 中文译文)，英文原文同时作为 key。
+ * 新增翻译只需在此追加一行。
+ */
+#define LINUXSTUDIO_I18N_CATALOG(X) \
+    /* Status */ \
+    X("LinuxStudio Framework Status", "LinuxStudio 框架状态") \
+    X("Version", "版本") \
+    X("Install Path", "安装路径") \
+    X("System Information", "系统信息") \
+    X("OS", "操作系统") \
+    X("Architecture", "架构") \
+    X("CPU Cores", "CPU 核心数") \
+    X("Memory", "内存") \
+    X("MB available", "MB 可用") \
+    X("Process Footprint", "进程占用") \
+    X("peak", "峰值") \
+    X("Binary", "可执行文件") \
+    X("Budget", "内存预算") \
+    X("embedded build", "嵌入式构建") \
+    /* Plugin */ \
+    X("Installed Plugins", "已安装的插件") \
+    X("No plugins installed yet.", "尚未安装任何插件。") \
+    X("Available plugins:", "可用插件：") \
+    X("Install a plugin", "安装插件") \
+    X("enabled", "已启用") \
+    X("disabled", "已禁用") \
+    X("Plugin Disk Usage", "插件磁盘占用") \
+    X("Plugin Integrity", "插件完整性校验") \
+    X("Plugin not installed", "插件未安装") \
+    X("files", "个文件") \
+    X("No manifest", "没有哈希清单") \
+    X("mismatched files", "个文件不一致") \
+    X("packages", "个软件包") \
+    X("Total", "合计") \
+    /* Component */ \
+    X("Installed Components", "已安装的组件") \
+    X("No components installed yet.", "尚未安装任何组件。") \
+    X("Component Disk Usage", "组件磁盘占用") \
+    X("Component Search", "组件搜索") \
+    X("No matching components found.", "没有找到匹配的组件。") \
+    X("matches", "个结果") \
+    /* Scene */ \
+    X("Dependency Plan", "依赖解析") \
+    X("Closure", "依赖闭包") \
+    X("installed", "已安装") \
+    X("To install", "待安装") \
+    X("levels", "层") \
+    X("Missing", "缺失") \
+    X("Dependency cycles", "依赖环") \
+    X("Conflicts", "冲突") \
+    X("Nothing to install", "无需安装任何软件包") \
+    X("cached", "缓存") \
+    X("Scene Lock", "场景锁定") \
+    X("Lock file", "锁文件") \
+    X("Lock file not found", "找不到锁文件") \
+    X("without digest", "个无摘要") \
+    X("Satisfied", "已满足") \
+    X("From cache", "来自缓存") \
+    X("Downloaded", "已下载") \
+    X("Version drift", "版本不一致（未降级）") \
+    X("Digest mismatch", "摘要不符") \
+    X("OCI Export", "导出 OCI 镜像") \
+    X("Nothing recorded for this scene", "该场景没有安装记录") \
+    X("Image", "镜像") \
+    X("Layer", "镜像层") \
+    X("deduplicated", "个去重") \
+    X("directories", "个目录") \
+    X("symlinks", "个符号链接") \
+    X("No longer installed", "已不再安装") \
+    X("OCI export failed", "OCI 镜像导出失败") \
+    X("Switching scene", "切换场景") \
+    X("Shared, kept", "共用，保留") \
+    X("To remove", "待卸载") \
+    X("Removed", "已卸载") \
+    X("Kept warm", "保留以便切回") \
+    X("Still required, kept", "仍被其他软件依赖，保留") \
+    X("current", "当前") \
+    /* Bundle */ \
+    X("Bundle subcommand required", "需要指定 bundle 子命令") \
+    X("Offline Bundle", "离线安装包") \
+    X("Bundle", "离线包") \
+    X("Failed to create bundle", "离线包创建失败") \
+    X("Not a valid bundle", "不是有效的离线包") \
+    X("From bundle", "来自离线包") \
+    X("members", "个成员") \
+    /* Watch */ \
+    X("Watching plugins and system packages (Ctrl+C to stop)", "正在监视插件与系统软件包（Ctrl+C 停止）") \
+    X("Plugins changed", "插件变化") \
+    X("Components changed", "组件变化") \
+    /* Resource limits */ \
+    X("build jobs", "编译并行度") \
+    X("cgroup v2 unavailable, install commands ran at low priority", "cgroup v2 不可用，安装命令以低优先级运行") \
+    X("Install limits", "安装资源限额") \
+    X("Throttled", "节流情况") \
+    /* Source builds */ \
+    X("Build cache hit", "构件缓存命中") \
+    X("Build finished", "构建完成") \
+    X("ccache not found, building without compiler cache", "未找到 ccache，不使用编译缓存") \
+    X("compile jobs", "编译并行度") \
+    X("link jobs", "链接并行度") \
+    /* Logs */ \
+    X("Invalid time", "无效的时间") \
+    X("Unknown log level", "未知的日志级别") \
+    X("Cannot follow log file", "无法跟随日志文件") \
+    /* Messages */ \
+    X("Error", "错误") \
+    X("No command specified", "未指定命令") \
+    X("Failed to initialize LinuxStudio Framework", "初始化 LinuxStudio 框架失败") \
+    X("Plugin subcommand required", "需要插件子命令") \
+    X("Plugin name required", "需要插件名称") \
+    X("Unknown plugin subcommand", "未知的插件子命令") \
+    X("Component subcommand required", "需要组件子命令") \
+    X("Component name required", "需要组件名称") \
+    X("Search keyword required", "需要搜索关键词") \
+    X("Unknown component subcommand", "未知的组件子命令") \
+    X("Unknown command", "未知命令") \
+    X("Unknown output format", "未知的输出格式") \
+    X("installed successfully", "安装成功") \
+    X("Manage", "管理") \
+    /* Help */ \
+    X("High-Performance Linux Environment Manager", "高性能 Linux 环境管理器") \
+    X("Framework Commands", "框架命令") \
+    X("Component Management", "组件管理") \
+    X("Plugin Management", "插件管理") \
+    X("Scene Management", "场景管理") \
+    X("Other Commands", "其他命令") \
+    X("Examples", "示例") \
+    /* Scene */ \
+    X("Scene subcommand required", "需要场景子命令") \
+    X("Scene name required", "需要场景名称") \
+    X("Unknown scene subcommand", "未知的场景子命令") \
+    X("Shell name required", "需要 shell 名称") \
+    /* I18n */ \
+    X("I18n subcommand required", "需要 i18n 子命令") \
+    X("Failed to compile catalog", "编译翻译目录失败") \
+    /* Mirror */ \
+    X("Mirror subcommand required", "需要镜像子命令") \
+    X("Unknown mirror type", "未知的镜像类型") \
+    X("Mirror Ranking", "镜像测速排名") \
+    X("unreachable", "不可达") \
+    /* Python */ \
+    X("Python subcommand required", "需要 python 子命令") \
+    X("Environment name required", "需要环境名称") \
+    X("Python Environments", "Python 环境") \
+    X("No Python environments yet.", "还没有 Python 环境。") \
+    /* Repository */ \
+    X("Repository subcommand required", "需要 repo 子命令") \
+    X("Repository URL required", "需要仓库地址") \
+    X("Repository index is up to date", "仓库索引已是最新") \
+    X("Repository index updated", "仓库索引已更新") \
+    X("Repository update failed", "仓库索引更新失败") \
+    X("Failed to compile repository", "编译仓库索引失败") \
+    X("matched blocks", "匹配的块") \
+    X("downloaded", "下载") \
+    /* Install queue */ \
+    X("Queue subcommand required", "需要 queue 子命令") \
+    X("Install Queue", "安装队列") \
+    X("Queue is empty.", "队列为空。") \
+    X("Queued job", "已加入队列") \
+    X("Invalid job id", "无效的任务编号") \
+    X("Job not found or still running", "任务不存在或正在运行") \
+    X("System pressure", "系统压力") \
+    X("Queue scheduler is not running, start it with: xkl queue run", "队列调度进程未运行，用 xkl queue run 启动") \
+    X("Queue scheduler already running", "队列调度进程已在运行") \
+    X("Running queued installs when the system is idle (Ctrl+C to stop)", "系统空闲时执行队列中的安装（Ctrl+C 停止）") \
+    X("Waiting for the running job to finish", "等待正在运行的任务结束") \
+    X("Job started", "任务开始") \
+    X("Job paused under pressure", "压力升高，任务暂停") \
+    X("Job resumed", "任务恢复") \
+    X("Job finished", "任务完成") \
+    X("Job failed", "任务失败") \
+    X("Adopted job left running by the previous scheduler", "接管上一个调度进程留下的任务") \
+    X("Adopted job exited, see its log for the result", "接管的任务已结束，结果见任务日志")
+
+namespace i18n {
+
+using KeyId = std::uint16_t;
+constexpr KeyId kNoKey = 0xFFFF;
+
+#define LINUXSTUDIO_I18N_KEY(en, zh) en,
+#define LINUXSTUDIO_I18N_ZH(en, zh) zh,
+
+// 按语言分列存放，运行时只会访问当前语言所在的数组
+inline constexpr const char* kKeys[] = { LINUXSTUDIO_I18N_CATALOG(LINUXSTUDIO_I18N_KEY) };
+inline constexpr const char* kZhCN[] = { LINUXSTUDIO_I18N_CATALOG(LINUXSTUDIO_I18N_ZH) };
+
+#undef LINUXSTUDIO_I18N_KEY
+#undef LINUXSTUDIO_I18N_ZH
+
+constexpr std::size_t kKeyCount = sizeof(kKeys) / sizeof(kKeys[0]);
+static_assert(kKeyCount < kNoKey, "too many translation keys");
+
+/**
+ * @brief FNV-1a 哈希（带种子），编译期与运行期结果一致
+ */
+constexpr std::uint32_t hashKey(const char* s, std::uint32_t seed) {
+    std::uint32_t h = 2166136261u ^ (seed * 16777619u);
+    for (; *s; ++s) {
+        h ^= static_cast<unsigned char>(*s);
+        h *= 16777619u;
+    }
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+constexpr bool keyEquals(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return *a == *b;
+}
+
+constexpr std::size_t nextPow2(std::size_t n) {
+    std::size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+// 哈希-位移 (hash and displace) 完美哈希：键先分桶，每个桶选一个位移种子
+constexpr std::size_t kBucketCount = nextPow2(kKeyCount / 2 + 1);
+constexpr std::size_t kSlotCount = nextPow2(kKeyCount * 2);
+
+struct PerfectHashTable {
+    std::uint16_t displacement[kBucketCount];
+    KeyId slots[kSlotCount];
+};
+
+constexpr PerfectHashTable buildTable() {
+    PerfectHashTable table{};
+    for (std::size_t i = 0; i < kSlotCount; ++i) {
+        table.slots[i] = kNoKey;
+    }
+
+    std::size_t bucketSize[kBucketCount] = {};
+    std::size_t maxSize = 0;
+    for (std::size_t k = 0; k < kKeyCount; ++k) {
+        std::size_t b = hashKey(kKeys[k], 0) & (kBucketCount - 1);
+        if (++bucketSize[b] > maxSize) {
+            maxSize = bucketSize[b];
+        }
+    }
+
+    // 先放大桶，冲突概率最低
+    for (std::size_t size = maxSize; size > 0; --size) {
+        for (std::size_t b = 0; b < kBucketCount; ++b) {
+            if (bucketSize[b] != size) {
+                continue;
+            }
+            for (std::uint16_t d = 1; d != 0; ++d) {
+                std::size_t placed[kKeyCount] = {};
+                std::size_t count = 0;
+                bool ok = true;
+                for (std::size_t k = 0; k < kKeyCount && ok; ++k) {
+                    if ((hashKey(kKeys[k], 0) & (kBucketCount - 1)) != b) {
+                        continue;
+                    }
+                    std::size_t slot = hashKey(kKeys[k], d) & (kSlotCount - 1);
+                    if (table.slots[slot] != kNoKey) {
+                        ok = false;
+                    }
+                    for (std::size_t j = 0; j < count && ok; ++j) {
+                        if (placed[j] == slot) {
+                            ok = false;
+                        }
+                    }
+                    placed[count++] = slot;
+                }
+                if (!ok) {
+                    continue;
+                }
+                std::size_t n = 0;
+                for (std::size_t k = 0; k < kKeyCount; ++k) {
+                    if ((hashKey(kKeys[k], 0) & (kBucketCount - 1)) == b) {
+                        table.slots[placed[n++]] = static_cast<KeyId>(k);
+                    }
+                }
+                table.displacement[b] = d;
+                break;
+            }
+        }
+    }
+    return table;
+}
+
+inline constexpr PerfectHashTable kTable = buildTable();
+
+/**
+ * @brief 查找 key 对应的编号
+ * 通过 T() 宏调用时在编译期求值
+ * @return 未收录的 key 返回 kNoKey
+ */
+constexpr KeyId keyId(const char* key) {
+    std::size_t bucket = hashKey(key, 0) & (kBucketCount - 1);
+    std::uint16_t d = kTable.displacement[bucket];
+    if (d == 0) {
+        return kNoKey;
+    }
+    KeyId id = kTable.slots[hashKey(key, d) & (kSlotCount - 1)];
+    if (id == kNoKey || !keyEquals(kKeys[id], key)) {
+        return kNoKey;
+    }
+    return id;
+}
+
+// 翻译文件中按 key 的无种子哈希排序，编译期预先算好
+constexpr std::uint32_t keyHashAt(std::size_t id) {
+    return hashKey(kKeys[id], 0);
+}
+
+} // namespace i18n
+
+/**
+ * @brief 国际化类
+ * 内置英文与简体中文（编译期翻译表），
+ * 其他语言可从 /opt/linuxstudio/i18n/<lang>.cat 目录文件 mmap 加载。
+ * 初始化过程不分配堆内存。
  */
 class I18n {
 public:
     enum class Language {
-        AUTO,   // 自动检测
-        ZH_CN,  // 简体中文
-        EN      // 英文
+        AUTO,    // 自动检测
+        ZH_CN,   // 简体中文
+        EN,      // 英文
+        CATALOG  // 外部翻译目录文件
     };
 
     static I18n& getInstance() {
@@ -34,41 +355,54 @@ public:
     }
 
     /**
-     * @brief 获取翻译文本
+     * @brief 获取翻译文本（key 编号已在编译期解析）
+     * @param id key 编号，kNoKey 表示未收录
+     * @param key 英文原文，作为兜底
      */
-    const std::string& t(const std::string& key) const {
-        if (currentLang_ == Language::ZH_CN) {
-            auto it = zhTranslations_.find(key);
-            if (it != zhTranslations_.end()) {
-                return it->second;
-            }
+    const char* t(i18n::KeyId id, const char* key) const {
+        if (id == i18n::kNoKey) {
+            return key;
         }
-        // 默认返回英文（key 作为英文文本）
-        auto it = enTranslations_.find(key);
-        if (it != enTranslations_.end()) {
-            return it->second;
+        switch (currentLang_) {
+            case Language::ZH_CN:
+                return i18n::kZhCN[id];
+            case Language::CATALOG: {
+                const char* text = lookupCatalog(i18n::keyHashAt(id), key);
+                return text ? text : key;
+            }
+            default:
+                return key;
         }
-        // 如果找不到，返回 key 本身
-        return key;
     }
 
     /**
-     * @brief 检测系统语言
+     * @brief 获取翻译文本（运行期 key，经完美哈希查找）
      */
-    void detectLanguage() {
-        const char* lang = std::getenv("LANG");
-        if (lang) {
-            std::string langStr(lang);
-            // 检查是否包含 zh_CN 或 zh
-            if (langStr.find("zh_CN") != std::string::npos || 
-                langStr.find("zh") != std::string::npos) {
-                currentLang_ = Language::ZH_CN;
-                return;
-            }
-        }
-        currentLang_ = Language::EN;
+    const char* t(const char* key) const {
+        return t(i18n::keyId(key), key);
     }
 
+    /**
+     * @brief 检测系统语言
+     * zh* 使用内置中文；其他非英文语言尝试加载对应的目录文件
+     */
+    void detectLanguage();
+
+    /**
+     * @brief 加载外部翻译目录文件（mmap，只读）
+     * @param path 目录文件路径
+     * @return 成功返回 true，并切换到 CATALOG 语言
+     */
+    bool loadCatalog(const char* path);
+
+    /**
+     * @brief 将 "key<TAB>译文" 格式的文本编译为目录文件
+     * @param sourcePath 源文本路径
+     * @param outputPath 输出目录文件路径
+     * @return 成功返回 true
+     */
+    static bool compileCatalog(const char* sourcePath, const char* outputPath);
+
     Language getCurrentLanguage() const {
         return currentLang_;
     }
@@ -78,127 +412,18 @@ public:
     }
 
 private:
-    I18n() : currentLang_(Language::EN) {
-        initTranslations();
-    }
+    constexpr I18n() : currentLang_(Language::EN), catalog_(nullptr), catalogSize_(0) {}
+    ~I18n();
 
-    void initTranslations() {
-        // 英文翻译（默认值，key = value）
-        enTranslations_ = {
-            // Status
-            {"LinuxStudio Framework Status", "LinuxStudio Framework Status"},
-            {"Version", "Version"},
-            {"Install Path", "Install Path"},
-            {"System Information", "System Information"},
-            {"OS", "OS"},
-            {"Architecture", "Architecture"},
-            {"CPU Cores", "CPU Cores"},
-            {"Memory", "Memory"},
-            {"MB available", "MB available"},
-            
-            // Plugin
-            {"Installed Plugins", "Installed Plugins"},
-            {"No plugins installed yet.", "No plugins installed yet."},
-            {"Available plugins:", "Available plugins:"},
-            {"Install a plugin", "Install a plugin"},
-            {"enabled", "enabled"},
-            {"disabled", "disabled"},
-            
-            // Component
-            {"Installed Components", "Installed Components"},
-            {"Component listing not yet implemented", "Component listing not yet implemented"},
-            
-            // Messages
-            {"Error", "Error"},
-            {"No command specified", "No command specified"},
-            {"Failed to initialize LinuxStudio Framework", "Failed to initialize LinuxStudio Framework"},
-            {"Plugin subcommand required", "Plugin subcommand required"},
-            {"Plugin name required", "Plugin name required"},
-            {"Unknown plugin subcommand", "Unknown plugin subcommand"},
-            {"Component subcommand required", "Component subcommand required"},
-            {"Component name required", "Component name required"},
-            {"Unknown component subcommand", "Unknown component subcommand"},
-            {"Unknown command", "Unknown command"},
-            {"installed successfully", "installed successfully"},
-            {"Manage", "Manage"},
-            
-            // Help
-            {"High-Performance Linux Environment Manager", "High-Performance Linux Environment Manager"},
-            {"Framework Commands", "Framework Commands"},
-            {"Component Management", "Component Management"},
-            {"Plugin Management", "Plugin Management"},
-            {"Scene Management", "Scene Management"},
-            {"Other Commands", "Other Commands"},
-            {"Examples", "Examples"},
-            
-            // Scene
-            {"Scene subcommand required", "Scene subcommand required"},
-            {"Scene name required", "Scene name required"},
-            {"Unknown scene subcommand", "Unknown scene subcommand"},
-        };
-
-        // 中文翻译
-        zhTranslations_ = {
-            // Status
-            {"LinuxStudio Framework Status", "LinuxStudio 框架状态"},
-            {"Version", "版本"},
-            {"Install Path", "安装路径"},
-            {"System Information", "系统信息"},
-            {"OS", "操作系统"},
-            {"Architecture", "架构"},
-            {"CPU Cores", "CPU 核心数"},
-            {"Memory", "内存"},
-            {"MB available", "MB 可用"},
-            
-            // Plugin
-            {"Installed Plugins", "已安装的插件"},
-            {"No plugins installed yet.", "尚未安装任何插件。"},
-            {"Available plugins:", "可用插件："},
-            {"Install a plugin", "安装插件"},
-            {"enabled", "已启用"},
-            {"disabled", "已禁用"},
-            
-            // Component
-            {"Installed Components", "已安装的组件"},
-            {"Component listing not yet implemented", "组件列表功能尚未实现"},
-            
-            // Messages
-            {"Error", "错误"},
-            {"No command specified", "未指定命令"},
-            {"Failed to initialize LinuxStudio Framework", "初始化 LinuxStudio 框架失败"},
-            {"Plugin subcommand required", "需要插件子命令"},
-            {"Plugin name required", "需要插件名称"},
-            {"Unknown plugin subcommand", "未知的插件子命令"},
-            {"Component subcommand required", "需要组件子命令"},
-            {"Component name required", "需要组件名称"},
-            {"Unknown component subcommand", "未知的组件子命令"},
-            {"Unknown command", "未知命令"},
-            {"installed successfully", "安装成功"},
-            {"Manage", "管理"},
-            
-            // Help
-            {"High-Performance Linux Environment Manager", "高性能 Linux 环境管理器"},
-            {"Framework Commands", "框架命令"},
-            {"Component Management", "组件管理"},
-            {"Plugin Management", "插件管理"},
-            {"Scene Management", "场景管理"},
-            {"Other Commands", "其他命令"},
-            {"Examples", "示例"},
-            
-            // Scene
-            {"Scene subcommand required", "需要场景子命令"},
-            {"Scene name required", "需要场景名称"},
-            {"Unknown scene subcommand", "未知的场景子命令"},
-        };
-    }
+    const char* lookupCatalog(std::uint32_t keyHash, const char* key) const;
 
     Language currentLang_;
-    std::map<std::string, std::string> enTranslations_;
-    std::map<std::string, std::string> zhTranslations_;
+    const unsigned char* catalog_;  // mmap 映射的目录文件
+    std::size_t catalogSize_;
 };
 
-// 便捷宏
-#define T(key) LinuxStudio::I18n::getInstance().t(key)
+// 便捷宏：key 编号在编译期解析
+#define T(key) LinuxStudio::I18n::getInstance().t( \
+    std::integral_constant<LinuxStudio::i18n::KeyId, LinuxStudio::i18n::keyId(key)>::value, key)
 
 } // namespace LinuxStudio
-
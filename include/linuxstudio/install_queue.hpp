@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 空闲时执行的后台安装队列
+ *
+ * 大型框架与工具链的安装并不着急，在共享的开发服务器上应当等机器空闲时再做。
+ * xkl queue add 只把任务追加到队列文件（跨重启保留），由 xkl queue run 调度进程逐个执行：
+ * - 每隔几秒采样 /proc/pressure/{cpu,memory,io} 的 some avg10 与 1 分钟负载（按核心数归一）；
+ * - 所有指标持续 settle 秒低于阈值才启动下一个任务；
+ * - 任务运行中 PSI 超过阈值的 pause-factor 倍时向任务的进程组发送 SIGSTOP，
+ *   持续 settle 秒回到阈值以下后 SIGCONT。负载包含任务自身，只用于决定是否启动/恢复；
+ *   没有 PSI（旧内核或未启用 psi）时只按负载启动，不会暂停。
+ * 每个任务是一个独立的 xkl 子进程（自己的进程组、nice 10，安装命令仍受 ResourceSlice 限额），
+ * 输出写入 kJobDir/<编号>.log。调度进程停止时恢复被暂停的任务并等它结束，不中断 dpkg；
+ * 调度进程异常退出后再次启动时，仍在运行的任务（boot id 相同且进程组长的 cmdline 与任务一致）被接管，
+ * 轮询到组长退出后按任务子进程写下的 kJobDir/<编号>.status（退出码）记为完成或失败，
+ * 没有状态文件（被信号杀死、旧版本启动的任务）时记为 exited，结果只能看任务日志；
+ * 进程已不存在或机器已重启的任务重新排队（安装命令可重复执行）。
+ *
+ * 配置项（/etc/linuxstudio/config.yaml）：
+ *   queue_cpu_pressure: 10      （%，PSI some avg10）
+ *   queue_memory_pressure: 5
+ *   queue_io_pressure: 10
+ *   queue_load: 0.7             （1 分钟负载 / 核心数）
+ *   queue_pause_factor: 2
+ *   queue_settle: 30s
+ *   queue_poll: 5s
+ */
+class InstallQueue {
+public:
+    static constexpr const char* kPath = "/opt/linuxstudio/data/queue";
+    static constexpr const char* kRunLockPath = "/opt/linuxstudio/data/queue.run";
+    static constexpr const char* kJobDir = "/opt/linuxstudio/data/queue.d";
+
+    enum class Kind {
+        Component,
+        Plugin,
+        Scene
+    };
+
+    enum class State {
+        Queued,
+        Running,
+        Paused,
+        Done,
+        Failed,
+        Exited      // 接管的任务已结束，退出码未知
+    };
+
+    struct Job {
+        unsigned id = 0;
+        Kind kind = Kind::Component;
+        std::string name;
+        State state = State::Queued;
+        std::string addedAt;
+        std::string finishedAt;
+        unsigned pauses = 0;    // 因压力暂停的次数
+        int pid = 0;            // 运行中的进程组
+        std::string bootId;     // 启动任务时的 /proc/sys/kernel/random/boot_id
+    };
+
+    /**
+     * @brief 一次压力采样；PSI 不可用（旧内核、未启用 psi）时为 -1
+     */
+    struct Pressure {
+        double cpu = -1;        // %，some avg10
+        double memory = -1;
+        double io = -1;
+        double load = 0;        // 1 分钟负载 / 核心数
+    };
+
+    /**
+     * @brief 读取配置文件中的 queue_* 项，未出现的项保持默认
+     */
+    void loadConfig(const std::string& path);
+
+    /**
+     * @brief 追加任务
+     * @param job 成功时为新任务（含编号）
+     */
+    static bool add(Kind kind, const std::string& name, Job& job);
+
+    /**
+     * @brief 删除未在运行的任务
+     * @return 任务不存在或正在运行返回 false
+     */
+    static bool remove(unsigned id);
+
+    /**
+     * @brief 队列中的全部任务（按编号）
+     */
+    static std::vector<Job> jobs();
+
+    /**
+     * @brief 是否有调度进程在运行
+     */
+    static bool active();
+
+    /**
+     * @brief 采样当前系统压力
+     */
+    static Pressure sample();
+
+    /**
+     * @brief 压力是否低于启动阈值
+     */
+    bool idle(const Pressure& pressure) const;
+
+    /**
+     * @brief 压力是否高到需要暂停正在运行的任务
+     */
+    bool busy(const Pressure& pressure) const;
+
+    /**
+     * @brief 调度执行队列，直到 stop 置位（之后等正在运行的任务结束再返回）
+     * @param onEvent 任务状态变化时回调（事件名：start、pause、resume、done、failed，
+     *        停止后等待任务结束时为 wait，接管上一个调度进程留下的任务时为 adopt，
+     *        接管的任务结束且没有状态文件时为 exit）
+     * @return 已有调度进程时返回 false
+     */
+    bool run(const std::atomic<bool>& stop, const std::function<void(const Job&, const char*)>& onEvent);
+
+    static const char* kindName(Kind kind);
+    static bool parseKind(const std::string& name, Kind& kind);
+    static const char* stateName(State state);
+
+    /**
+     * @brief 任务子进程退出前调用：把退出码写入 kStatusEnv 指定的状态文件（未设置时不做任何事）
+     */
+    static void recordExit(int code);
+
+    // start() 为任务子进程设置的环境变量，值为 kJobDir/<编号>.status
+    static constexpr const char* kStatusEnv = "XKL_QUEUE_STATUS";
+
+private:
+    double cpuPressure_ = 10;
+    double memoryPressure_ = 5;
+    double ioPressure_ = 10;
+    double load_ = 0.7;
+    double pauseFactor_ = 2;
+    unsigned settleSeconds_ = 30;
+    unsigned pollSeconds_ = 5;
+
+    /**
+     * @brief 在文件锁内读取、修改并写回队列文件
+     */
+    static bool modify(const std::function<bool(std::vector<Job>&)>& mutate);
+
+    static bool start(Job& job);
+};
+
+} // namespace LinuxStudio
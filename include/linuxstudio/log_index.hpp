@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 日志分段的稀疏索引与查询（xkl logs）
+ *
+ * 分段关闭时（压缩之前）按固定大小切块，每块记录偏移、首末行时间、出现过的级别
+ * 以及消息中单词的布隆过滤器，写入 <分段>.idx。查询时先用索引挑出可能命中的块：
+ * 没有块命中的分段完全不读；压缩的分段只在有块命中时才解压，且只解压到最后一个命中块。
+ * 块内扫描基于映射内存，用 memchr 找行尾（glibc 向量化实现），级别与时间直接比较固定位置的字节。
+ * 索引文本格式（字段以 TAB 分隔）：
+ *   xkl-logidx-1 <块大小>
+ *   B <偏移> <长度> <首行时间> <末行时间> <级别位> <布隆过滤器（十六进制）>
+ * 偏移均指未压缩的内容；没有索引的分段（旧版本留下的、当前段）整段扫描。
+ */
+class LogIndex {
+public:
+    /**
+     * @brief 查询条件；时间为 "YYYY-MM-DD HH:MM:SS"，与日志行的时间戳按字节比较
+     */
+    struct Query {
+        std::string since;       // 空为不限
+        std::string until;       // 空为不限（含该秒）
+        unsigned levels = 0;     // levelBit 的组合，0 为不限
+        std::string component;   // 消息中以独立单词出现的名称，空为不限
+
+        bool empty() const { return since.empty() && until.empty() && levels == 0 && component.empty(); }
+    };
+
+    struct Stats {
+        std::size_t segments = 0;        // 参与查询的分段
+        std::size_t skipped = 0;         // 由索引整段跳过
+        std::size_t blocks = 0;          // 有索引的块
+        std::size_t scannedBlocks = 0;   // 其中实际扫描的块
+    };
+
+    /**
+     * @brief 级别名（DEBUG、info、Error……）对应的位，未知返回 0
+     */
+    static unsigned levelBit(const std::string& name);
+
+    /**
+     * @brief 把 --since/--until 的参数规范为时间戳
+     * 支持 YYYY-MM-DD[ HH:MM[:SS]]（日期与时间之间也可用 T）和相对时间 30m、12h、7d
+     * @param endOfRange 只给日期或分钟时补到该区间的末尾（用于 --until）
+     * @return 无法识别返回 false
+     */
+    static bool parseTime(const std::string& text, bool endOfRange, std::string& stamp);
+
+    /**
+     * @brief 为已关闭的（未压缩）分段生成索引
+     */
+    static bool build(const std::string& segment);
+
+    /**
+     * @brief 分段的索引路径（压缩分段与原分段共用一个索引）
+     */
+    static std::string indexPath(const std::string& segment);
+
+    /**
+     * @brief 日志文件的全部分段，按轮转时间从旧到新（名称中的时间戳与同一秒内的序号，不看修改时间），当前段在最后
+     */
+    static std::vector<std::string> segments(const std::string& logPath);
+
+    /**
+     * @brief 多线程查询所有分段，按时间顺序逐行回调
+     * @param onLine 命中的行（不含换行符）
+     */
+    static void query(const std::string& logPath, const Query& query,
+                      const std::function<void(const std::string&)>& onLine, Stats& stats);
+
+    /**
+     * @brief 跟随当前段的新增内容（跨轮转），直到 stop 置位
+     * @return inotify 不可用或日志文件无法打开返回 false
+     */
+    static bool follow(const std::string& logPath, const Query& query, const std::atomic<bool>& stop,
+                       const std::function<void(const std::string&)>& onLine);
+
+    /**
+     * @brief 单行是否满足查询条件
+     */
+    static bool matches(const char* line, std::size_t length, const Query& query);
+};
+
+} // namespace LinuxStudio
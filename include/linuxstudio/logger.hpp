@@ -1,11 +1,13 @@
 #pragma once
 
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <deque>
 #include <string>
-#include <fstream>
-#include <iostream>
-#include <sstream>
-#include <chrono>
-#include <iomanip>
+#include <mutex>
+#include <thread>
 
 namespace LinuxStudio {
 
@@ -23,12 +25,38 @@ enum class LogLevel {
 /**
  * @brief 日志器类
  * 提供彩色终端输出和文件日志功能
+ * log() 线程安全：整行一次写出，多个工作线程的日志不会交错
+ *
+ * 日志文件按大小与时间分段：当前段写满或过期后改名为 <文件>.<时间戳>，
+ * 关闭的分段由后台线程建立查询索引（见 LogIndex）、gzip 压缩并按总大小清理最旧的，不阻塞日志写入。
+ * 文件写入可以攒批，减少小容量闪存上的写放大；ERROR 级别总是立即写出。
  */
 class Logger {
 public:
+    static constexpr const char* kDefaultPath = "/opt/linuxstudio/logs/linuxstudio.log";
+    
+    /**
+     * @brief 日志文件的分段与写入策略（/etc/linuxstudio/config.yaml 中的 log_* 项）
+     */
+    struct Rotation {
+        std::uint64_t maxBytes;       // 单段大小上限（log_max_size）
+        long maxAgeSeconds;           // 单段最长时间，0 不限（log_max_age）
+        std::uint64_t retainBytes;    // 已关闭分段的总大小上限（log_retain）
+        std::size_t batchBytes;       // 攒够这么多字节才写文件，0 逐行写出（log_batch_size）
+        long batchSeconds;            // 攒批最长时间（log_batch_interval）
+        bool compress;                // 压缩关闭的分段（log_compress）
+    };
+    
     Logger();
     ~Logger();
     
+    /**
+     * @brief 读取配置文件中的日志项（key: value 格式），未出现的项保持默认
+     * 应在 setLogFile 之前调用
+     * @param path 配置文件路径
+     */
+    void loadConfig(const std::string& path);
+    
     /**
      * @brief 设置日志文件路径
      * @param path 日志文件路径
@@ -56,9 +84,23 @@ public:
     void success(const std::string& message);
     
 private:
-    std::ofstream logFile_;
+    int logFd_;
+    std::string logPath_;
+    std::string pending_;                         // 攒批中尚未写出的行
+    std::uint64_t segmentBytes_;                  // 当前段大小
+    std::time_t segmentStart_;                    // 当前段第一行的时间
+    std::time_t lastWrite_;
+    Rotation rotation_;
     LogLevel minLevel_;
     bool useColors_;
+    std::mutex mutex_;
+    
+    // 后台压缩与清理
+    std::thread compressor_;
+    std::deque<std::string> closed_;              // 待压缩的分段
+    std::mutex closedMutex_;
+    std::condition_variable closedReady_;
+    bool stopping_;
     
     std::string getCurrentTime();
     std::string getLevelString(LogLevel level);
@@ -66,6 +108,11 @@ private:
     std::string getColorReset();
     void writeToConsole(LogLevel level, const std::string& message);
     void writeToFile(LogLevel level, const std::string& message);
+    void openSegment();
+    void flushFile();
+    void rotate();
+    void enqueueClosed(const std::string& segment);
+    void compressLoop();
 };
 
 } // namespace LinuxStudio
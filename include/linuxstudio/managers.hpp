@@ -1,9 +1,22 @@
 #pragma once
 
 #include "core.hpp"
+#include "registry_store.hpp"
+#include "concurrent_map.hpp"
+#include "disk_usage.hpp"
+#include "component_catalog.hpp"
+#include "dependency_resolver.hpp"
+#include "scene_lock.hpp"
+#include "manifest.hpp"
+#include "source_build.hpp"
+#include "repo_index.hpp"
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <set>
 #include <functional>
 
 namespace LinuxStudio {
@@ -11,6 +24,9 @@ namespace LinuxStudio {
 /**
  * @brief 组件管理器
  * 负责组件的安装、卸载、查询等操作
+ *
+ * 线程安全：所有公开方法可被多个线程并发调用。
+ * 查询走无锁快照；同名组件的并发安装/卸载只有一个会执行，其余直接失败。
  */
 class ComponentManager {
 public:
@@ -24,22 +40,115 @@ public:
     std::vector<Component> listInstalled();
     
     /**
-     * @brief 搜索组件
+     * @brief 逐个遍历已安装的组件（不复制整个列表）
+     * @param visitor 回调函数
+     */
+    void forEachInstalled(const std::function<void(const Component&)>& visitor) const;
+    
+    /**
+     * @brief 搜索组件（在软件包目录中按包名和简介匹配）
      * @param keyword 关键词
-     * @return 匹配的组件列表
+     * @return 匹配条目的视图（指向目录映像，不复制字符串）
+     */
+    std::vector<ComponentView> search(const std::string& keyword);
+    
+    /**
+     * @brief 软件包目录（首次调用时加载，之后只读，可跨线程共享）
+     */
+    const ComponentCatalog& catalog();
+    
+    /**
+     * @brief 解析一组软件包的依赖（结果按注册表版本与系统软件包状态缓存）
+     * @param packages 包名
+     * @param refresh 忽略缓存重新计算
+     * @param fullClosure 已安装的包也展开并参与分层
+     * @return 解析结果
+     */
+    Resolution resolve(const std::vector<std::string>& packages, bool refresh = false, bool fullClosure = false);
+    
+    /**
+     * @brief 按解析结果逐层安装：每层一次 apt 事务，依赖包标记为自动安装
+     * @param plan 解析结果
+     * @return 全部安装成功返回 true
+     */
+    bool installPlan(const Resolution& plan);
+    
+    /**
+     * @brief 锁定一组软件包：完整闭包中每个包的确切版本、安装层与软件源索引中的 .deb 摘要
+     * @param packages 包名
+     * @param lock 输出，填充 packages
+     * @param plan 输出完整闭包的解析结果（缺失、冲突）
+     * @return 有冲突时返回 false
      */
-    std::vector<Component> search(const std::string& keyword);
+    bool lockPackages(const std::vector<std::string>& packages, SceneLock& lock, Resolution& plan);
+    
+    /**
+     * @brief 取出一个锁定包的 .deb 写到 path（如从离线包中解压），成功返回 true
+     */
+    using ArchiveSource = std::function<bool(const SceneLock::Package& package, const std::string& path)>;
+    
+    /**
+     * @brief 卸载不再需要的软件包（场景切换）
+     * 先标记为自动安装，只卸载 apt 判定为无人依赖的包；仍被其他软件依赖的包保留（已标记为自动安装），
+     * 不会像 apt-get remove 那样连带卸载依赖它们的软件
+     * @param packages 候选包
+     * @param removed 输出实际卸载的包
+     * @return apt 执行失败返回 false
+     */
+    bool removeUnused(const std::vector<std::string>& packages, std::vector<std::string>& removed);
+    
+    /**
+     * @brief 按锁文件安装软件包，不再解析依赖
+     * 已安装且版本一致的包跳过；本地缓存中摘要相符的 .deb 直接使用，其余按确切版本下载后校验；
+     * 已安装但版本不同的包只报告，不降级
+     * @param lock 锁文件
+     * @param report 输出统计
+     * @param source 给出时缓存中没有的包不下载，安装每一层前从 source 取出、装完即删除
+     * @return 全部安装成功返回 true；摘要不符时不安装任何包
+     */
+    bool installLocked(const SceneLock& lock, SceneLock::Report& report, const ArchiveSource& source = nullptr);
+    
+    /**
+     * @brief 把锁文件中全部包（含本机已安装的）的 .deb 放进本地缓存：按确切版本下载并校验摘要
+     * @param lock 锁文件
+     * @param paths 输出与 lock.packages 一一对应的缓存文件路径
+     * @param report 输出统计（cached、downloaded、mismatched）
+     * @return 全部就绪返回 true
+     */
+    bool fetchLocked(const SceneLock& lock, std::vector<std::string>& paths, SceneLock::Report& report);
+    
+    /**
+     * @brief 组件名是否是合法的软件包名
+     *
+     * 字母或数字开头，其余为字母、数字与 + . - _（Debian 包名的字符集，加上 RPM、pacman 用到的大写与下划线）。
+     * 不含空白与 shell 元字符，也不会被包管理器当成选项。
+     */
+    static bool validName(const std::string& name);
     
     /**
      * @brief 安装组件
-     * @param name 组件名称
+     * @param name 组件名称（不合法的名字直接拒绝，见 validName）
      * @return 成功返回 true
      */
     bool install(const std::string& name);
     
+    /**
+     * @brief 按配方从源码构建并安装组件（相同配方与工具链的构件直接取自缓存）
+     * @param name 配方名称
+     * @param rebuild 忽略构件缓存重新编译
+     * @param report 输出构建统计
+     * @return 成功返回 true
+     */
+    bool build(const std::string& name, bool rebuild, SourceBuilder::Report& report);
+    
+    /**
+     * @brief 源码构建后端（用于加载 build_* 配置）
+     */
+    SourceBuilder& getSourceBuilder() { return builder_; }
+    
     /**
      * @brief 卸载组件
-     * @param name 组件名称
+     * @param name 组件名称（不合法的名字直接拒绝，见 validName）
      * @return 成功返回 true
      */
     bool uninstall(const std::string& name);
@@ -58,18 +167,60 @@ public:
      */
     Component getInfo(const std::string& name);
     
+    /**
+     * @brief 将已安装组件写入 shell 补全索引
+     */
+    void updateCompletionIndex() const;
+    
+    /**
+     * @brief 组件注册表版本号（每次提交递增，可用作缓存键）
+     */
+    std::uint64_t registryVersion() const;
+    
+    /**
+     * @brief dpkg 状态文件变化后，同步注册表中组件的安装状态与版本
+     * 状态文件的变更标记与上次同步时相同则直接返回
+     * @return 变化的组件
+     */
+    std::vector<std::string> syncSystemPackages();
+    
 private:
-    std::map<std::string, Component> components_;
+    ShardedMap<std::string, Component> components_;
     std::string componentsPath_;
+    RegistryStore registry_;
+    std::atomic<std::uint64_t> registryVersion_;
+    std::mutex commitMutex_;             // 提交与刷新内存视图作为一个整体
+    std::mutex busyMutex_;
+    std::set<std::string> busy_;         // 正在安装/卸载的组件
+    ComponentCatalog catalog_;
+    std::once_flag catalogLoaded_;
+    SourceBuilder builder_;
     
+    bool acquire(const std::string& name);
+    void release(const std::string& name);
     void loadComponentRegistry();
-    void saveComponentRegistry();
+    void importLegacyRegistry();
+    bool commitChanges(const RegistryStore::Changes& changes);
     bool executeSystemCommand(const std::string& cmd);
+    bool stageArchives(const std::vector<const SceneLock::Package*>& packages, std::vector<std::string>& paths,
+                       SceneLock::Report& report, bool download);
+};
+
+/**
+ * @brief 插件磁盘占用
+ */
+struct PluginFootprint {
+    DiskUsage::Totals files;      // 插件目录与 Python 环境
+    DiskUsage::Totals packages;   // 插件安装的系统软件包
+    size_t packageCount = 0;
 };
 
 /**
  * @brief 插件管理器
  * 负责插件的安装、卸载、启用、禁用等操作
+ *
+ * 线程安全：所有公开方法可被多个线程并发调用，不同插件的操作可并行执行。
+ * 查询走无锁快照；同名插件的并发安装/卸载只有一个会执行，其余直接失败。
  */
 class PluginManager {
 public:
@@ -82,6 +233,12 @@ public:
      */
     std::vector<Plugin> listInstalled();
     
+    /**
+     * @brief 逐个遍历已安装的插件（不复制整个列表）
+     * @param visitor 回调函数
+     */
+    void forEachInstalled(const std::function<void(const Plugin&)>& visitor) const;
+    
     /**
      * @brief 安装插件
      * @param name 插件名称
@@ -90,11 +247,12 @@ public:
     bool install(const std::string& name);
     
     /**
-     * @brief 卸载插件
+     * @brief 卸载插件（目录移入回收区后由后台进程删除）
      * @param name 插件名称
+     * @param reclaimedBytes 输出释放的磁盘空间，可为空
      * @return 成功返回 true
      */
-    bool uninstall(const std::string& name);
+    bool uninstall(const std::string& name, std::uint64_t* reclaimedBytes = nullptr);
     
     /**
      * @brief 启用插件
@@ -131,18 +289,100 @@ public:
      */
     Plugin getInfo(const std::string& name);
     
+    /**
+     * @brief 列出所有内置插件名称（可安装的插件）
+     * @return 插件名称列表
+     */
+    std::vector<std::string> listAvailable() const;
+    
+    /**
+     * @brief 统计插件的磁盘占用
+     * @param name 插件名称
+     * @param usage 统计器（携带增量缓存，可在多个插件间复用）
+     * @return 插件目录、Python 环境及所属软件包的占用
+     */
+    PluginFootprint diskUsage(const std::string& name, DiskUsage& usage) const;
+    
+    /**
+     * @brief 记录插件落盘文件的哈希清单（插件目录、Python 环境、所属系统软件包的文件）
+     * 安装成功后自动调用；清单写入插件目录下的 .manifest
+     * @param name 插件名称
+     * @param entries 输出记录的文件数，可为空
+     * @return 成功返回 true
+     */
+    bool recordManifest(const std::string& name, std::size_t* entries = nullptr);
+    
+    /**
+     * @brief 按清单校验插件文件
+     * @param name 插件名称
+     * @param report 校验结果
+     * @return 没有清单或清单不完整返回 false
+     */
+    bool verify(const std::string& name, Manifest::Report& report) const;
+    
+    /**
+     * @brief 是否为 Python 插件（安装到独立 venv，依赖以 wheel 集合记录）
+     */
+    static bool isPythonPlugin(const std::string& name);
+    
+    /**
+     * @brief 锁定 Python 插件的 wheel 集合：已安装时取当前集合，否则重新解析
+     * @param name 插件名称
+     * @param wheels 输出 wheel 集合（文件名#sha256=摘要）
+     * @return 不是 Python 插件或解析失败返回 false
+     */
+    bool lockWheels(const std::string& name, std::vector<std::string>& wheels);
+    
+    /**
+     * @brief 按锁定的 wheel 集合安装 Python 插件：集合一致时不做任何事，仓库中已有的 wheel 不再下载
+     * @param name 插件名称
+     * @param wheels wheel 集合
+     * @param changed 输出是否重建了环境，可为空
+     * @return 成功返回 true
+     */
+    bool installLocked(const std::string& name, const std::vector<std::string>& wheels, bool* changed = nullptr);
+    
+    /**
+     * @brief 插件目录中随插件分发的文件（相对路径；不含元数据、锁与清单）
+     */
+    std::vector<std::string> payloadFiles(const std::string& name) const;
+    
+    /**
+     * @brief 将插件列表写入 shell 补全索引
+     */
+    void updateCompletionIndex() const;
+    
+    /**
+     * @brief 按变更标记增量同步插件（插件目录被外部修改时使用）
+     * @param names 只检查这些插件；为空时检查全部，插件目录本身未变化时不读目录
+     * @return 新增、修改或删除的插件
+     */
+    std::vector<std::string> syncPlugins(const std::set<std::string>& names = {});
+    
+    /**
+     * @brief 插件目录（环境变量 XKL_PLUGINS_DIR 可覆盖，测试用；组件目录对应 XKL_COMPONENTS_DIR）
+     */
+    const std::string& pluginsPath() const { return pluginsPath_; }
+    
 private:
-    std::map<std::string, Plugin> plugins_;
+    ShardedMap<std::string, Plugin> plugins_;
     std::string pluginsPath_;
+    RegistryStore index_;                // 插件索引：元数据副本 + 变更标记
+    std::mutex busyMutex_;
+    std::set<std::string> busy_;         // 正在安装/卸载的插件
     
-    // 内置插件安装函数
+    // 内置插件安装函数（构造后只读）
     using PluginInstaller = std::function<bool()>;
     std::map<std::string, PluginInstaller> installers_;
     
+    bool acquire(const std::string& name);
+    void release(const std::string& name);
     void loadPluginRegistry();
-    void savePluginRegistry();
-    void savePluginMetadata(const std::string& name, const Plugin& plugin);
+    bool readPluginMetadata(const std::string& name, Plugin& plugin) const;
+    bool savePluginMetadata(const std::string& name, const Plugin& plugin);
+    bool updatePlugin(const std::string& name, const std::function<void(Plugin&)>& mutate);
     void registerBuiltinInstallers();
+    std::string manifestPath(const std::string& name) const;
     
     // 内置插件安装函数
     bool installROS2();
@@ -151,6 +391,185 @@ private:
     bool installPyTorch();
     bool installTensorFlow();
     bool installCUDA();
+    bool installPythonPlugin(const std::string& name);
+    bool installFromRepository(const std::string& name, const RepoIndex::PluginEntry& entry);
+};
+
+/**
+ * @brief 镜像类型
+ */
+enum class MirrorKind {
+    APT,  // 发行版软件源
+    PIP,  // Python 包索引
+    ROS   // ROS 2 软件源
+};
+
+/**
+ * @brief 单个镜像的测速结果
+ */
+struct MirrorProbe {
+    std::string url;
+    bool reachable;
+    double connectMs;       // TCP 建连耗时
+    double throughputKBps;  // 短传输吞吐（https 镜像只测建连，为 0）
+    
+    MirrorProbe() : reachable(false), connectMs(0), throughputKBps(0) {}
+};
+
+/**
+ * @brief 镜像管理器
+ * 并行测速候选镜像（内置列表 + /etc/linuxstudio/mirrors.conf），
+ * 排名缓存在 /opt/linuxstudio/data/mirrors.cache，超过 TTL 后重新测速。
+ * 两个路径可分别用环境变量 XKL_MIRRORS_CONF、XKL_MIRRORS_CACHE 覆盖。
+ *
+ * 配置文件每行一项：
+ *   apt|pip|ros <url>    追加候选镜像
+ *   ttl <秒>             排名缓存有效期（默认 86400）
+ */
+class MirrorManager {
+public:
+    MirrorManager();
+    
+    /**
+     * @brief 解析镜像类型名称
+     * @param name apt / pip / ros
+     * @param kind 解析结果
+     * @return 成功返回 true
+     */
+    static bool parseKind(const std::string& name, MirrorKind& kind);
+    static const char* kindName(MirrorKind kind);
+    
+    /**
+     * @brief 候选镜像（第一个为官方源）
+     */
+    std::vector<std::string> candidates(MirrorKind kind) const;
+    
+    /**
+     * @brief 镜像排名（最快在前，不可达的排在最后）
+     * @param kind 镜像类型
+     * @param refresh 忽略缓存重新测速
+     * @return 排名结果
+     */
+    std::vector<MirrorProbe> rank(MirrorKind kind, bool refresh = false);
+    
+    /**
+     * @brief 最快的可用镜像，全部不可达时返回官方源
+     */
+    std::string fastest(MirrorKind kind);
+    
+    /**
+     * @brief 将系统配置切换到最快的镜像
+     * apt 改写 sources.list，pip 写入 /etc/pip.conf，ros 改写 ros2.list；
+     * 改写前保留一份 .xkl-bak 备份
+     * @return 成功返回 true
+     */
+    bool apply(MirrorKind kind);
+    
+private:
+    std::string configPath_;
+    std::string cachePath_;
+    long ttlSeconds_;
+    std::map<std::string, std::vector<std::string>> configured_;  // 类型名 -> 配置的镜像
+    std::mutex mutex_;                                            // 串行化测速与缓存读写
+    
+    void loadConfig();
+    bool loadCache(MirrorKind kind, std::vector<MirrorProbe>& probes) const;
+    void saveCache(MirrorKind kind, const std::vector<MirrorProbe>& probes) const;
+    bool rewriteSources(const std::string& path, MirrorKind kind, const std::string& url) const;
+    bool applyPip(const std::string& url) const;
+};
+
+/**
+ * @brief Python 环境管理器
+ * 为插件和项目创建 venv，所有环境共享一个内容寻址的 wheel 仓库：
+ *   /opt/linuxstudio/python/wheels/<sha256>.whl   下载的 wheel
+ *   /opt/linuxstudio/python/store/<sha256>/       解包后的文件（只读）
+ *   /opt/linuxstudio/python/envs/<名称>/          venv
+ * venv 中的文件硬链接到仓库（跨文件系统时尝试 reflink，最后才复制），
+ * 相同的 wheel 只下载、解包、占用磁盘一次。
+ *
+ * wheel 集合的每一项形如 "文件名#sha256=摘要"（与 pip 的 URL 片段一致）。
+ */
+class PythonEnvManager {
+public:
+    PythonEnvManager();
+    
+    /**
+     * @brief 解析依赖并把所需 wheel 收入仓库
+     * @param requirements pip 依赖描述（如 "torch"、"numpy>=1.24"）
+     * @param wheels 输出解析出的 wheel 集合
+     * @return 成功返回 true
+     */
+    bool resolve(const std::vector<std::string>& requirements, std::vector<std::string>& wheels);
+    
+    /**
+     * @brief 确保锁定的 wheel 都在仓库中：缺少的按确切版本与摘要下载
+     * @param wheels wheel 集合（文件名#sha256=摘要）
+     * @param downloaded 输出需要下载的 wheel 数，可为空
+     * @return 全部就绪且摘要相符返回 true
+     */
+    bool fetch(const std::vector<std::string>& wheels, size_t* downloaded = nullptr);
+    
+    /**
+     * @brief wheel 在仓库中的文件路径（不检查是否存在）
+     * @param wheel 文件名#sha256=摘要
+     */
+    std::string wheelPath(const std::string& wheel) const;
+    
+    /**
+     * @brief 从本地来源（如离线包）收入 wheel，仓库中已有时不调用 write
+     * @param wheel 文件名#sha256=摘要
+     * @param write 把 wheel 内容写到给定路径，成功返回 true（须保证摘要相符）
+     * @return wheel 已在仓库中返回 true
+     */
+    bool importWheel(const std::string& wheel, const std::function<bool(const std::string& path)>& write);
+    
+    /**
+     * @brief 环境名是否合法：字母或数字开头，其余为字母、数字与 . - _（不含 /，不能跳出 envs/）
+     */
+    static bool validEnvName(const std::string& name);
+    
+    /**
+     * @brief 用仓库中的 wheel 集合创建 venv
+     * @param name 环境名称（见 validEnvName）
+     * @param wheels wheel 集合（须已在仓库中）
+     * @return 成功返回 true
+     */
+    bool createEnv(const std::string& name, const std::vector<std::string>& wheels);
+    
+    /**
+     * @brief 删除环境（仓库中的文件保留，由 gc 回收）
+     * @param name 环境名称（见 validEnvName）
+     * @param reclaimedBytes 输出释放的磁盘空间，可为空
+     */
+    bool removeEnv(const std::string& name, std::uint64_t* reclaimedBytes = nullptr);
+    
+    /**
+     * @brief 列出已创建的环境
+     */
+    std::vector<std::string> listEnvs() const;
+    
+    /**
+     * @brief 读取环境的 wheel 集合
+     */
+    bool readEnvWheels(const std::string& name, std::vector<std::string>& wheels) const;
+    
+    /**
+     * @brief 回收既不被任何环境引用、也不被默认目录（SceneLock::directory）下的锁文件固定的 wheel
+     * 用 --file 存到其他位置的锁文件不计入，其中的 wheel 回收后按锁文件应用时按摘要重新下载；
+     * 离线包自带 wheel 副本，不依赖仓库
+     * @return 回收的 wheel 数量
+     */
+    size_t collectGarbage();
+    
+    std::string envPath(const std::string& name) const;
+    
+private:
+    std::string rootPath_;
+    
+    bool download(const std::vector<std::string>& requirements, bool pinned, std::vector<std::string>& entries);
+    bool ingestWheel(const std::string& path, std::string& entry);
+    bool unpackWheel(const std::string& digest);
 };
 
 } // namespace LinuxStudio
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 文件哈希清单
+ *
+ * 安装完成时记录落盘文件的 XXH64 摘要，之后可随时多线程重算，找出损坏或被改动的文件。
+ * 文本格式：首行 "xkl-manifest-1 xxh64 <条目数>"，之后每行
+ *   类型(f/l)<TAB>大小<TAB>摘要<TAB>绝对路径
+ * 符号链接记录链接目标的摘要。条目数用于发现写入中途掉电造成的截断。
+ */
+class Manifest {
+public:
+    struct Entry {
+        std::string path;
+        char type = 'f';          // f 普通文件，l 符号链接
+        std::uint64_t size = 0;
+        std::string digest;
+    };
+
+    struct Mismatch {
+        std::string path;
+        std::string reason;       // missing / modified / type / unreadable
+    };
+
+    struct Report {
+        std::uint64_t files = 0;
+        std::uint64_t bytes = 0;  // 实际读取的字节数
+        double seconds = 0;
+        std::vector<Mismatch> mismatches;
+
+        bool ok() const { return mismatches.empty(); }
+    };
+
+    /**
+     * @brief 收集并哈希文件
+     * @param roots 目录树（递归，不跟随符号链接；不存在的忽略）
+     * @param files 单独的文件
+     * @param exclude 跳过的路径
+     * @return 没有任何文件可记录返回 false
+     */
+    bool build(const std::vector<std::string>& roots, const std::vector<std::string>& files,
+               const std::set<std::string>& exclude = {});
+
+    /**
+     * @brief 读取清单文件
+     * @return 文件不存在或不完整返回 false
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief 原子写入清单文件
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief 按清单重算摘要（大文件优先，多线程并行）
+     */
+    Report verify() const;
+
+    const std::vector<Entry>& entries() const { return entries_; }
+
+    /**
+     * @brief 清单中普通文件的总字节数
+     */
+    std::uint64_t totalBytes() const;
+
+private:
+    std::vector<Entry> entries_;
+};
+
+} // namespace LinuxStudio
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 单层 OCI 镜像导出
+ *
+ * 把一组文件直接流式写成 OCI 镜像布局（oci-layout、index.json、blobs/sha256/）中的一个层：
+ * - 不压缩时文件内容经 copy_file_range（退回 sendfile、read/write）由内核直接拷入层文件；
+ * - 压缩时 tar 流按块分发给多个线程做 deflate，块之间以前一块末尾 32 KB 作字典，
+ *   拼接成一个标准 gzip 流（与 pigz 相同的做法）；
+ * 两种方式都不生成临时目录或临时 tar。同一 inode 或内容相同（大小与 XXH64 相同）的文件
+ * 只写一次数据，其余写成 tar 硬链接。
+ */
+class OciImageWriter {
+public:
+    struct Options {
+        bool compress = true;        // gzip 压缩层（需要 zlib）
+        unsigned threads = 0;        // 压缩线程数，0 为自动
+        std::string reference;       // index.json 中的镜像名（org.opencontainers.image.ref.name）
+    };
+
+    struct Report {
+        std::uint64_t files = 0;         // 写入数据的普通文件
+        std::uint64_t deduplicated = 0;  // 写成硬链接的文件
+        std::uint64_t directories = 0;
+        std::uint64_t symlinks = 0;
+        std::uint64_t tarBytes = 0;      // 未压缩的层大小
+        std::uint64_t blobBytes = 0;     // 层文件大小
+        std::string layerDigest;         // sha256:...
+        std::string manifestDigest;
+        double seconds = 0;
+    };
+
+    /**
+     * @param outDir 镜像布局目录（不存在时创建）
+     */
+    explicit OciImageWriter(const std::string& outDir);
+
+    /**
+     * @brief 加入单个路径（文件、符号链接或目录本身，不递归）；上级目录自动加入
+     */
+    void addPath(const std::string& path);
+
+    /**
+     * @brief 递归加入目录树（不跟随符号链接）
+     */
+    void addTree(const std::string& root);
+
+    /**
+     * @brief 写出层、镜像配置、清单与 index.json
+     * @return 成功返回 true；失败时不留下不完整的 blob
+     */
+    bool write(const Options& options, Report& report);
+
+    /**
+     * @brief 是否支持压缩层（编译时找到 zlib）
+     */
+    static bool compressionAvailable();
+
+private:
+    std::string outDir_;
+    std::set<std::string> paths_;
+};
+
+} // namespace LinuxStudio
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <initializer_list>
+#include <mutex>
+#include <type_traits>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 输出格式
+ */
+enum class OutputFormat {
+    TEXT,  // 面向人的彩色文本（默认）
+    JSON,  // 机器可读 JSON
+    TSV    // 制表符分隔，便于 shell 脚本处理
+};
+
+/**
+ * @brief 缓冲输出层
+ * 所有标准输出都先写入缓冲区，命令结束时一次性写出；
+ * 缓冲区超过阈值时自动刷新，大列表逐行流式输出，内存占用恒定。
+ *
+ * 文本模式下 operator<< 生效、结构化调用被忽略；
+ * JSON/TSV 模式下正好相反，日志输出改走 stderr。
+ * 缓冲区由互斥锁保护，工作线程可与主线程同时写入；
+ * 单次 write/operator<< 的内容不会与其他线程交错。
+ */
+class Output {
+public:
+    static Output& getInstance();
+
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+
+    /**
+     * @brief 解析 --format 参数值
+     * @param name json / tsv / text
+     * @param format 解析结果
+     * @return 成功返回 true
+     */
+    static bool parseFormat(const std::string& name, OutputFormat& format);
+
+    void setFormat(OutputFormat format) { format_ = format; }
+    OutputFormat getFormat() const { return format_; }
+    bool isText() const { return format_ == OutputFormat::TEXT; }
+
+    // ========== 文本模式 ==========
+    Output& operator<<(const std::string& s);
+    Output& operator<<(std::string_view s);
+    Output& operator<<(const char* s);
+    Output& operator<<(char c);
+
+    template <typename T,
+              typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    Output& operator<<(T value) {
+        return *this << std::to_string(value);
+    }
+
+    // ========== 结构化结果 ==========
+
+    /**
+     * @brief 开始一个对象
+     * @param key 对象在父对象中的键名，顶层对象传空
+     */
+    void beginObject(const std::string& key = "");
+    void endObject();
+
+    /**
+     * @brief 开始一个列表
+     * @param key 列表键名
+     * @param columns TSV 表头（行内字段需按此顺序输出）
+     */
+    void beginList(const std::string& key, std::initializer_list<const char*> columns = {});
+    void endList();
+
+    /**
+     * @brief 列表中的一行（JSON 对象 / TSV 一行）
+     */
+    void beginRow();
+    void endRow();
+
+    void field(const std::string& key, const std::string& value);
+    void field(const std::string& key, const char* value);
+    void field(const std::string& key, long long value);
+    void field(const std::string& key, int value) { field(key, static_cast<long long>(value)); }
+    void field(const std::string& key, bool value);
+
+    /**
+     * @brief 字符串数组字段
+     */
+    void field(const std::string& key, const std::vector<std::string>& values);
+
+    // ========== 底层 ==========
+
+    /**
+     * @brief 无论何种格式都写入（帮助信息等）
+     */
+    void write(const char* data, size_t size);
+    void write(const std::string& s) { write(s.data(), s.size()); }
+
+    /**
+     * @brief 将缓冲区写到 stdout
+     */
+    void flush();
+
+    /**
+     * @brief 设置终端底部的状态区（多行，每行以换行结尾；空串清除）
+     * 之后每次刷新都先擦除状态区、写出缓冲内容、再重绘，普通输出始终出现在状态区上方。
+     * 只应在文本模式且 stdout 是终端时使用
+     */
+    void setStatus(const std::string& block);
+
+private:
+    Output();
+    ~Output();
+
+    enum class ScopeType { OBJECT, LIST, ROW };
+
+    struct Scope {
+        ScopeType type;
+        bool first;
+        std::string prefix;  // TSV 扁平化键名前缀
+    };
+
+    OutputFormat format_;
+    std::string buffer_;
+    std::vector<Scope> scopes_;
+    std::recursive_mutex mutex_;  // 结束对象时会在持锁状态下刷新
+    std::string status_;          // 当前显示的状态区
+    size_t statusLines_ = 0;
+
+    void beginMember(const std::string& key);
+    void appendJsonString(const std::string& s);
+    void appendTsvValue(const std::string& s);
+    void writeScalar(const std::string& key, const std::string& raw, bool quoted);
+    void maybeFlush();
+    void writeOut(const std::string& data);
+    std::string eraseStatus() const;
+};
+
+} // namespace LinuxStudio
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 子进程执行工具
+ * 统一执行外部命令，执行前刷新缓冲输出，保证与子进程输出顺序一致
+ */
+class Process {
+public:
+    /**
+     * @brief 通过 /bin/sh 执行命令
+     * @param cmd 命令行
+     * @return 退出状态（与 system() 返回值一致）
+     */
+    static int run(const std::string& cmd);
+
+    /**
+     * @brief 执行命令并判断是否成功
+     * @param cmd 命令行
+     * @return 退出码为 0 返回 true
+     */
+    static bool succeeded(const std::string& cmd) { return run(cmd) == 0; }
+
+    /**
+     * @brief 执行命令，stdout 与 stderr 交给进度引擎解析，不直接显示
+     * 用于输出冗长的 apt、pip 等命令：终端上只显示汇总的进度，失败时附带最近的输出
+     * @param cmd 命令行
+     * @param label 进度显示中的任务名
+     * @return 退出状态（与 run 一致）
+     */
+    static int run(const std::string& cmd, const std::string& label);
+
+    static bool succeeded(const std::string& cmd, const std::string& label) { return run(cmd, label) == 0; }
+
+    /**
+     * @brief 执行命令并读取其标准输出
+     * @param cmd 命令行
+     * @param output 输出内容
+     * @return 退出码为 0 返回 true
+     */
+    static bool capture(const std::string& cmd, std::string& output);
+
+    /**
+     * @brief 把参数加上单引号，作为一个整体传给 /bin/sh（内部的单引号转义为 '\''）
+     */
+    static std::string quote(const std::string& arg);
+};
+
+} // namespace LinuxStudio
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 多任务进度汇总
+ *
+ * 子进程（apt、dpkg、pip）的输出不再直接打到终端，而是逐块交给进度引擎：
+ * 按行增量解析出阶段、百分比与当前处理的包，每个任务只保留状态和最近几行输出。
+ * - stdout 是终端时，在底部状态区每任务一行重绘，帧率有上限，多个任务同时运行也不交错；
+ * - 否则（管道、串口日志）每隔一段时间输出一行有变化的任务摘要。
+ * 任务结束时输出一行结果；失败的任务补上最近的原始输出，便于排查。
+ *
+ * 线程安全：不同线程可同时 begin/feed/end 各自的任务。
+ */
+class ProgressEngine {
+public:
+    static ProgressEngine& getInstance();
+
+    ProgressEngine(const ProgressEngine&) = delete;
+    ProgressEngine& operator=(const ProgressEngine&) = delete;
+
+    /**
+     * @brief 开始一个任务
+     * @param label 显示名称（如 "apt level 2"）
+     * @return 任务编号
+     */
+    int begin(const std::string& label);
+
+    /**
+     * @brief 送入任务的一段原始输出（可以在行中间截断）
+     */
+    void feed(int task, const char* data, std::size_t size);
+
+    /**
+     * @brief 结束任务并输出结果行
+     * @param ok 是否成功；失败时附带最近的输出
+     */
+    void end(int task, bool ok);
+
+private:
+    struct Task {
+        std::string label;
+        std::string phase;               // 下载、解包、配置……
+        std::string item;                // 当前处理的包
+        double percent = -1;             // 未知为负
+        std::string error;               // 最后一条错误
+        std::string partial;             // 未结束的行
+        std::deque<std::string> recent;  // 最近的输出行
+        std::size_t lines = 0;
+        bool changed = true;             // 上次摘要后是否有变化
+        std::chrono::steady_clock::time_point start;
+    };
+
+    ProgressEngine();
+
+    std::map<int, Task> tasks_;
+    int nextId_ = 1;
+    bool interactive_;
+    std::chrono::steady_clock::time_point lastFrame_;
+    std::mutex mutex_;
+
+    void parseLine(Task& task, const std::string& line);
+    void render(bool force);
+    std::string statusLine(const Task& task, std::size_t width) const;
+};
+
+} // namespace LinuxStudio
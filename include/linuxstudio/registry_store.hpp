@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 多进程共享的键值注册表文件
+ *
+ * 文件布局：一页文件头 + 两个等长数据槽（双缓冲）。
+ * - 读者 mmap 文件，按 seqlock 协议读取当前槽，从不加锁、从不阻塞；
+ * - 写者在独立锁文件上 flock 串行化，读取最新内容、合并本进程的变更后
+ *   写入非活动槽，再切换活动槽并递增版本号；
+ * - 每个槽带校验和，写入中途掉电时读者回退到另一个完整的槽；
+ * - 容量不足时写入新文件并原子 rename 替换。
+ */
+class RegistryStore {
+public:
+    /**
+     * @brief 变更集：值为 nullopt 表示删除该键
+     */
+    using Changes = std::map<std::string, std::optional<std::string>>;
+    using Entries = std::map<std::string, std::string>;
+
+    explicit RegistryStore(const std::string& path);
+
+    /**
+     * @brief 读取一致的快照（无锁）
+     * @param entries 输出全部键值
+     * @param version 输出快照版本号（可为空）
+     * @return 文件不存在或损坏返回 false
+     */
+    bool read(Entries& entries, std::uint64_t* version = nullptr) const;
+
+    /**
+     * @brief 合并提交变更
+     * @param changes 本进程的变更
+     * @param merged 输出合并后的完整内容（可为空）
+     * @param version 输出提交后的版本号（可为空）
+     * @return 成功返回 true
+     */
+    bool commit(const Changes& changes, Entries* merged = nullptr, std::uint64_t* version = nullptr);
+
+    /**
+     * @brief 当前版本号（每次提交递增，文件不存在时为 0）
+     */
+    std::uint64_t version() const;
+
+    /**
+     * @brief 注册表文件是否存在
+     */
+    bool exists() const;
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+} // namespace LinuxStudio
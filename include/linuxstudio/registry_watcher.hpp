@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 注册表增量刷新
+ *
+ * 插件目录与 dpkg 状态文件的变化以增量方式应用到内存视图和磁盘索引：
+ * - 一次性追赶：按上次记录的变更标记（inode、大小、mtime）只重读有变化的插件和软件包；
+ * - 长驻监视：inotify 监视插件目录、各插件目录与 /var/lib/dpkg，事件去抖后按名字增量同步。
+ * 长驻进程运行期间持有锁文件，其他 xkl 进程据此直接信任索引，启动时不再逐个检查插件。
+ */
+class RegistryWatcher {
+public:
+    static constexpr const char* kLockPath = "/opt/linuxstudio/data/watch.lock";
+    static constexpr const char* kDpkgStatusPath = "/var/lib/dpkg/status";
+
+    /**
+     * @brief 一次同步中变化的条目
+     */
+    struct Changes {
+        std::vector<std::string> plugins;    // 新增、修改或删除的插件
+        std::vector<std::string> packages;   // 安装状态或版本变化的组件
+
+        bool empty() const { return plugins.empty() && packages.empty(); }
+    };
+
+    /**
+     * @brief 监视进程的锁文件（环境变量 XKL_WATCH_LOCK 可覆盖 kLockPath，测试用）
+     */
+    static std::string lockPath();
+
+    /**
+     * @brief dpkg 状态文件（环境变量 XKL_DPKG_STATUS 可覆盖 kDpkgStatusPath，测试用）
+     */
+    static std::string dpkgStatusPath();
+
+    /**
+     * @brief 是否有长驻监视进程在运行
+     */
+    static bool active();
+
+    /**
+     * @brief 一次性追赶：按保存的变更标记同步插件与系统软件包
+     */
+    static Changes catchUp();
+
+    /**
+     * @brief 长驻监视，直到 stop 置位
+     * @param stop 停止标志（可在信号处理函数中设置）
+     * @param onChange 每批变化应用后回调
+     * @return 已有监视进程或 inotify 不可用时返回 false
+     */
+    static bool run(const std::atomic<bool>& stop, const std::function<void(const Changes&)>& onChange);
+};
+
+} // namespace LinuxStudio
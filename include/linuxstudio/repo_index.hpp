@@ -0,0 +1,154 @@
+#pragma once
+
+#include "scenes.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief xkl 仓库索引：场景与插件定义
+ *
+ * 场景、组件别名与插件不再只能随二进制发布：仓库发布一个带版本号的索引映像，
+ * 本地副本直接 mmap，按名查找是对映射内存的二分查找，不需要解析。
+ * 映像布局（整数均为小端）：
+ *   文件头 | 场景表（源文件顺序）| 插件表（按名排序）| 别名表（按组件名排序）| 名称列表 | 字符串区
+ *
+ * 仓库目录下除 index.xri 外还有 index.xri.sums，记录每个块的弱校验（rsync 滚动校验和）与 XXH64：
+ *   xkl-sums-1
+ *   version <版本> / length <字节数> / blocksize <块大小> / sha256 <整个映像的摘要>
+ *   <弱校验> <XXH64>          （每块一行，十六进制，末块补零到块大小）
+ * 更新时在本地旧副本上滑动窗口匹配这些块，只用 HTTP Range 请求取回匹配不到的字节，
+ * 组装后校验摘要再原子替换，目录的小改动只需传输几 KB。
+ *
+ * 仓库维护者用 xkl repo build 把文本源编译成映像与校验文件。文本源每行一条（字段以 TAB 分隔）：
+ *   xkl-repo-1 <版本>
+ *   S <场景名> <中文名> <英文名> <简介> <组件（空格分隔）>
+ *   A <组件> <系统软件包>
+ *   P <插件名> <说明> <系统软件包（空格分隔，* 结尾为前缀）> <pip 依赖（空格分隔）>
+ */
+class RepoIndex {
+public:
+    static constexpr const char* kDefaultPath = "/opt/linuxstudio/data/repo/index.xri";
+    static constexpr const char* kIndexName = "index.xri";
+    static constexpr const char* kSumsName = "index.xri.sums";
+    static constexpr std::size_t kBlockSize = 1024;
+
+    /**
+     * @brief 仓库中的插件：系统软件包与 Python 依赖，均可为空
+     */
+    struct PluginEntry {
+        std::string description;
+        std::vector<std::string> packages;
+        std::vector<std::string> requirements;
+    };
+
+    /**
+     * @brief 增量更新的统计
+     */
+    struct UpdateReport {
+        std::uint64_t fromVersion = 0;    // 0 表示本地没有索引
+        std::uint64_t toVersion = 0;
+        bool upToDate = false;
+        bool full = false;                // 整个下载（没有旧副本或差异过大）
+        std::size_t blocks = 0;           // 新映像的块数
+        std::size_t matchedBlocks = 0;    // 其中在旧副本中找到的块
+        std::size_t ranges = 0;           // Range 请求的区间数
+        std::uint64_t length = 0;         // 新映像字节数
+        std::uint64_t fetched = 0;        // 实际下载的字节（含校验文件）
+        std::string error;
+    };
+
+    RepoIndex();
+    ~RepoIndex();
+
+    RepoIndex(const RepoIndex&) = delete;
+    RepoIndex& operator=(const RepoIndex&) = delete;
+
+    /**
+     * @brief 映射索引文件
+     * @return 文件不存在或校验不通过返回 false
+     */
+    bool open(const std::string& path);
+
+    bool loaded() const { return image_ != nullptr; }
+
+    std::uint64_t version() const;
+
+    /**
+     * @brief 仓库定义的场景（源文件顺序）
+     */
+    std::vector<SceneDefinition> scenes() const;
+
+    /**
+     * @brief 组件对应的系统软件包名
+     * @return 仓库没有该别名返回 false
+     */
+    bool alias(std::string_view component, std::string& package) const;
+
+    /**
+     * @brief 按名查找插件
+     */
+    bool plugin(std::string_view name, PluginEntry& entry) const;
+
+    std::vector<std::string> pluginNames() const;
+
+    /**
+     * @brief 本机已下载的索引（第一次调用时映射，没有时为空索引）
+     */
+    static const RepoIndex& local();
+
+    /**
+     * @brief 更新后重新映射本机索引（之前取得的 local() 内容随之失效）
+     */
+    static bool reloadLocal();
+
+    // ---- 仓库维护 ----
+
+    /**
+     * @brief 把文本源编译成映像
+     * @param error 失败时为出错的行号与原因
+     */
+    static bool compile(const std::string& source, std::string& image, std::string& error);
+
+    /**
+     * @brief 映像的块校验文件内容
+     */
+    static std::string sums(const std::string& image, std::size_t blockSize = kBlockSize);
+
+    // ---- 客户端 ----
+
+    /**
+     * @brief 从仓库增量更新本地索引
+     * @param url 仓库地址（http://、https://、file://），其下有 index.xri 与 index.xri.sums
+     * @param path 本地索引路径
+     * @return 成功（含已是最新）返回 true，失败时 report.error 为原因
+     */
+    static bool update(const std::string& url, const std::string& path, UpdateReport& report);
+
+private:
+    struct Header;
+    struct SceneRecord;
+    struct PluginRecord;
+    struct AliasRecord;
+
+    void* mapping_;
+    std::size_t mappingSize_;
+    const char* image_;
+    const Header* header_;
+    const SceneRecord* scenes_;
+    const PluginRecord* plugins_;
+    const AliasRecord* aliases_;
+    const std::uint32_t* lists_;
+    const char* strings_;
+
+    void reset();
+    static bool validate(const char* image, std::size_t size);
+    std::vector<std::string> list(std::uint32_t begin, std::uint32_t count) const;
+    std::string_view string(std::uint32_t offset) const { return std::string_view(strings_ + offset); }
+};
+
+} // namespace LinuxStudio
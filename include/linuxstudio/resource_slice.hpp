@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 安装子进程的资源隔离（cgroup v2）
+ *
+ * 在正在服务业务的机器上应用场景时，apt、pip 以及它们触发的源码编译不应抢占业务的资源。
+ * 第一次启动安装子进程时创建本次的 cgroup，之后所有经 Process::run(cmd, label) 启动的命令都先把自己移入该 cgroup 再执行：
+ * - 由 systemd 管理 cgroup 树时（存在 /run/systemd/system），用
+ *   systemd-run --scope --slice=xkl.slice -p CPUQuota= -p MemoryHigh= -p IOWeight= 启动一个占位进程，
+ *   得到 xkl.slice/xkl-install-<pid>.scope，限额由 systemd 写入，不与它的树冲突；
+ * - 否则（或 systemd-run 失败）直接创建 <cgroup2>/xkl.slice/install-<pid>，写入 cpu.max、memory.high、io.weight。
+ * CPU 限额按比例写成 quota/period（单核机器上 50% 即 "50000 100000"），不取整到整核。
+ * 同时按可用核心与内存设定编译并行度（MAKEFLAGS、CMAKE_BUILD_PARALLEL_LEVEL、MAX_JOBS），
+ * 避免 -j 过大在 memory.high 下反复回收内存。
+ * 没有 cgroup v2 或相应控制器（旧内核、容器内、非 root）时只限制并行度并降低调度优先级。
+ * 进程退出时删除本次的 cgroup（结束占位进程后 systemd 自行回收 scope）；xkl.slice 保留供下次使用。
+ *
+ * 配置项（/etc/linuxstudio/config.yaml）：
+ *   install_cgroup: true|false
+ *   install_cpu_max: 50% | 2（核） | max
+ *   install_memory_high: 50% | 2G | max    （百分比相对于当前可用内存）
+ *   install_io_weight: 50                   （1-10000，100 与其他进程相同）
+ *   install_jobs: 0                          （0 自动）
+ */
+class ResourceSlice {
+public:
+    static constexpr const char* kSliceName = "xkl.slice";
+
+    /**
+     * @brief 本次安装所受的限制与节流统计
+     */
+    struct Usage {
+        bool isolated = false;                 // 子进程是否在 cgroup 中运行
+        std::string path;                      // cgroup 目录
+        std::vector<std::string> applied;      // 生效的限制（如 "cpu.max 200000 100000"、"CPUQuota 200%"）
+        unsigned jobs = 1;                     // 编译并行度
+        std::uint64_t periods = 0;             // CPU 调度周期数
+        std::uint64_t throttledPeriods = 0;    // 其中被 cpu.max 限流的周期
+        double throttledSeconds = 0;           // 被限流的总时间
+        std::uint64_t memoryHighEvents = 0;    // 超过 memory.high 被强制回收的次数
+        std::uint64_t memoryPeak = 0;          // 内存峰值（内核 5.19 起提供）
+        double memoryStallSeconds = 0;         // 因内存不足等待的时间（PSI）
+        double ioStallSeconds = 0;             // 因 I/O 等待的时间（PSI）
+    };
+
+    static ResourceSlice& getInstance();
+
+    ResourceSlice(const ResourceSlice&) = delete;
+    ResourceSlice& operator=(const ResourceSlice&) = delete;
+
+    /**
+     * @brief 读取配置文件中的 install_* 项，未出现的项保持默认
+     */
+    void loadConfig(const std::string& path);
+
+    /**
+     * @brief 包装命令：进入 cgroup、设置并行度（第一次调用时创建 cgroup）
+     * @param cmd 原命令
+     * @return 交给 shell 执行的命令
+     */
+    std::string wrap(const std::string& cmd);
+
+    /**
+     * @brief 本进程是否启动过受限的安装子进程
+     */
+    bool used() const { return used_; }
+
+    /**
+     * @brief 每个任务需要 memoryPerJob 内存时的并行度（源码构建的链接步骤等）
+     * @param memoryPerJob 0 为默认的每任务内存（即 MAKEFLAGS 使用的并行度）
+     */
+    unsigned jobsFor(std::uint64_t memoryPerJob);
+
+    /**
+     * @brief 读取 cgroup 的节流统计
+     */
+    Usage usage();
+
+private:
+    ResourceSlice() = default;
+    ~ResourceSlice();
+
+    bool enabled_ = true;
+    std::string cpuMax_ = "50%";
+    std::string memoryHigh_ = "50%";
+    unsigned ioWeight_ = 50;
+    unsigned jobs_ = 0;
+
+    bool used_ = false;
+    bool prepared_ = false;
+    std::string path_;                   // 创建成功的 cgroup，失败为空
+    int holder_ = 0;                     // 维持 systemd scope 的占位进程
+    std::vector<std::string> applied_;
+    unsigned effectiveJobs_ = 1;
+    std::uint64_t memoryBudget_ = 0;     // memory.high，不限时为可用内存
+    std::mutex mutex_;
+
+    void prepare();
+
+    /**
+     * @brief 由 systemd 创建带限额的 scope，成功时设置 path_ 与 holder_
+     */
+    bool startScope(const std::string& root, double cpuCores, std::uint64_t memoryHigh);
+};
+
+} // namespace LinuxStudio
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 场景锁文件
+ *
+ * 记录一次完整解析的结果：闭包中每个软件包的确切版本、安装层与 .deb 的 SHA256，
+ * 以及 Python 插件的 wheel 集合。按锁文件应用时不再解析依赖，只安装这些构件；
+ * 本地缓存中摘要相符的文件直接使用，不再下载。
+ * 文本格式（字段以 TAB 分隔）：
+ *   xkl-lock-1 <场景>
+ *   P <层> <根 0/1> <包名> <版本> <SHA256，未知为 -> <软件源中的路径>
+ *   W <插件> <wheel（文件名#sha256=摘要）>
+ */
+struct SceneLock {
+    static constexpr const char* kDefaultDir = "/etc/linuxstudio/locks";
+
+    struct Package {
+        std::string name;
+        std::string version;
+        std::string sha256;       // 软件源索引中没有该版本时为空（无法校验）
+        std::string filename;     // 软件源中的相对路径（pool/...）
+        unsigned level = 0;       // 安装层（0 层不依赖闭包内其他包）
+        bool root = false;        // 场景直接要求的包（其余标记为自动安装）
+    };
+
+    /**
+     * @brief 按锁文件应用的统计
+     */
+    struct Report {
+        std::size_t satisfied = 0;               // 已安装且版本一致
+        std::size_t cached = 0;                  // 使用本地缓存的 .deb
+        std::size_t downloaded = 0;              // 新下载的 .deb
+        std::size_t bundled = 0;                 // 从离线包中取出的 .deb
+        std::vector<std::string> drifted;        // 已安装但版本不同（不降级，只报告）
+        std::vector<std::string> mismatched;     // 摘要与锁文件不符（中止安装）
+        std::vector<std::string> installed;      // 本次实际安装的包
+    };
+
+    std::string scene;
+    std::vector<Package> packages;                            // 按层排列
+    std::map<std::string, std::vector<std::string>> wheels;   // Python 插件 -> wheel 集合
+
+    /**
+     * @brief 锁文件的默认目录（环境变量 XKL_LOCK_DIR 可覆盖 kDefaultDir，测试用）
+     */
+    static std::string directory();
+
+    /**
+     * @brief 场景锁文件的默认位置
+     */
+    static std::string defaultPath(const std::string& scene);
+
+    /**
+     * @brief 读取锁文件
+     * @return 文件不存在或格式不符返回 false
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief 从文本解析锁文件（如离线包中的 scene.lock）
+     * 场景、插件与软件包名只能由字母、数字与 + . - _ 组成，版本、摘要、路径与 wheel 条目同样检查字符集
+     * @return 格式不符或含不安全的名字返回 false
+     */
+    bool parse(const std::string& content);
+
+    /**
+     * @brief 原子写入锁文件（自动创建所在目录）
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief 安装层数
+     */
+    std::size_t levelCount() const;
+};
+
+} // namespace LinuxStudio
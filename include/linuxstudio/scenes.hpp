@@ -0,0 +1,139 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 开发场景定义
+ */
+struct SceneDefinition {
+    std::string name;                     // 场景名（命令行使用）
+    std::string titleZh;                  // 中文显示名称
+    std::string titleEn;                  // 英文显示名称
+    std::string highlights;               // 代表性工具简介
+    std::vector<std::string> components;  // 场景包含的组件
+};
+
+/**
+ * @brief 获取内置场景列表（按显示顺序）
+ */
+const std::vector<SceneDefinition>& builtinScenes();
+
+/**
+ * @brief 内置场景加上仓库索引中的场景
+ * 仓库中的同名场景覆盖内置定义，新场景排在内置场景之后
+ */
+const std::vector<SceneDefinition>& availableScenes();
+
+/**
+ * @brief 按名称查找场景
+ * @param name 场景名
+ * @return 未找到返回 nullptr
+ */
+const SceneDefinition* findScene(const std::string& name);
+
+/**
+ * @brief 场景组件对应的系统软件包名（Debian/Ubuntu）
+ * 场景里的组件是通用名称（如 python、java），依赖解析前需要换成实际包名
+ * 仓库索引中的别名优先于内置别名
+ * @param component 组件名
+ * @return 没有别名时原样返回
+ */
+std::string scenePackageName(const std::string& component);
+
+/**
+ * @brief 场景应用记录：历次 scene apply 实际安装的软件包与 Python 插件
+ * 导出镜像时只收录这些事务新增的文件（相当于应用前后文件系统的差异）
+ */
+struct SceneRecord {
+    static constexpr const char* kDefaultDir = "/opt/linuxstudio/data/scenes";
+
+    /**
+     * @brief 记录与场景状态所在的目录（环境变量 XKL_SCENES_DIR 可覆盖 kDefaultDir，测试用）
+     */
+    static std::string directory();
+
+    std::set<std::string> packages;
+    std::set<std::string> plugins;
+
+    /**
+     * @brief 读取场景的记录
+     * @return 没有记录返回 false
+     */
+    bool load(const std::string& scene);
+
+    /**
+     * @brief 把本次安装的内容并入磁盘上的记录
+     */
+    bool merge(const std::string& scene) const;
+
+    /**
+     * @brief 用当前内容覆盖磁盘上的记录（场景切换移除软件包之后）
+     */
+    bool save(const std::string& scene) const;
+};
+
+/**
+ * @brief 当前应用的场景，以及切换场景后为快速切回而保留的软件包
+ * 场景切换时，离开的场景记录中、新场景闭包不需要的包才会卸载
+ */
+struct SceneState {
+    /**
+     * @brief 状态文件路径（记录目录下的 state）
+     */
+    static std::string path();
+
+    std::set<std::string> active;   // 当前应用的场景
+    std::set<std::string> warm;     // 不再被任何场景需要、但暂不卸载的包
+
+    /**
+     * @brief 读取状态（文件不存在时为空）
+     */
+    bool load();
+
+    bool save() const;
+
+    /**
+     * @brief 把场景加入当前应用的场景
+     */
+    static bool activate(const std::string& scene);
+};
+
+/**
+ * @brief 一次场景切换的差异（xkl scene switch）
+ * 卸载候选只来自离开场景的安装记录与此前保留的包，场景之外装的软件不受影响；
+ * 候选中仍被保留场景（含新场景）的完整闭包需要的包留下，其余为孤立的包
+ */
+struct SceneSwitch {
+    std::set<std::string> leaving;                 // 离开的场景
+    std::set<std::string> staying;                 // 切换后应用的场景（含新场景）
+    std::map<std::string, SceneRecord> records;    // 离开场景的安装记录
+    std::vector<std::string> shared;               // 候选中仍需要的包
+    std::vector<std::string> orphans;              // 候选中不再需要的包
+
+    /**
+     * @param from 非空时只离开该场景，否则新场景替换当前所有场景
+     */
+    SceneSwitch(const SceneState& state, const std::string& target, const std::string& from);
+
+    /**
+     * @brief 读取离开场景的记录，把卸载候选按是否在 needed 中分为 shared 与 orphans
+     * @param needed 保留场景的完整闭包
+     */
+    void classify(const SceneState& state, const std::set<std::string>& needed);
+
+    /**
+     * @brief 卸载之后更新离开场景的记录与场景状态并写回磁盘
+     * 保留（--keep-warm）或卸载失败时孤立且仍安装着的包记为 warm，下次切换时再作为候选
+     * @param removed 实际卸载的包
+     * @return 孤立但仍被场景之外的软件需要、因而没有卸载的包
+     */
+    std::vector<std::string> finish(SceneState& state, const std::vector<std::string>& removed, bool keepWarm,
+                                    bool removalOk);
+};
+
+} // namespace LinuxStudio
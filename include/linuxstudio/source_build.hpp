@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 源码构建配方
+ *
+ * 部分发行版没有合适的二进制包（交叉工具链、OpenOCD、启用 NEON 的 OpenCV、机械臂驱动），
+ * 这些组件按配方从源码构建。配方是 "键 值..." 格式的文本，# 开头为注释：
+ *   name         openocd
+ *   version      0.12.0
+ *   url          <源码包地址> <sha256>      （或 git <仓库> <标签>，二选一）
+ *   system       cmake | autotools | make
+ *   bootstrap    ./bootstrap                 （autotools 在 configure 前执行，可省略）
+ *   depends      libusb-1.0-0-dev ...        （构建依赖的系统软件包）
+ *   configure    --enable-ftdi ...           （可多行，追加到 configure/cmake/make 参数）
+ *   configure.aarch64 ...                    （只在该架构上追加，架构名同 uname -m）
+ *   link-memory  2G                          （单个链接任务的内存，决定链接并行度）
+ *   prefix       /usr/local
+ * /etc/linuxstudio/recipes/<名称>.recipe 优先于内置配方。
+ */
+struct BuildRecipe {
+    static constexpr const char* kDefaultDir = "/etc/linuxstudio/recipes";
+
+    enum class System {
+        CMake,
+        Autotools,
+        Make
+    };
+
+    std::string name;
+    std::string version;
+    std::string url;
+    std::string sha256;
+    std::string git;
+    std::string ref;
+    System system = System::CMake;
+    std::string bootstrap;
+    std::vector<std::string> depends;
+    std::vector<std::string> configure;
+    std::map<std::string, std::vector<std::string>> archConfigure;   // 架构 -> 追加参数
+    std::uint64_t linkMemory = 0;                                     // 0 为默认
+    std::string prefix = "/usr/local";
+    std::string text;                                                 // 规范化的配方内容（参与缓存键）
+
+    /**
+     * @brief 解析配方文本
+     * @return 缺少 name/version、源码地址或构建系统无法识别返回 false
+     */
+    bool parse(const std::string& content);
+
+    /**
+     * @brief 按名称查找配方（先配方目录，后内置）
+     */
+    static bool find(const std::string& name, BuildRecipe& recipe);
+
+    /**
+     * @brief 所有可用配方的名称
+     */
+    static std::vector<std::string> available();
+};
+
+/**
+ * @brief 源码构建后端
+ *
+ * 每次构建：
+ *   1. 以 配方内容 + 工具链标识（编译器版本、目标三元组、架构）的 SHA256 为键查找构件缓存，
+ *      命中则直接解压安装，不再编译；
+ *   2. 否则安装构建依赖、获取源码（源码包按摘要缓存，git 仓库浅克隆后缓存），
+ *      经 ccache 编译（所有构建共用一个缓存目录），安装到暂存目录并打包进构件缓存，再解压安装。
+ * 并行度由 ResourceSlice 按核心数与可用内存确定：编译任务按每任务的默认内存计，
+ * 链接任务按配方的 link-memory 计；cmake + Ninja 时两者分别放入 job pool，
+ * 其他构建系统无法单独限制链接，取两者中较小的值。
+ * 所有步骤经 Process::run(cmd, label) 执行，受安装资源限额约束并显示在进度中。
+ */
+class SourceBuilder {
+public:
+    static constexpr const char* kCacheDir = "/opt/linuxstudio/cache";
+    static constexpr const char* kWorkDir = "/var/tmp";
+
+    struct Report {
+        bool cacheHit = false;
+        std::string key;             // 构件缓存键（十六进制）
+        std::string artifact;        // 构件缓存文件
+        unsigned jobs = 1;           // 编译并行度
+        unsigned linkJobs = 1;       // 链接并行度
+        bool ccache = false;         // 是否使用了编译缓存
+        std::string failedStep;      // 失败的步骤（成功时为空）
+        double seconds = 0;
+    };
+
+    /**
+     * @brief 读取配置文件中的 build_* 项
+     *   build_ccache: true|false
+     *   build_ccache_size: 5G
+     *   build_link_memory: 2G      （配方未指定 link-memory 时使用）
+     */
+    void loadConfig(const std::string& path);
+
+    /**
+     * @brief 构建并安装
+     * @param rebuild 忽略构件缓存，重新编译（编译缓存仍然生效）
+     * @return 成功返回 true；失败时 report.failedStep 为失败的步骤
+     */
+    bool build(const BuildRecipe& recipe, bool rebuild, Report& report);
+
+    /**
+     * @brief 当前工具链的标识（cc/c++ 版本与目标三元组、uname -m）
+     */
+    static std::string toolchainIdentity();
+
+private:
+    bool ccache_ = true;
+    std::string ccacheSize_ = "5G";
+#ifdef LINUXSTUDIO_EMBEDDED
+    std::uint64_t linkMemory_ = 512ull << 20;
+#else
+    std::uint64_t linkMemory_ = 2ull << 30;
+#endif
+
+    bool fetch(const BuildRecipe& recipe, const std::string& sourceDir, Report& report);
+};
+
+} // namespace LinuxStudio
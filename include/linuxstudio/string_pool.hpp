@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace LinuxStudio {
+
+/**
+ * @brief 字符串驻留池
+ *
+ * 相同内容只存一份，以连续的整数 ID 引用。字符串存放在按块分配的 arena 中，
+ * 追加新块不会移动已有字符串，返回的 string_view 在池存活期间一直有效。
+ * 非线程安全：构建阶段由单个线程使用。
+ */
+class StringPool {
+public:
+    StringPool();
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    /**
+     * @brief 驻留字符串
+     * @return 已存在时返回原有 ID
+     */
+    std::uint32_t intern(std::string_view s);
+
+    /**
+     * @brief 按 ID 取字符串
+     */
+    std::string_view get(std::uint32_t id) const { return strings_[id]; }
+
+    /**
+     * @brief 不同字符串的个数（即下一个 ID）
+     */
+    std::size_t size() const { return strings_.size(); }
+
+    /**
+     * @brief arena 已分配的字节数
+     */
+    std::size_t arenaBytes() const { return arenaBytes_; }
+
+private:
+    static constexpr std::size_t kBlockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::vector<std::unique_ptr<char[]>> large_;
+    std::size_t blockUsed_;
+    std::size_t arenaBytes_;
+    std::vector<std::string_view> strings_;
+    std::unordered_map<std::string_view, std::uint32_t> index_;
+
+    const char* store(std::string_view s);
+};
+
+} // namespace LinuxStudio
@@ -9,6 +9,8 @@ Source0:        %{name}-%{version}.tar.gz
 
 BuildRequires:  gcc-c++
 BuildRequires:  make
+BuildRequires:  zlib-devel
+BuildRequires:  libzstd-devel
 Requires:       bash
 Requires:       curl
 Requires:       git
@@ -60,6 +62,33 @@ version: 1.1.1
 install_path: /opt/linuxstudio
 log_level: info
 auto_update_check: true
+# 日志分段（默认值随构建而定，嵌入式构建段更小并攒批写入）：
+# log_max_size: 8M          # 单段大小上限
+# log_max_age: 30d          # 单段最长时间
+# log_retain: 64M           # 已关闭分段（gzip 压缩）的总大小上限
+# log_compress: true
+# log_batch_size: 16K       # 攒批写入，0 表示逐行写出
+# log_batch_interval: 5s
+# 安装子进程的资源限额（cgroup v2 的 xkl.slice，在线上机器上安装时不抢占业务）：
+# install_cgroup: true
+# install_cpu_max: 50%       # 可用核心的百分比或核数，max 不限
+# install_memory_high: 50%   # 可用内存的百分比或大小，max 不限
+# install_io_weight: 50      # 1-10000，100 与其他进程相同
+# install_jobs: 0            # 编译并行度，0 按核心与内存自动
+# 源码构建（配方位于 /etc/linuxstudio/recipes，构件缓存在 /opt/linuxstudio/cache）：
+# build_ccache: true
+# build_ccache_size: 5G
+# build_link_memory: 2G      # 单个链接任务的内存，决定链接并行度
+# 场景仓库（xkl repo update 的默认地址，其下有 index.xri 与 index.xri.sums）：
+# repository_url: https://repo.linuxstudio.org/scenes
+# 后台安装队列（xkl queue run 在 PSI 与负载低于阈值时启动任务，超过阈值的 pause_factor 倍时暂停）：
+# queue_cpu_pressure: 10     # %，/proc/pressure/cpu 的 some avg10
+# queue_memory_pressure: 5
+# queue_io_pressure: 10
+# queue_load: 0.7            # 1 分钟负载 / 核心数
+# queue_pause_factor: 2
+# queue_settle: 30s          # 持续空闲这么久才启动或恢复
+# queue_poll: 5s
 EOF
 
 %post
@@ -2,48 +2,252 @@
 #include "linuxstudio/managers.hpp"
 #include "linuxstudio/logger.hpp"
 #include "linuxstudio/i18n.hpp"
-#include <iostream>
+#include "linuxstudio/output.hpp"
+#include "linuxstudio/scenes.hpp"
+#include "linuxstudio/completion.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/registry_watcher.hpp"
+#include "linuxstudio/oci_image.hpp"
+#include "linuxstudio/disk_usage.hpp"
+#include "linuxstudio/bundle.hpp"
+#include "linuxstudio/log_index.hpp"
+#include "linuxstudio/resource_slice.hpp"
+#include "linuxstudio/repo_index.hpp"
+#include "linuxstudio/install_queue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
 #include <vector>
 #include <string>
 #include <cstring>
 #include <map>
+#include <set>
+
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace LinuxStudio;
 
+namespace {
+
+/**
+ * @brief 错误信息直接写 stderr
+ * 不引入 iostream：它的静态初始化和 locale 会让只读命令的常驻内存翻倍
+ */
+struct ErrorStream {
+    ErrorStream& operator<<(const std::string& s) {
+        std::fwrite(s.data(), 1, s.size(), stderr);
+        return *this;
+    }
+    ErrorStream& operator<<(const char* s) {
+        std::fputs(s, stderr);
+        return *this;
+    }
+};
+ErrorStream errorOut;
+
+const char* const kRule = "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+}
+
 // 前向声明
 void showHelp();
 void showVersion();
 void cmdStatus();
 void cmdPluginList();
-void cmdPluginInstall(const std::string& name);
-void cmdPluginUninstall(const std::string& name);
-void cmdPluginEnable(const std::string& name);
-void cmdPluginDisable(const std::string& name);
+bool cmdPluginInstall(const std::string& name);
+bool cmdPluginUninstall(const std::string& name);
+bool cmdPluginEnable(const std::string& name);
+bool cmdPluginDisable(const std::string& name);
+void cmdPluginDu(bool refresh);
+bool cmdPluginVerify(const std::string& name, bool update);
 void cmdComponentList();
-void cmdComponentInstall(const std::string& name);
+void cmdComponentSearch(const std::string& keyword);
+bool cmdComponentInstall(const std::string& name);
+bool cmdComponentUninstall(const std::string& name);
+void cmdComponentDu(bool refresh);
+bool cmdComponentBuild(const std::string& name, bool rebuild);
 void cmdSceneList();
-void cmdSceneApply(const std::string& name);
+bool cmdSceneResolve(const std::string& name, bool refresh);
+bool cmdSceneApply(const std::string& name);
+bool cmdSceneSwitch(const std::string& name, const std::string& from, bool keepWarm, bool dryRun);
+bool cmdSceneLock(const std::string& name, const std::string& file);
+bool cmdSceneApplyLocked(const std::string& name, const std::string& file);
+bool cmdSceneExport(const std::string& name, const std::string& outDir, bool compress);
+bool cmdBundleCreate(const std::string& name, const std::string& file);
+bool cmdBundleApply(const std::string& file);
+bool cmdBundleList(const std::string& file);
+void printPlan(const Resolution& plan);
+void cmdMirrorRank(const std::vector<MirrorKind>& kinds, bool refresh);
+bool cmdMirrorApply(MirrorKind kind);
+bool cmdPythonEnvCreate(const std::string& name, const std::vector<std::string>& sources);
+void cmdPythonEnvList();
+bool cmdPythonEnvRemove(const std::string& name);
+void cmdPythonGc();
+bool cmdWatch();
+bool cmdLogs(const LogIndex::Query& query, bool follow);
+void cmdI18nKeys();
+bool cmdRepoUpdate(const std::string& url);
+bool cmdRepoBuild(const std::string& source, const std::string& outDir);
+bool cmdQueueAdd(InstallQueue::Kind kind, const std::string& name);
+void cmdQueueList();
+bool cmdQueueRemove(const std::string& id);
+bool cmdQueueRun();
+void printResult(const std::string& command, const std::string& name, bool success);
+void printResourceUsage();
+int runCommand(int argc, char* argv[]);
 
 int main(int argc, char* argv[]) {
+    int code = runCommand(argc, argv);
+    // 队列任务子进程：退出码留给可能接管它的调度进程（上一个调度进程异常退出时）
+    InstallQueue::recordExit(code);
+    return code;
+}
+
+int runCommand(int argc, char* argv[]) {
+    // Shell 补全：只读预生成索引，不初始化框架
+    if (argc >= 2 && std::strcmp(argv[1], "__complete") == 0) {
+        return CompletionIndex::complete(std::vector<std::string>(argv + 2, argv + argc));
+    }
+    
+    // 后台删除进程：清空卸载时移入回收区的目录
+    if (argc >= 2 && std::strcmp(argv[1], "__purge-trash") == 0) {
+        FileUtils::purgeTrash();
+        return 0;
+    }
+    char self[4096];
+    ssize_t selfLength = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (selfLength > 0) {
+        FileUtils::setPurger(std::string(self, static_cast<size_t>(selfLength)));
+    }
+
+    // 输出层最先构造、最后析构，保证退出时缓冲内容全部写出
+    auto& out = Output::getInstance();
+    
     // 初始化国际化（自动检测语言）
     auto& i18n = I18n::getInstance();
     i18n.init(I18n::Language::AUTO);
     
+    // 解析全局选项（--format=json|tsv|text、--json、--tsv），其余参数按顺序保留
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string formatName;
+        if (arg == "--json") {
+            formatName = "json";
+        } else if (arg == "--tsv") {
+            formatName = "tsv";
+        } else if (arg.compare(0, 9, "--format=") == 0) {
+            formatName = arg.substr(9);
+        } else if (arg == "--format" && i + 1 < argc) {
+            formatName = argv[++i];
+        } else {
+            args.push_back(arg);
+            continue;
+        }
+        
+        OutputFormat format;
+        if (!Output::parseFormat(formatName, format)) {
+            errorOut << T("Error") << ": " << T("Unknown output format") << ": " << formatName << "\n";
+            return 1;
+        }
+        out.setFormat(format);
+    }
+    
     // 检查参数
-    if (argc < 2) {
-        std::cerr << T("Error") << ": " << T("No command specified") << "\n\n";
+    if (args.empty()) {
+        errorOut << T("Error") << ": " << T("No command specified") << "\n\n";
         showHelp();
         return 1;
     }
     
+    // 无需框架的命令（输出常被重定向到文件，不能混入初始化日志）
+    const std::string& command = args[0];
+    if (command == "completion") {
+        std::string script;
+        if (args.size() < 2 || !CompletionIndex::generateScript(args[1], script)) {
+            errorOut << T("Error") << ": " << T("Shell name required") << "\n";
+            errorOut << "  Use: xkl completion <bash|zsh|fish>\n";
+            return 1;
+        }
+        out.write(script);
+        out.flush();
+        return 0;
+    }
+    if (command == "i18n") {
+        if (args.size() < 2) {
+            errorOut << T("Error") << ": " << T("I18n subcommand required") << "\n";
+            errorOut << "  Use: xkl i18n keys   or   xkl i18n compile <source.txt> <output.cat>\n";
+            return 1;
+        }
+        
+        const std::string& subcommand = args[1];
+        if (subcommand == "keys") {
+            cmdI18nKeys();
+        }
+        else if (subcommand == "compile" && args.size() >= 4) {
+            if (!I18n::compileCatalog(args[2].c_str(), args[3].c_str())) {
+                errorOut << T("Error") << ": " << T("Failed to compile catalog") << ": " << args[2] << "\n";
+                return 1;
+            }
+        }
+        else {
+            errorOut << "  Use: xkl i18n keys   or   xkl i18n compile <source.txt> <output.cat>\n";
+            return 1;
+        }
+        out.flush();
+        return 0;
+    }
+    
+    if (command == "logs") {
+        const char* usage = "  Use: xkl logs [--since <time>] [--until <time>] [--level <level[,level]>]\n"
+                            "                [--component <name>] [--follow]\n"
+                            "  <time>: YYYY-MM-DD[ HH:MM[:SS]] or 30m / 12h / 7d ago\n";
+        LogIndex::Query query;
+        bool follow = false;
+        for (size_t i = 1; i < args.size(); ++i) {
+            const std::string& option = args[i];
+            bool hasValue = i + 1 < args.size();
+            if (option == "--follow" || option == "-f") {
+                follow = true;
+            } else if ((option == "--since" || option == "--until") && hasValue) {
+                std::string& stamp = option == "--since" ? query.since : query.until;
+                if (!LogIndex::parseTime(args[++i], option == "--until", stamp)) {
+                    errorOut << T("Error") << ": " << T("Invalid time") << ": " << args[i] << "\n" << usage;
+                    return 1;
+                }
+            } else if (option == "--level" && hasValue) {
+                std::string levels = args[++i];
+                std::replace(levels.begin(), levels.end(), ',', ' ');
+                for (const auto& name : FileUtils::splitFields(levels)) {
+                    unsigned bit = LogIndex::levelBit(name);
+                    if (bit == 0) {
+                        errorOut << T("Error") << ": " << T("Unknown log level") << ": " << name << "\n";
+                        errorOut << "  Valid levels: debug, info, warning, error, success\n";
+                        return 1;
+                    }
+                    query.levels |= bit;
+                }
+            } else if (option == "--component" && hasValue) {
+                query.component = args[++i];
+            } else {
+                errorOut << usage;
+                return 1;
+            }
+        }
+        bool ok = cmdLogs(query, follow);
+        out.flush();
+        return ok ? 0 : 1;
+    }
+    
     // 初始化框架
     auto& engine = CoreEngine::getInstance();
     if (!engine.initialize()) {
-        std::cerr << T("Failed to initialize LinuxStudio Framework") << "\n";
+        errorOut << T("Failed to initialize LinuxStudio Framework") << "\n";
         return 1;
     }
     
-    std::string command = argv[1];
+    bool ok = true;
     
     // 处理命令
     if (command == "help" || command == "--help" || command == "-h") {
@@ -57,125 +261,362 @@ int main(int argc, char* argv[]) {
     }
     else if (command == "init") {
         // 初始化命令 - 静默模式
-        bool quiet = false;
-        if (argc > 2 && std::string(argv[2]) == "--quiet") {
-            quiet = true;
-        }
+        bool quiet = args.size() > 1 && args[1] == "--quiet";
+        
+        // 重建 shell 补全索引
+        CompletionIndex::rebuildStatic();
+        engine.getPluginManager().updateCompletionIndex();
+        engine.getComponentManager().updateCompletionIndex();
         
         if (!quiet) {
             if (I18n::getInstance().isChinese()) {
-                std::cout << "LinuxStudio 框架初始化成功！\n";
+                out << "LinuxStudio 框架初始化成功！\n";
             } else {
-                std::cout << "LinuxStudio Framework initialized successfully!\n";
+                out << "LinuxStudio Framework initialized successfully!\n";
             }
         }
-        return 0;
+        printResult("init", "", true);
     }
     else if (command == "plugin") {
-        if (argc < 3) {
-            std::cerr << T("Error") << ": " << T("Plugin subcommand required") << "\n";
+        if (args.size() < 2) {
+            errorOut << T("Error") << ": " << T("Plugin subcommand required") << "\n";
             return 1;
         }
         
-        std::string subcommand = argv[2];
+        const std::string& subcommand = args[1];
         if (subcommand == "list") {
             cmdPluginList();
         }
-        else if (subcommand == "install") {
-            if (argc < 4) {
-                std::cerr << T("Error") << ": " << T("Plugin name required") << "\n";
-                return 1;
-            }
-            cmdPluginInstall(argv[3]);
+        else if (subcommand == "du") {
+            cmdPluginDu(args.size() > 2 && args[2] == "--refresh");
         }
-        else if (subcommand == "uninstall") {
-            if (argc < 4) {
-                std::cerr << T("Error") << ": " << T("Plugin name required") << "\n";
-                return 1;
+        else if (subcommand == "verify") {
+            std::string name;
+            bool update = false;
+            for (size_t i = 2; i < args.size(); ++i) {
+                if (args[i] == "--update") {
+                    update = true;
+                } else {
+                    name = args[i];
+                }
             }
-            cmdPluginUninstall(argv[3]);
+            ok = cmdPluginVerify(name, update);
         }
-        else if (subcommand == "enable") {
-            if (argc < 4) {
-                std::cerr << T("Error") << ": " << T("Plugin name required") << "\n";
+        else if (subcommand == "install" || subcommand == "uninstall" ||
+                 subcommand == "enable" || subcommand == "disable") {
+            if (args.size() < 3) {
+                errorOut << T("Error") << ": " << T("Plugin name required") << "\n";
                 return 1;
             }
-            cmdPluginEnable(argv[3]);
-        }
-        else if (subcommand == "disable") {
-            if (argc < 4) {
-                std::cerr << T("Error") << ": " << T("Plugin name required") << "\n";
-                return 1;
+            if (subcommand == "install") {
+                ok = cmdPluginInstall(args[2]);
+            } else if (subcommand == "uninstall") {
+                ok = cmdPluginUninstall(args[2]);
+            } else if (subcommand == "enable") {
+                ok = cmdPluginEnable(args[2]);
+            } else {
+                ok = cmdPluginDisable(args[2]);
             }
-            cmdPluginDisable(argv[3]);
         }
         else {
-            std::cerr << T("Error") << ": " << T("Unknown plugin subcommand") << ": " << subcommand << "\n";
+            errorOut << T("Error") << ": " << T("Unknown plugin subcommand") << ": " << subcommand << "\n";
             return 1;
         }
     }
     else if (command == "component") {
-        if (argc < 3) {
-            std::cerr << T("Error") << ": " << T("Component subcommand required") << "\n";
+        if (args.size() < 2) {
+            errorOut << T("Error") << ": " << T("Component subcommand required") << "\n";
             return 1;
         }
         
-        std::string subcommand = argv[2];
+        const std::string& subcommand = args[1];
         if (subcommand == "list") {
             cmdComponentList();
         }
+        else if (subcommand == "du") {
+            cmdComponentDu(args.size() > 2 && args[2] == "--refresh");
+        }
+        else if (subcommand == "search") {
+            if (args.size() < 3) {
+                errorOut << T("Error") << ": " << T("Search keyword required") << "\n";
+                return 1;
+            }
+            cmdComponentSearch(args[2]);
+        }
         else if (subcommand == "install") {
-            if (argc < 4) {
-                std::cerr << T("Error") << ": " << T("Component name required") << "\n";
+            if (args.size() < 3) {
+                errorOut << T("Error") << ": " << T("Component name required") << "\n";
+                return 1;
+            }
+            ok = cmdComponentInstall(args[2]);
+        }
+        else if (subcommand == "uninstall") {
+            if (args.size() < 3) {
+                errorOut << T("Error") << ": " << T("Component name required") << "\n";
+                return 1;
+            }
+            ok = cmdComponentUninstall(args[2]);
+        }
+        else if (subcommand == "build") {
+            std::string name;
+            bool rebuild = false;
+            for (size_t i = 2; i < args.size(); ++i) {
+                if (args[i] == "--rebuild") {
+                    rebuild = true;
+                } else {
+                    name = args[i];
+                }
+            }
+            if (name.empty()) {
+                errorOut << T("Error") << ": " << T("Component name required") << "\n";
                 return 1;
             }
-            cmdComponentInstall(argv[3]);
+            ok = cmdComponentBuild(name, rebuild);
         }
         else {
-            std::cerr << T("Error") << ": " << T("Unknown component subcommand") << ": " << subcommand << "\n";
+            errorOut << T("Error") << ": " << T("Unknown component subcommand") << ": " << subcommand << "\n";
             return 1;
         }
     }
     else if (command == "scene") {
-        if (argc < 3) {
-            std::cerr << T("Error") << ": " << T("Scene subcommand required") << "\n";
-            std::cerr << "  Use: xkl scene list   or   xkl scene apply <scene-name>\n";
+        if (args.size() < 2) {
+            errorOut << T("Error") << ": " << T("Scene subcommand required") << "\n";
+            errorOut << "  Use: xkl scene list | resolve <scene-name> | lock <scene-name> | apply <scene-name> | switch <scene-name> | export <scene-name> --oci <dir>\n";
             return 1;
         }
         
-        std::string subcommand = argv[2];
+        const std::string& subcommand = args[1];
         if (subcommand == "list") {
             cmdSceneList();
         }
-        else if (subcommand == "apply") {
-            if (argc < 4) {
-                std::cerr << T("Error") << ": " << T("Scene name required") << "\n";
-                std::cerr << "  Use: xkl scene apply <scene-name>\n";
-                std::cerr << "  Run 'xkl scene list' to see available scenes\n";
+        else if (subcommand == "resolve") {
+            if (args.size() < 3) {
+                errorOut << T("Error") << ": " << T("Scene name required") << "\n";
+                errorOut << "  Use: xkl scene resolve <scene-name> [--refresh]\n";
+                return 1;
+            }
+            ok = cmdSceneResolve(args[2], args.size() > 3 && args[3] == "--refresh");
+        }
+        else if (subcommand == "lock" || subcommand == "apply") {
+            const char* usage = subcommand == "lock" ? "  Use: xkl scene lock <scene-name> [--file <path>]\n"
+                                                     : "  Use: xkl scene apply <scene-name> [--locked [--file <path>]]\n";
+            if (args.size() < 3) {
+                errorOut << T("Error") << ": " << T("Scene name required") << "\n";
+                errorOut << usage;
+                errorOut << "  Run 'xkl scene list' to see available scenes\n";
+                return 1;
+            }
+            
+            bool locked = false;
+            std::string file;
+            for (size_t i = 3; i < args.size(); ++i) {
+                if (args[i] == "--locked" && subcommand == "apply") {
+                    locked = true;
+                } else if (args[i] == "--file" && i + 1 < args.size()) {
+                    file = args[++i];
+                } else {
+                    errorOut << usage;
+                    return 1;
+                }
+            }
+            
+            if (subcommand == "lock") {
+                ok = cmdSceneLock(args[2], file);
+            } else if (locked) {
+                ok = cmdSceneApplyLocked(args[2], file);
+            } else {
+                ok = cmdSceneApply(args[2]);
+            }
+        }
+        else if (subcommand == "switch") {
+            const char* usage = "  Use: xkl scene switch <scene-name> [--from <scene-name>] [--keep-warm] [--dry-run]\n";
+            if (args.size() < 3) {
+                errorOut << T("Error") << ": " << T("Scene name required") << "\n";
+                errorOut << usage;
+                return 1;
+            }
+            std::string from;
+            bool keepWarm = false;
+            bool dryRun = false;
+            for (size_t i = 3; i < args.size(); ++i) {
+                if (args[i] == "--from" && i + 1 < args.size()) {
+                    from = args[++i];
+                } else if (args[i] == "--keep-warm") {
+                    keepWarm = true;
+                } else if (args[i] == "--dry-run") {
+                    dryRun = true;
+                } else {
+                    errorOut << usage;
+                    return 1;
+                }
+            }
+            ok = cmdSceneSwitch(args[2], from, keepWarm, dryRun);
+        }
+        else if (subcommand == "export") {
+            std::string outDir;
+            bool compress = true;
+            for (size_t i = 3; i < args.size(); ++i) {
+                if (args[i] == "--oci" && i + 1 < args.size()) {
+                    outDir = args[++i];
+                } else if (args[i] == "--no-compress") {
+                    compress = false;
+                } else {
+                    outDir.clear();
+                    break;
+                }
+            }
+            if (args.size() < 3 || outDir.empty()) {
+                errorOut << T("Error") << ": " << T("Scene name required") << "\n";
+                errorOut << "  Use: xkl scene export <scene-name> --oci <dir> [--no-compress]\n";
+                return 1;
+            }
+            ok = cmdSceneExport(args[2], outDir, compress);
+        }
+        else {
+            errorOut << T("Error") << ": " << T("Unknown scene subcommand") << ": " << subcommand << "\n";
+            errorOut << "  Valid subcommands: list, resolve, lock, apply, switch, export\n";
+            return 1;
+        }
+    }
+    else if (command == "bundle") {
+        const char* usage = "  Use: xkl bundle create <scene-name> [-o <file>]\n"
+                            "       xkl bundle apply <file> | list <file>\n";
+        if (args.size() < 3 || (args[1] != "create" && args[1] != "apply" && args[1] != "list")) {
+            errorOut << T("Error") << ": " << T("Bundle subcommand required") << "\n" << usage;
+            return 1;
+        }
+        if (args[1] == "create") {
+            std::string file = args[2] + Bundle::kExtension;
+            if (args.size() == 5 && (args[3] == "-o" || args[3] == "--output")) {
+                file = args[4];
+            } else if (args.size() != 3) {
+                errorOut << usage;
+                return 1;
+            }
+            ok = cmdBundleCreate(args[2], file);
+        } else if (args[1] == "apply") {
+            ok = cmdBundleApply(args[2]);
+        } else {
+            ok = cmdBundleList(args[2]);
+        }
+    }
+    else if (command == "mirror") {
+        if (args.size() < 2 || (args[1] != "rank" && args[1] != "apply")) {
+            errorOut << T("Error") << ": " << T("Mirror subcommand required") << "\n";
+            errorOut << "  Use: xkl mirror rank [apt|pip|ros] [--refresh]   or   xkl mirror apply <apt|pip|ros>\n";
+            return 1;
+        }
+        
+        bool refresh = false;
+        std::vector<MirrorKind> kinds;
+        for (size_t i = 2; i < args.size(); ++i) {
+            MirrorKind kind;
+            if (args[i] == "--refresh") {
+                refresh = true;
+            } else if (MirrorManager::parseKind(args[i], kind)) {
+                kinds.push_back(kind);
+            } else {
+                errorOut << T("Error") << ": " << T("Unknown mirror type") << ": " << args[i] << "\n";
+                return 1;
+            }
+        }
+        
+        if (args[1] == "rank") {
+            if (kinds.empty()) {
+                kinds = {MirrorKind::APT, MirrorKind::PIP, MirrorKind::ROS};
+            }
+            cmdMirrorRank(kinds, refresh);
+        } else {
+            if (kinds.size() != 1) {
+                errorOut << "  Use: xkl mirror apply <apt|pip|ros>\n";
+                return 1;
+            }
+            ok = cmdMirrorApply(kinds[0]);
+        }
+    }
+    else if (command == "repo") {
+        const char* usage = "  Use: xkl repo update [<url>]\n"
+                            "       xkl repo build <source> <output-dir>\n";
+        if (args.size() >= 2 && args[1] == "update" && args.size() <= 3) {
+            ok = cmdRepoUpdate(args.size() == 3 ? args[2] : "");
+        }
+        else if (args.size() == 4 && args[1] == "build") {
+            ok = cmdRepoBuild(args[2], args[3]);
+        }
+        else {
+            errorOut << T("Error") << ": " << T("Repository subcommand required") << "\n" << usage;
+            return 1;
+        }
+    }
+    else if (command == "queue") {
+        const char* usage = "  Use: xkl queue add <component|plugin|scene> <name>\n"
+                            "       xkl queue list | remove <id> | run\n";
+        InstallQueue::Kind kind;
+        if (args.size() == 4 && args[1] == "add" && InstallQueue::parseKind(args[2], kind)) {
+            ok = cmdQueueAdd(kind, args[3]);
+        }
+        else if (args.size() == 2 && args[1] == "list") {
+            cmdQueueList();
+        }
+        else if (args.size() == 3 && args[1] == "remove") {
+            ok = cmdQueueRemove(args[2]);
+        }
+        else if (args.size() == 2 && args[1] == "run") {
+            ok = cmdQueueRun();
+        }
+        else {
+            errorOut << T("Error") << ": " << T("Queue subcommand required") << "\n" << usage;
+            return 1;
+        }
+    }
+    else if (command == "watch") {
+        ok = cmdWatch();
+    }
+    else if (command == "python") {
+        const char* usage = "  Use: xkl python env create <name> <plugin|requirement...>\n"
+                            "       xkl python env list | remove <name>\n"
+                            "       xkl python gc\n";
+        if (args.size() >= 2 && args[1] == "gc") {
+            cmdPythonGc();
+        }
+        else if (args.size() >= 3 && args[1] == "env" && args[2] == "list") {
+            cmdPythonEnvList();
+        }
+        else if (args.size() >= 3 && args[1] == "env" &&
+                 (args[2] == "create" || args[2] == "remove")) {
+            if (args.size() < 4 || (args[2] == "create" && args.size() < 5)) {
+                errorOut << T("Error") << ": " << T("Environment name required") << "\n" << usage;
                 return 1;
             }
-            cmdSceneApply(argv[3]);
+            if (args[2] == "create") {
+                ok = cmdPythonEnvCreate(args[3], std::vector<std::string>(args.begin() + 4, args.end()));
+            } else {
+                ok = cmdPythonEnvRemove(args[3]);
+            }
         }
         else {
-            std::cerr << T("Error") << ": " << T("Unknown scene subcommand") << ": " << subcommand << "\n";
-            std::cerr << "  Valid subcommands: list, apply\n";
+            errorOut << T("Error") << ": " << T("Python subcommand required") << "\n" << usage;
             return 1;
         }
     }
     else {
-        std::cerr << T("Error") << ": " << T("Unknown command") << ": " << command << "\n\n";
+        errorOut << T("Error") << ": " << T("Unknown command") << ": " << command << "\n\n";
         showHelp();
         return 1;
     }
     
-    return 0;
+    if (ResourceSlice::getInstance().used()) {
+        printResourceUsage();
+    }
+    out.flush();
+    return ok ? 0 : 1;
 }
 
 void showHelp() {
     auto& i18n = I18n::getInstance();
     
     if (i18n.isChinese()) {
-        std::cout << R"(LinuxStudio CLI v1.1.1 (C++ 核心)
+        Output::getInstance().write(R"(LinuxStudio CLI v1.1.1 (C++ 核心)
 高性能 Linux 环境管理器
 
 用法: xkl <命令> [选项]
@@ -185,12 +626,17 @@ void showHelp() {
   init                初始化 LinuxStudio 框架
   status              显示框架状态
   update              更新 LinuxStudio 框架
+  watch               监视插件目录与系统软件包，增量刷新注册表
+  logs [--since <时间>] [--until <时间>] [--level <级别>] [--component <名称>] [--follow]
+                      按条件查询全部日志分段（借助索引跳过无关分段），--follow 持续跟随
 
 组件管理:
   component list                    列出已安装的组件
   component search <关键词>         搜索组件
   component install <名称>          安装组件
   component uninstall <名称>        卸载组件
+  component du [--refresh]          统计组件磁盘占用
+  component build <配方> [--rebuild] 从源码构建组件（编译缓存与构件缓存）
 
 插件管理:
   plugin list                       列出已安装的插件
@@ -198,24 +644,63 @@ void showHelp() {
   plugin uninstall <名称>           卸载插件
   plugin enable <名称>              启用插件
   plugin disable <名称>             禁用插件
+  plugin du [--refresh]             统计插件磁盘占用
+  plugin verify [名称] [--update]   按哈希清单校验插件文件（--update 重新记录）
 
 场景管理:
   scene list                        列出可用场景
-  scene apply <名称>                应用开发场景
+  scene resolve <名称> [--refresh]  解析场景依赖（安装顺序、冲突）
+  scene lock <名称> [--file <路径>] 锁定场景的确切版本与摘要
+  scene apply <名称> [--locked]     应用开发场景（--locked 按锁文件安装，不再解析）
+  scene switch <名称> [--from <场景>] [--keep-warm] [--dry-run]
+                                    切换场景：只安装缺少的包，卸载离开的场景独有的包
+  scene export <名称> --oci <目录>  把场景安装的文件导出为 OCI 镜像（--no-compress 不压缩）
+
+后台安装队列:
+  queue add <component|plugin|scene> <名称>
+                                    加入队列，系统空闲（PSI 与负载低于阈值）时再安装
+  queue list                        列出队列中的任务与当前系统压力
+  queue remove <编号>               删除未在运行的任务
+  queue run                         运行调度进程：按压力启动、暂停与恢复任务（队列跨重启保留）
+
+离线安装:
+  bundle create <场景> [-o <文件>]  把场景的 .deb、wheel 与插件文件打成一个离线包
+  bundle apply <文件>               在无网络的设备上按离线包安装（逐层解压，不整包解开）
+  bundle list <文件>                列出离线包成员
+
+镜像源:
+  mirror rank [apt|pip|ros]         测速并列出镜像排名（--refresh 忽略缓存）
+  mirror apply <apt|pip|ros>        将系统配置切换到最快的镜像
+
+场景仓库:
+  repo update [地址]                增量更新场景与插件索引（只下载变化的块，默认地址取 repository_url）
+  repo build <源文件> <目录>        把仓库文本源编译成索引与块校验文件
+
+Python 环境:
+  python env create <名称> <插件|依赖...>  创建共享 wheel 仓库的 venv
+  python env list                   列出 Python 环境
+  python env remove <名称>          删除 Python 环境
+  python gc                         回收未被引用的 wheel
 
 其他命令:
+  completion <bash|zsh|fish>        输出 shell 补全脚本
+  i18n keys                         导出翻译模板（key<TAB>译文）
+  i18n compile <源文件> <输出.cat>  编译翻译目录文件
   help                显示此帮助信息
   version             显示版本信息
 
+全局选项:
+  --format=<json|tsv|text>          输出格式（--json / --tsv 为简写）
+
 示例:
   xkl status
   xkl plugin install ros2
   xkl scene apply robotics
 
 更多信息，请访问: https://docs.linuxstudio.org
-)" << std::endl;
+)" "\n");
     } else {
-        std::cout << R"(LinuxStudio CLI v1.1.1 (C++ Core)
+        Output::getInstance().write(R"(LinuxStudio CLI v1.1.1 (C++ Core)
 High-Performance Linux Environment Manager
 
 Usage: xkl <command> [options]
@@ -225,12 +710,17 @@ Framework Commands:
   init                Initialize LinuxStudio framework
   status              Show framework status
   update              Update LinuxStudio framework
+  watch               Watch plugins and system packages, refresh the registry incrementally
+  logs [--since <time>] [--until <time>] [--level <level>] [--component <name>] [--follow]
+                      Query all log segments (indexed, skips unrelated ones); --follow keeps tailing
 
 Component Management:
   component list                    List installed components
   component search <keyword>        Search for components
   component install <name>          Install a component
   component uninstall <name>        Uninstall a component
+  component du [--refresh]          Show component disk usage
+  component build <recipe> [--rebuild] Build a component from source (compiler and artifact cache)
 
 Plugin Management:
   plugin list                       List installed plugins
@@ -238,322 +728,2199 @@ Plugin Management:
   plugin uninstall <name>           Uninstall a plugin
   plugin enable <name>              Enable a plugin
   plugin disable <name>             Disable a plugin
+  plugin du [--refresh]             Show plugin disk usage
+  plugin verify [name] [--update]   Verify plugin files against their hash manifest (--update re-records)
 
 Scene Management:
   scene list                        List available scenes
-  scene apply <name>                Apply a development scene
+  scene resolve <name> [--refresh]  Resolve scene dependencies (order, conflicts)
+  scene lock <name> [--file <path>] Lock exact package and wheel versions with digests
+  scene apply <name> [--locked]     Apply a development scene (--locked installs from the lock file)
+  scene switch <name> [--from <scene>] [--keep-warm] [--dry-run]
+                                    Switch scenes: install only what is missing, remove what only the old scene used
+  scene export <name> --oci <dir>   Export files installed by the scene as an OCI image (--no-compress)
+
+Background Install Queue:
+  queue add <component|plugin|scene> <name>
+                                    Queue an install to run when the system is idle (PSI and load below thresholds)
+  queue list                        List queued jobs and the current system pressure
+  queue remove <id>                 Remove a job that is not running
+  queue run                         Run the scheduler: start, pause and resume jobs by pressure (queue survives reboots)
+
+Offline Install:
+  bundle create <scene> [-o <file>] Pack a scene's debs, wheels and plugin files into one bundle
+  bundle apply <file>               Install from a bundle without network (streams members, no full unpack)
+  bundle list <file>                List bundle members
+
+Mirrors:
+  mirror rank [apt|pip|ros]         Probe and rank mirrors (--refresh ignores the cache)
+  mirror apply <apt|pip|ros>        Switch system configuration to the fastest mirror
+
+Scene Repository:
+  repo update [url]                 Delta-update the scene and plugin index (fetches changed blocks only; default repository_url)
+  repo build <source> <dir>         Compile a repository source into the index and its block checksums
+
+Python Environments:
+  python env create <name> <plugin|requirement...>  Create a venv backed by the shared wheel store
+  python env list                   List Python environments
+  python env remove <name>          Remove a Python environment
+  python gc                         Reclaim wheels no environment references
 
 Other Commands:
+  completion <bash|zsh|fish>        Print a shell completion script
+  i18n keys                         Export a translation template (key<TAB>text)
+  i18n compile <source> <out.cat>   Compile a translation catalog file
   help                Show this help message
   version             Show version information
 
+Global Options:
+  --format=<json|tsv|text>          Output format (--json / --tsv for short)
+
 Examples:
   xkl status
   xkl plugin install ros2
   xkl scene apply robotics
 
 For more information, visit: https://docs.linuxstudio.org
-)" << std::endl;
+)" "\n");
     }
 }
 
 void showVersion() {
     auto& engine = CoreEngine::getInstance();
-    std::cout << "LinuxStudio Framework v" << engine.getVersion() << " (C++ Core)\n";
-    std::cout << "Copyright (c) 2025 Dino Studio\n";
-    std::cout << "Built with C++17\n";
+    auto& out = Output::getInstance();
+    
+    out << "LinuxStudio Framework v" << engine.getVersion() << " (C++ Core)\n";
+    out << "Copyright (c) 2025 Dino Studio\n";
+    out << "Built with C++17\n";
+    
+    out.beginObject();
+    out.field("command", "version");
+    out.field("version", engine.getVersion());
+    out.field("core", "C++17");
+    out.endObject();
+}
+
+/**
+ * @brief 输出操作类命令的结构化结果
+ */
+void printResult(const std::string& command, const std::string& name, bool success) {
+    auto& out = Output::getInstance();
+    out.beginObject();
+    out.field("command", command);
+    if (!name.empty()) {
+        out.field("name", name);
+    }
+    out.field("success", success);
+    out.endObject();
+}
+
+void printResourceUsage() {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    ResourceSlice::Usage usage = ResourceSlice::getInstance().usage();
+    std::string jobs = std::string(T("build jobs")) + " " + std::to_string(usage.jobs);
+    if (!usage.isolated) {
+        logger.warning(std::string(T("cgroup v2 unavailable, install commands ran at low priority")) + "; " + jobs);
+        return;
+    }
+    
+    std::string limits;
+    for (const auto& limit : usage.applied) {
+        limits += (limits.empty() ? "" : ", ") + limit;
+    }
+    logger.info(std::string(T("Install limits")) + ": " + (limits.empty() ? "-" : limits) + "; " + jobs);
+    
+    char text[256];
+    std::snprintf(text, sizeof(text), "CPU %.1fs (%llu/%llu), memory.high %llu, PSI memory %.1fs / io %.1fs",
+                  usage.throttledSeconds, static_cast<unsigned long long>(usage.throttledPeriods),
+                  static_cast<unsigned long long>(usage.periods), static_cast<unsigned long long>(usage.memoryHighEvents),
+                  usage.memoryStallSeconds, usage.ioStallSeconds);
+    std::string throttled = text;
+    if (usage.memoryPeak > 0) {
+        throttled += ", " + std::string(T("peak")) + " " + DiskUsage::formatBytes(usage.memoryPeak);
+    }
+    logger.info(std::string(T("Throttled")) + ": " + throttled);
 }
 
 void cmdStatus() {
     auto& engine = CoreEngine::getInstance();
     auto& logger = engine.getLogger();
     const auto& sysInfo = engine.getSystemInfo();
-    auto& i18n = I18n::getInstance();
+    MemoryFootprint footprint = engine.getMemoryFootprint();
+    auto& out = Output::getInstance();
     
-    std::cout << "\n";
+    out << "\n";
     logger.info(T("LinuxStudio Framework Status"));
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << T("Version") << ":        " << engine.getVersion() << " (C++ Core)\n";
-    std::cout << T("Install Path") << ":   /opt/linuxstudio\n";
-    std::cout << "\n";
-    std::cout << T("System Information") << ":\n";
-    std::cout << "  " << T("OS") << ":           " << sysInfo.osName << "\n";
-    std::cout << "  " << T("Version") << ":      " << sysInfo.osVersion << "\n";
-    std::cout << "  " << T("Architecture") << ": " << sysInfo.architecture << "\n";
-    std::cout << "  " << T("CPU Cores") << ":    " << sysInfo.cpuCores << "\n";
-    std::cout << "  " << T("Memory") << ":       " << sysInfo.totalMemory << " MB (";
-    std::cout << sysInfo.availableMemory << " " << T("MB available") << ")\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "\n";
+    out << kRule;
+    out << T("Version") << ":        " << engine.getVersion() << " (C++ Core)\n";
+    out << T("Install Path") << ":   /opt/linuxstudio\n";
+    out << "\n";
+    out << T("System Information") << ":\n";
+    out << "  " << T("OS") << ":           " << sysInfo.osName << "\n";
+    out << "  " << T("Version") << ":      " << sysInfo.osVersion << "\n";
+    out << "  " << T("Architecture") << ": " << sysInfo.architecture << "\n";
+    out << "  " << T("CPU Cores") << ":    " << sysInfo.cpuCores << "\n";
+    out << "  " << T("Memory") << ":       " << sysInfo.totalMemory << " MB (";
+    out << sysInfo.availableMemory << " " << T("MB available") << ")\n";
+    out << "\n";
+    out << T("Process Footprint") << ":\n";
+    out << "  RSS:          " << DiskUsage::formatBytes(footprint.rssKB * 1024) << " (";
+    out << T("peak") << " " << DiskUsage::formatBytes(footprint.peakRssKB * 1024) << ")\n";
+    out << "  " << T("Binary") << ":       " << DiskUsage::formatBytes(footprint.binaryBytes) << "\n";
+    if (footprint.embedded) {
+        out << "  " << T("Budget") << ":       ";
+        out << (footprint.budgetMB > 0 ? std::to_string(footprint.budgetMB) + " MB" : std::string("-"));
+        out << " (" << T("embedded build") << ")\n";
+    }
+    out << kRule;
+    out << "\n";
+    
+    out.beginObject();
+    out.field("command", "status");
+    out.field("version", engine.getVersion());
+    out.field("installPath", "/opt/linuxstudio");
+    out.beginObject("system");
+    out.field("os", sysInfo.osName);
+    out.field("osVersion", sysInfo.osVersion);
+    out.field("architecture", sysInfo.architecture);
+    out.field("cpuCores", sysInfo.cpuCores);
+    out.field("totalMemoryMB", sysInfo.totalMemory);
+    out.field("availableMemoryMB", sysInfo.availableMemory);
+    out.endObject();
+    out.beginObject("memory");
+    out.field("rssKB", footprint.rssKB);
+    out.field("peakRssKB", footprint.peakRssKB);
+    out.field("binaryBytes", footprint.binaryBytes);
+    out.field("budgetMB", footprint.budgetMB);
+    out.field("embedded", footprint.embedded);
+    out.endObject();
+    out.endObject();
 }
 
 void cmdPluginList() {
     auto& engine = CoreEngine::getInstance();
     auto& pluginMgr = engine.getPluginManager();
     auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
     
-    auto plugins = pluginMgr.listInstalled();
+    out.beginObject();
+    out.field("command", "plugin.list");
+    out.beginList("plugins", {"name", "version", "enabled", "installedAt"});
     
-    std::cout << "\n";
+    out << "\n";
     logger.info(T("Installed Plugins"));
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+    out << kRule;
     
-    if (plugins.empty()) {
+    // 逐条渲染，插件再多也不会整体复制列表
+    size_t count = 0;
+    pluginMgr.forEachInstalled([&](const Plugin& plugin) {
+        ++count;
+        
+        out.beginRow();
+        out.field("name", plugin.name);
+        out.field("version", plugin.version);
+        out.field("enabled", plugin.enabled);
+        out.field("installedAt", plugin.installedAt);
+        out.endRow();
+        
+        std::string status = plugin.enabled ? "✅ " : "⚪ ";
+        std::string enabledStr = plugin.enabled ? 
+            ("(" + std::string(T("enabled")) + ")") : 
+            ("(" + std::string(T("disabled")) + ")");
+        out << "  " << status << plugin.name << " " << enabledStr << "\n";
+    });
+    
+    out.endList();
+    out.endObject();
+    
+    if (count == 0) {
         logger.warning(T("No plugins installed yet."));
-        std::cout << "\n";
+        out << "\n";
         logger.info(T("Available plugins:"));
         if (I18n::getInstance().isChinese()) {
-            std::cout << "  • ros2           - 机器人操作系统 2\n";
-            std::cout << "  • robot-arm      - 机械臂控制库\n";
-            std::cout << "  • opencv         - 计算机视觉库\n";
-            std::cout << "  • pytorch        - 深度学习框架\n";
-            std::cout << "  • tensorflow     - 机器学习框架\n";
-            std::cout << "  • cuda-toolkit   - NVIDIA CUDA 开发工具包\n";
+            out << "  • ros2           - 机器人操作系统 2\n";
+            out << "  • robot-arm      - 机械臂控制库\n";
+            out << "  • opencv         - 计算机视觉库\n";
+            out << "  • pytorch        - 深度学习框架\n";
+            out << "  • tensorflow     - 机器学习框架\n";
+            out << "  • cuda-toolkit   - NVIDIA CUDA 开发工具包\n";
         } else {
-            std::cout << "  • ros2           - Robot Operating System 2\n";
-            std::cout << "  • robot-arm      - Robot arm control libraries\n";
-            std::cout << "  • opencv         - Computer vision library\n";
-            std::cout << "  • pytorch        - Deep learning framework\n";
-            std::cout << "  • tensorflow     - Machine learning framework\n";
-            std::cout << "  • cuda-toolkit   - NVIDIA CUDA development kit\n";
-        }
-        std::cout << "\n";
+            out << "  • ros2           - Robot Operating System 2\n";
+            out << "  • robot-arm      - Robot arm control libraries\n";
+            out << "  • opencv         - Computer vision library\n";
+            out << "  • pytorch        - Deep learning framework\n";
+            out << "  • tensorflow     - Machine learning framework\n";
+            out << "  • cuda-toolkit   - NVIDIA CUDA development kit\n";
+        }
+        out << "\n";
         if (I18n::getInstance().isChinese()) {
             logger.info("安装插件: sudo xkl plugin install <名称>");
         } else {
             logger.info("Install a plugin: sudo xkl plugin install <name>");
         }
-    } else {
-        for (const auto& plugin : plugins) {
-            std::string status = plugin.enabled ? "✅ " : "⚪ ";
-            std::string enabledStr = plugin.enabled ? 
-                ("(" + std::string(T("enabled")) + ")") : 
-                ("(" + std::string(T("disabled")) + ")");
-            std::cout << "  " << status << plugin.name << " " << enabledStr << "\n";
-        }
     }
     
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "\n";
+    out << kRule;
+    out << "\n";
 }
 
-void cmdPluginInstall(const std::string& name) {
+bool cmdPluginInstall(const std::string& name) {
     auto& engine = CoreEngine::getInstance();
     auto& pluginMgr = engine.getPluginManager();
+    auto& out = Output::getInstance();
     
-    if (pluginMgr.install(name)) {
-        std::cout << "\n";
+    bool success = pluginMgr.install(name);
+    if (success) {
+        out << "\n";
         if (I18n::getInstance().isChinese()) {
-            std::cout << "插件 '" << name << "' " << T("installed successfully") << "!\n";
-            std::cout << T("Manage") << ": xkl plugin [enable|disable] " << name << "\n";
+            out << "插件 '" << name << "' " << T("installed successfully") << "!\n";
         } else {
-            std::cout << "Plugin '" << name << "' " << T("installed successfully") << "!\n";
-            std::cout << T("Manage") << ": xkl plugin [enable|disable] " << name << "\n";
+            out << "Plugin '" << name << "' " << T("installed successfully") << "!\n";
         }
-        std::cout << "\n";
+        out << T("Manage") << ": xkl plugin [enable|disable] " << name << "\n";
+        out << "\n";
     }
+    printResult("plugin.install", name, success);
+    return success;
 }
 
-void cmdPluginUninstall(const std::string& name) {
+bool cmdPluginUninstall(const std::string& name) {
     auto& pluginMgr = CoreEngine::getInstance().getPluginManager();
-    pluginMgr.uninstall(name);
+    std::uint64_t reclaimed = 0;
+    bool success = pluginMgr.uninstall(name, &reclaimed);
+    
+    auto& out = Output::getInstance();
+    out.beginObject();
+    out.field("command", "plugin.uninstall");
+    out.field("name", name);
+    out.field("success", success);
+    out.field("reclaimedBytes", static_cast<long long>(reclaimed));
+    out.endObject();
+    return success;
 }
 
-void cmdPluginEnable(const std::string& name) {
+bool cmdPluginEnable(const std::string& name) {
     auto& pluginMgr = CoreEngine::getInstance().getPluginManager();
-    pluginMgr.enable(name);
+    bool success = pluginMgr.enable(name);
+    printResult("plugin.enable", name, success);
+    return success;
 }
 
-void cmdPluginDisable(const std::string& name) {
+bool cmdPluginDisable(const std::string& name) {
     auto& pluginMgr = CoreEngine::getInstance().getPluginManager();
-    pluginMgr.disable(name);
+    bool success = pluginMgr.disable(name);
+    printResult("plugin.disable", name, success);
+    return success;
 }
 
-void cmdComponentList() {
-    auto& logger = CoreEngine::getInstance().getLogger();
+void cmdPluginDu(bool refresh) {
+    auto& engine = CoreEngine::getInstance();
+    auto& pluginMgr = engine.getPluginManager();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
     
-    std::cout << "\n";
-    logger.info(T("Installed Components"));
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-    logger.warning(T("Component listing not yet implemented"));
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "\n";
+    out << "\n";
+    logger.info(T("Plugin Disk Usage"));
+    out << kRule;
+    
+    out.beginObject();
+    out.field("command", "plugin.du");
+    out.beginList("plugins", {"name", "bytes", "fileBytes", "packageBytes", "packages"});
+    
+    DiskUsage usage(DiskUsage::kDefaultCachePath, refresh);
+    std::uint64_t total = 0;
+    size_t count = 0;
+    pluginMgr.forEachInstalled([&](const Plugin& plugin) {
+        ++count;
+        PluginFootprint footprint = pluginMgr.diskUsage(plugin.name, usage);
+        std::uint64_t bytes = footprint.files.bytes + footprint.packages.bytes;
+        total += bytes;
+        
+        out.beginRow();
+        out.field("name", plugin.name);
+        out.field("bytes", static_cast<long long>(bytes));
+        out.field("fileBytes", static_cast<long long>(footprint.files.bytes));
+        out.field("packageBytes", static_cast<long long>(footprint.packages.bytes));
+        out.field("packages", static_cast<long long>(footprint.packageCount));
+        out.endRow();
+        
+        std::string padded = plugin.name;
+        padded.resize(17, ' ');
+        std::string size = DiskUsage::formatBytes(bytes);
+        size.resize(11, ' ');
+        out << "  " << padded << size << "(" << footprint.packageCount << " " << T("packages") << ")\n";
+    });
+    
+    out.endList();
+    out.field("totalBytes", static_cast<long long>(total));
+    out.endObject();
+    usage.save();
+    
+    if (count == 0) {
+        logger.warning(T("No plugins installed yet."));
+    } else {
+        out << "  " << T("Total") << ": " << DiskUsage::formatBytes(total) << "\n";
+    }
+    out << kRule;
+    out << "\n";
 }
 
-void cmdComponentInstall(const std::string& name) {
-    auto& logger = CoreEngine::getInstance().getLogger();
-    auto& i18n = I18n::getInstance();
+bool cmdPluginVerify(const std::string& name, bool update) {
+    auto& engine = CoreEngine::getInstance();
+    auto& pluginMgr = engine.getPluginManager();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
     
-    if (i18n.isChinese()) {
-        logger.info("正在安装组件: " + name);
-        logger.warning("组件安装功能尚未在 C++ 版本中实现");
+    std::vector<std::string> names;
+    if (!name.empty()) {
+        if (!pluginMgr.isInstalled(name)) {
+            logger.error(std::string(T("Plugin not installed")) + ": " + name);
+            printResult("plugin.verify", name, false);
+            return false;
+        }
+        names.push_back(name);
     } else {
-        logger.info("Installing component: " + name);
-        logger.warning("Component installation not yet implemented in C++ version");
+        pluginMgr.forEachInstalled([&names](const Plugin& plugin) {
+            names.push_back(plugin.name);
+        });
+    }
+    
+    out << "\n";
+    logger.info(T("Plugin Integrity"));
+    out << kRule;
+    
+    out.beginObject();
+    out.field("command", "plugin.verify");
+    out.beginList("plugins", {"name", "status", "files", "bytes", "milliseconds"});
+    
+    bool ok = true;
+    std::vector<std::pair<std::string, Manifest::Mismatch>> mismatches;
+    for (const auto& plugin : names) {
+        std::string padded = plugin;
+        padded.resize(17, ' ');
+        
+        out.beginRow();
+        out.field("name", plugin);
+        if (update) {
+            std::size_t entries = 0;
+            bool recorded = pluginMgr.recordManifest(plugin, &entries);
+            ok = ok && recorded;
+            out.field("status", recorded ? "recorded" : "failed");
+            out.field("files", static_cast<long long>(entries));
+            out << "  " << (recorded ? "📝 " : "❌ ") << padded << entries << " " << T("files") << "\n";
+            out.endRow();
+            continue;
+        }
+        
+        Manifest::Report report;
+        if (!pluginMgr.verify(plugin, report)) {
+            ok = false;
+            out.field("status", "no-manifest");
+            out << "  ⚠️  " << padded << T("No manifest") << " (xkl plugin verify --update " << plugin << ")\n";
+            out.endRow();
+            continue;
+        }
+        
+        ok = ok && report.ok();
+        out.field("status", report.ok() ? "ok" : "mismatch");
+        out.field("files", static_cast<long long>(report.files));
+        out.field("bytes", static_cast<long long>(report.bytes));
+        out.field("milliseconds", static_cast<long long>(report.seconds * 1000));
+        out.endRow();
+        
+        std::string size = DiskUsage::formatBytes(report.bytes);
+        size.resize(11, ' ');
+        std::string rate = report.seconds > 0
+            ? DiskUsage::formatBytes(static_cast<std::uint64_t>(report.bytes / report.seconds)) + "/s"
+            : std::string();
+        out << "  " << (report.ok() ? "✅ " : "❌ ") << padded << report.files << " " << T("files") << "  "
+            << size << rate << "\n";
+        for (const auto& mismatch : report.mismatches) {
+            out << "       " << mismatch.reason << "  " << mismatch.path << "\n";
+            mismatches.emplace_back(plugin, mismatch);
+        }
+    }
+    out.endList();
+    
+    out.beginList("mismatches", {"plugin", "reason", "path"});
+    for (const auto& entry : mismatches) {
+        out.beginRow();
+        out.field("plugin", entry.first);
+        out.field("reason", entry.second.reason);
+        out.field("path", entry.second.path);
+        out.endRow();
+    }
+    out.endList();
+    out.field("success", ok);
+    out.endObject();
+    
+    if (names.empty()) {
+        logger.warning(T("No plugins installed yet."));
+    } else if (!mismatches.empty()) {
+        out << "  " << mismatches.size() << " " << T("mismatched files") << "\n";
     }
+    out << kRule;
+    out << "\n";
+    return ok;
 }
 
-void cmdSceneList() {
-    auto& logger = CoreEngine::getInstance().getLogger();
-    auto& i18n = I18n::getInstance();
+void cmdComponentList() {
+    auto& engine = CoreEngine::getInstance();
+    auto& componentMgr = engine.getComponentManager();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
     
-    std::cout << "\n";
-    if (i18n.isChinese()) {
-        logger.info("可用场景");
-        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-        std::cout << "  1) web-development  - Web 开发\n";
-        std::cout << "     Nginx, PHP, Java, MySQL, Redis, Node.js\n";
-        std::cout << "\n";
-        std::cout << "  2) embedded         - 嵌入式开发\n";
-        std::cout << "     ARM/RISC-V GCC, OpenOCD, GDB\n";
-        std::cout << "\n";
-        std::cout << "  3) robotics         - 机器人开发\n";
-        std::cout << "     ROS2, MoveIt2, Gazebo, OpenCV\n";
-        std::cout << "\n";
-        std::cout << "  4) ai-ml            - AI/ML 开发\n";
-        std::cout << "     Python, Jupyter, TensorFlow, PyTorch\n";
-        std::cout << "\n";
-        std::cout << "  5) game-dev         - 游戏开发\n";
-        std::cout << "     SDL2, OpenGL, Vulkan, Godot\n";
-        std::cout << "\n";
-        std::cout << "  6) devops           - DevOps\n";
-        std::cout << "     Docker, Kubernetes, Jenkins, Prometheus\n";
-        std::cout << "\n";
-        std::cout << "  7) security         - 网络安全\n";
-        std::cout << "     Nmap, Wireshark, Metasploit\n";
-        std::cout << "\n";
-        std::cout << "  8) blockchain       - 区块链开发\n";
-        std::cout << "     Hardhat, Solidity, Web3.js\n";
-        std::cout << "\n";
-        std::cout << "  9) iot              - 物联网开发\n";
-        std::cout << "     Mosquitto, Node-RED, InfluxDB\n";
-    } else {
-        logger.info("Available Scenes");
-        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-        std::cout << "  1) web-development  - Web Development\n";
-        std::cout << "     Nginx, PHP, Java, MySQL, Redis, Node.js\n";
-        std::cout << "\n";
-        std::cout << "  2) embedded         - Embedded Systems\n";
-        std::cout << "     ARM/RISC-V GCC, OpenOCD, GDB\n";
-        std::cout << "\n";
-        std::cout << "  3) robotics         - Robotics\n";
-        std::cout << "     ROS2, MoveIt2, Gazebo, OpenCV\n";
-        std::cout << "\n";
-        std::cout << "  4) ai-ml            - AI/ML Development\n";
-        std::cout << "     Python, Jupyter, TensorFlow, PyTorch\n";
-        std::cout << "\n";
-        std::cout << "  5) game-dev         - Game Development\n";
-        std::cout << "     SDL2, OpenGL, Vulkan, Godot\n";
-        std::cout << "\n";
-        std::cout << "  6) devops           - DevOps\n";
-        std::cout << "     Docker, Kubernetes, Jenkins, Prometheus\n";
-        std::cout << "\n";
-        std::cout << "  7) security         - Security\n";
-        std::cout << "     Nmap, Wireshark, Metasploit\n";
-        std::cout << "\n";
-        std::cout << "  8) blockchain       - Blockchain\n";
-        std::cout << "     Hardhat, Solidity, Web3.js\n";
-        std::cout << "\n";
-        std::cout << "  9) iot              - IoT Development\n";
-        std::cout << "     Mosquitto, Node-RED, InfluxDB\n";
-    }
-    std::cout << "\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "\n";
-    if (i18n.isChinese()) {
-        logger.info("应用场景: xkl scene apply <场景名>");
-    } else {
-        logger.info("Apply scene: xkl scene apply <scene-name>");
+    out << "\n";
+    logger.info(T("Installed Components"));
+    out << kRule;
+    
+    out.beginObject();
+    out.field("command", "component.list");
+    out.beginList("components", {"name", "version", "description"});
+    
+    size_t count = 0;
+    componentMgr.forEachInstalled([&](const Component& comp) {
+        ++count;
+        
+        out.beginRow();
+        out.field("name", comp.name);
+        out.field("version", comp.version);
+        out.field("description", comp.description);
+        out.endRow();
+        
+        out << "  ✅ " << comp.name;
+        if (!comp.version.empty()) {
+            out << " (" << comp.version << ")";
+        }
+        out << "\n";
+    });
+    
+    out.endList();
+    out.endObject();
+    
+    if (count == 0) {
+        logger.warning(T("No components installed yet."));
     }
-    std::cout << "\n";
+    out << kRule;
+    out << "\n";
 }
 
-void cmdSceneApply(const std::string& name) {
+void cmdComponentSearch(const std::string& keyword) {
     auto& engine = CoreEngine::getInstance();
     auto& logger = engine.getLogger();
-    auto& i18n = I18n::getInstance();
+    auto& out = Output::getInstance();
     
-    // 场景到组件的映射
-    std::map<std::string, std::vector<std::string>> sceneComponents = {
-        {"web-development", {"nginx", "php", "java", "mysql", "redis", "nodejs"}},
-        {"embedded", {"gcc-arm", "openocd", "gdb", "minicom", "i2c-tools", "spi-tools"}},
-        {"robotics", {"ros2", "opencv", "gazebo", "moveit2"}},
-        {"ai-ml", {"python", "jupyter", "tensorflow", "pytorch", "opencv"}},
-        {"game-dev", {"sdl2", "opengl", "vulkan", "godot"}},
-        {"devops", {"docker", "kubernetes", "jenkins", "prometheus", "grafana"}},
-        {"security", {"nmap", "wireshark", "metasploit"}},
-        {"blockchain", {"hardhat", "web3js", "solidity", "ipfs"}},
-        {"iot", {"mosquitto", "node-red", "influxdb", "grafana"}}
-    };
+    out << "\n";
+    logger.info(std::string(T("Component Search")) + ": " + keyword);
+    out << kRule;
     
-    // 场景显示名称
-    std::map<std::string, std::pair<std::string, std::string>> sceneNames = {
-        {"web-development", {"Web 开发", "Web Development"}},
-        {"embedded", {"嵌入式开发", "Embedded Systems"}},
-        {"robotics", {"机器人开发", "Robotics"}},
-        {"ai-ml", {"AI/ML 开发", "AI/ML Development"}},
-        {"game-dev", {"游戏开发", "Game Development"}},
-        {"devops", {"DevOps", "DevOps"}},
-        {"security", {"网络安全", "Security"}},
-        {"blockchain", {"区块链开发", "Blockchain Development"}},
-        {"iot", {"物联网开发", "IoT Development"}}
-    };
+    out.beginObject();
+    out.field("command", "component.search");
+    out.field("keyword", keyword);
+    out.beginList("components", {"name", "version", "installed", "description"});
     
-    auto sceneIt = sceneComponents.find(name);
-    if (sceneIt == sceneComponents.end()) {
-        if (i18n.isChinese()) {
-            logger.error("未知的场景: " + name);
-            std::cout << "\n";
-            logger.info("运行 'xkl scene list' 查看可用场景");
-        } else {
-            logger.error("Unknown scene: " + name);
-            std::cout << "\n";
-            logger.info("Run 'xkl scene list' to see available scenes");
+    // 视图直接指向目录映像，输出时才转换为字符串
+    std::vector<ComponentView> matches = engine.getComponentManager().search(keyword);
+    for (const auto& comp : matches) {
+        out.beginRow();
+        out.field("name", std::string(comp.name()));
+        out.field("version", std::string(comp.version()));
+        out.field("installed", comp.installed());
+        out.field("description", std::string(comp.description()));
+        out.endRow();
+        
+        out << "  " << (comp.installed() ? "✅ " : "⚪ ") << comp.name();
+        if (!comp.description().empty()) {
+            out << " - " << comp.description();
         }
-        return;
+        out << "\n";
     }
     
-    auto nameIt = sceneNames.find(name);
-    std::string displayName = i18n.isChinese() ? nameIt->second.first : nameIt->second.second;
+    out.endList();
+    out.endObject();
     
-    std::cout << "\n";
-    if (i18n.isChinese()) {
-        logger.info("正在应用场景: " + displayName);
-        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-        std::cout << "\n";
-        std::cout << "此场景包含以下组件:\n";
+    if (matches.empty()) {
+        logger.warning(T("No matching components found."));
     } else {
-        logger.info("Applying scene: " + displayName);
-        std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-        std::cout << "\n";
-        std::cout << "This scene includes the following components:\n";
+        out << "\n  " << matches.size() << " " << T("matches") << "\n";
     }
+    out << kRule;
+    out << "\n";
+}
+
+bool cmdComponentInstall(const std::string& name) {
+    // 发行版没有该软件包时由 ComponentManager 改用源码配方构建
+    bool success = CoreEngine::getInstance().getComponentManager().install(name);
+    printResult("component.install", name, success);
+    return success;
+}
+
+bool cmdComponentUninstall(const std::string& name) {
+    bool success = CoreEngine::getInstance().getComponentManager().uninstall(name);
+    printResult("component.uninstall", name, success);
+    return success;
+}
+
+void cmdComponentDu(bool refresh) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
     
-    const auto& components = sceneIt->second;
-    for (size_t i = 0; i < components.size(); ++i) {
-        std::cout << "  " << (i + 1) << ") " << components[i] << "\n";
+    out << "\n";
+    logger.info(T("Component Disk Usage"));
+    out << kRule;
+    
+    // 组件即系统软件包，一次性交给统计器并行处理
+    std::vector<std::string> names;
+    engine.getComponentManager().forEachInstalled([&names](const Component& comp) {
+        names.push_back(comp.name);
+    });
+    DiskUsage usage(DiskUsage::kDefaultCachePath, refresh);
+    std::map<std::string, DiskUsage::Totals> sizes = usage.measurePackages(names);
+    usage.save();
+    
+    out.beginObject();
+    out.field("command", "component.du");
+    out.beginList("components", {"name", "bytes", "files"});
+    
+    std::uint64_t total = 0;
+    for (const auto& name : names) {
+        const DiskUsage::Totals& totals = sizes[name];
+        total += totals.bytes;
+        
+        out.beginRow();
+        out.field("name", name);
+        out.field("bytes", static_cast<long long>(totals.bytes));
+        out.field("files", static_cast<long long>(totals.files));
+        out.endRow();
+        
+        std::string padded = name;
+        padded.resize(25, ' ');
+        out << "  " << padded << DiskUsage::formatBytes(totals.bytes) << "\n";
     }
     
-    std::cout << "\n";
-    if (i18n.isChinese()) {
-        logger.info("注意: 组件安装功能仍在开发中");
-        logger.info("请手动安装所需的组件，或等待后续版本更新");
-        std::cout << "\n";
-        std::cout << "当前可用的操作:\n";
-        std::cout << "  • xkl component list       # 列出已安装的组件\n";
-        std::cout << "  • xkl plugin list          # 列出已安装的插件\n";
-        std::cout << "  • xkl status               # 查看系统状态\n";
+    out.endList();
+    out.field("totalBytes", static_cast<long long>(total));
+    out.endObject();
+    
+    if (names.empty()) {
+        logger.warning(T("No components installed yet."));
     } else {
-        logger.info("Note: Component installation is still under development");
-        logger.info("Please install required components manually, or wait for future updates");
-        std::cout << "\n";
-        std::cout << "Available operations:\n";
-        std::cout << "  • xkl component list       # List installed components\n";
-        std::cout << "  • xkl plugin list          # List installed plugins\n";
-        std::cout << "  • xkl status               # Check system status\n";
+        out << "  " << T("Total") << ": " << DiskUsage::formatBytes(total) << "\n";
     }
+    out << kRule;
+    out << "\n";
+}
+
+bool cmdComponentBuild(const std::string& name, bool rebuild) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
+    
+    SourceBuilder::Report report;
+    bool success = engine.getComponentManager().build(name, rebuild, report);
+    
+    out.beginObject();
+    out.field("command", "component.build");
+    out.field("name", name);
+    out.field("success", success);
+    out.field("cacheHit", report.cacheHit);
+    out.field("artifact", report.artifact);
+    out.field("jobs", static_cast<long long>(report.jobs));
+    out.field("linkJobs", static_cast<long long>(report.linkJobs));
+    out.field("ccache", report.ccache);
+    out.field("failedStep", report.failedStep);
+    out.field("milliseconds", static_cast<long long>(report.seconds * 1000));
+    out.endObject();
+    
+    if (!report.cacheHit && !report.key.empty()) {
+        if (!report.ccache) {
+            logger.warning(T("ccache not found, building without compiler cache"));
+        }
+        logger.info(std::string(T("compile jobs")) + " " + std::to_string(report.jobs) + ", " +
+                    T("link jobs") + " " + std::to_string(report.linkJobs));
+    }
+    if (success) {
+        char seconds[32];
+        std::snprintf(seconds, sizeof(seconds), "%.1fs", report.seconds);
+        logger.info(std::string(report.cacheHit ? T("Build cache hit") : T("Build finished")) + " (" + seconds + ")");
+    }
+    return success;
+}
+
+void cmdSceneList() {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    auto& i18n = I18n::getInstance();
+    auto& out = Output::getInstance();
+    const auto& scenes = availableScenes();
+    SceneState state;
+    state.load();
+    
+    out << "\n";
+    logger.info(i18n.isChinese() ? "可用场景" : "Available Scenes");
+    out << kRule;
+    
+    out.beginObject();
+    out.field("command", "scene.list");
+    out.beginList("scenes", {"name", "title", "components", "active"});
+    
+    for (size_t i = 0; i < scenes.size(); ++i) {
+        const auto& scene = scenes[i];
+        const std::string& title = i18n.isChinese() ? scene.titleZh : scene.titleEn;
+        bool active = state.active.count(scene.name) > 0;
+        
+        out.beginRow();
+        out.field("name", scene.name);
+        out.field("title", title);
+        out.field("components", scene.components);
+        out.field("active", active);
+        out.endRow();
+        
+        std::string padded = scene.name;
+        padded.resize(17, ' ');
+        out << "  " << (i + 1) << ") " << padded << "- " << title;
+        if (active) {
+            out << "  [" << T("current") << "]";
+        }
+        out << "\n";
+        out << "     " << scene.highlights << "\n";
+        if (i + 1 < scenes.size()) {
+            out << "\n";
+        }
+    }
+    
+    out.endList();
+    out.endObject();
+    
+    out << "\n";
+    out << kRule;
+    out << "\n";
+    if (i18n.isChinese()) {
+        logger.info("应用场景: xkl scene apply <场景名>");
+    } else {
+        logger.info("Apply scene: xkl scene apply <scene-name>");
+    }
+    out << "\n";
+}
+
+namespace {
+
+/**
+ * @brief 查找场景，找不到时输出提示
+ */
+const SceneDefinition* requireScene(const std::string& name, const char* command) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    auto& out = Output::getInstance();
+    
+    const SceneDefinition* scene = findScene(name);
+    if (scene == nullptr) {
+        if (I18n::getInstance().isChinese()) {
+            logger.error("未知的场景: " + name);
+            out << "\n";
+            logger.info("运行 'xkl scene list' 查看可用场景");
+        } else {
+            logger.error("Unknown scene: " + name);
+            out << "\n";
+            logger.info("Run 'xkl scene list' to see available scenes");
+        }
+        printResult(command, name, false);
+    }
+    return scene;
+}
+
+/**
+ * @brief 场景组件对应的系统软件包
+ */
+std::vector<std::string> scenePackages(const SceneDefinition& scene) {
+    std::vector<std::string> packages;
+    for (const auto& component : scene.components) {
+        packages.push_back(scenePackageName(component));
+    }
+    return packages;
+}
+
+/**
+ * @brief 单行显示包名列表，过长时截断
+ */
+std::string summarizeNames(const std::vector<std::string>& names, size_t limit = 8) {
+    std::string line;
+    for (size_t i = 0; i < names.size() && i < limit; ++i) {
+        line += (i > 0 ? " " : "") + names[i];
+    }
+    if (names.size() > limit) {
+        line += " … +" + std::to_string(names.size() - limit);
+    }
+    return line;
+}
+
+/**
+ * @brief 锁定场景：软件包的完整闭包，以及系统软件源中没有的 Python 插件的 wheel 集合
+ * @param missing 输出既不在软件源中、也不是 Python 插件的组件
+ */
+bool lockScene(const SceneDefinition& scene, SceneLock& lock, Resolution& plan, std::vector<std::string>& missing) {
+    auto& engine = CoreEngine::getInstance();
+    lock.scene = scene.name;
+    if (!engine.getComponentManager().lockPackages(scenePackages(scene), lock, plan)) {
+        return false;
+    }
+    for (const auto& component : scene.components) {
+        std::string package = scenePackageName(component);
+        if (!std::binary_search(plan.missing.begin(), plan.missing.end(), package)) {
+            continue;
+        }
+        if (!PluginManager::isPythonPlugin(component)) {
+            missing.push_back(package);
+            continue;
+        }
+        std::vector<std::string> wheels;
+        if (!engine.getPluginManager().lockWheels(component, wheels)) {
+            return false;
+        }
+        lock.wheels[component] = wheels;
+    }
+    return true;
+}
+
+/**
+ * @brief wheel 集合项（文件名#sha256=摘要）中的摘要
+ */
+std::string wheelDigest(const std::string& wheel) {
+    size_t pos = wheel.rfind("#sha256=");
+    return pos == std::string::npos ? std::string() : wheel.substr(pos + 8);
+}
+
+} // namespace
+
+void printPlan(const Resolution& plan) {
+    auto& out = Output::getInstance();
+    
+    out << "  " << T("Closure") << ": " << plan.closureSize << " " << T("packages") << " (";
+    out << plan.installedCount << " " << T("installed") << ")";
+    if (plan.fromCache) {
+        out << " [" << T("cached") << "]";
+    }
+    out << "\n";
+    if (plan.pendingCount() == 0) {
+        out << "  " << T("Nothing to install") << "\n";
+    } else {
+        out << "  " << T("To install") << ": " << plan.pendingCount() << " " << T("packages") << ", ";
+        out << plan.levels.size() << " " << T("levels") << "\n";
+        for (size_t i = 0; i < plan.levels.size(); ++i) {
+            out << "    [" << (i + 1) << "] " << summarizeNames(plan.levels[i]) << "\n";
+        }
+    }
+    if (!plan.missing.empty()) {
+        out << "  ⚠️  " << T("Missing") << ": " << summarizeNames(plan.missing, 16) << "\n";
+    }
+    for (const auto& cycle : plan.cycles) {
+        out << "  🔁 " << T("Dependency cycles") << ": " << summarizeNames(cycle) << "\n";
+    }
+    for (const auto& conflict : plan.conflicts) {
+        out << "  ❌ " << T("Conflicts") << ": " << conflict.first << " ↔ " << conflict.second << "\n";
+    }
+    
+    out.field("closureSize", static_cast<long long>(plan.closureSize));
+    out.field("installedCount", static_cast<long long>(plan.installedCount));
+    out.field("pendingCount", static_cast<long long>(plan.pendingCount()));
+    out.field("fromCache", plan.fromCache);
+    out.field("missing", plan.missing);
+    out.beginList("levels", {"level", "packages"});
+    for (size_t i = 0; i < plan.levels.size(); ++i) {
+        out.beginRow();
+        out.field("level", static_cast<long long>(i + 1));
+        out.field("packages", plan.levels[i]);
+        out.endRow();
+    }
+    out.endList();
+    out.beginList("cycles", {"packages"});
+    for (const auto& cycle : plan.cycles) {
+        out.beginRow();
+        out.field("packages", cycle);
+        out.endRow();
+    }
+    out.endList();
+    out.beginList("conflicts", {"package", "conflictsWith"});
+    for (const auto& conflict : plan.conflicts) {
+        out.beginRow();
+        out.field("package", conflict.first);
+        out.field("conflictsWith", conflict.second);
+        out.endRow();
+    }
+    out.endList();
+}
+
+bool cmdSceneResolve(const std::string& name, bool refresh) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& i18n = I18n::getInstance();
+    auto& out = Output::getInstance();
+    
+    const SceneDefinition* scene = requireScene(name, "scene.resolve");
+    if (scene == nullptr) {
+        return false;
+    }
+    std::string displayName = i18n.isChinese() ? scene->titleZh : scene->titleEn;
+    
+    out << "\n";
+    logger.info(std::string(T("Dependency Plan")) + ": " + displayName);
+    out << kRule;
+    
+    Resolution plan = engine.getComponentManager().resolve(scenePackages(*scene), refresh);
+    
+    out.beginObject();
+    out.field("command", "scene.resolve");
+    out.field("scene", scene->name);
+    out.field("roots", plan.roots);
+    printPlan(plan);
+    out.field("success", plan.conflicts.empty());
+    out.endObject();
+    
+    out << kRule;
+    out << "\n";
+    return plan.conflicts.empty();
+}
+
+bool cmdSceneApply(const std::string& name) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& i18n = I18n::getInstance();
+    auto& out = Output::getInstance();
+    
+    const SceneDefinition* scene = requireScene(name, "scene.apply");
+    if (scene == nullptr) {
+        return false;
+    }
+    
+    std::string displayName = i18n.isChinese() ? scene->titleZh : scene->titleEn;
+    
+    out << "\n";
+    if (i18n.isChinese()) {
+        logger.info("正在应用场景: " + displayName);
+        out << kRule;
+        out << "\n";
+        out << "此场景包含以下组件:\n";
+    } else {
+        logger.info("Applying scene: " + displayName);
+        out << kRule;
+        out << "\n";
+        out << "This scene includes the following components:\n";
+    }
+    
+    const auto& components = scene->components;
+    for (size_t i = 0; i < components.size(); ++i) {
+        out << "  " << (i + 1) << ") " << components[i] << "\n";
+    }
+    out << "\n";
+    
+    // 先解析完整依赖：有冲突时不动系统；目录中没有的组件（npm、pip 等来源）跳过并提示
+    auto& componentMgr = engine.getComponentManager();
+    Resolution plan = componentMgr.resolve(scenePackages(*scene));
+    
+    out.beginObject();
+    out.field("command", "scene.apply");
+    out.field("scene", scene->name);
+    out.field("title", displayName);
+    out.field("components", scene->components);
+    printPlan(plan);
+    out << "\n";
+    
+    bool success = componentMgr.installPlan(plan);
+    out.field("success", success);
+    out.endObject();
+    
+    // 记录本次事务安装的包，供 xkl scene export 与 scene switch 使用
+    if (success && plan.pendingCount() > 0) {
+        SceneRecord record;
+        for (const auto& level : plan.levels) {
+            record.packages.insert(level.begin(), level.end());
+        }
+        record.merge(scene->name);
+    }
+    if (success) {
+        SceneState::activate(scene->name);
+    }
+    
+    if (success && !plan.missing.empty()) {
+        if (i18n.isChinese()) {
+            logger.warning("以下组件不在系统软件源中，请手动安装: " + summarizeNames(plan.missing, 16));
+        } else {
+            logger.warning("Not available from system repositories, install manually: " +
+                           summarizeNames(plan.missing, 16));
+        }
+    } else if (success) {
+        logger.success(displayName);
+    }
+    
+    out << kRule;
+    out << "\n";
+    return success;
+}
+
+bool cmdSceneSwitch(const std::string& name, const std::string& from, bool keepWarm, bool dryRun) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& i18n = I18n::getInstance();
+    auto& out = Output::getInstance();
+    
+    const SceneDefinition* scene = requireScene(name, "scene.switch");
+    if (scene == nullptr || (!from.empty() && requireScene(from, "scene.switch") == nullptr)) {
+        return false;
+    }
+    std::string displayName = i18n.isChinese() ? scene->titleZh : scene->titleEn;
+    
+    // 指定 --from 时只离开该场景，否则新场景替换当前所有场景
+    SceneState state;
+    state.load();
+    SceneSwitch change(state, scene->name, from);
+    
+    out << "\n";
+    logger.info(std::string(T("Switching scene")) + ": " +
+                (change.leaving.empty() ? "-" : summarizeNames(std::vector<std::string>(change.leaving.begin(),
+                                                                                        change.leaving.end()))) +
+                " → " + displayName);
+    out << kRule;
+    
+    // 切换后仍需要的包：所有保留场景的完整闭包（含已安装的包）
+    auto& componentMgr = engine.getComponentManager();
+    std::vector<std::string> roots;
+    for (const auto& active : change.staying) {
+        if (const SceneDefinition* definition = findScene(active)) {
+            std::vector<std::string> packages = scenePackages(*definition);
+            roots.insert(roots.end(), packages.begin(), packages.end());
+        }
+    }
+    Resolution closure = componentMgr.resolve(roots, false, true);
+    std::set<std::string> needed(roots.begin(), roots.end());
+    for (const auto& level : closure.levels) {
+        needed.insert(level.begin(), level.end());
+    }
+    change.classify(state, needed);
+    const std::vector<std::string>& shared = change.shared;
+    const std::vector<std::string>& orphans = change.orphans;
+    
+    // 新场景只安装缺少的包，共用的组件（如 opencv）已安装，不在计划中
+    Resolution plan = componentMgr.resolve(scenePackages(*scene));
+    
+    out.beginObject();
+    out.field("command", "scene.switch");
+    out.field("scene", scene->name);
+    out.field("from", std::vector<std::string>(change.leaving.begin(), change.leaving.end()));
+    out.field("dryRun", dryRun);
+    printPlan(plan);
+    if (!shared.empty()) {
+        out << "  " << T("Shared, kept") << ": " << summarizeNames(shared, 16) << "\n";
+    }
+    if (!orphans.empty()) {
+        out << "  " << (keepWarm ? T("Kept warm") : T("To remove")) << ": " << summarizeNames(orphans, 16) << "\n";
+    }
+    out << "\n";
+    out.field("shared", shared);
+    out.field("orphans", orphans);
+    out.field("keepWarm", keepWarm);
+    
+    if (dryRun) {
+        out.field("success", plan.conflicts.empty());
+        out.endObject();
+        out << kRule;
+        out << "\n";
+        return plan.conflicts.empty();
+    }
+    
+    // 先装后卸：安装失败时原场景保持完整
+    bool success = componentMgr.installPlan(plan);
+    std::vector<std::string> removed;
+    if (success) {
+        SceneRecord record;
+        for (const auto& level : plan.levels) {
+            record.packages.insert(level.begin(), level.end());
+        }
+        // 共用的包改记到新场景名下，之后再从新场景切走时才能正确卸载
+        record.packages.insert(shared.begin(), shared.end());
+        record.merge(scene->name);
+        
+        if (!keepWarm) {
+            success = componentMgr.removeUnused(orphans, removed);
+        }
+        std::vector<std::string> required = change.finish(state, removed, keepWarm, success);
+        if (!removed.empty()) {
+            out << "  " << T("Removed") << ": " << summarizeNames(removed, 16) << "\n";
+        }
+        if (!required.empty()) {
+            out << "  " << T("Still required, kept") << ": " << summarizeNames(required, 16) << "\n";
+        }
+    }
+    out.field("removed", removed);
+    out.field("success", success);
+    out.endObject();
+    
+    if (success) {
+        logger.success(displayName);
+    }
+    out << kRule;
+    out << "\n";
+    return success;
+}
+
+bool cmdSceneLock(const std::string& name, const std::string& file) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& i18n = I18n::getInstance();
+    auto& out = Output::getInstance();
+    
+    const SceneDefinition* scene = requireScene(name, "scene.lock");
+    if (scene == nullptr) {
+        return false;
+    }
+    std::string displayName = i18n.isChinese() ? scene->titleZh : scene->titleEn;
+    std::string path = file.empty() ? SceneLock::defaultPath(scene->name) : file;
+    
+    out << "\n";
+    logger.info(std::string(T("Scene Lock")) + ": " + displayName);
+    out << kRule;
+    
+    SceneLock lock;
+    Resolution plan;
+    std::vector<std::string> missing;
+    bool success = lockScene(*scene, lock, plan, missing) && lock.save(path);
+    
+    size_t unverified = 0;
+    for (const auto& package : lock.packages) {
+        unverified += package.sha256.empty() ? 1 : 0;
+    }
+    
+    out.beginObject();
+    out.field("command", "scene.lock");
+    out.field("scene", scene->name);
+    out.field("file", path);
+    out.field("levels", static_cast<long long>(lock.levelCount()));
+    out.beginList("packages", {"level", "name", "version", "sha256", "root"});
+    for (const auto& package : lock.packages) {
+        out.beginRow();
+        out.field("level", static_cast<long long>(package.level + 1));
+        out.field("name", package.name);
+        out.field("version", package.version);
+        out.field("sha256", package.sha256);
+        out.field("root", package.root);
+        out.endRow();
+    }
+    out.endList();
+    out.beginList("plugins", {"name", "wheels"});
+    for (const auto& plugin : lock.wheels) {
+        out.beginRow();
+        out.field("name", plugin.first);
+        out.field("wheels", plugin.second);
+        out.endRow();
+    }
+    out.endList();
+    out.field("missing", missing);
+    out.field("success", success);
+    out.endObject();
+    
+    for (const auto& conflict : plan.conflicts) {
+        out << "  ❌ " << T("Conflicts") << ": " << conflict.first << " ↔ " << conflict.second << "\n";
+    }
+    if (success) {
+        out << "  " << T("Lock file") << ": " << path << "\n";
+        out << "  " << lock.packages.size() << " " << T("packages") << ", " << lock.levelCount() << " " << T("levels");
+        if (unverified > 0) {
+            out << " (" << unverified << " " << T("without digest") << ")";
+        }
+        out << "\n";
+        for (const auto& plugin : lock.wheels) {
+            out << "  🐍 " << plugin.first << ": " << plugin.second.size() << " wheels\n";
+        }
+        if (!missing.empty()) {
+            out << "  ⚠️  " << T("Missing") << ": " << summarizeNames(missing, 16) << "\n";
+        }
+        logger.success(displayName);
+    }
+    
+    out << kRule;
+    out << "\n";
+    return success;
+}
+
+bool cmdSceneApplyLocked(const std::string& name, const std::string& file) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& i18n = I18n::getInstance();
+    auto& out = Output::getInstance();
+    
+    const SceneDefinition* scene = requireScene(name, "scene.apply");
+    if (scene == nullptr) {
+        return false;
+    }
+    std::string displayName = i18n.isChinese() ? scene->titleZh : scene->titleEn;
+    std::string path = file.empty() ? SceneLock::defaultPath(scene->name) : file;
+    
+    SceneLock lock;
+    if (!lock.load(path) || lock.scene != scene->name) {
+        logger.error(std::string(T("Lock file not found")) + ": " + path);
+        out << "\n";
+        logger.info("xkl scene lock " + scene->name);
+        printResult("scene.apply", name, false);
+        return false;
+    }
+    
+    out << "\n";
+    logger.info(std::string(i18n.isChinese() ? "正在应用场景: " : "Applying scene: ") + displayName +
+                " [" + T("Lock file") + "]");
+    out << kRule;
     
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "\n";
+    // 不解析依赖：锁文件已给出完整闭包、安装顺序与摘要
+    SceneLock::Report report;
+    bool success = engine.getComponentManager().installLocked(lock, report);
+    
+    std::vector<std::string> rebuilt;
+    for (const auto& plugin : lock.wheels) {
+        bool changed = false;
+        if (!success || !engine.getPluginManager().installLocked(plugin.first, plugin.second, &changed)) {
+            success = false;
+            break;
+        }
+        if (changed) {
+            rebuilt.push_back(plugin.first);
+        }
+    }
+    
+    if (!report.installed.empty() || !rebuilt.empty()) {
+        SceneRecord record;
+        record.packages.insert(report.installed.begin(), report.installed.end());
+        record.plugins.insert(rebuilt.begin(), rebuilt.end());
+        record.merge(scene->name);
+    }
+    if (success) {
+        SceneState::activate(scene->name);
+    }
+    
+    out << "  " << T("Satisfied") << ": " << report.satisfied << ", " << T("From cache") << ": " << report.cached
+        << ", " << T("Downloaded") << ": " << report.downloaded << "\n";
+    if (!report.drifted.empty()) {
+        out << "  ⚠️  " << T("Version drift") << ": " << summarizeNames(report.drifted, 4) << "\n";
+    }
+    if (!report.mismatched.empty()) {
+        out << "  ❌ " << T("Digest mismatch") << ": " << summarizeNames(report.mismatched, 16) << "\n";
+    }
+    for (const auto& plugin : lock.wheels) {
+        bool changed = std::find(rebuilt.begin(), rebuilt.end(), plugin.first) != rebuilt.end();
+        out << "  🐍 " << plugin.first << ": " << plugin.second.size() << " wheels"
+            << (changed ? "" : std::string(" (") + T("Satisfied") + ")") << "\n";
+    }
+    
+    out.beginObject();
+    out.field("command", "scene.apply");
+    out.field("scene", scene->name);
+    out.field("file", path);
+    out.field("locked", true);
+    out.field("satisfied", static_cast<long long>(report.satisfied));
+    out.field("cached", static_cast<long long>(report.cached));
+    out.field("downloaded", static_cast<long long>(report.downloaded));
+    out.field("drifted", report.drifted);
+    out.field("mismatched", report.mismatched);
+    out.field("pluginsInstalled", rebuilt);
+    out.field("success", success);
+    out.endObject();
+    
+    if (success) {
+        logger.success(displayName);
+    }
+    out << kRule;
+    out << "\n";
+    return success;
 }
 
+bool cmdSceneExport(const std::string& name, const std::string& outDir, bool compress) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& i18n = I18n::getInstance();
+    auto& out = Output::getInstance();
+    
+    const SceneDefinition* scene = requireScene(name, "scene.export");
+    if (scene == nullptr) {
+        return false;
+    }
+    std::string displayName = i18n.isChinese() ? scene->titleZh : scene->titleEn;
+    
+    SceneRecord record;
+    if (!record.load(scene->name) || (record.packages.empty() && record.plugins.empty())) {
+        logger.error(std::string(T("Nothing recorded for this scene")) + ": " + scene->name);
+        out << "\n";
+        logger.info("xkl scene apply " + scene->name);
+        printResult("scene.export", name, false);
+        return false;
+    }
+    
+    out << "\n";
+    logger.info(std::string(T("OCI Export")) + ": " + displayName);
+    out << kRule;
+    
+    // 只收录场景事务新增的内容：软件包登记的路径与 dpkg 元数据、Python 插件的目录与环境
+    OciImageWriter writer(outDir);
+    DiskUsage usage;
+    std::vector<std::string> gone;
+    for (const auto& package : record.packages) {
+        std::vector<std::string> paths = usage.packageContents(package);
+        if (paths.empty()) {
+            gone.push_back(package);  // 应用之后又被卸载
+        }
+        for (const auto& path : paths) {
+            writer.addPath(path);
+        }
+    }
+    if (gone.size() < record.packages.size()) {
+        writer.addPath(RegistryWatcher::dpkgStatusPath());
+    }
+    auto& pluginMgr = engine.getPluginManager();
+    for (const auto& plugin : record.plugins) {
+        if (!pluginMgr.isInstalled(plugin)) {
+            gone.push_back(plugin);
+            continue;
+        }
+        writer.addTree(pluginMgr.pluginsPath() + "/" + plugin);
+        writer.addTree(engine.getPythonEnvManager().envPath(plugin));
+    }
+    
+    if (compress && !OciImageWriter::compressionAvailable()) {
+        logger.warning("Built without zlib, writing an uncompressed layer");
+    }
+    OciImageWriter::Options options;
+    options.compress = compress;
+    options.reference = scene->name;
+    OciImageWriter::Report report;
+    bool success = writer.write(options, report);
+    
+    out.beginObject();
+    out.field("command", "scene.export");
+    out.field("scene", scene->name);
+    out.field("directory", outDir);
+    out.field("manifest", report.manifestDigest);
+    out.field("layer", report.layerDigest);
+    out.field("files", static_cast<long long>(report.files));
+    out.field("deduplicated", static_cast<long long>(report.deduplicated));
+    out.field("directories", static_cast<long long>(report.directories));
+    out.field("symlinks", static_cast<long long>(report.symlinks));
+    out.field("tarBytes", static_cast<long long>(report.tarBytes));
+    out.field("layerBytes", static_cast<long long>(report.blobBytes));
+    out.field("milliseconds", static_cast<long long>(report.seconds * 1000));
+    out.field("missing", gone);
+    out.field("success", success);
+    out.endObject();
+    
+    if (success) {
+        out << "  " << T("Image") << ": " << outDir << " (" << scene->name << ")\n";
+        out << "  " << T("Layer") << ": " << report.layerDigest.substr(0, 19) << "  "
+            << DiskUsage::formatBytes(report.blobBytes) << " / " << DiskUsage::formatBytes(report.tarBytes) << "\n";
+        out << "  " << report.files << " " << T("files") << ", " << report.deduplicated << " " << T("deduplicated")
+            << ", " << report.directories << " " << T("directories") << ", " << report.symlinks << " " << T("symlinks") << "\n";
+        if (report.seconds > 0) {
+            char rate[64];
+            std::snprintf(rate, sizeof(rate), "%.2fs, %.0f MB/s", report.seconds,
+                          report.tarBytes / report.seconds / (1024.0 * 1024.0));
+            out << "  " << rate << "\n";
+        }
+        if (!gone.empty()) {
+            out << "  ⚠️  " << T("No longer installed") << ": " << summarizeNames(gone, 16) << "\n";
+        }
+        logger.success(displayName);
+    } else {
+        logger.error(std::string(T("OCI export failed")) + ": " + outDir);
+    }
+    
+    out << kRule;
+    out << "\n";
+    return success;
+}
+
+bool cmdBundleCreate(const std::string& name, const std::string& file) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& i18n = I18n::getInstance();
+    auto& out = Output::getInstance();
+    
+    const SceneDefinition* scene = requireScene(name, "bundle.create");
+    if (scene == nullptr) {
+        return false;
+    }
+    std::string displayName = i18n.isChinese() ? scene->titleZh : scene->titleEn;
+    
+    out << "\n";
+    logger.info(std::string(T("Offline Bundle")) + ": " + displayName);
+    out << kRule;
+    
+    // 目标设备上什么都可能没装：锁定完整闭包，本机已安装的包也要取到 .deb
+    SceneLock lock;
+    Resolution plan;
+    std::vector<std::string> missing;
+    SceneLock::Report fetched;
+    std::vector<std::string> paths;
+    bool success = lockScene(*scene, lock, plan, missing) &&
+                   engine.getComponentManager().fetchLocked(lock, paths, fetched);
+    
+    Bundle bundle;
+    auto& python = engine.getPythonEnvManager();
+    auto& pluginMgr = engine.getPluginManager();
+    size_t wheelCount = 0;
+    size_t payloadCount = 0;
+    for (size_t i = 0; success && i < lock.packages.size(); ++i) {
+        bundle.add("deb/" + lock.packages[i].name + "=" + lock.packages[i].version, paths[i]);
+    }
+    for (const auto& plugin : lock.wheels) {
+        if (!success || !python.fetch(plugin.second)) {
+            success = false;
+            break;
+        }
+        for (const auto& wheel : plugin.second) {
+            bundle.add("wheel/" + wheelDigest(wheel), python.wheelPath(wheel));
+            ++wheelCount;
+        }
+        for (const auto& payload : pluginMgr.payloadFiles(plugin.first)) {
+            bundle.add("plugin/" + plugin.first + "/" + payload, pluginMgr.pluginsPath() + "/" + plugin.first + "/" + payload);
+            ++payloadCount;
+        }
+    }
+    
+    // 锁文件随包分发，应用时据此确定安装顺序与摘要
+    std::string lockPath = file + ".lock.tmp";
+    Bundle::Report report;
+    if (success) {
+        success = lock.save(lockPath);
+        bundle.add("scene.lock", lockPath);
+    }
+    if (success) {
+        logger.info("Compressing " + std::to_string(lock.packages.size() + wheelCount + payloadCount + 1) +
+                    " members (" + Bundle::codecName(Bundle::defaultCodec()) + ")...");
+        success = bundle.write(file, report);
+    }
+    unlink(lockPath.c_str());
+    
+    out.beginObject();
+    out.field("command", "bundle.create");
+    out.field("scene", scene->name);
+    out.field("file", file);
+    out.field("codec", Bundle::codecName(Bundle::defaultCodec()));
+    out.field("packages", static_cast<long long>(lock.packages.size()));
+    out.field("wheels", static_cast<long long>(wheelCount));
+    out.field("payloads", static_cast<long long>(payloadCount));
+    out.field("downloaded", static_cast<long long>(fetched.downloaded));
+    out.field("bytes", static_cast<long long>(report.bytes));
+    out.field("bundleBytes", static_cast<long long>(report.stored));
+    out.field("milliseconds", static_cast<long long>(report.seconds * 1000));
+    out.field("missing", missing);
+    out.field("success", success);
+    out.endObject();
+    
+    for (const auto& conflict : plan.conflicts) {
+        out << "  ❌ " << T("Conflicts") << ": " << conflict.first << " ↔ " << conflict.second << "\n";
+    }
+    if (!fetched.mismatched.empty()) {
+        out << "  ❌ " << T("Digest mismatch") << ": " << summarizeNames(fetched.mismatched, 16) << "\n";
+    }
+    if (success) {
+        out << "  " << T("Bundle") << ": " << file << "\n";
+        out << "  " << lock.packages.size() << " " << T("packages") << ", " << wheelCount << " wheels, "
+            << payloadCount << " " << T("files") << "  " << DiskUsage::formatBytes(report.stored) << " / "
+            << DiskUsage::formatBytes(report.bytes) << "\n";
+        if (!missing.empty()) {
+            out << "  ⚠️  " << T("Missing") << ": " << summarizeNames(missing, 16) << "\n";
+        }
+        logger.success(displayName);
+    } else {
+        logger.error(std::string(T("Failed to create bundle")) + ": " + file);
+    }
+    
+    out << kRule;
+    out << "\n";
+    return success;
+}
+
+bool cmdBundleApply(const std::string& file) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& i18n = I18n::getInstance();
+    auto& out = Output::getInstance();
+    
+    Bundle bundle;
+    SceneLock lock;
+    std::string content;
+    const Bundle::Entry* lockEntry = nullptr;
+    if (!bundle.open(file) || (lockEntry = bundle.find("scene.lock")) == nullptr ||
+        !bundle.read(*lockEntry, content) || !lock.parse(content)) {
+        logger.error(std::string(T("Not a valid bundle")) + ": " + file);
+        printResult("bundle.apply", file, false);
+        return false;
+    }
+    const SceneDefinition* scene = requireScene(lock.scene, "bundle.apply");
+    if (scene == nullptr) {
+        return false;
+    }
+    std::string displayName = i18n.isChinese() ? scene->titleZh : scene->titleEn;
+    
+    out << "\n";
+    logger.info(std::string(i18n.isChinese() ? "正在应用场景: " : "Applying scene: ") + displayName +
+                " [" + T("Bundle") + "]");
+    out << kRule;
+    
+    // .deb 逐层解压到暂存目录、装完即删；wheel 与插件文件直接解压到最终位置。
+    // 包文件本身只被映射，任何时候都不需要整包解开的空间
+    auto fromBundle = [&bundle](const SceneLock::Package& package, const std::string& path) {
+        const Bundle::Entry* entry = bundle.find("deb/" + package.name + "=" + package.version);
+        return entry != nullptr && (package.sha256.empty() || Bundle::digest(*entry) == package.sha256) &&
+               bundle.extract(*entry, path);
+    };
+    SceneLock::Report report;
+    bool success = engine.getComponentManager().installLocked(lock, report, fromBundle);
+    
+    auto& pluginMgr = engine.getPluginManager();
+    auto& python = engine.getPythonEnvManager();
+    std::vector<std::string> rebuilt;
+    for (const auto& plugin : lock.wheels) {
+        std::vector<std::uint8_t> imported(plugin.second.size(), 0);
+        FileUtils::parallelFor(success ? plugin.second.size() : 0, [&](size_t i) {
+            std::string digest = wheelDigest(plugin.second[i]);
+            imported[i] = python.importWheel(plugin.second[i], [&](const std::string& path) {
+                const Bundle::Entry* entry = bundle.find("wheel/" + digest);
+                return entry != nullptr && Bundle::digest(*entry) == digest && bundle.extract(*entry, path);
+            });
+        });
+        if (std::count(imported.begin(), imported.end(), 0) > 0) {
+            success = false;
+            break;
+        }
+        
+        std::string prefix = "plugin/" + plugin.first + "/";
+        std::vector<const Bundle::Entry*> payloads = bundle.list(prefix);
+        std::vector<std::uint8_t> extracted(payloads.size(), 0);
+        FileUtils::parallelFor(payloads.size(), [&](size_t i) {
+            std::string path = pluginMgr.pluginsPath() + "/" + plugin.first + "/" +
+                               std::string(bundle.name(*payloads[i]).substr(prefix.size()));
+            for (size_t slash = path.find('/', pluginMgr.pluginsPath().size() + 1); slash != std::string::npos;
+                 slash = path.find('/', slash + 1)) {
+                mkdir(path.substr(0, slash).c_str(), 0755);
+            }
+            extracted[i] = bundle.extract(*payloads[i], path);
+        });
+        
+        bool changed = false;
+        if (std::count(extracted.begin(), extracted.end(), 0) > 0 ||
+            !pluginMgr.installLocked(plugin.first, plugin.second, &changed)) {
+            success = false;
+            break;
+        }
+        if (changed) {
+            rebuilt.push_back(plugin.first);
+        }
+    }
+    
+    if (!report.installed.empty() || !rebuilt.empty()) {
+        SceneRecord record;
+        record.packages.insert(report.installed.begin(), report.installed.end());
+        record.plugins.insert(rebuilt.begin(), rebuilt.end());
+        record.merge(scene->name);
+    }
+    if (success) {
+        SceneState::activate(scene->name);
+    }
+    
+    out << "  " << T("Satisfied") << ": " << report.satisfied << ", " << T("From cache") << ": " << report.cached
+        << ", " << T("From bundle") << ": " << report.bundled << "\n";
+    if (!report.drifted.empty()) {
+        out << "  ⚠️  " << T("Version drift") << ": " << summarizeNames(report.drifted, 4) << "\n";
+    }
+    if (!report.mismatched.empty()) {
+        out << "  ❌ " << T("Digest mismatch") << ": " << summarizeNames(report.mismatched, 16) << "\n";
+    }
+    for (const auto& plugin : lock.wheels) {
+        bool changed = std::find(rebuilt.begin(), rebuilt.end(), plugin.first) != rebuilt.end();
+        out << "  🐍 " << plugin.first << ": " << plugin.second.size() << " wheels"
+            << (changed ? "" : std::string(" (") + T("Satisfied") + ")") << "\n";
+    }
+    
+    out.beginObject();
+    out.field("command", "bundle.apply");
+    out.field("scene", scene->name);
+    out.field("file", file);
+    out.field("codec", Bundle::codecName(bundle.codec()));
+    out.field("satisfied", static_cast<long long>(report.satisfied));
+    out.field("cached", static_cast<long long>(report.cached));
+    out.field("bundled", static_cast<long long>(report.bundled));
+    out.field("drifted", report.drifted);
+    out.field("mismatched", report.mismatched);
+    out.field("pluginsInstalled", rebuilt);
+    out.field("success", success);
+    out.endObject();
+    
+    if (success) {
+        logger.success(displayName);
+    }
+    out << kRule;
+    out << "\n";
+    return success;
+}
+
+bool cmdBundleList(const std::string& file) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    auto& out = Output::getInstance();
+    
+    Bundle bundle;
+    if (!bundle.open(file)) {
+        logger.error(std::string(T("Not a valid bundle")) + ": " + file);
+        printResult("bundle.list", file, false);
+        return false;
+    }
+    
+    out << "\n";
+    logger.info(std::string(T("Bundle")) + ": " + file + " (" + Bundle::codecName(bundle.codec()) + ")");
+    out << kRule;
+    
+    std::uint64_t bytes = 0;
+    std::uint64_t stored = 0;
+    out.beginObject();
+    out.field("command", "bundle.list");
+    out.field("file", file);
+    out.field("codec", Bundle::codecName(bundle.codec()));
+    out.beginList("members", {"name", "size", "stored", "sha256"});
+    for (size_t i = 0; i < bundle.size(); ++i) {
+        const Bundle::Entry& entry = bundle.entry(i);
+        bytes += entry.size;
+        stored += entry.stored;
+        out.beginRow();
+        out.field("name", std::string(bundle.name(entry)));
+        out.field("size", static_cast<long long>(entry.size));
+        out.field("stored", static_cast<long long>(entry.stored));
+        out.field("sha256", Bundle::digest(entry).substr(0, 12));
+        out.endRow();
+        out << "  " << bundle.name(entry) << "  " << DiskUsage::formatBytes(entry.size) << "\n";
+    }
+    out.endList();
+    out.field("bytes", static_cast<long long>(bytes));
+    out.field("storedBytes", static_cast<long long>(stored));
+    out.endObject();
+    
+    out << "  " << bundle.size() << " " << T("members") << ", " << DiskUsage::formatBytes(stored) << " / "
+        << DiskUsage::formatBytes(bytes) << "\n";
+    out << kRule;
+    out << "\n";
+    return true;
+}
+
+void cmdMirrorRank(const std::vector<MirrorKind>& kinds, bool refresh) {
+    auto& engine = CoreEngine::getInstance();
+    auto& mirrorMgr = engine.getMirrorManager();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
+    
+    out << "\n";
+    logger.info(T("Mirror Ranking"));
+    out << kRule;
+    
+    out.beginObject();
+    out.field("command", "mirror.rank");
+    out.beginList("mirrors", {"kind", "rank", "url", "reachable", "connectMs", "throughputKBps"});
+    
+    for (MirrorKind kind : kinds) {
+        std::vector<MirrorProbe> probes = mirrorMgr.rank(kind, refresh);
+        out << "[" << MirrorManager::kindName(kind) << "]\n";
+        
+        for (size_t i = 0; i < probes.size(); ++i) {
+            const auto& probe = probes[i];
+            
+            out.beginRow();
+            out.field("kind", MirrorManager::kindName(kind));
+            out.field("rank", static_cast<int>(i + 1));
+            out.field("url", probe.url);
+            out.field("reachable", probe.reachable);
+            out.field("connectMs", static_cast<long long>(probe.connectMs));
+            out.field("throughputKBps", static_cast<long long>(probe.throughputKBps));
+            out.endRow();
+            
+            out << "  " << (i + 1) << ") " << probe.url;
+            if (!probe.reachable) {
+                out << "  (" << T("unreachable") << ")\n";
+                continue;
+            }
+            out << "  " << static_cast<long long>(probe.connectMs) << " ms";
+            if (probe.throughputKBps > 0) {
+                out << "  " << static_cast<long long>(probe.throughputKBps) << " KB/s";
+            }
+            out << "\n";
+        }
+    }
+    
+    out.endList();
+    out.endObject();
+    
+    out << kRule;
+    out << "\n";
+}
+
+bool cmdMirrorApply(MirrorKind kind) {
+    auto& mirrorMgr = CoreEngine::getInstance().getMirrorManager();
+    bool success = mirrorMgr.apply(kind);
+    printResult("mirror.apply", MirrorManager::kindName(kind), success);
+    return success;
+}
+
+bool cmdPythonEnvCreate(const std::string& name, const std::vector<std::string>& sources) {
+    auto& engine = CoreEngine::getInstance();
+    auto& python = engine.getPythonEnvManager();
+    auto& pluginMgr = engine.getPluginManager();
+    
+    // 来源是已安装的 Python 插件时直接复用其 wheel 集合，无需重新解析下载
+    // 先检查名字，不合法时不必解析下载
+    std::vector<std::string> wheels;
+    bool success = PythonEnvManager::validEnvName(name);
+    if (!success) {
+        engine.getLogger().error("Invalid Python environment name: " + name);
+    } else if (sources.size() == 1 && !pluginMgr.getInfo(sources[0]).wheels.empty()) {
+        wheels = pluginMgr.getInfo(sources[0]).wheels;
+    } else {
+        success = python.resolve(sources, wheels);
+    }
+    success = success && python.createEnv(name, wheels);
+    
+    if (success) {
+        Output::getInstance() << "\n  source " << python.envPath(name) << "/bin/activate\n\n";
+    }
+    printResult("python.env.create", name, success);
+    return success;
+}
+
+void cmdPythonEnvList() {
+    auto& engine = CoreEngine::getInstance();
+    auto& python = engine.getPythonEnvManager();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
+    
+    out << "\n";
+    logger.info(T("Python Environments"));
+    out << kRule;
+    
+    out.beginObject();
+    out.field("command", "python.env.list");
+    out.beginList("environments", {"name", "wheels", "path"});
+    
+    std::vector<std::string> envs = python.listEnvs();
+    for (const auto& name : envs) {
+        std::vector<std::string> wheels;
+        python.readEnvWheels(name, wheels);
+        
+        out.beginRow();
+        out.field("name", name);
+        out.field("wheels", static_cast<long long>(wheels.size()));
+        out.field("path", python.envPath(name));
+        out.endRow();
+        
+        std::string padded = name;
+        padded.resize(17, ' ');
+        out << "  " << padded << wheels.size() << " wheels  " << python.envPath(name) << "\n";
+    }
+    
+    out.endList();
+    out.endObject();
+    
+    if (envs.empty()) {
+        logger.warning(T("No Python environments yet."));
+    }
+    out << kRule;
+    out << "\n";
+}
+
+bool cmdPythonEnvRemove(const std::string& name) {
+    auto& python = CoreEngine::getInstance().getPythonEnvManager();
+    bool success = python.removeEnv(name);
+    printResult("python.env.remove", name, success);
+    return success;
+}
+
+void cmdPythonGc() {
+    auto& engine = CoreEngine::getInstance();
+    size_t removed = engine.getPythonEnvManager().collectGarbage();
+    engine.getLogger().info("Removed " + std::to_string(removed) + " unreferenced wheels");
+    
+    auto& out = Output::getInstance();
+    out.beginObject();
+    out.field("command", "python.gc");
+    out.field("removed", static_cast<long long>(removed));
+    out.endObject();
+}
+
+namespace {
+
+/**
+ * @brief 配置文件中某一项的值（第一个字段），没有时返回空串
+ */
+std::string configValue(const std::string& key) {
+    std::vector<std::string> lines;
+    FileUtils::readLines(CoreEngine::getInstance().getConfigPath(), lines);
+    for (const auto& line : lines) {
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> name = FileUtils::splitFields(line.substr(0, colon));
+        std::vector<std::string> value = FileUtils::splitFields(line.substr(colon + 1));
+        if (name.size() == 1 && name[0] == key && !value.empty()) {
+            return value[0];
+        }
+    }
+    return "";
+}
+
+} // namespace
+
+bool cmdRepoUpdate(const std::string& url) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
+    
+    std::string base = url.empty() ? configValue("repository_url") : url;
+    if (base.empty()) {
+        errorOut << T("Error") << ": " << T("Repository URL required") << "\n";
+        errorOut << "  Use: xkl repo update <url>   or set repository_url in " << engine.getConfigPath() << "\n";
+        return false;
+    }
+    
+    RepoIndex::UpdateReport report;
+    bool success = RepoIndex::update(base, RepoIndex::kDefaultPath, report);
+    
+    out.beginObject();
+    out.field("command", "repo.update");
+    out.field("url", base);
+    out.field("success", success);
+    out.field("fromVersion", static_cast<long long>(report.fromVersion));
+    out.field("toVersion", static_cast<long long>(report.toVersion));
+    out.field("upToDate", report.upToDate);
+    out.field("full", report.full);
+    out.field("blocks", static_cast<long long>(report.blocks));
+    out.field("matchedBlocks", static_cast<long long>(report.matchedBlocks));
+    out.field("ranges", static_cast<long long>(report.ranges));
+    out.field("length", static_cast<long long>(report.length));
+    out.field("fetched", static_cast<long long>(report.fetched));
+    out.field("error", report.error);
+    out.endObject();
+    
+    if (!success) {
+        logger.error(std::string(T("Repository update failed")) + ": " + report.error);
+        return false;
+    }
+    if (report.upToDate) {
+        logger.info(std::string(T("Repository index is up to date")) + " (v" + std::to_string(report.toVersion) + ")");
+        return true;
+    }
+    
+    logger.success(std::string(T("Repository index updated")) + ": v" + std::to_string(report.fromVersion) +
+                   " -> v" + std::to_string(report.toVersion));
+    logger.info(std::string(T("matched blocks")) + " " + std::to_string(report.matchedBlocks) + "/" +
+                std::to_string(report.blocks) + ", " + T("downloaded") + " " +
+                DiskUsage::formatBytes(report.fetched) + " / " + DiskUsage::formatBytes(report.length));
+    
+    // 新场景与插件进入补全
+    RepoIndex::reloadLocal();
+    CompletionIndex::rebuildStatic();
+    engine.getPluginManager().updateCompletionIndex();
+    return true;
+}
+
+bool cmdRepoBuild(const std::string& source, const std::string& outDir) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    
+    std::string text;
+    if (!FileUtils::readFile(source, text)) {
+        logger.error("Cannot read " + source);
+        return false;
+    }
+    std::string image;
+    std::string error;
+    if (!RepoIndex::compile(text, image, error)) {
+        errorOut << T("Error") << ": " << T("Failed to compile repository") << ": " << source << ": " << error << "\n";
+        return false;
+    }
+    
+    mkdir(outDir.c_str(), 0755);
+    std::string indexPath = outDir + "/" + RepoIndex::kIndexName;
+    std::string sumsPath = outDir + "/" + RepoIndex::kSumsName;
+    bool success = FileUtils::writeFileAtomic(indexPath, image) &&
+                   FileUtils::writeFileAtomic(sumsPath, RepoIndex::sums(image));
+    
+    auto& out = Output::getInstance();
+    out.beginObject();
+    out.field("command", "repo.build");
+    out.field("index", indexPath);
+    out.field("sums", sumsPath);
+    out.field("success", success);
+    out.field("bytes", static_cast<long long>(image.size()));
+    out.endObject();
+    
+    if (success) {
+        logger.success("Wrote " + indexPath + " (" + DiskUsage::formatBytes(image.size()) + ") and " + sumsPath);
+    } else {
+        logger.error("Cannot write " + outDir);
+    }
+    return success;
+}
+
+namespace {
+
+std::atomic<bool> watchStopped(false);
+
+void stopWatching(int) {
+    watchStopped = true;
+}
+
+} // namespace
+
+bool cmdWatch() {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
+    
+    struct sigaction action = {};
+    action.sa_handler = stopWatching;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    
+    logger.info(T("Watching plugins and system packages (Ctrl+C to stop)"));
+    out.flush();
+    
+    // 每批变化一行；JSON 模式下每批一个对象（逐行 JSON）
+    return RegistryWatcher::run(watchStopped, [&](const RegistryWatcher::Changes& changes) {
+        if (!changes.plugins.empty()) {
+            logger.info(std::string(T("Plugins changed")) + ": " + summarizeNames(changes.plugins, 16));
+        }
+        if (!changes.packages.empty()) {
+            logger.info(std::string(T("Components changed")) + ": " + summarizeNames(changes.packages, 16));
+        }
+        out.beginObject();
+        out.field("command", "watch");
+        out.field("plugins", changes.plugins);
+        out.field("packages", changes.packages);
+        out.endObject();
+        out.flush();
+    });
+}
+
+namespace {
+
+/**
+ * @brief 检查队列任务的目标是否存在，不存在时输出提示
+ *
+ * 插件须在可用列表（内置安装器与仓库索引）中；组件须在软件包目录中（可安装或虚包）
+ * 或有源码构建配方。软件包目录不可用时只检查包名语法，并给出警告。
+ */
+bool requireQueueTarget(InstallQueue::Kind kind, const std::string& name) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
+    bool chinese = I18n::getInstance().isChinese();
+
+    if (kind == InstallQueue::Kind::Scene) {
+        return requireScene(name, "queue.add") != nullptr;
+    }
+
+    bool known = false;
+    if (kind == InstallQueue::Kind::Plugin) {
+        std::vector<std::string> available = engine.getPluginManager().listAvailable();
+        known = std::find(available.begin(), available.end(), name) != available.end();
+    } else {
+        BuildRecipe recipe;
+        const ComponentCatalog& catalog = engine.getComponentManager().catalog();
+        if (BuildRecipe::find(name, recipe)) {
+            known = true;
+        } else if (catalog.size() == 0) {
+            known = ComponentManager::validName(name);
+            if (known) {
+                logger.warning(chinese ? "软件包目录不可用，未校验组件是否存在: " + name
+                                       : "Package catalog unavailable, component not verified: " + name);
+            }
+        } else {
+            std::uint32_t id = catalog.find(name);
+            known = id != ComponentCatalog::kInvalidId &&
+                    (catalog.view(id).available() || catalog.view(id).isVirtual());
+        }
+    }
+    if (known) {
+        return true;
+    }
+
+    bool plugin = kind == InstallQueue::Kind::Plugin;
+    if (chinese) {
+        logger.error(std::string(plugin ? "未知的插件: " : "未知的组件: ") + name);
+        out << "\n";
+        logger.info(plugin ? "运行 'xkl plugin list' 查看可用插件" : "运行 'xkl component search <关键词>' 查找组件");
+    } else {
+        logger.error(std::string(plugin ? "Unknown plugin: " : "Unknown component: ") + name);
+        out << "\n";
+        logger.info(plugin ? "Run 'xkl plugin list' to see available plugins"
+                           : "Run 'xkl component search <keyword>' to find components");
+    }
+    printResult("queue.add", name, false);
+    return false;
+}
+
+} // namespace
+
+bool cmdQueueAdd(InstallQueue::Kind kind, const std::string& name) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    auto& out = Output::getInstance();
+
+    if (!requireQueueTarget(kind, name)) {
+        return false;
+    }
+    InstallQueue::Job job;
+    bool success = InstallQueue::add(kind, name, job);
+    
+    out.beginObject();
+    out.field("command", "queue.add");
+    out.field("id", static_cast<long long>(job.id));
+    out.field("kind", InstallQueue::kindName(kind));
+    out.field("name", name);
+    out.field("success", success);
+    out.endObject();
+    
+    if (!success) {
+        logger.error("Cannot write " + std::string(InstallQueue::kPath));
+        return false;
+    }
+    logger.success(std::string(T("Queued job")) + " #" + std::to_string(job.id) + ": " +
+                   InstallQueue::kindName(kind) + " " + name);
+    if (!InstallQueue::active()) {
+        logger.info(T("Queue scheduler is not running, start it with: xkl queue run"));
+    }
+    return true;
+}
+
+namespace {
+
+/**
+ * @brief PSI 百分比，不可用时显示 -
+ */
+std::string formatPressure(double value) {
+    if (value < 0) {
+        return "-";
+    }
+    char text[16];
+    std::snprintf(text, sizeof(text), "%.1f%%", value);
+    return text;
+}
+
+} // namespace
+
+void cmdQueueList() {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    auto& out = Output::getInstance();
+    
+    InstallQueue::Pressure pressure = InstallQueue::sample();
+    std::vector<InstallQueue::Job> jobs = InstallQueue::jobs();
+    
+    out << "\n";
+    logger.info(T("Install Queue"));
+    out << kRule;
+    
+    out.beginObject();
+    out.field("command", "queue.list");
+    out.field("scheduler", InstallQueue::active());
+    out.beginList("jobs", {"id", "kind", "name", "state", "addedAt", "finishedAt", "pauses"});
+    for (const auto& job : jobs) {
+        out.beginRow();
+        out.field("id", static_cast<long long>(job.id));
+        out.field("kind", InstallQueue::kindName(job.kind));
+        out.field("name", job.name);
+        out.field("state", InstallQueue::stateName(job.state));
+        out.field("addedAt", job.addedAt);
+        out.field("finishedAt", job.finishedAt);
+        out.field("pauses", static_cast<long long>(job.pauses));
+        out.endRow();
+        
+        std::string id = "#" + std::to_string(job.id);
+        id.resize(6, ' ');
+        std::string target = std::string(InstallQueue::kindName(job.kind)) + " " + job.name;
+        target.resize(std::max<size_t>(target.size() + 1, 28), ' ');
+        std::string state = InstallQueue::stateName(job.state);
+        state.resize(9, ' ');
+        out << "  " << id << target << state << job.addedAt;
+        if (job.pauses > 0) {
+            out << "  (" << std::to_string(job.pauses) << " pauses)";
+        }
+        out << "\n";
+    }
+    out.endList();
+    out.endObject();
+    
+    if (jobs.empty()) {
+        logger.warning(T("Queue is empty."));
+    }
+    out << kRule;
+    char load[16];
+    std::snprintf(load, sizeof(load), "%.2f", pressure.load);
+    logger.info(std::string(T("System pressure")) + ": cpu " + formatPressure(pressure.cpu) + ", memory " +
+                formatPressure(pressure.memory) + ", io " + formatPressure(pressure.io) + ", load/core " + load);
+    if (!InstallQueue::active() && !jobs.empty()) {
+        logger.info(T("Queue scheduler is not running, start it with: xkl queue run"));
+    }
+    out << "\n";
+}
+
+bool cmdQueueRemove(const std::string& id) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    
+    char* end = nullptr;
+    unsigned long value = std::strtoul(id.c_str() + (id[0] == '#' ? 1 : 0), &end, 10);
+    if (value == 0 || *end != '\0') {
+        errorOut << T("Error") << ": " << T("Invalid job id") << ": " << id << "\n";
+        return false;
+    }
+    bool success = InstallQueue::remove(static_cast<unsigned>(value));
+    if (!success) {
+        logger.error(std::string(T("Job not found or still running")) + ": #" + std::to_string(value));
+    }
+    printResult("queue.remove", "#" + std::to_string(value), success);
+    return success;
+}
+
+namespace {
+
+std::atomic<bool> queueStopped(false);
+
+void stopQueue(int) {
+    queueStopped = true;
+}
+
+} // namespace
+
+bool cmdQueueRun() {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& out = Output::getInstance();
+    
+    struct sigaction action = {};
+    action.sa_handler = stopQueue;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    
+    InstallQueue queue;
+    queue.loadConfig(engine.getConfigPath());
+    
+    logger.info(T("Running queued installs when the system is idle (Ctrl+C to stop)"));
+    out.flush();
+    
+    // 每次状态变化一行；JSON 模式下每次一个对象（逐行 JSON）
+    bool ok = queue.run(queueStopped, [&](const InstallQueue::Job& job, const char* event) {
+        std::string target = "#" + std::to_string(job.id) + " " + InstallQueue::kindName(job.kind) + " " + job.name;
+        if (std::strcmp(event, "start") == 0) {
+            logger.info(std::string(T("Job started")) + ": " + target + " (" + InstallQueue::kJobDir + "/" +
+                        std::to_string(job.id) + ".log)");
+        } else if (std::strcmp(event, "pause") == 0) {
+            logger.warning(std::string(T("Job paused under pressure")) + ": " + target);
+        } else if (std::strcmp(event, "resume") == 0) {
+            logger.info(std::string(T("Job resumed")) + ": " + target);
+        } else if (std::strcmp(event, "wait") == 0) {
+            logger.info(std::string(T("Waiting for the running job to finish")) + ": " + target);
+        } else if (std::strcmp(event, "adopt") == 0) {
+            logger.info(std::string(T("Adopted job left running by the previous scheduler")) + ": " + target);
+        } else if (std::strcmp(event, "exit") == 0) {
+            logger.info(std::string(T("Adopted job exited, see its log for the result")) + ": " + target + " (" +
+                        InstallQueue::kJobDir + "/" + std::to_string(job.id) + ".log)");
+        } else if (std::strcmp(event, "done") == 0) {
+            logger.success(std::string(T("Job finished")) + ": " + target);
+        } else {
+            logger.error(std::string(T("Job failed")) + ": " + target);
+        }
+        out.beginObject();
+        out.field("command", "queue.run");
+        out.field("event", event);
+        out.field("id", static_cast<long long>(job.id));
+        out.field("kind", InstallQueue::kindName(job.kind));
+        out.field("name", job.name);
+        out.field("state", InstallQueue::stateName(job.state));
+        out.endObject();
+        out.flush();
+    });
+    if (!ok) {
+        logger.error(T("Queue scheduler already running"));
+    }
+    return ok;
+}
+
+namespace {
+
+/**
+ * @brief 把日志行拆成时间、级别、消息（续行只有消息）
+ */
+void logRow(const std::string& line) {
+    auto& out = Output::getInstance();
+    out.beginRow();
+    std::size_t close = line.find(']', 23);
+    if (line.size() > 23 && line[0] == '[' && line[22] == '[' && close != std::string::npos) {
+        out.field("time", line.substr(1, 19));
+        out.field("level", line.substr(23, close - 23));
+        out.field("message", close + 2 <= line.size() ? line.substr(close + 2) : std::string());
+    } else {
+        out.field("time", "");
+        out.field("level", "");
+        out.field("message", line);
+    }
+    out.endRow();
+}
+
+} // namespace
+
+bool cmdLogs(const LogIndex::Query& query, bool follow) {
+    auto& out = Output::getInstance();
+    
+    // 文本模式原样输出日志行，便于继续用 grep 等处理
+    out.beginObject();
+    out.field("command", "logs");
+    out.beginList("lines", {"time", "level", "message"});
+    LogIndex::Stats stats;
+    LogIndex::query(Logger::kDefaultPath, query, [&](const std::string& line) {
+        logRow(line);
+        out << line << "\n";
+    }, stats);
+    out.endList();
+    out.field("segments", static_cast<long long>(stats.segments));
+    out.field("skippedSegments", static_cast<long long>(stats.skipped));
+    out.field("indexedBlocks", static_cast<long long>(stats.blocks));
+    out.field("scannedBlocks", static_cast<long long>(stats.scannedBlocks));
+    out.endObject();
+    out.flush();
+    
+    if (!follow) {
+        return true;
+    }
+    
+    struct sigaction action = {};
+    action.sa_handler = stopWatching;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    
+    // 跟随时每行立即输出；JSON 模式下每行一个对象（逐行 JSON）
+    bool ok = LogIndex::follow(Logger::kDefaultPath, query, watchStopped, [&](const std::string& line) {
+        if (out.isText()) {
+            out << line << "\n";
+        } else {
+            out.beginObject();
+            out.field("command", "logs");
+            out.beginList("lines", {"time", "level", "message"});
+            logRow(line);
+            out.endList();
+            out.endObject();
+        }
+        out.flush();
+    });
+    if (!ok) {
+        errorOut << T("Error") << ": " << T("Cannot follow log file") << ": " << Logger::kDefaultPath << "\n";
+    }
+    return ok;
+}
+
+void cmdI18nKeys() {
+    // 译者以此为模板填写第二列，再用 xkl i18n compile 生成 .cat 文件
+    auto& out = Output::getInstance();
+    out.write("# LinuxStudio translation template: key<TAB>text\n");
+    for (std::size_t i = 0; i < i18n::kKeyCount; ++i) {
+        out.write(std::string(i18n::kKeys[i]) + "\t" + i18n::kKeys[i] + "\n");
+    }
+}
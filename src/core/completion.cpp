@@ -0,0 +1,367 @@
+#include "linuxstudio/completion.hpp"
+#include "linuxstudio/scenes.hpp"
+#include "linuxstudio/source_build.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+const char* const CompletionIndex::kCommands = "commands";
+const char* const CompletionIndex::kScenes = "scenes";
+const char* const CompletionIndex::kPlugins = "plugins";
+const char* const CompletionIndex::kPluginsInstalled = "plugins-installed";
+const char* const CompletionIndex::kComponentsInstalled = "components-installed";
+const char* const CompletionIndex::kRecipes = "recipes";
+
+namespace {
+
+/**
+ * @brief 静态命令树：路径 -> 子命令
+ * 索引缺失时（如首次运行前）直接使用
+ */
+struct CommandNode {
+    const char* path;
+    const char* words;
+};
+
+const CommandNode kCommandTree[] = {
+    {"", "init status watch logs component plugin scene bundle mirror repo queue python i18n completion help version"},
+    {"component", "list search install uninstall du build"},
+    {"plugin", "list install uninstall enable disable du verify"},
+    {"scene", "list resolve lock apply switch export"},
+    {"bundle", "create apply list"},
+    {"logs", "--since --until --level --component --follow"},
+    {"mirror", "rank apply"},
+    {"mirror rank", "apt pip ros"},
+    {"mirror apply", "apt pip ros"},
+    {"repo", "update build"},
+    {"queue", "add list remove run"},
+    {"queue add", "component plugin scene"},
+    {"python", "env gc"},
+    {"python env", "create list remove"},
+    {"i18n", "keys compile"},
+    {"completion", "bash zsh fish"},
+};
+
+/**
+ * @brief 命令参数 -> 候选分区
+ */
+struct ArgumentNode {
+    const char* path;
+    const char* section;
+};
+
+const ArgumentNode kArgumentSections[] = {
+    {"plugin install", CompletionIndex::kPlugins},
+    {"plugin uninstall", CompletionIndex::kPluginsInstalled},
+    {"plugin enable", CompletionIndex::kPluginsInstalled},
+    {"plugin disable", CompletionIndex::kPluginsInstalled},
+    {"plugin verify", CompletionIndex::kPluginsInstalled},
+    {"component uninstall", CompletionIndex::kComponentsInstalled},
+    {"component build", CompletionIndex::kRecipes},
+    {"scene resolve", CompletionIndex::kScenes},
+    {"scene lock", CompletionIndex::kScenes},
+    {"scene apply", CompletionIndex::kScenes},
+    {"scene switch", CompletionIndex::kScenes},
+    {"scene export", CompletionIndex::kScenes},
+    {"bundle create", CompletionIndex::kScenes},
+    {"queue add plugin", CompletionIndex::kPlugins},
+    {"queue add scene", CompletionIndex::kScenes},
+};
+
+const char* const kGlobalOptions = "--format=json --format=tsv --format=text --json --tsv";
+
+std::string sectionForSubcommands(const std::string& path) {
+    return path.empty() ? CompletionIndex::kCommands : "sub:" + path;
+}
+
+bool readWholeFile(const std::string& path, std::string& content) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    content.resize(static_cast<size_t>(st.st_size));
+    size_t done = 0;
+    while (done < content.size()) {
+        ssize_t n = read(fd, &content[done], content.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    content.resize(done);
+    close(fd);
+    return true;
+}
+
+/**
+ * @brief 在索引内容中查找分区，返回空格分隔的候选词
+ */
+bool findSection(const std::string& index, const std::string& section, std::string& words) {
+    size_t pos = 0;
+    while (pos < index.size()) {
+        size_t end = index.find('\n', pos);
+        if (end == std::string::npos) {
+            end = index.size();
+        }
+        if (end - pos > section.size() &&
+            index.compare(pos, section.size(), section) == 0 &&
+            index[pos + section.size()] == '\t') {
+            words = index.substr(pos + section.size() + 1, end - pos - section.size() - 1);
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+void appendMatches(const std::string& words, const std::string& prefix, std::string& out) {
+    size_t pos = 0;
+    while (pos < words.size()) {
+        size_t end = words.find(' ', pos);
+        if (end == std::string::npos) {
+            end = words.size();
+        }
+        if (end > pos && words.compare(pos, prefix.size(), prefix) == 0 &&
+            end - pos >= prefix.size()) {
+            out.append(words, pos, end - pos);
+            out += '\n';
+        }
+        pos = end + 1;
+    }
+}
+
+std::string dataDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+} // namespace
+
+std::string CompletionIndex::indexPath() {
+    const char* override = std::getenv("XKL_COMPLETION_INDEX");
+    if (override && *override) {
+        return override;
+    }
+    return "/opt/linuxstudio/data/completion.idx";
+}
+
+bool CompletionIndex::updateSection(const std::string& section, std::vector<std::string> words) {
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    std::string line = section + "\t";
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (i > 0) {
+            line += ' ';
+        }
+        line += words[i];
+    }
+    line += '\n';
+
+    std::string path = indexPath();
+    mkdir(dataDirectory(path).c_str(), 0755);
+
+    // 多个 xkl 进程可能同时更新不同分区，用独立的锁文件串行化读-改-写
+    std::string lockPath = path + ".lock";
+    int lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockFd < 0) {
+        return false;
+    }
+    flock(lockFd, LOCK_EX);
+
+    std::string index;
+    readWholeFile(path, index);
+
+    // 替换该分区所在的行，其余行原样保留
+    std::string updated;
+    bool replaced = false;
+    size_t pos = 0;
+    while (pos < index.size()) {
+        size_t end = index.find('\n', pos);
+        end = (end == std::string::npos) ? index.size() : end + 1;
+        if (index.compare(pos, section.size() + 1, section + "\t") == 0) {
+            updated += line;
+            replaced = true;
+        } else {
+            updated.append(index, pos, end - pos);
+        }
+        pos = end;
+    }
+    if (!replaced) {
+        updated += line;
+    }
+
+    bool ok = true;
+    if (updated != index) {
+        std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+        FILE* file = std::fopen(tmpPath.c_str(), "w");
+        ok = file != nullptr &&
+             std::fwrite(updated.data(), 1, updated.size(), file) == updated.size();
+        if (file) {
+            ok = (std::fclose(file) == 0) && ok;
+        }
+        ok = ok && std::rename(tmpPath.c_str(), path.c_str()) == 0;
+        if (!ok) {
+            std::remove(tmpPath.c_str());
+        }
+    }
+
+    flock(lockFd, LOCK_UN);
+    close(lockFd);
+    return ok;
+}
+
+bool CompletionIndex::rebuildStatic() {
+    bool ok = true;
+    for (const auto& node : kCommandTree) {
+        std::vector<std::string> words;
+        std::string all = node.words;
+        size_t pos = 0;
+        while (pos < all.size()) {
+            size_t end = all.find(' ', pos);
+            if (end == std::string::npos) {
+                end = all.size();
+            }
+            words.push_back(all.substr(pos, end - pos));
+            pos = end + 1;
+        }
+        ok = updateSection(sectionForSubcommands(node.path), words) && ok;
+    }
+
+    std::vector<std::string> scenes;
+    for (const auto& scene : availableScenes()) {
+        scenes.push_back(scene.name);
+    }
+    ok = updateSection(kScenes, scenes) && ok;
+    return updateSection(kRecipes, BuildRecipe::available()) && ok;
+}
+
+int CompletionIndex::complete(const std::vector<std::string>& words) {
+    std::string current = words.empty() ? "" : words.back();
+
+    // 上下文路径：已输入的非选项参数
+    std::string path;
+    size_t positional = 0;
+    for (size_t i = 0; i + 1 < words.size(); ++i) {
+        if (words[i].compare(0, 2, "--") == 0) {
+            continue;
+        }
+        if (!path.empty()) {
+            path += ' ';
+        }
+        path += words[i];
+        ++positional;
+    }
+
+    std::string index;
+    bool haveIndex = readWholeFile(indexPath(), index);
+
+    std::string out;
+    std::string candidates;
+    if (current.compare(0, 2, "--") == 0) {
+        appendMatches(kGlobalOptions, current, out);
+    } else {
+        bool found = false;
+        for (const auto& node : kCommandTree) {
+            if (path == node.path) {
+                if (!(haveIndex && findSection(index, sectionForSubcommands(path), candidates))) {
+                    candidates = node.words;
+                }
+                found = true;
+                break;
+            }
+        }
+        if (!found && positional >= 2 && haveIndex) {
+            for (const auto& node : kArgumentSections) {
+                if (path == node.path) {
+                    findSection(index, node.section, candidates);
+                    break;
+                }
+            }
+        }
+        appendMatches(candidates, current, out);
+    }
+
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = write(1, out.data() + done, out.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return 0;
+}
+
+bool CompletionIndex::generateScript(const std::string& shell, std::string& script) {
+    // 顶层命令直接写入脚本，首个参数补全无需启动 xkl
+    std::string index;
+    std::string commands;
+    if (!(readWholeFile(indexPath(), index) && findSection(index, kCommands, commands))) {
+        commands = kCommandTree[0].words;
+    }
+
+    if (shell == "bash") {
+        script =
+            "# bash completion for xkl (generated by 'xkl completion bash')\n"
+            "_xkl() {\n"
+            "    local cur=\"${COMP_WORDS[COMP_CWORD]}\"\n"
+            "    if [ \"$COMP_CWORD\" -eq 1 ] && [ \"${cur#-}\" = \"$cur\" ]; then\n"
+            "        COMPREPLY=( $(compgen -W \"" + commands + "\" -- \"$cur\") )\n"
+            "        return\n"
+            "    fi\n"
+            "    local IFS=$'\\n'\n"
+            "    COMPREPLY=( $(xkl __complete \"${COMP_WORDS[@]:1:COMP_CWORD}\" 2>/dev/null) )\n"
+            "}\n"
+            "complete -F _xkl xkl linuxstudio\n";
+        return true;
+    }
+    if (shell == "zsh") {
+        script =
+            "#compdef xkl linuxstudio\n"
+            "# zsh completion for xkl (generated by 'xkl completion zsh')\n"
+            "_xkl() {\n"
+            "    local -a candidates\n"
+            "    if (( CURRENT == 2 )) && [[ $PREFIX != -* ]]; then\n"
+            "        candidates=(" + commands + ")\n"
+            "    else\n"
+            "        candidates=(${(f)\"$(xkl __complete \"${(@)words[2,CURRENT]}\" 2>/dev/null)\"})\n"
+            "    fi\n"
+            "    compadd -a candidates\n"
+            "}\n"
+            "compdef _xkl xkl linuxstudio\n";
+        return true;
+    }
+    if (shell == "fish") {
+        script =
+            "# fish completion for xkl (generated by 'xkl completion fish')\n"
+            "complete -c xkl -f -n '__fish_use_subcommand' -a '" + commands + "'\n"
+            "complete -c xkl -f -n 'not __fish_use_subcommand' "
+            "-a '(xkl __complete (commandline -opc)[2..-1] (commandline -ct) 2>/dev/null)'\n"
+            "complete -c linuxstudio -w xkl\n";
+        return true;
+    }
+    return false;
+}
+
+} // namespace LinuxStudio
@@ -0,0 +1,629 @@
+#include "linuxstudio/component_catalog.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/string_pool.hpp"
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+// 映像按本机字节序存放，只作为本机缓存使用
+const char kMagic[8] = {'X', 'K', 'L', 'C', 'A', 'T', '0', '2'};
+
+const std::uint32_t kFlagAvailable = 1;
+const std::uint32_t kFlagInstalled = 2;
+const std::uint32_t kFlagVirtual = 4;
+
+struct ImageHeader {
+    char magic[8];
+    std::uint64_t fingerprint;
+    std::uint32_t count;
+    std::uint32_t depCount;
+    std::uint64_t stringBytes;
+};
+
+/**
+ * @brief 构建阶段的条目（字段为 StringPool ID）
+ */
+struct PendingRecord {
+    std::uint32_t version = 0;
+    std::uint32_t description = 0;
+    std::uint32_t depBegin = 0;
+    std::uint32_t depCount = 0;
+    std::uint32_t conflictCount = 0;
+    std::uint32_t flags = 0;
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+/**
+ * @brief 逐组处理 "libc6 (>= 2.34) | libc6.1, python3:any"，每组取一个候选包名
+ * @param prefer 优先选择返回 true 的候选（如已安装的），都不满足时取第一个
+ */
+template <typename Prefer, typename Visitor>
+void forEachDependency(std::string_view field, Prefer prefer, Visitor visit) {
+    while (!field.empty()) {
+        size_t comma = field.find(',');
+        std::string_view group = field.substr(0, comma);
+        field = (comma == std::string_view::npos) ? std::string_view() : field.substr(comma + 1);
+
+        std::string_view chosen;
+        while (!group.empty()) {
+            size_t bar = group.find('|');
+            std::string_view candidate = trim(group.substr(0, bar));
+            group = (bar == std::string_view::npos) ? std::string_view() : group.substr(bar + 1);
+            candidate = candidate.substr(0, candidate.find_first_of(" (:[<"));
+            if (candidate.empty()) {
+                continue;
+            }
+            if (chosen.empty()) {
+                chosen = candidate;
+            }
+            if (prefer(candidate)) {
+                chosen = candidate;
+                break;
+            }
+        }
+        if (!chosen.empty()) {
+            visit(chosen);
+        }
+    }
+}
+
+/**
+ * @brief 逐个取出 "foo, bar (<< 2.0), baz:any" 中的包名（Provides 与 Conflicts 使用）
+ * @param unversionedOnly 跳过带版本约束的项（不比较版本，避免误报冲突）
+ */
+template <typename Visitor>
+void forEachName(std::string_view field, bool unversionedOnly, Visitor visit) {
+    while (!field.empty()) {
+        size_t comma = field.find(',');
+        std::string_view item = trim(field.substr(0, comma));
+        field = (comma == std::string_view::npos) ? std::string_view() : field.substr(comma + 1);
+
+        if (unversionedOnly && item.find('(') != std::string_view::npos) {
+            continue;
+        }
+        std::string_view name = item.substr(0, item.find_first_of(" (:"));
+        if (!name.empty()) {
+            visit(name);
+        }
+    }
+}
+
+/**
+ * @brief 只读映射整个文件（源文件可能有几十 MB，不复制到堆上）
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) : data_(nullptr), size_(0) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                data_ = static_cast<const char*>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+            }
+        }
+        close(fd);
+    }
+    ~MappedFile() {
+        if (data_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool valid() const { return data_ != nullptr; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+std::uint64_t fnv1a64(std::uint64_t h, const void* data, size_t n) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+} // namespace
+
+struct ComponentCatalog::Record {
+    std::uint32_t name;          // 字符串区偏移
+    std::uint32_t version;
+    std::uint32_t description;
+    std::uint32_t depBegin;      // 依赖 ID 表下标，依赖之后紧跟冲突项
+    std::uint32_t depCount;
+    std::uint32_t conflictCount;
+    std::uint32_t flags;
+};
+
+// ========== ComponentView ==========
+
+std::string_view ComponentView::name() const {
+    return catalog_->string(catalog_->record(id_).name);
+}
+
+std::string_view ComponentView::version() const {
+    return catalog_->string(catalog_->record(id_).version);
+}
+
+std::string_view ComponentView::description() const {
+    return catalog_->string(catalog_->record(id_).description);
+}
+
+bool ComponentView::installed() const {
+    return (catalog_->record(id_).flags & kFlagInstalled) != 0;
+}
+
+bool ComponentView::available() const {
+    return (catalog_->record(id_).flags & kFlagAvailable) != 0;
+}
+
+bool ComponentView::isVirtual() const {
+    return (catalog_->record(id_).flags & kFlagVirtual) != 0;
+}
+
+std::size_t ComponentView::dependencyCount() const {
+    return catalog_->record(id_).depCount;
+}
+
+std::uint32_t ComponentView::dependency(std::size_t i) const {
+    return catalog_->deps_[catalog_->record(id_).depBegin + i];
+}
+
+std::size_t ComponentView::conflictCount() const {
+    return catalog_->record(id_).conflictCount;
+}
+
+std::uint32_t ComponentView::conflict(std::size_t i) const {
+    const auto& r = catalog_->record(id_);
+    return catalog_->deps_[r.depBegin + r.depCount + i];
+}
+
+Component ComponentView::toComponent() const {
+    Component comp{std::string(name()), std::string(description())};
+    comp.version = std::string(version());
+    comp.installed = installed();
+    comp.dependencies.reserve(dependencyCount());
+    for (std::size_t i = 0; i < dependencyCount(); ++i) {
+        comp.dependencies.emplace_back(catalog_->view(dependency(i)).name());
+    }
+    return comp;
+}
+
+// ========== ComponentCatalog ==========
+
+ComponentCatalog::ComponentCatalog(const std::string& cachePath)
+    : cachePath_(cachePath),
+      mapping_(nullptr),
+      mappingSize_(0),
+      imageSize_(0),
+      records_(nullptr),
+      deps_(nullptr),
+      strings_(nullptr),
+      count_(0),
+      fingerprint_(0),
+      fromCache_(false) {
+}
+
+ComponentCatalog::~ComponentCatalog() {
+    reset();
+}
+
+void ComponentCatalog::reset() {
+    if (mapping_) {
+        munmap(mapping_, mappingSize_);
+        mapping_ = nullptr;
+        mappingSize_ = 0;
+    }
+    built_.clear();
+    built_.shrink_to_fit();
+    imageSize_ = 0;
+    records_ = nullptr;
+    deps_ = nullptr;
+    strings_ = nullptr;
+    count_ = 0;
+    fingerprint_ = 0;
+    fromCache_ = false;
+}
+
+const ComponentCatalog::Record& ComponentCatalog::record(std::uint32_t id) const {
+    return records_[id];
+}
+
+std::vector<std::string> ComponentCatalog::defaultSources() {
+    std::vector<std::string> sources = {"/var/lib/dpkg/status"};
+
+    const char* listsDir = "/var/lib/apt/lists";
+    std::vector<std::string> lists;
+    int fd = open(listsDir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        FileUtils::readEntries(fd, [&](const char* name, unsigned char) {
+            size_t len = std::strlen(name);
+            if (len > 9 && std::strcmp(name + len - 9, "_Packages") == 0) {
+                lists.push_back(std::string(listsDir) + "/" + name);
+            }
+        });
+        close(fd);
+    }
+    std::sort(lists.begin(), lists.end());
+    sources.insert(sources.end(), lists.begin(), lists.end());
+    return sources;
+}
+
+std::uint64_t ComponentCatalog::fingerprintSources(const std::vector<std::string>& sources) {
+    std::uint64_t h = fnv1a64(14695981039346656037ull, kMagic, sizeof(kMagic));
+    for (const auto& path : sources) {
+        struct stat st;
+        std::int64_t stamp[2] = {-1, -1};
+        if (stat(path.c_str(), &st) == 0) {
+            stamp[0] = static_cast<std::int64_t>(st.st_size);
+            stamp[1] = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        }
+        h = fnv1a64(h, path.data(), path.size() + 1);
+        h = fnv1a64(h, stamp, sizeof(stamp));
+    }
+    return h;
+}
+
+bool ComponentCatalog::load(const std::vector<std::string>& sources, bool refresh) {
+    reset();
+    std::uint64_t fingerprint = fingerprintSources(sources);
+    if (!refresh && mapCache(fingerprint)) {
+        fromCache_ = true;
+        return true;
+    }
+
+    std::string image = build(sources, fingerprint);
+    if (image.empty()) {
+        return false;
+    }
+
+    std::string dir = cachePath_.substr(0, cachePath_.find_last_of('/'));
+    if (!dir.empty()) {
+        mkdir(dir.c_str(), 0755);
+    }
+    // 写不了缓存（非 root）不影响本次使用
+    FileUtils::writeFileAtomic(cachePath_, image);
+
+    built_ = std::move(image);
+    return attach(built_.data(), built_.size(), fingerprint);
+}
+
+bool ComponentCatalog::mapCache(std::uint64_t fingerprint) {
+    int fd = open(cachePath_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(ImageHeader))) {
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    if (!attach(static_cast<const char*>(addr), size, fingerprint)) {
+        munmap(addr, size);
+        return false;
+    }
+    mapping_ = addr;
+    mappingSize_ = size;
+    return true;
+}
+
+bool ComponentCatalog::attach(const char* image, std::size_t size, std::uint64_t fingerprint) {
+    if (size < sizeof(ImageHeader)) {
+        return false;
+    }
+    ImageHeader header;
+    std::memcpy(&header, image, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.fingerprint != fingerprint) {
+        return false;
+    }
+
+    std::uint64_t recordsBytes = static_cast<std::uint64_t>(header.count) * sizeof(Record);
+    std::uint64_t depsBytes = static_cast<std::uint64_t>(header.depCount) * sizeof(std::uint32_t);
+    if (header.stringBytes == 0 ||
+        sizeof(ImageHeader) + recordsBytes + depsBytes + header.stringBytes != size) {
+        return false;
+    }
+
+    const Record* records = reinterpret_cast<const Record*>(image + sizeof(ImageHeader));
+    const std::uint32_t* deps = reinterpret_cast<const std::uint32_t*>(image + sizeof(ImageHeader) + recordsBytes);
+    const char* strings = image + sizeof(ImageHeader) + recordsBytes + depsBytes;
+    if (strings[header.stringBytes - 1] != '\0') {
+        return false;
+    }
+
+    // 缓存可能被截断或改坏：校验所有偏移，之后的访问不再检查边界
+    for (std::uint32_t i = 0; i < header.count; ++i) {
+        const Record& r = records[i];
+        if (r.name >= header.stringBytes || r.version >= header.stringBytes ||
+            r.description >= header.stringBytes ||
+            static_cast<std::uint64_t>(r.depBegin) + r.depCount + r.conflictCount > header.depCount) {
+            return false;
+        }
+    }
+    for (std::uint32_t i = 0; i < header.depCount; ++i) {
+        if (deps[i] >= header.count) {
+            return false;
+        }
+    }
+
+    imageSize_ = size;
+    records_ = records;
+    deps_ = deps;
+    strings_ = strings;
+    count_ = header.count;
+    fingerprint_ = fingerprint;
+    return true;
+}
+
+std::string ComponentCatalog::build(const std::vector<std::string>& sources, std::uint64_t fingerprint) {
+    // 包名与其他文本分开驻留：包名 ID 直接作为 pending 下标
+    StringPool names;
+    StringPool texts;
+    std::vector<PendingRecord> pending;
+    std::vector<std::uint32_t> deps;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> provides;  // (虚包名, 提供者)
+    bool anySource = false;
+
+    auto nameId = [&](std::string_view name) {
+        std::uint32_t id = names.intern(name);
+        if (id >= pending.size()) {
+            pending.resize(id + 1);
+        }
+        return id;
+    };
+    texts.intern("");
+
+    for (const auto& source : sources) {
+        MappedFile file(source);
+        if (!file.valid()) {
+            continue;
+        }
+        anySource = true;
+
+        std::string_view content = file.view();
+        std::string_view package, version, description, depends, preDepends, conflicts, provided;
+        bool hasStatus = false;
+        bool installed = false;
+
+        // dpkg 状态文件的条目带 Status 字段：只收录已安装的包（其余是残留配置）
+        auto commit = [&]() {
+            if (!package.empty() && (!hasStatus || installed)) {
+                std::uint32_t id = nameId(package);
+                if (!(pending[id].flags & kFlagAvailable)) {
+                    // 先 intern 依赖名：可能扩容 pending，之后再取引用
+                    std::uint32_t depBegin = static_cast<std::uint32_t>(deps.size());
+                    auto addDependency = [&](std::string_view dep) { deps.push_back(nameId(dep)); };
+                    // dpkg 状态文件最先解析：apt 列表中的候选已知是否安装
+                    auto isInstalled = [&](std::string_view dep) {
+                        return (pending[nameId(dep)].flags & kFlagInstalled) != 0;
+                    };
+                    forEachDependency(preDepends, isInstalled, addDependency);
+                    forEachDependency(depends, isInstalled, addDependency);
+                    std::uint32_t depCount = static_cast<std::uint32_t>(deps.size()) - depBegin;
+                    forEachName(conflicts, true, addDependency);
+                    forEachName(provided, false, [&](std::string_view name) {
+                        provides.emplace_back(nameId(name), id);
+                    });
+
+                    PendingRecord& r = pending[id];
+                    r.version = texts.intern(version);
+                    r.description = texts.intern(description);
+                    r.depBegin = depBegin;
+                    r.depCount = depCount;
+                    r.conflictCount = static_cast<std::uint32_t>(deps.size()) - depBegin - depCount;
+                    r.flags = kFlagAvailable | (installed ? kFlagInstalled : 0);
+                }
+            }
+            package = version = description = depends = preDepends = conflicts = provided = std::string_view();
+            hasStatus = false;
+            installed = false;
+        };
+
+        size_t pos = 0;
+        while (pos < content.size()) {
+            size_t end = content.find('\n', pos);
+            if (end == std::string_view::npos) {
+                end = content.size();
+            }
+            std::string_view line = content.substr(pos, end - pos);
+            pos = end + 1;
+
+            if (line.empty() || line == "\r") {
+                commit();
+                continue;
+            }
+            if (line[0] == ' ' || line[0] == '\t') {
+                continue;  // 续行（长描述等）
+            }
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos) {
+                continue;
+            }
+            std::string_view key = line.substr(0, colon);
+            std::string_view value = trim(line.substr(colon + 1));
+            if (key == "Package") {
+                package = value;
+            } else if (key == "Version") {
+                version = value;
+            } else if (key == "Description") {
+                description = value;
+            } else if (key == "Depends") {
+                depends = value;
+            } else if (key == "Pre-Depends") {
+                preDepends = value;
+            } else if (key == "Conflicts") {
+                conflicts = value;
+            } else if (key == "Provides") {
+                provided = value;
+            } else if (key == "Status") {
+                hasStatus = true;
+                installed = value.size() >= 10 && value.substr(value.size() - 10) == " installed";
+            }
+        }
+        commit();
+    }
+
+    if (!anySource) {
+        return std::string();
+    }
+
+    // 没有实际条目的名字若被其他包 Provides，记为虚包，其依赖表即提供者列表
+    std::stable_sort(provides.begin(), provides.end(),
+                     [](const std::pair<std::uint32_t, std::uint32_t>& a,
+                        const std::pair<std::uint32_t, std::uint32_t>& b) { return a.first < b.first; });
+    for (size_t i = 0; i < provides.size();) {
+        std::uint32_t virtualId = provides[i].first;
+        PendingRecord& r = pending[virtualId];
+        bool isVirtual = !(r.flags & kFlagAvailable);
+        if (isVirtual) {
+            r.depBegin = static_cast<std::uint32_t>(deps.size());
+            r.flags |= kFlagVirtual;
+        }
+        for (; i < provides.size() && provides[i].first == virtualId; ++i) {
+            if (isVirtual && provides[i].second != virtualId &&
+                (deps.size() == r.depBegin || deps.back() != provides[i].second)) {
+                deps.push_back(provides[i].second);
+            }
+        }
+        if (isVirtual) {
+            r.depCount = static_cast<std::uint32_t>(deps.size()) - r.depBegin;
+        }
+    }
+
+    // 按包名排序后重新编号，ID 即条目表下标，查找用二分
+    std::uint32_t count = static_cast<std::uint32_t>(names.size());
+    std::vector<std::uint32_t> order(count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&names](std::uint32_t a, std::uint32_t b) {
+        return names.get(a) < names.get(b);
+    });
+    std::vector<std::uint32_t> remap(count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        remap[order[i]] = i;
+    }
+
+    std::string strings(1, '\0');
+    std::vector<std::uint32_t> textOffsets(texts.size(), kInvalidId);
+    textOffsets[0] = 0;
+    auto textOffset = [&](std::uint32_t id) {
+        if (textOffsets[id] == kInvalidId) {
+            textOffsets[id] = static_cast<std::uint32_t>(strings.size());
+            strings.append(texts.get(id));
+            strings.push_back('\0');
+        }
+        return textOffsets[id];
+    };
+
+    std::vector<Record> records(count);
+    std::vector<std::uint32_t> packedDeps;
+    packedDeps.reserve(deps.size());
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const PendingRecord& p = pending[order[i]];
+        Record& r = records[i];
+        r.name = static_cast<std::uint32_t>(strings.size());
+        strings.append(names.get(order[i]));
+        strings.push_back('\0');
+        r.version = textOffset(p.version);
+        r.description = textOffset(p.description);
+        r.depBegin = static_cast<std::uint32_t>(packedDeps.size());
+        r.depCount = p.depCount;
+        r.conflictCount = p.conflictCount;
+        r.flags = p.flags;
+        for (std::uint32_t d = 0; d < p.depCount + p.conflictCount; ++d) {
+            packedDeps.push_back(remap[deps[p.depBegin + d]]);
+        }
+    }
+
+    ImageHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.fingerprint = fingerprint;
+    header.count = count;
+    header.depCount = static_cast<std::uint32_t>(packedDeps.size());
+    header.stringBytes = strings.size();
+
+    std::string image;
+    image.reserve(sizeof(header) + records.size() * sizeof(Record) +
+                  packedDeps.size() * sizeof(std::uint32_t) + strings.size());
+    image.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    image.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+    image.append(reinterpret_cast<const char*>(packedDeps.data()), packedDeps.size() * sizeof(std::uint32_t));
+    image.append(strings);
+    return image;
+}
+
+std::uint32_t ComponentCatalog::find(std::string_view name) const {
+    std::uint32_t low = 0;
+    std::uint32_t high = count_;
+    while (low < high) {
+        std::uint32_t mid = low + (high - low) / 2;
+        int cmp = string(records_[mid].name).compare(name);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return kInvalidId;
+}
+
+void ComponentCatalog::forEach(const std::function<void(const ComponentView&)>& visitor) const {
+    for (std::uint32_t i = 0; i < count_; ++i) {
+        if (records_[i].flags & kFlagAvailable) {
+            visitor(ComponentView(this, i));
+        }
+    }
+}
+
+std::vector<ComponentView> ComponentCatalog::search(std::string_view keyword) const {
+    std::vector<ComponentView> result;
+    for (std::uint32_t i = 0; i < count_; ++i) {
+        const Record& r = records_[i];
+        if ((r.flags & kFlagAvailable) &&
+            (string(r.name).find(keyword) != std::string_view::npos ||
+             string(r.description).find(keyword) != std::string_view::npos)) {
+            result.push_back(ComponentView(this, i));
+        }
+    }
+    return result;
+}
+
+} // namespace LinuxStudio
@@ -0,0 +1,415 @@
+#include "linuxstudio/dependency_resolver.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+
+#include <sys/stat.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+const char* kCacheHeader = "xkl-resolve-1";
+
+std::uint64_t fnv1a64(std::uint64_t h, const void* data, size_t n) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+const std::uint64_t kFnvOffset = 14695981039346656037ull;
+
+std::string toHex(std::uint64_t value) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+    return buffer;
+}
+
+std::string joinNames(const std::vector<std::string>& names) {
+    std::string out;
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (i > 0) {
+            out += ' ';
+        }
+        out += names[i];
+    }
+    return out;
+}
+
+std::vector<std::string> sortedUnique(std::vector<std::string> names) {
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
+} // namespace
+
+std::size_t Resolution::pendingCount() const {
+    std::size_t count = 0;
+    for (const auto& level : levels) {
+        count += level.size();
+    }
+    return count;
+}
+
+DependencyResolver::DependencyResolver(const ComponentCatalog& catalog, std::uint64_t registryVersion,
+                                       const std::string& cacheDir)
+    : catalog_(catalog), registryVersion_(registryVersion), cacheDir_(cacheDir), extraHash_(kFnvOffset) {
+}
+
+void DependencyResolver::addDependencies(const std::string& package,
+                                         const std::vector<std::string>& dependencies) {
+    std::uint32_t id = catalog_.find(package);
+    if (id == ComponentCatalog::kInvalidId || dependencies.empty()) {
+        return;
+    }
+    extraHash_ = fnv1a64(extraHash_, package.data(), package.size() + 1);
+    auto& extra = extraDependencies_[id];
+    for (const auto& dep : dependencies) {
+        std::uint32_t depId = catalog_.find(dep);
+        if (depId != ComponentCatalog::kInvalidId) {
+            extra.push_back(depId);
+            extraHash_ = fnv1a64(extraHash_, dep.data(), dep.size() + 1);
+        }
+    }
+}
+
+std::uint32_t DependencyResolver::choose(std::uint32_t id) const {
+    ComponentView view = catalog_.view(id);
+    if (!view.isVirtual()) {
+        return id;
+    }
+    // 虚包：已安装的提供者优先，否则取第一个
+    for (std::size_t i = 0; i < view.dependencyCount(); ++i) {
+        if (catalog_.view(view.dependency(i)).installed()) {
+            return view.dependency(i);
+        }
+    }
+    return view.dependencyCount() > 0 ? view.dependency(0) : id;
+}
+
+void DependencyResolver::dependenciesOf(std::uint32_t id, std::vector<std::uint32_t>& out) const {
+    out.clear();
+    ComponentView view = catalog_.view(id);
+    for (std::size_t i = 0; i < view.dependencyCount(); ++i) {
+        out.push_back(choose(view.dependency(i)));
+    }
+    auto extra = extraDependencies_.find(id);
+    if (extra != extraDependencies_.end()) {
+        out.insert(out.end(), extra->second.begin(), extra->second.end());
+    }
+}
+
+Resolution DependencyResolver::resolve(const std::vector<std::string>& roots, bool refresh, bool fullClosure) {
+    std::vector<std::string> normalized = sortedUnique(roots);
+    std::string path = cachePath(normalized, fullClosure);
+    std::uint64_t key = cacheKey(normalized, fullClosure);
+
+    Resolution result;
+    if (!refresh && loadCache(path, key, result)) {
+        result.fromCache = true;
+        return result;
+    }
+
+    result = compute(normalized, fullClosure);
+    saveCache(path, key, result);
+    return result;
+}
+
+Resolution DependencyResolver::compute(const std::vector<std::string>& roots, bool fullClosure) const {
+    Resolution result;
+    result.roots = roots;
+
+    const std::uint32_t kNone = ComponentCatalog::kInvalidId;
+    std::size_t total = catalog_.size();
+    std::vector<std::uint8_t> visited(total, 0);
+    std::vector<std::uint32_t> pending;     // 闭包中待安装的包
+    std::vector<std::uint32_t> stack;
+    std::set<std::string> missing;
+    std::vector<std::uint32_t> deps;
+
+    auto visit = [&](std::uint32_t id) {
+        if (!visited[id]) {
+            visited[id] = 1;
+            stack.push_back(id);
+        }
+    };
+
+    for (const auto& root : roots) {
+        std::uint32_t id = catalog_.find(root);
+        if (id == kNone || !catalog_.view(choose(id)).available()) {
+            missing.insert(root);
+            continue;
+        }
+        id = choose(id);
+        visit(id);
+
+        std::vector<std::string>& direct = result.dependencies[root];
+        dependenciesOf(id, deps);
+        for (std::uint32_t dep : deps) {
+            direct.emplace_back(catalog_.view(dep).name());
+        }
+    }
+
+    // 传递闭包：已安装的包视为已满足，不再展开（其依赖可能由同组的其他候选满足）；
+    // 完整闭包模式下已安装的包同样展开，与待安装的包一起分层
+    while (!stack.empty()) {
+        std::uint32_t id = stack.back();
+        stack.pop_back();
+        ++result.closureSize;
+        ComponentView view = catalog_.view(id);
+        if (view.installed()) {
+            ++result.installedCount;
+            if (!fullClosure) {
+                continue;
+            }
+        } else if (!view.available()) {
+            missing.insert(std::string(view.name()));
+            continue;
+        }
+        pending.push_back(id);
+        dependenciesOf(id, deps);
+        for (std::uint32_t dep : deps) {
+            visit(dep);
+        }
+    }
+    std::sort(pending.begin(), pending.end());
+
+    // 待安装子图（CSR 邻接表），下标为 pending 中的位置
+    std::vector<std::uint32_t> local(total, kNone);
+    for (std::uint32_t i = 0; i < pending.size(); ++i) {
+        local[pending[i]] = i;
+    }
+    std::vector<std::uint32_t> edgeBegin(pending.size() + 1, 0);
+    std::vector<std::uint32_t> edges;
+    for (std::uint32_t i = 0; i < pending.size(); ++i) {
+        dependenciesOf(pending[i], deps);
+        for (std::uint32_t dep : deps) {
+            if (local[dep] != kNone) {
+                edges.push_back(local[dep]);
+            }
+        }
+        edgeBegin[i + 1] = static_cast<std::uint32_t>(edges.size());
+    }
+
+    // Tarjan 强连通分量（迭代实现，依赖链很深时不会爆栈）。
+    // 边从包指向其依赖，分量按逆拓扑序产生：产生某分量时它依赖的分量都已产生，
+    // 层号 = 1 + 依赖分量的最大层号
+    std::size_t n = pending.size();
+    std::vector<std::uint32_t> index(n, kNone);
+    std::vector<std::uint32_t> lowlink(n, 0);
+    std::vector<std::uint8_t> onStack(n, 0);
+    std::vector<std::uint32_t> component(n, kNone);
+    std::vector<std::uint32_t> componentLevel;
+    std::vector<std::uint32_t> sccStack;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> callStack;  // (节点, 下一条边)
+    std::uint32_t counter = 0;
+
+    for (std::uint32_t start = 0; start < n; ++start) {
+        if (index[start] != kNone) {
+            continue;
+        }
+        callStack.emplace_back(start, edgeBegin[start]);
+        index[start] = lowlink[start] = counter++;
+        sccStack.push_back(start);
+        onStack[start] = 1;
+
+        while (!callStack.empty()) {
+            std::uint32_t v = callStack.back().first;
+            std::uint32_t& next = callStack.back().second;
+            if (next < edgeBegin[v + 1]) {
+                std::uint32_t w = edges[next++];
+                if (index[w] == kNone) {
+                    index[w] = lowlink[w] = counter++;
+                    sccStack.push_back(w);
+                    onStack[w] = 1;
+                    callStack.emplace_back(w, edgeBegin[w]);
+                } else if (onStack[w]) {
+                    lowlink[v] = std::min(lowlink[v], index[w]);
+                }
+                continue;
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                std::uint32_t parent = callStack.back().first;
+                lowlink[parent] = std::min(lowlink[parent], lowlink[v]);
+            }
+            if (lowlink[v] != index[v]) {
+                continue;
+            }
+
+            std::uint32_t id = static_cast<std::uint32_t>(componentLevel.size());
+            std::vector<std::uint32_t> members;
+            std::uint32_t w;
+            do {
+                w = sccStack.back();
+                sccStack.pop_back();
+                onStack[w] = 0;
+                component[w] = id;
+                members.push_back(w);
+            } while (w != v);
+
+            std::uint32_t level = 0;
+            for (std::uint32_t member : members) {
+                for (std::uint32_t e = edgeBegin[member]; e < edgeBegin[member + 1]; ++e) {
+                    std::uint32_t dep = component[edges[e]];
+                    if (dep != id) {
+                        level = std::max(level, componentLevel[dep] + 1);
+                    }
+                }
+            }
+            componentLevel.push_back(level);
+
+            if (result.levels.size() <= level) {
+                result.levels.resize(level + 1);
+            }
+            std::vector<std::string> names;
+            for (std::uint32_t member : members) {
+                names.emplace_back(catalog_.view(pending[member]).name());
+                result.levels[level].push_back(names.back());
+            }
+            if (members.size() > 1) {
+                result.cycles.push_back(sortedUnique(names));
+            }
+        }
+    }
+    for (auto& level : result.levels) {
+        std::sort(level.begin(), level.end());
+    }
+    std::sort(result.cycles.begin(), result.cycles.end());
+
+    // 冲突：待安装的包与已安装或同批待安装的包互斥（Provides 自身的虚包除外）
+    std::set<std::pair<std::string, std::string>> conflicts;
+    auto isPresent = [&](std::uint32_t id) {
+        return catalog_.view(id).installed() || local[id] != kNone;
+    };
+    for (std::uint32_t id : pending) {
+        ComponentView view = catalog_.view(id);
+        if (view.installed()) {
+            continue;  // 完整闭包中已安装的包：已共存于系统，不再检查
+        }
+        for (std::size_t i = 0; i < view.conflictCount(); ++i) {
+            ComponentView target = catalog_.view(view.conflict(i));
+            std::vector<std::uint32_t> candidates;
+            if (target.isVirtual()) {
+                for (std::size_t p = 0; p < target.dependencyCount(); ++p) {
+                    candidates.push_back(target.dependency(p));
+                }
+            } else {
+                candidates.push_back(target.id());
+            }
+            for (std::uint32_t other : candidates) {
+                if (other != id && isPresent(other)) {
+                    std::string a(view.name());
+                    std::string b(catalog_.view(other).name());
+                    conflicts.insert(a < b ? std::make_pair(a, b) : std::make_pair(b, a));
+                }
+            }
+        }
+    }
+    result.conflicts.assign(conflicts.begin(), conflicts.end());
+    result.missing.assign(missing.begin(), missing.end());
+    return result;
+}
+
+std::uint64_t DependencyResolver::cacheKey(const std::vector<std::string>& roots, bool fullClosure) const {
+    std::uint64_t parts[4] = {catalog_.fingerprint(), registryVersion_, extraHash_, fullClosure ? 1u : 0u};
+    std::uint64_t h = fnv1a64(kFnvOffset, parts, sizeof(parts));
+    for (const auto& root : roots) {
+        h = fnv1a64(h, root.data(), root.size() + 1);
+    }
+    return h;
+}
+
+std::string DependencyResolver::cachePath(const std::vector<std::string>& roots, bool fullClosure) const {
+    // 文件名只由根（与模式）决定：同一组根只保留最新的一份结果
+    std::uint64_t h = fullClosure ? fnv1a64(kFnvOffset, "full", 4) : kFnvOffset;
+    for (const auto& root : roots) {
+        h = fnv1a64(h, root.data(), root.size() + 1);
+    }
+    return cacheDir_ + "/" + toHex(h) + ".res";
+}
+
+// 缓存格式（每行一条，字段以 TAB 分隔，包名列表以空格分隔）：
+//   xkl-resolve-1 <键>
+//   N <闭包大小> <已安装数>
+//   R <根...>      M <缺失的包...>
+//   L <一层的包...> Y <一个环的包...>
+//   C <包> <冲突包>  D <根> <直接依赖...>
+bool DependencyResolver::loadCache(const std::string& path, std::uint64_t key, Resolution& result) const {
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(path, lines) || lines.empty() ||
+        lines[0] != std::string(kCacheHeader) + "\t" + toHex(key)) {
+        return false;
+    }
+
+    result = Resolution();
+    for (size_t i = 1; i < lines.size(); ++i) {
+        const std::string& line = lines[i];
+        if (line.size() < 2 || line[1] != '\t') {
+            continue;
+        }
+        size_t tab = line.find('\t', 2);
+        std::string first = line.substr(2, tab == std::string::npos ? std::string::npos : tab - 2);
+        std::string rest = (tab == std::string::npos) ? std::string() : line.substr(tab + 1);
+        switch (line[0]) {
+            case 'N':
+                result.closureSize = std::strtoull(first.c_str(), nullptr, 10);
+                result.installedCount = std::strtoull(rest.c_str(), nullptr, 10);
+                break;
+            case 'R':
+                result.roots = FileUtils::splitFields(line.substr(2));
+                break;
+            case 'M':
+                result.missing = FileUtils::splitFields(line.substr(2));
+                break;
+            case 'L':
+                result.levels.push_back(FileUtils::splitFields(line.substr(2)));
+                break;
+            case 'Y':
+                result.cycles.push_back(FileUtils::splitFields(line.substr(2)));
+                break;
+            case 'C':
+                result.conflicts.emplace_back(first, rest);
+                break;
+            case 'D':
+                result.dependencies[first] = FileUtils::splitFields(rest);
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+void DependencyResolver::saveCache(const std::string& path, std::uint64_t key, const Resolution& result) const {
+    std::string content = std::string(kCacheHeader) + "\t" + toHex(key) + "\n";
+    content += "N\t" + std::to_string(result.closureSize) + "\t" + std::to_string(result.installedCount) + "\n";
+    content += "R\t" + joinNames(result.roots) + "\n";
+    content += "M\t" + joinNames(result.missing) + "\n";
+    for (const auto& level : result.levels) {
+        content += "L\t" + joinNames(level) + "\n";
+    }
+    for (const auto& cycle : result.cycles) {
+        content += "Y\t" + joinNames(cycle) + "\n";
+    }
+    for (const auto& conflict : result.conflicts) {
+        content += "C\t" + conflict.first + "\t" + conflict.second + "\n";
+    }
+    for (const auto& entry : result.dependencies) {
+        content += "D\t" + entry.first + "\t" + joinNames(entry.second) + "\n";
+    }
+
+    std::string parent = cacheDir_.substr(0, cacheDir_.find_last_of('/'));
+    mkdir(parent.c_str(), 0755);
+    mkdir(cacheDir_.c_str(), 0755);
+    FileUtils::writeFileAtomic(path, content);
+}
+
+} // namespace LinuxStudio
@@ -1,8 +1,8 @@
 #include "linuxstudio/core.hpp"
 #include "linuxstudio/managers.hpp"
 #include "linuxstudio/logger.hpp"
-#include <fstream>
-#include <sstream>
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/resource_slice.hpp"
 #include <cstdlib>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -12,6 +12,8 @@
     #include <unistd.h>
     #include <sys/utsname.h>
     #include <sys/sysinfo.h>
+    #include <sys/resource.h>
+    #include <malloc.h>
 #elif _WIN32
     #include <windows.h>
     #pragma message("WARNING: LinuxStudio C++ version is designed for Linux. Windows support is limited.")
@@ -21,6 +23,43 @@
 
 namespace LinuxStudio {
 
+#if defined(__linux__) && defined(LINUXSTUDIO_EMBEDDED)
+namespace {
+
+// 默认内存预算（MB），可用环境变量 XKL_MEMORY_BUDGET_MB 覆盖，0 表示不限制
+const long kDefaultMemoryBudgetMB = 64;
+
+/**
+ * @brief 嵌入式模式：收紧 malloc 并设置数据段硬上限
+ * 超出预算时分配失败，而不是拖垮板子上的其他进程
+ */
+void applyMemoryBudget() {
+    // 所有线程共用一个 arena，避免每线程预留 64 MB 地址空间；固定阈值，及时归还内存
+    mallopt(M_ARENA_MAX, 1);
+    mallopt(M_MMAP_THRESHOLD, 64 * 1024);
+    mallopt(M_TRIM_THRESHOLD, 128 * 1024);
+
+    long budgetMB = kDefaultMemoryBudgetMB;
+    if (const char* env = std::getenv("XKL_MEMORY_BUDGET_MB")) {
+        budgetMB = std::atol(env);
+    }
+    if (budgetMB <= 0) {
+        return;
+    }
+    // 只设软限制：Process 启动 apt/pip 前会解除，外部命令不受 xkl 的预算约束
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_DATA, &limit) == 0) {
+        rlim_t bytes = static_cast<rlim_t>(budgetMB) * 1024 * 1024;
+        if (limit.rlim_max == RLIM_INFINITY || bytes <= limit.rlim_max) {
+            limit.rlim_cur = bytes;
+            setrlimit(RLIMIT_DATA, &limit);
+        }
+    }
+}
+
+} // namespace
+#endif
+
 // 单例实例
 CoreEngine& CoreEngine::getInstance() {
     static CoreEngine instance;
@@ -30,9 +69,14 @@ CoreEngine& CoreEngine::getInstance() {
 // 私有构造函数
 CoreEngine::CoreEngine() 
     : initialized_(false) {
+#if defined(__linux__) && defined(LINUXSTUDIO_EMBEDDED)
+    applyMemoryBudget();
+#endif
     logger_ = std::make_unique<Logger>();
     componentMgr_ = std::make_unique<ComponentManager>();
     pluginMgr_ = std::make_unique<PluginManager>();
+    mirrorMgr_ = std::make_unique<MirrorManager>();
+    pythonEnvMgr_ = std::make_unique<PythonEnvManager>();
 }
 
 CoreEngine::~CoreEngine() {
@@ -50,6 +94,8 @@ bool CoreEngine::initialize() {
         struct stat info;
         const char* baseDir = "/opt/linuxstudio";
         const char* logDir = "/opt/linuxstudio/logs";
+        const char* configOverride = std::getenv("XKL_CONFIG");
+        configPath_ = configOverride && *configOverride ? configOverride : "/etc/linuxstudio/config.yaml";
         
         // 检查并创建基础目录
         if (stat(baseDir, &info) != 0) {
@@ -63,9 +109,15 @@ bool CoreEngine::initialize() {
         
         // 如果目录存在（或创建成功），设置日志文件
         if (stat(logDir, &info) == 0 && S_ISDIR(info.st_mode)) {
-            logger_->setLogFile("/opt/linuxstudio/logs/linuxstudio.log");
+            // 分段大小、保留总量与攒批写入可在配置文件中调整
+            logger_->loadConfig(configPath_);
+            logger_->setLogFile(Logger::kDefaultPath);
         }
         // 如果目录不存在或创建失败（权限问题），跳过文件日志（只输出到控制台）
+        
+        // 安装子进程的 cgroup 限额
+        ResourceSlice::getInstance().loadConfig(configPath_);
+        componentMgr_->getSourceBuilder().loadConfig(configPath_);
     #endif
     
     logger_->info("Initializing LinuxStudio Framework...");
@@ -95,10 +147,9 @@ SystemInfo CoreEngine::detectSystem() {
     }
     
     // 读取 /etc/os-release 获取发行版信息
-    std::ifstream osRelease("/etc/os-release");
-    if (osRelease.is_open()) {
-        std::string line;
-        while (std::getline(osRelease, line)) {
+    std::vector<std::string> osRelease;
+    if (FileUtils::readLines("/etc/os-release", osRelease)) {
+        for (const auto& line : osRelease) {
             if (line.find("PRETTY_NAME=") == 0) {
                 // 提取引号中的内容
                 size_t start = line.find('"') + 1;
@@ -114,7 +165,6 @@ SystemInfo CoreEngine::detectSystem() {
                 }
             }
         }
-        osRelease.close();
     }
     
     // 获取 CPU 核心数
@@ -166,6 +216,38 @@ SystemInfo CoreEngine::detectSystem() {
     return info;
 }
 
+MemoryFootprint CoreEngine::getMemoryFootprint() const {
+    MemoryFootprint footprint;
+#ifdef LINUXSTUDIO_EMBEDDED
+    footprint.embedded = true;
+#endif
+
+#ifdef __linux__
+    std::vector<std::string> status;
+    if (FileUtils::readLines("/proc/self/status", status)) {
+        for (const auto& line : status) {
+            if (line.compare(0, 6, "VmRSS:") == 0) {
+                footprint.rssKB = std::atoll(line.c_str() + 6);
+            } else if (line.compare(0, 6, "VmHWM:") == 0) {
+                footprint.peakRssKB = std::atoll(line.c_str() + 6);
+            }
+        }
+    }
+
+    struct stat exe;
+    if (stat("/proc/self/exe", &exe) == 0) {
+        footprint.binaryBytes = exe.st_size;
+    }
+
+    struct rlimit limit;
+    if (footprint.embedded && getrlimit(RLIMIT_DATA, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        footprint.budgetMB = static_cast<long long>(limit.rlim_cur / (1024 * 1024));
+    }
+#endif
+
+    return footprint;
+}
+
 std::vector<Component> CoreEngine::recommendComponents(SceneType scene) {
     std::vector<Component> components;
     
@@ -211,6 +293,14 @@ PluginManager& CoreEngine::getPluginManager() {
     return *pluginMgr_;
 }
 
+MirrorManager& CoreEngine::getMirrorManager() {
+    return *mirrorMgr_;
+}
+
+PythonEnvManager& CoreEngine::getPythonEnvManager() {
+    return *pythonEnvMgr_;
+}
+
 Logger& CoreEngine::getLogger() {
     return *logger_;
 }
@@ -0,0 +1,226 @@
+#include "linuxstudio/i18n.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace LinuxStudio {
+
+namespace {
+
+// 目录文件格式（小端）：
+//   char     magic[8]   "XKLCAT01"
+//   uint32_t count
+//   uint32_t reserved
+//   struct { uint32_t keyHash; uint32_t offset; } entries[count]  按 keyHash 升序
+//   字符串区：每条为 "key\0译文\0"，offset 相对文件起始
+const char kCatalogMagic[8] = {'X', 'K', 'L', 'C', 'A', 'T', '0', '1'};
+const std::size_t kHeaderSize = 16;
+const std::size_t kEntrySize = 8;
+
+std::uint32_t readU32(const unsigned char* p) {
+    return static_cast<std::uint32_t>(p[0]) |
+           (static_cast<std::uint32_t>(p[1]) << 8) |
+           (static_cast<std::uint32_t>(p[2]) << 16) |
+           (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+void appendU32(std::string& out, std::uint32_t v) {
+    out.push_back(static_cast<char>(v & 0xFF));
+    out.push_back(static_cast<char>((v >> 8) & 0xFF));
+    out.push_back(static_cast<char>((v >> 16) & 0xFF));
+    out.push_back(static_cast<char>((v >> 24) & 0xFF));
+}
+
+} // namespace
+
+I18n::~I18n() {
+#ifdef __linux__
+    if (catalog_) {
+        munmap(const_cast<unsigned char*>(catalog_), catalogSize_);
+    }
+#endif
+}
+
+void I18n::detectLanguage() {
+    currentLang_ = Language::EN;
+
+    // 显式指定的目录文件优先
+    const char* catalogPath = std::getenv("XKL_I18N_CATALOG");
+    if (catalogPath && *catalogPath && loadCatalog(catalogPath)) {
+        return;
+    }
+
+    const char* lang = std::getenv("LANG");
+    if (!lang || !*lang) {
+        return;
+    }
+    // 检查是否为中文（zh_CN、zh_TW、zh 等）
+    if (std::strstr(lang, "zh") != nullptr) {
+        currentLang_ = Language::ZH_CN;
+        return;
+    }
+    if (std::strncmp(lang, "en", 2) == 0 || std::strcmp(lang, "C") == 0 ||
+        std::strncmp(lang, "C.", 2) == 0 || std::strcmp(lang, "POSIX") == 0) {
+        return;
+    }
+
+    // 取语言代码（如 ja_JP.UTF-8 -> ja），查找 /opt/linuxstudio/i18n/ja.cat
+    char code[16];
+    std::size_t n = 0;
+    while (lang[n] && lang[n] != '_' && lang[n] != '.' && lang[n] != '@' && n < sizeof(code) - 1) {
+        code[n] = lang[n];
+        ++n;
+    }
+    code[n] = '\0';
+
+    char path[64];
+    std::snprintf(path, sizeof(path), "/opt/linuxstudio/i18n/%s.cat", code);
+    loadCatalog(path);
+}
+
+bool I18n::loadCatalog(const char* path) {
+#ifdef __linux__
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < kHeaderSize) {
+        close(fd);
+        return false;
+    }
+
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    const unsigned char* data = static_cast<const unsigned char*>(addr);
+    std::uint32_t count = readU32(data + 8);
+    if (std::memcmp(data, kCatalogMagic, sizeof(kCatalogMagic)) != 0 ||
+        kHeaderSize + static_cast<std::size_t>(count) * kEntrySize > size) {
+        munmap(addr, size);
+        return false;
+    }
+
+    if (catalog_) {
+        munmap(const_cast<unsigned char*>(catalog_), catalogSize_);
+    }
+    catalog_ = data;
+    catalogSize_ = size;
+    currentLang_ = Language::CATALOG;
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+const char* I18n::lookupCatalog(std::uint32_t keyHash, const char* key) const {
+    if (!catalog_) {
+        return nullptr;
+    }
+
+    std::uint32_t count = readU32(catalog_ + 8);
+    const unsigned char* entries = catalog_ + kHeaderSize;
+
+    // 二分查找第一个 keyHash 不小于目标的条目
+    std::uint32_t lo = 0;
+    std::uint32_t hi = count;
+    while (lo < hi) {
+        std::uint32_t mid = lo + (hi - lo) / 2;
+        if (readU32(entries + mid * kEntrySize) < keyHash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // 哈希相同的条目再比较原文
+    for (; lo < count && readU32(entries + lo * kEntrySize) == keyHash; ++lo) {
+        std::uint32_t offset = readU32(entries + lo * kEntrySize + 4);
+        if (offset >= catalogSize_) {
+            return nullptr;
+        }
+        const char* entryKey = reinterpret_cast<const char*>(catalog_ + offset);
+        std::size_t keyLen = strnlen(entryKey, catalogSize_ - offset);
+        if (offset + keyLen + 1 >= catalogSize_) {
+            return nullptr;
+        }
+        if (std::strcmp(entryKey, key) == 0) {
+            const char* text = entryKey + keyLen + 1;
+            if (strnlen(text, catalogSize_ - offset - keyLen - 1) == catalogSize_ - offset - keyLen - 1) {
+                return nullptr;  // 未以 \0 结尾，文件损坏
+            }
+            return text;
+        }
+    }
+    return nullptr;
+}
+
+bool I18n::compileCatalog(const char* sourcePath, const char* outputPath) {
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(sourcePath, lines)) {
+        return false;
+    }
+
+    struct Item {
+        std::uint32_t hash;
+        std::string key;
+        std::string text;
+    };
+    std::vector<Item> items;
+
+    for (const auto& line : lines) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;
+        }
+        Item item;
+        item.key = line.substr(0, tab);
+        item.text = line.substr(tab + 1);
+        item.hash = i18n::hashKey(item.key.c_str(), 0);
+        items.push_back(item);
+    }
+
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        return a.hash < b.hash;
+    });
+
+    std::string out(kCatalogMagic, sizeof(kCatalogMagic));
+    appendU32(out, static_cast<std::uint32_t>(items.size()));
+    appendU32(out, 0);
+
+    std::string strings;
+    std::size_t stringBase = kHeaderSize + items.size() * kEntrySize;
+    for (const auto& item : items) {
+        appendU32(out, item.hash);
+        appendU32(out, static_cast<std::uint32_t>(stringBase + strings.size()));
+        strings += item.key;
+        strings.push_back('\0');
+        strings += item.text;
+        strings.push_back('\0');
+    }
+    out += strings;
+
+    return FileUtils::writeFileAtomic(outputPath, out);
+}
+
+} // namespace LinuxStudio
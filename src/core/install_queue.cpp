@@ -0,0 +1,613 @@
+#include "linuxstudio/install_queue.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+// 等待期间检查停止标志与任务退出的间隔
+const int kSliceMs = 250;
+
+/**
+ * @brief 解析时长（如 30s、5m；无后缀为秒）
+ */
+bool parseDuration(const std::string& text, long& seconds) {
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (end == text.c_str()) {
+        return false;
+    }
+    switch (*end) {
+        case 's': case '\0': break;
+        case 'm': value *= 60; break;
+        case 'h': value *= 3600; break;
+        default: return false;
+    }
+    seconds = value;
+    return true;
+}
+
+/**
+ * @brief 本地时间，格式 2024-01-31T08:00:00
+ */
+std::string currentTimestamp() {
+    std::time_t now = std::time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &local);
+    return buffer;
+}
+
+/**
+ * @brief PSI 文件中 "some avg10=<百分比>"，文件不存在或格式不符返回 -1
+ */
+double someAvg10(const char* path) {
+    std::string content;
+    if (!FileUtils::readFile(path, content) || content.compare(0, 4, "some") != 0) {
+        return -1;
+    }
+    std::size_t avg = content.find("avg10=");
+    return avg == std::string::npos ? -1 : std::strtod(content.c_str() + avg + 6, nullptr);
+}
+
+const InstallQueue::State kStates[] = {
+    InstallQueue::State::Queued, InstallQueue::State::Running, InstallQueue::State::Paused,
+    InstallQueue::State::Done, InstallQueue::State::Failed, InstallQueue::State::Exited,
+};
+
+// 队列文件每行一个任务：id<TAB>kind<TAB>name<TAB>state<TAB>addedAt<TAB>finishedAt<TAB>pauses<TAB>pid<TAB>bootId
+// （旧版本写的行没有 bootId）
+std::string serialize(const InstallQueue::Job& job) {
+    return std::to_string(job.id) + "\t" + InstallQueue::kindName(job.kind) + "\t" + job.name + "\t" +
+           InstallQueue::stateName(job.state) + "\t" + job.addedAt + "\t" + job.finishedAt + "\t" +
+           std::to_string(job.pauses) + "\t" + std::to_string(job.pid) + "\t" + job.bootId + "\n";
+}
+
+bool parse(const std::string& line, InstallQueue::Job& job) {
+    std::vector<std::string> fields(1);
+    for (char c : line) {
+        if (c == '\t') {
+            fields.emplace_back();
+        } else {
+            fields.back() += c;
+        }
+    }
+    if ((fields.size() != 8 && fields.size() != 9) || !InstallQueue::parseKind(fields[1], job.kind)) {
+        return false;
+    }
+    job.id = static_cast<unsigned>(std::strtoul(fields[0].c_str(), nullptr, 10));
+    job.name = fields[2];
+    job.state = InstallQueue::State::Queued;
+    for (auto state : kStates) {
+        if (fields[3] == InstallQueue::stateName(state)) {
+            job.state = state;
+        }
+    }
+    job.addedAt = fields[4];
+    job.finishedAt = fields[5];
+    job.pauses = static_cast<unsigned>(std::strtoul(fields[6].c_str(), nullptr, 10));
+    job.pid = std::atoi(fields[7].c_str());
+    job.bootId = fields.size() > 8 ? fields[8] : "";
+    return job.id > 0 && !job.name.empty();
+}
+
+std::vector<InstallQueue::Job> readJobs() {
+    std::vector<InstallQueue::Job> jobs;
+    std::vector<std::string> lines;
+    FileUtils::readLines(InstallQueue::kPath, lines);
+    for (const auto& line : lines) {
+        InstallQueue::Job job;
+        if (parse(line, job)) {
+            jobs.push_back(job);
+        }
+    }
+    return jobs;
+}
+
+/**
+ * @brief 调度进程的 fcntl 写锁（进程退出时内核自动释放）
+ */
+struct RunLock {
+    int fd = -1;
+
+    bool acquire() {
+        fd = open(InstallQueue::kRunLockPath, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        struct flock lock = {};
+        lock.l_type = F_WRLCK;
+        lock.l_whence = SEEK_SET;
+        return fcntl(fd, F_SETLK, &lock) == 0;
+    }
+
+    ~RunLock() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+
+/**
+ * @brief 睡眠 seconds 秒，stop 置位或子进程退出时提前返回（不回收子进程）
+ */
+void sleepFor(const std::atomic<bool>& stop, unsigned seconds, pid_t child) {
+    for (unsigned waited = 0; waited < seconds * 1000 && !stop; waited += kSliceMs) {
+        siginfo_t info = {};
+        if (child > 0 && waitid(P_PID, static_cast<id_t>(child), &info, WEXITED | WNOHANG | WNOWAIT) == 0 &&
+            info.si_pid == child) {
+            return;
+        }
+        usleep(kSliceMs * 1000);
+    }
+}
+
+/**
+ * @brief 本次启动的 boot id，读取失败返回空串
+ */
+std::string currentBootId() {
+    std::string content;
+    if (!FileUtils::readFile("/proc/sys/kernel/random/boot_id", content)) {
+        return "";
+    }
+    content.erase(content.find_last_not_of(" \n") + 1);
+    return content;
+}
+
+/**
+ * @brief 任务子进程的子命令与动作（scene apply 或 <kind> install）
+ */
+const char* jobCommand(const InstallQueue::Job& job) {
+    return job.kind == InstallQueue::Kind::Scene ? "scene" : InstallQueue::kindName(job.kind);
+}
+
+const char* jobVerb(const InstallQueue::Job& job) {
+    return job.kind == InstallQueue::Kind::Scene ? "apply" : "install";
+}
+
+/**
+ * @brief 记录的进程组是否仍是这个任务的 xkl 进程
+ *
+ * 重启后 pid 会被复用，只有 boot id 相同、进程组存在且组长的 /proc/<pid>/cmdline
+ * 与 start() 传给 execl 的参数完全一致才算数。组长已退出（包括僵尸进程，cmdline 为空）视为任务已结束。
+ */
+bool jobAlive(const InstallQueue::Job& job) {
+    if (job.pid <= 0 || job.bootId.empty() || job.bootId != currentBootId() || kill(-job.pid, 0) != 0) {
+        return false;
+    }
+    std::string cmdline;
+    if (!FileUtils::readFile("/proc/" + std::to_string(job.pid) + "/cmdline", cmdline)) {
+        return false;
+    }
+    std::string expected = std::string("xkl") + '\0' + jobCommand(job) + '\0' + jobVerb(job) + '\0' + job.name + '\0';
+    return cmdline == expected;
+}
+
+/**
+ * @brief 任务子进程写下退出码的状态文件
+ */
+std::string statusPath(unsigned id) {
+    return std::string(InstallQueue::kJobDir) + "/" + std::to_string(id) + ".status";
+}
+
+/**
+ * @brief 读取任务的退出码，状态文件不存在或内容不是数字时返回 false
+ */
+bool readStatus(unsigned id, int& code) {
+    std::string content;
+    if (!FileUtils::readFile(statusPath(id), content)) {
+        return false;
+    }
+    char* end = nullptr;
+    long value = std::strtol(content.c_str(), &end, 10);
+    if (end == content.c_str() || (*end != '\n' && *end != '\0')) {
+        return false;
+    }
+    code = static_cast<int>(value);
+    return true;
+}
+
+/**
+ * @brief 接管的任务是否已结束：进程组组长已退出（包括尚未被 init 回收的僵尸进程）
+ *
+ * 组长是等待 apt、dpkg 等后代结束的 xkl 进程，它退出即任务结束。
+ */
+bool adoptedJobExited(pid_t pid) {
+    std::string stat;
+    if (!FileUtils::readFile("/proc/" + std::to_string(pid) + "/stat", stat)) {
+        return true;
+    }
+    std::size_t paren = stat.rfind(')');
+    return paren == std::string::npos || paren + 2 >= stat.size() || stat[paren + 2] == 'Z' ||
+           stat[paren + 2] == 'X';
+}
+
+} // namespace
+
+const char* InstallQueue::kindName(Kind kind) {
+    switch (kind) {
+        case Kind::Component: return "component";
+        case Kind::Plugin: return "plugin";
+        case Kind::Scene: return "scene";
+    }
+    return "component";
+}
+
+bool InstallQueue::parseKind(const std::string& name, Kind& kind) {
+    for (auto candidate : {Kind::Component, Kind::Plugin, Kind::Scene}) {
+        if (name == kindName(candidate)) {
+            kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* InstallQueue::stateName(State state) {
+    switch (state) {
+        case State::Queued: return "queued";
+        case State::Running: return "running";
+        case State::Paused: return "paused";
+        case State::Done: return "done";
+        case State::Failed: return "failed";
+        case State::Exited: return "exited";
+    }
+    return "queued";
+}
+
+void InstallQueue::recordExit(int code) {
+    const char* path = std::getenv(kStatusEnv);
+    if (path != nullptr && *path != '\0') {
+        FileUtils::writeFileAtomic(path, std::to_string(code) + "\n");
+    }
+}
+
+void InstallQueue::loadConfig(const std::string& path) {
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(path, lines)) {
+        return;
+    }
+    for (const auto& line : lines) {
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> key = FileUtils::splitFields(line.substr(0, colon));
+        std::vector<std::string> value = FileUtils::splitFields(line.substr(colon + 1));
+        if (key.size() != 1 || value.empty()) {
+            continue;
+        }
+        const std::string& k = key[0];
+        const std::string& v = value[0];
+        long seconds = 0;
+        if (k == "queue_cpu_pressure") {
+            cpuPressure_ = std::strtod(v.c_str(), nullptr);
+        } else if (k == "queue_memory_pressure") {
+            memoryPressure_ = std::strtod(v.c_str(), nullptr);
+        } else if (k == "queue_io_pressure") {
+            ioPressure_ = std::strtod(v.c_str(), nullptr);
+        } else if (k == "queue_load") {
+            load_ = std::strtod(v.c_str(), nullptr);
+        } else if (k == "queue_pause_factor") {
+            pauseFactor_ = std::max(std::strtod(v.c_str(), nullptr), 1.0);
+        } else if (k == "queue_settle" && parseDuration(v, seconds)) {
+            settleSeconds_ = static_cast<unsigned>(std::max(seconds, 0L));
+        } else if (k == "queue_poll" && parseDuration(v, seconds)) {
+            pollSeconds_ = static_cast<unsigned>(std::max(seconds, 1L));
+        }
+    }
+}
+
+bool InstallQueue::modify(const std::function<bool(std::vector<Job>&)>& mutate) {
+    // 队列文件整体原子替换，锁放在单独的文件上
+    std::string lockPath = std::string(kPath) + ".lock";
+    int fd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    while (flock(fd, LOCK_EX) != 0 && errno == EINTR) {
+    }
+
+    std::vector<Job> jobs = readJobs();
+    bool ok = true;
+    if (mutate(jobs)) {
+        std::string content;
+        for (const auto& job : jobs) {
+            content += serialize(job);
+        }
+        ok = FileUtils::writeFileAtomic(kPath, content);
+    }
+    close(fd);
+    return ok;
+}
+
+bool InstallQueue::add(Kind kind, const std::string& name, Job& job) {
+    job = Job();
+    job.kind = kind;
+    job.name = name;
+    job.addedAt = currentTimestamp();
+    return modify([&job](std::vector<Job>& jobs) {
+        for (const auto& existing : jobs) {
+            job.id = std::max(job.id, existing.id);
+        }
+        ++job.id;
+        jobs.push_back(job);
+        return true;
+    });
+}
+
+bool InstallQueue::remove(unsigned id) {
+    bool removed = false;
+    bool ok = modify([id, &removed](std::vector<Job>& jobs) {
+        for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+            if (it->id == id && it->state != State::Running && it->state != State::Paused) {
+                jobs.erase(it);
+                removed = true;
+                return true;
+            }
+        }
+        return false;
+    });
+    if (removed) {
+        unlink((std::string(kJobDir) + "/" + std::to_string(id) + ".log").c_str());
+        unlink(statusPath(id).c_str());
+    }
+    return ok && removed;
+}
+
+std::vector<InstallQueue::Job> InstallQueue::jobs() {
+    return readJobs();
+}
+
+bool InstallQueue::active() {
+    // F_GETLK 只查询不加锁，不会与调度进程启动时的加锁竞争
+    int fd = open(kRunLockPath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct flock lock = {};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    bool held = fcntl(fd, F_GETLK, &lock) == 0 && lock.l_type != F_UNLCK;
+    close(fd);
+    return held;
+}
+
+InstallQueue::Pressure InstallQueue::sample() {
+    Pressure pressure;
+    pressure.cpu = someAvg10("/proc/pressure/cpu");
+    pressure.memory = someAvg10("/proc/pressure/memory");
+    pressure.io = someAvg10("/proc/pressure/io");
+
+    std::string loadavg;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (FileUtils::readFile("/proc/loadavg", loadavg)) {
+        pressure.load = std::strtod(loadavg.c_str(), nullptr) / static_cast<double>(cores > 0 ? cores : 1);
+    }
+    return pressure;
+}
+
+bool InstallQueue::idle(const Pressure& pressure) const {
+    return pressure.cpu < cpuPressure_ && pressure.memory < memoryPressure_ && pressure.io < ioPressure_ &&
+           pressure.load < load_;
+}
+
+bool InstallQueue::busy(const Pressure& pressure) const {
+    // PSI 不可用时为 -1，不会触发暂停；负载包含任务自身，不参与判断
+    return pressure.cpu >= cpuPressure_ * pauseFactor_ || pressure.memory >= memoryPressure_ * pauseFactor_ ||
+           pressure.io >= ioPressure_ * pauseFactor_;
+}
+
+bool InstallQueue::start(Job& job) {
+    const char* command = jobCommand(job);
+    const char* verb = jobVerb(job);
+    std::string log = std::string(kJobDir) + "/" + std::to_string(job.id) + ".log";
+    std::string status = statusPath(job.id);
+    unlink(status.c_str());
+
+    // 环境在 fork 前准备好，子进程中只调用 async-signal-safe 的函数
+    std::vector<std::string> environment;
+    std::string prefix = std::string(kStatusEnv) + "=";
+    for (char** entry = environ; *entry != nullptr; ++entry) {
+        if (std::strncmp(*entry, prefix.c_str(), prefix.size()) != 0) {
+            environment.emplace_back(*entry);
+        }
+    }
+    environment.push_back(prefix + status);
+    std::vector<char*> envp;
+    for (auto& entry : environment) {
+        envp.push_back(&entry[0]);
+    }
+    envp.push_back(nullptr);
+    const char* argv[] = {"xkl", command, verb, job.name.c_str(), nullptr};
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        // 独立进程组：SIGSTOP/SIGCONT 覆盖 apt、dpkg、pip 等全部后代，终端的 Ctrl+C 也不会传到这里
+        setpgid(0, 0);
+        setpriority(PRIO_PROCESS, 0, 10);
+        int out = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int in = open("/dev/null", O_RDONLY);
+        if (out >= 0) {
+            dup2(out, STDOUT_FILENO);
+            dup2(out, STDERR_FILENO);
+        }
+        if (in >= 0) {
+            dup2(in, STDIN_FILENO);
+        }
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        execve("/proc/self/exe", const_cast<char* const*>(argv), envp.data());
+        _exit(127);
+    }
+    setpgid(pid, pid);   // 与子进程中的调用竞争无妨，保证发信号前已成组
+    job.pid = pid;
+    job.bootId = currentBootId();
+    return true;
+}
+
+bool InstallQueue::run(const std::atomic<bool>& stop, const std::function<void(const Job&, const char*)>& onEvent) {
+    mkdir(kJobDir, 0755);
+    RunLock lock;
+    if (!lock.acquire()) {
+        return false;
+    }
+
+    // 上一个调度进程异常退出：任务进程仍在运行时接管（不重复执行），
+    // 进程已不存在（包括机器重启）时重新排队。不向无法确认的进程组发信号，它的 pid 可能已被复用
+    std::vector<Job> orphans;
+    modify([&orphans](std::vector<Job>& jobs) {
+        bool changed = false;
+        for (auto& job : jobs) {
+            if (job.state != State::Running && job.state != State::Paused) {
+                continue;
+            }
+            if (jobAlive(job)) {
+                orphans.push_back(job);
+            } else {
+                job.state = State::Queued;
+                job.pid = 0;
+                job.bootId.clear();
+                changed = true;
+            }
+        }
+        return changed;
+    });
+
+    Job current;
+    bool running = false;
+    bool adopted = false;   // 接管的任务不是本进程的子进程，只能轮询组长是否退出，退出码从状态文件读取
+    bool waiting = false;
+    std::time_t quietSince = 0;
+    auto record = [&current, &onEvent](State state, const char* event) {
+        current.state = state;
+        const Job snapshot = current;
+        modify([&snapshot](std::vector<Job>& jobs) {
+            for (auto& job : jobs) {
+                if (job.id == snapshot.id) {
+                    job = snapshot;
+                    return true;
+                }
+            }
+            return false;
+        });
+        onEvent(current, event);
+    };
+
+    for (;;) {
+        if (!running && !orphans.empty()) {
+            current = orphans.front();
+            orphans.erase(orphans.begin());
+            running = true;
+            adopted = true;
+            onEvent(current, "adopt");
+        }
+        // 停止时不中断安装：恢复被暂停的任务，然后阻塞等待它结束
+        if (stop && running && !waiting) {
+            waiting = true;
+            if (current.state == State::Paused) {
+                kill(-current.pid, SIGCONT);
+                record(State::Running, "resume");
+            }
+            onEvent(current, "wait");
+        }
+        if (running && adopted) {
+            if (adoptedJobExited(current.pid)) {
+                running = false;
+                adopted = false;
+                current.finishedAt = currentTimestamp();
+                current.pid = 0;
+                int code = 0;
+                if (!readStatus(current.id, code)) {
+                    record(State::Exited, "exit");
+                } else if (code == 0) {
+                    record(State::Done, "done");
+                } else {
+                    record(State::Failed, "failed");
+                }
+                quietSince = 0;
+            } else if (stop) {
+                usleep(kSliceMs * 1000);
+            }
+        } else if (running) {
+            int status = 0;
+            pid_t exited = waitpid(current.pid, &status, stop ? 0 : WNOHANG);
+            if (exited == current.pid || (exited < 0 && errno == ECHILD)) {
+                bool success = exited == current.pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+                running = false;
+                current.finishedAt = currentTimestamp();
+                current.pid = 0;
+                record(success ? State::Done : State::Failed, success ? "done" : "failed");
+                quietSince = 0;   // 任务自身抬高的负载回落后再启动下一个
+            }
+        }
+        if (stop) {
+            if (!running) {
+                break;
+            }
+            continue;
+        }
+
+        Pressure pressure = sample();
+        std::time_t now = std::time(nullptr);
+        if (!idle(pressure)) {
+            quietSince = 0;
+        } else if (quietSince == 0) {
+            quietSince = now;
+        }
+        bool settled = quietSince != 0 && now - quietSince >= static_cast<std::time_t>(settleSeconds_);
+
+        if (running && current.state == State::Running && busy(pressure)) {
+            kill(-current.pid, SIGSTOP);
+            ++current.pauses;
+            record(State::Paused, "pause");
+            quietSince = 0;
+        } else if (running && current.state == State::Paused && settled) {
+            kill(-current.pid, SIGCONT);
+            record(State::Running, "resume");
+        } else if (!running && settled) {
+            // 每次重新读取队列，期间 xkl queue add/remove 的修改都能看到；
+            // 在锁内标记为运行中，之后 remove 不会删掉它
+            bool found = false;
+            modify([&current, &found](std::vector<Job>& jobs) {
+                for (auto& job : jobs) {
+                    if (job.state == State::Queued) {
+                        job.state = State::Running;
+                        current = job;
+                        found = true;
+                        return true;
+                    }
+                }
+                return false;
+            });
+            if (found && start(current)) {
+                running = true;
+                record(State::Running, "start");
+            } else if (found) {
+                current.finishedAt = currentTimestamp();
+                record(State::Failed, "failed");
+            }
+        }
+        sleepFor(stop, pollSeconds_, running && !adopted ? current.pid : 0);
+    }
+    return true;
+}
+
+} // namespace LinuxStudio
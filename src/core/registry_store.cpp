@@ -0,0 +1,404 @@
+#include "linuxstudio/registry_store.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+const char kMagic[8] = {'X', 'K', 'L', 'R', 'E', 'G', '0', '1'};
+const std::uint64_t kHeaderSize = 4096;
+const std::uint64_t kInitialCapacity = 16 * 1024;
+const int kMaxReadRetries = 1000;
+
+/**
+ * @brief 文件头（位于第一页）
+ * seq 为偶数表示稳定；写者切换活动槽前后各加一
+ */
+struct Header {
+    char magic[8];
+    std::atomic<std::uint64_t> seq;
+    std::atomic<std::uint64_t> version;
+    std::atomic<std::uint64_t> capacity;   // 单个槽容量（页对齐）
+    std::atomic<std::uint64_t> active;     // 当前活动槽 0/1
+    std::atomic<std::uint64_t> size[2];
+    std::atomic<std::uint64_t> checksum[2];
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "registry header requires lock-free 64-bit atomics");
+static_assert(sizeof(Header) <= kHeaderSize, "registry header too large");
+
+std::uint64_t fnv1a64(const char* data, std::size_t n) {
+    std::uint64_t h = 14695981039346656037ull;
+    for (std::size_t i = 0; i < n; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::uint64_t slotOffset(std::uint64_t capacity, std::uint64_t slot) {
+    return kHeaderSize + slot * capacity;
+}
+
+/**
+ * @brief mmap 映射（RAII）
+ */
+class Mapping {
+public:
+    Mapping() : addr_(nullptr), size_(0) {}
+    ~Mapping() { reset(); }
+
+    bool map(int fd, std::size_t size, bool writable) {
+        reset();
+        void* addr = mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                          MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        addr_ = static_cast<char*>(addr);
+        size_ = size;
+        return true;
+    }
+
+    void reset() {
+        if (addr_) {
+            munmap(addr_, size_);
+            addr_ = nullptr;
+            size_ = 0;
+        }
+    }
+
+    char* data() const { return addr_; }
+    std::size_t size() const { return size_; }
+    Header* header() const { return reinterpret_cast<Header*>(addr_); }
+
+private:
+    char* addr_;
+    std::size_t size_;
+};
+
+/**
+ * @brief 文件描述符（RAII）
+ */
+class FileHandle {
+public:
+    explicit FileHandle(int fd) : fd_(fd) {}
+    ~FileHandle() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+    int get() const { return fd_; }
+    bool valid() const { return fd_ >= 0; }
+
+private:
+    int fd_;
+};
+
+void appendU32(std::string& out, std::uint32_t v) {
+    char bytes[4] = {static_cast<char>(v & 0xFF), static_cast<char>((v >> 8) & 0xFF),
+                     static_cast<char>((v >> 16) & 0xFF), static_cast<char>((v >> 24) & 0xFF)};
+    out.append(bytes, 4);
+}
+
+std::uint32_t readU32(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<std::uint32_t>(u[0]) | (static_cast<std::uint32_t>(u[1]) << 8) |
+           (static_cast<std::uint32_t>(u[2]) << 16) | (static_cast<std::uint32_t>(u[3]) << 24);
+}
+
+// 记录格式：u32 键长 + u32 值长 + 键 + 值
+std::string encode(const RegistryStore::Entries& entries) {
+    std::string out;
+    for (const auto& pair : entries) {
+        appendU32(out, static_cast<std::uint32_t>(pair.first.size()));
+        appendU32(out, static_cast<std::uint32_t>(pair.second.size()));
+        out += pair.first;
+        out += pair.second;
+    }
+    return out;
+}
+
+bool decode(const std::string& data, RegistryStore::Entries& entries) {
+    entries.clear();
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+        if (data.size() - pos < 8) {
+            return false;
+        }
+        std::uint32_t keyLen = readU32(data.data() + pos);
+        std::uint32_t valueLen = readU32(data.data() + pos + 4);
+        pos += 8;
+        if (data.size() - pos < static_cast<std::size_t>(keyLen) + valueLen) {
+            return false;
+        }
+        entries[data.substr(pos, keyLen)] = data.substr(pos + keyLen, valueLen);
+        pos += keyLen + valueLen;
+    }
+    return true;
+}
+
+bool validHeader(const Mapping& mapping) {
+    if (mapping.size() < kHeaderSize ||
+        std::memcmp(mapping.header()->magic, kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    std::uint64_t capacity = mapping.header()->capacity.load(std::memory_order_relaxed);
+    return capacity > 0 && slotOffset(capacity, 2) <= mapping.size();
+}
+
+/**
+ * @brief 在 seqlock 保护下复制一个槽
+ * @param slot 要读的槽，传 -1 表示读活动槽
+ * @return 读到一致数据返回 true；ignoreSeq 用于写者崩溃后 seq 停在奇数的情况
+ */
+bool copySlot(const Mapping& mapping, int slot, std::string& data, std::uint64_t& version,
+              bool ignoreSeq) {
+    Header* header = mapping.header();
+    std::uint64_t s1 = header->seq.load(std::memory_order_acquire);
+    if ((s1 & 1) && !ignoreSeq) {
+        return false;
+    }
+
+    std::uint64_t capacity = header->capacity.load(std::memory_order_relaxed);
+    std::uint64_t index = slot < 0 ? header->active.load(std::memory_order_relaxed) & 1
+                                   : static_cast<std::uint64_t>(slot);
+    std::uint64_t size = header->size[index].load(std::memory_order_relaxed);
+    std::uint64_t sum = header->checksum[index].load(std::memory_order_relaxed);
+    version = header->version.load(std::memory_order_relaxed);
+    if (size > capacity) {
+        return false;
+    }
+
+    data.assign(mapping.data() + slotOffset(capacity, index), size);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!ignoreSeq && header->seq.load(std::memory_order_relaxed) != s1) {
+        return false;
+    }
+    return fnv1a64(data.data(), data.size()) == sum;
+}
+
+/**
+ * @brief 读取最新的完整内容：活动槽校验失败时回退到另一个槽
+ */
+bool readLatest(const Mapping& mapping, std::string& data, std::uint64_t& version) {
+    for (int attempt = 0; attempt < kMaxReadRetries; ++attempt) {
+        if (copySlot(mapping, -1, data, version, false)) {
+            return true;
+        }
+        sched_yield();
+    }
+
+    // 写者可能在切换中途崩溃：忽略 seq，按校验和挑选完整的槽
+    std::uint64_t active = mapping.header()->active.load(std::memory_order_relaxed) & 1;
+    if (copySlot(mapping, static_cast<int>(active), data, version, true)) {
+        return true;
+    }
+    return copySlot(mapping, static_cast<int>(active ^ 1), data, version, true);
+}
+
+bool initializeFile(int fd, std::uint64_t capacity) {
+    if (ftruncate(fd, static_cast<off_t>(slotOffset(capacity, 2))) != 0) {
+        return false;
+    }
+    Mapping mapping;
+    if (!mapping.map(fd, slotOffset(capacity, 2), true)) {
+        return false;
+    }
+    Header* header = mapping.header();
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+    header->seq.store(0);
+    header->version.store(0);
+    header->capacity.store(capacity);
+    header->active.store(0);
+    for (int i = 0; i < 2; ++i) {
+        header->size[i].store(0);
+        header->checksum[i].store(fnv1a64(nullptr, 0));
+    }
+    return msync(mapping.data(), mapping.size(), MS_SYNC) == 0;
+}
+
+std::uint64_t roundCapacity(std::uint64_t needed) {
+    std::uint64_t capacity = kInitialCapacity;
+    while (capacity < needed * 2) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+} // namespace
+
+RegistryStore::RegistryStore(const std::string& path) : path_(path) {}
+
+bool RegistryStore::exists() const {
+    struct stat st;
+    return stat(path_.c_str(), &st) == 0;
+}
+
+bool RegistryStore::read(Entries& entries, std::uint64_t* version) const {
+    FileHandle file(open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+    if (!file.valid()) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(file.get(), &st) != 0) {
+        return false;
+    }
+
+    Mapping mapping;
+    if (!mapping.map(file.get(), static_cast<std::size_t>(st.st_size), false) || !validHeader(mapping)) {
+        return false;
+    }
+
+    std::string data;
+    std::uint64_t snapshotVersion = 0;
+    if (!readLatest(mapping, data, snapshotVersion) || !decode(data, entries)) {
+        return false;
+    }
+    if (version) {
+        *version = snapshotVersion;
+    }
+    return true;
+}
+
+std::uint64_t RegistryStore::version() const {
+    FileHandle file(open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+    if (!file.valid()) {
+        return 0;
+    }
+    // 写者 open(O_CREAT) 之后、ftruncate 之前文件为空，映射文件尾之外的页会触发 SIGBUS
+    struct stat st;
+    if (fstat(file.get(), &st) != 0 || static_cast<std::uint64_t>(st.st_size) < kHeaderSize) {
+        return 0;
+    }
+    Mapping mapping;
+    if (!mapping.map(file.get(), kHeaderSize, false) ||
+        std::memcmp(mapping.header()->magic, kMagic, sizeof(kMagic)) != 0) {
+        return 0;
+    }
+    return mapping.header()->version.load(std::memory_order_acquire);
+}
+
+bool RegistryStore::commit(const Changes& changes, Entries* merged, std::uint64_t* version) {
+    // 写者之间用独立锁文件串行化（数据文件可能被 rename 替换）
+    FileHandle lock(open((path_ + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+    if (!lock.valid()) {
+        return false;
+    }
+    while (flock(lock.get(), LOCK_EX) != 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+
+    FileHandle file(open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+    if (!file.valid()) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(file.get(), &st) != 0) {
+        return false;
+    }
+    if (st.st_size == 0) {
+        if (!initializeFile(file.get(), kInitialCapacity)) {
+            return false;
+        }
+        st.st_size = static_cast<off_t>(slotOffset(kInitialCapacity, 2));
+    }
+
+    Mapping mapping;
+    if (!mapping.map(file.get(), static_cast<std::size_t>(st.st_size), true) || !validHeader(mapping)) {
+        return false;  // 不是注册表文件，拒绝覆盖
+    }
+    Header* header = mapping.header();
+
+    // 上一个写者在切换中途崩溃：修复 seq
+    std::uint64_t seq = header->seq.load(std::memory_order_relaxed);
+    if (seq & 1) {
+        header->seq.store(++seq, std::memory_order_release);
+    }
+
+    // 读取最新内容并合并本进程的变更
+    std::string current;
+    std::uint64_t currentVersion = 0;
+    Entries entries;
+    if (readLatest(mapping, current, currentVersion)) {
+        decode(current, entries);
+    }
+    for (const auto& change : changes) {
+        if (change.second) {
+            entries[change.first] = *change.second;
+        } else {
+            entries.erase(change.first);
+        }
+    }
+
+    std::string data = encode(entries);
+    std::uint64_t sum = fnv1a64(data.data(), data.size());
+    std::uint64_t capacity = header->capacity.load(std::memory_order_relaxed);
+    std::uint64_t newVersion = currentVersion + 1;
+
+    if (data.size() > capacity) {
+        // 容量不足：写新文件后原子替换，已打开旧文件的读者继续看到旧的一致快照
+        std::uint64_t newCapacity = roundCapacity(data.size());
+        std::string tmpPath = path_ + ".tmp." + std::to_string(getpid());
+        FileHandle tmp(open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        Mapping tmpMapping;
+        bool ok = tmp.valid() && initializeFile(tmp.get(), newCapacity) &&
+                  tmpMapping.map(tmp.get(), slotOffset(newCapacity, 2), true);
+        if (ok) {
+            Header* tmpHeader = tmpMapping.header();
+            std::memcpy(tmpMapping.data() + slotOffset(newCapacity, 0), data.data(), data.size());
+            tmpHeader->size[0].store(data.size());
+            tmpHeader->checksum[0].store(sum);
+            tmpHeader->version.store(newVersion);
+            ok = msync(tmpMapping.data(), tmpMapping.size(), MS_SYNC) == 0 &&
+                 rename(tmpPath.c_str(), path_.c_str()) == 0;
+        }
+        if (!ok) {
+            unlink(tmpPath.c_str());
+            return false;
+        }
+    } else {
+        // 写非活动槽：只有在上一次切换之前开始的读者会读到它，它们会因 seq 变化而重试
+        std::uint64_t slot = (header->active.load(std::memory_order_relaxed) & 1) ^ 1;
+        std::uint64_t offset = slotOffset(capacity, slot);
+        std::memcpy(mapping.data() + offset, data.data(), data.size());
+        header->size[slot].store(data.size(), std::memory_order_relaxed);
+        header->checksum[slot].store(sum, std::memory_order_relaxed);
+        if (!data.empty()) {
+            msync(mapping.data() + offset, capacity, MS_SYNC);
+        }
+
+        // 切换活动槽
+        header->seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        header->active.store(slot, std::memory_order_relaxed);
+        header->version.store(newVersion, std::memory_order_relaxed);
+        header->seq.store(seq + 2, std::memory_order_release);
+        msync(mapping.data(), kHeaderSize, MS_SYNC);
+    }
+
+    if (merged) {
+        merged->swap(entries);
+    }
+    if (version) {
+        *version = newVersion;
+    }
+    return true;
+}
+
+} // namespace LinuxStudio
@@ -0,0 +1,244 @@
+#include "linuxstudio/registry_watcher.hpp"
+#include "linuxstudio/core.hpp"
+#include "linuxstudio/managers.hpp"
+#include "linuxstudio/logger.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+// 最后一个事件之后静默这么久才同步：dpkg 一次事务会多次改写状态文件，
+// 插件安装也会连续写入多个文件
+const int kDebounceMs = 200;
+
+// 没有待处理事件时的轮询间隔（检查停止标志）
+const int kIdlePollMs = 500;
+
+const std::uint32_t kRootMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+const std::uint32_t kPluginMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_ONLYDIR;
+const std::uint32_t kDpkgMask = IN_CLOSE_WRITE | IN_MOVED_TO;
+
+std::string parentOf(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+std::string baseOf(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+/**
+ * @brief 监视进程的 fcntl 写锁（进程退出时内核自动释放）
+ */
+struct WatchLock {
+    int fd = -1;
+
+    bool acquire() {
+        std::string path = RegistryWatcher::lockPath();
+        mkdir(parentOf(path).c_str(), 0755);
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        struct flock lock = {};
+        lock.l_type = F_WRLCK;
+        lock.l_whence = SEEK_SET;
+        return fcntl(fd, F_SETLK, &lock) == 0;
+    }
+
+    ~WatchLock() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+
+} // namespace
+
+std::string RegistryWatcher::lockPath() {
+    const char* override = std::getenv("XKL_WATCH_LOCK");
+    return override && *override ? override : kLockPath;
+}
+
+std::string RegistryWatcher::dpkgStatusPath() {
+    const char* override = std::getenv("XKL_DPKG_STATUS");
+    return override && *override ? override : kDpkgStatusPath;
+}
+
+bool RegistryWatcher::active() {
+    // F_GETLK 只查询不加锁，不会与监视进程启动时的加锁竞争
+    int fd = open(lockPath().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct flock lock = {};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    bool held = fcntl(fd, F_GETLK, &lock) == 0 && lock.l_type != F_UNLCK;
+    close(fd);
+    return held;
+}
+
+RegistryWatcher::Changes RegistryWatcher::catchUp() {
+    auto& engine = CoreEngine::getInstance();
+    auto& plugins = engine.getPluginManager();
+
+    Changes changes;
+    changes.plugins = plugins.syncPlugins();
+    changes.packages = engine.getComponentManager().syncSystemPackages();
+    if (!changes.plugins.empty()) {
+        plugins.updateCompletionIndex();
+    }
+    return changes;
+}
+
+bool RegistryWatcher::run(const std::atomic<bool>& stop, const std::function<void(const Changes&)>& onChange) {
+    auto& engine = CoreEngine::getInstance();
+    auto& logger = engine.getLogger();
+    auto& plugins = engine.getPluginManager();
+    auto& components = engine.getComponentManager();
+
+    WatchLock lock;
+    if (!lock.acquire()) {
+        logger.error("Another watcher is already running (" + lockPath() + ")");
+        return false;
+    }
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        logger.error("inotify unavailable: " + std::string(std::strerror(errno)));
+        return false;
+    }
+
+    // 先建立监视再追赶，两者之间发生的变化不会丢失
+    const std::string& root = plugins.pluginsPath();
+    const std::string dpkgStatus = dpkgStatusPath();
+    const std::string dpkgName = baseOf(dpkgStatus);
+    int rootWd = inotify_add_watch(fd, root.c_str(), kRootMask);
+    int dpkgWd = inotify_add_watch(fd, parentOf(dpkgStatus).c_str(), kDpkgMask);
+    if (rootWd < 0) {
+        logger.warning("Cannot watch " + root + ": " + std::strerror(errno));
+    }
+
+    std::map<int, std::string> pluginWds;
+    auto watchPlugin = [&](const std::string& name) {
+        int wd = inotify_add_watch(fd, (root + "/" + name).c_str(), kPluginMask);
+        if (wd >= 0) {
+            pluginWds[wd] = name;
+        }
+    };
+    DIR* dir = opendir(root.c_str());
+    if (dir != nullptr) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (entry->d_type == DT_DIR && entry->d_name[0] != '.') {
+                watchPlugin(entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+
+    Changes initial = catchUp();
+    if (!initial.empty()) {
+        onChange(initial);
+    }
+
+    std::set<std::string> dirtyPlugins;
+    bool dirtyPackages = false;
+    bool overflow = false;
+    alignas(struct inotify_event) char buffer[16384];
+
+    while (!stop) {
+        bool pending = overflow || dirtyPackages || !dirtyPlugins.empty();
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, pending ? kDebounceMs : kIdlePollMs);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            logger.error("poll failed: " + std::string(std::strerror(errno)));
+            break;
+        }
+
+        if (ready > 0) {
+            ssize_t n;
+            while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + n;) {
+                    const auto* event = reinterpret_cast<const struct inotify_event*>(p);
+                    p += sizeof(struct inotify_event) + event->len;
+
+                    std::string name = event->len > 0 ? event->name : "";
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        overflow = true;  // 事件丢失，退回按变更标记全量检查
+                    } else if (event->wd == dpkgWd) {
+                        dirtyPackages = dirtyPackages || name == dpkgName;
+                    } else if (event->wd == rootWd) {
+                        if (name.empty() || name[0] == '.') {
+                            continue;
+                        }
+                        if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                            watchPlugin(name);
+                        }
+                        dirtyPlugins.insert(name);
+                    } else {
+                        auto it = pluginWds.find(event->wd);
+                        if (it == pluginWds.end()) {
+                            continue;
+                        }
+                        if (event->mask & IN_IGNORED) {
+                            pluginWds.erase(it);
+                        } else if (name == "metadata.json") {
+                            dirtyPlugins.insert(it->second);
+                        }
+                    }
+                }
+            }
+            continue;  // 继续等到事件平息
+        }
+
+        if (!pending) {
+            continue;
+        }
+
+        Changes changes;
+        if (overflow) {
+            changes = catchUp();
+        } else {
+            if (!dirtyPlugins.empty()) {
+                changes.plugins = plugins.syncPlugins(dirtyPlugins);
+                if (!changes.plugins.empty()) {
+                    plugins.updateCompletionIndex();
+                }
+            }
+            if (dirtyPackages) {
+                changes.packages = components.syncSystemPackages();
+            }
+        }
+        overflow = false;
+        dirtyPackages = false;
+        dirtyPlugins.clear();
+
+        if (!changes.empty()) {
+            onChange(changes);
+        }
+    }
+
+    close(fd);
+    return true;
+}
+
+} // namespace LinuxStudio
@@ -0,0 +1,653 @@
+#include "linuxstudio/repo_index.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/hash.hpp"
+#include "linuxstudio/process.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+const char kMagic[8] = {'X', 'K', 'L', 'R', 'E', 'P', 'O', '1'};
+
+// 单次 Range 请求的区间数上限；差异更大时整个下载更省事
+const std::size_t kMaxRanges = 64;
+
+std::vector<std::string> splitTabs(const std::string& line) {
+    std::vector<std::string> fields(1);
+    for (char c : line) {
+        if (c == '\t') {
+            fields.emplace_back();
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+std::string shellQuote(const std::string& s) {
+    std::string quoted = "'";
+    for (char c : s) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+bool littleEndian() {
+    const std::uint16_t probe = 1;
+    return *reinterpret_cast<const unsigned char*>(&probe) == 1;
+}
+
+/**
+ * @brief rsync 的滚动校验和：a 为字节和，b 为加权和，各取低 16 位
+ */
+struct RollingSum {
+    std::uint32_t a = 0;
+    std::uint32_t b = 0;
+
+    void reset(const unsigned char* data, std::size_t size) {
+        a = 0;
+        b = 0;
+        for (std::size_t i = 0; i < size; ++i) {
+            a += data[i];
+            b += static_cast<std::uint32_t>(size - i) * data[i];
+        }
+    }
+
+    void roll(unsigned char out, unsigned char in, std::size_t size) {
+        a += in - out;
+        b += a - static_cast<std::uint32_t>(size) * out;
+    }
+
+    std::uint32_t value() const { return (a & 0xffff) | (b << 16); }
+};
+
+std::uint64_t blockHash(const unsigned char* data, std::size_t size) {
+    Xxh64 hash;
+    hash.update(data, size);
+    return hash.digest();
+}
+
+struct Sums {
+    std::uint64_t version = 0;
+    std::uint64_t length = 0;
+    std::size_t blockSize = 0;
+    std::string sha256;
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> blocks;   // (弱校验, XXH64)
+
+    bool parse(const std::string& content) {
+        std::vector<std::string> lines;
+        FileUtils::splitLines(content, lines);
+        if (lines.empty() || lines[0] != "xkl-sums-1") {
+            return false;
+        }
+        for (std::size_t i = 1; i < lines.size(); ++i) {
+            std::vector<std::string> fields = FileUtils::splitFields(lines[i]);
+            if (fields.size() != 2) {
+                continue;
+            }
+            if (fields[0] == "version") {
+                version = std::strtoull(fields[1].c_str(), nullptr, 10);
+            } else if (fields[0] == "length") {
+                length = std::strtoull(fields[1].c_str(), nullptr, 10);
+            } else if (fields[0] == "blocksize") {
+                blockSize = static_cast<std::size_t>(std::strtoul(fields[1].c_str(), nullptr, 10));
+            } else if (fields[0] == "sha256") {
+                sha256 = fields[1];
+            } else {
+                blocks.emplace_back(static_cast<std::uint32_t>(std::strtoul(fields[0].c_str(), nullptr, 16)),
+                                    std::strtoull(fields[1].c_str(), nullptr, 16));
+            }
+        }
+        return blockSize > 0 && sha256.size() == 64 && blocks.size() == (length + blockSize - 1) / blockSize;
+    }
+};
+
+std::string joinUrl(std::string base, const char* name) {
+    while (!base.empty() && base.back() == '/') {
+        base.pop_back();
+    }
+    return base + "/" + name;
+}
+
+} // namespace
+
+struct RepoIndex::Header {
+    char magic[8];
+    std::uint64_t version;
+    std::uint32_t sceneCount;
+    std::uint32_t pluginCount;
+    std::uint32_t aliasCount;
+    std::uint32_t listCount;
+    std::uint64_t stringBytes;
+};
+
+struct RepoIndex::SceneRecord {
+    std::uint32_t name;
+    std::uint32_t titleZh;
+    std::uint32_t titleEn;
+    std::uint32_t highlights;
+    std::uint32_t componentsBegin;
+    std::uint32_t componentsCount;
+};
+
+struct RepoIndex::PluginRecord {
+    std::uint32_t name;
+    std::uint32_t description;
+    std::uint32_t packagesBegin;
+    std::uint32_t packagesCount;
+    std::uint32_t requirementsBegin;
+    std::uint32_t requirementsCount;
+};
+
+struct RepoIndex::AliasRecord {
+    std::uint32_t component;
+    std::uint32_t package;
+};
+
+RepoIndex::RepoIndex() {
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    reset();
+}
+
+RepoIndex::~RepoIndex() {
+    reset();
+}
+
+void RepoIndex::reset() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mappingSize_);
+    }
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    image_ = nullptr;
+    header_ = nullptr;
+    scenes_ = nullptr;
+    plugins_ = nullptr;
+    aliases_ = nullptr;
+    lists_ = nullptr;
+    strings_ = nullptr;
+}
+
+bool RepoIndex::validate(const char* image, std::size_t size) {
+    if (!littleEndian() || size < sizeof(Header)) {
+        return false;
+    }
+    Header header;
+    std::memcpy(&header, image, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    std::uint64_t tables = sizeof(Header) + std::uint64_t(header.sceneCount) * sizeof(SceneRecord) +
+                           std::uint64_t(header.pluginCount) * sizeof(PluginRecord) +
+                           std::uint64_t(header.aliasCount) * sizeof(AliasRecord) +
+                           std::uint64_t(header.listCount) * sizeof(std::uint32_t);
+    if (header.stringBytes == 0 || tables + header.stringBytes != size || image[size - 1] != '\0') {
+        return false;
+    }
+
+    // 下载的文件已校验摘要，但本地副本仍可能被截断或改坏：检查所有偏移，之后的访问不再检查边界
+    const char* p = image + sizeof(Header);
+    auto inStrings = [&](std::uint32_t offset) { return offset < header.stringBytes; };
+    auto inLists = [&](std::uint32_t begin, std::uint32_t count) {
+        return std::uint64_t(begin) + count <= header.listCount;
+    };
+    for (std::uint32_t i = 0; i < header.sceneCount; ++i, p += sizeof(SceneRecord)) {
+        SceneRecord r;
+        std::memcpy(&r, p, sizeof(r));
+        if (!inStrings(r.name) || !inStrings(r.titleZh) || !inStrings(r.titleEn) || !inStrings(r.highlights) ||
+            !inLists(r.componentsBegin, r.componentsCount)) {
+            return false;
+        }
+    }
+    for (std::uint32_t i = 0; i < header.pluginCount; ++i, p += sizeof(PluginRecord)) {
+        PluginRecord r;
+        std::memcpy(&r, p, sizeof(r));
+        if (!inStrings(r.name) || !inStrings(r.description) || !inLists(r.packagesBegin, r.packagesCount) ||
+            !inLists(r.requirementsBegin, r.requirementsCount)) {
+            return false;
+        }
+    }
+    for (std::uint32_t i = 0; i < header.aliasCount; ++i, p += sizeof(AliasRecord)) {
+        AliasRecord r;
+        std::memcpy(&r, p, sizeof(r));
+        if (!inStrings(r.component) || !inStrings(r.package)) {
+            return false;
+        }
+    }
+    for (std::uint32_t i = 0; i < header.listCount; ++i, p += sizeof(std::uint32_t)) {
+        std::uint32_t offset;
+        std::memcpy(&offset, p, sizeof(offset));
+        if (!inStrings(offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RepoIndex::open(const std::string& path) {
+    reset();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        close(fd);
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    const char* image = static_cast<const char*>(addr);
+    if (!validate(image, size)) {
+        munmap(addr, size);
+        return false;
+    }
+
+    mapping_ = addr;
+    mappingSize_ = size;
+    image_ = image;
+    header_ = reinterpret_cast<const Header*>(image);
+    const char* p = image + sizeof(Header);
+    scenes_ = reinterpret_cast<const SceneRecord*>(p);
+    p += header_->sceneCount * sizeof(SceneRecord);
+    plugins_ = reinterpret_cast<const PluginRecord*>(p);
+    p += header_->pluginCount * sizeof(PluginRecord);
+    aliases_ = reinterpret_cast<const AliasRecord*>(p);
+    p += header_->aliasCount * sizeof(AliasRecord);
+    lists_ = reinterpret_cast<const std::uint32_t*>(p);
+    p += header_->listCount * sizeof(std::uint32_t);
+    strings_ = p;
+    return true;
+}
+
+std::uint64_t RepoIndex::version() const {
+    return header_ != nullptr ? header_->version : 0;
+}
+
+std::vector<std::string> RepoIndex::list(std::uint32_t begin, std::uint32_t count) const {
+    std::vector<std::string> items;
+    items.reserve(count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        items.emplace_back(string(lists_[begin + i]));
+    }
+    return items;
+}
+
+std::vector<SceneDefinition> RepoIndex::scenes() const {
+    std::vector<SceneDefinition> result;
+    for (std::uint32_t i = 0; header_ != nullptr && i < header_->sceneCount; ++i) {
+        const SceneRecord& r = scenes_[i];
+        SceneDefinition scene;
+        scene.name = std::string(string(r.name));
+        scene.titleZh = std::string(string(r.titleZh));
+        scene.titleEn = std::string(string(r.titleEn));
+        scene.highlights = std::string(string(r.highlights));
+        scene.components = list(r.componentsBegin, r.componentsCount);
+        result.push_back(std::move(scene));
+    }
+    return result;
+}
+
+bool RepoIndex::alias(std::string_view component, std::string& package) const {
+    if (header_ == nullptr) {
+        return false;
+    }
+    const AliasRecord* end = aliases_ + header_->aliasCount;
+    const AliasRecord* it = std::lower_bound(aliases_, end, component, [this](const AliasRecord& r, std::string_view key) {
+        return string(r.component) < key;
+    });
+    if (it == end || string(it->component) != component) {
+        return false;
+    }
+    package = std::string(string(it->package));
+    return true;
+}
+
+bool RepoIndex::plugin(std::string_view name, PluginEntry& entry) const {
+    if (header_ == nullptr) {
+        return false;
+    }
+    const PluginRecord* end = plugins_ + header_->pluginCount;
+    const PluginRecord* it = std::lower_bound(plugins_, end, name, [this](const PluginRecord& r, std::string_view key) {
+        return string(r.name) < key;
+    });
+    if (it == end || string(it->name) != name) {
+        return false;
+    }
+    entry.description = std::string(string(it->description));
+    entry.packages = list(it->packagesBegin, it->packagesCount);
+    entry.requirements = list(it->requirementsBegin, it->requirementsCount);
+    return true;
+}
+
+std::vector<std::string> RepoIndex::pluginNames() const {
+    std::vector<std::string> names;
+    for (std::uint32_t i = 0; header_ != nullptr && i < header_->pluginCount; ++i) {
+        names.emplace_back(string(plugins_[i].name));
+    }
+    return names;
+}
+
+namespace {
+
+RepoIndex& localIndex() {
+    static RepoIndex index;
+    static bool opened = index.open(RepoIndex::kDefaultPath);
+    (void)opened;
+    return index;
+}
+
+} // namespace
+
+const RepoIndex& RepoIndex::local() {
+    return localIndex();
+}
+
+bool RepoIndex::reloadLocal() {
+    return localIndex().open(kDefaultPath);
+}
+
+bool RepoIndex::compile(const std::string& source, std::string& image, std::string& error) {
+    std::vector<std::string> lines;
+    FileUtils::splitLines(source, lines);
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+
+    // 字符串去重，内容不变的字符串在新旧映像中保持相对位置，增量更新时更容易匹配
+    std::string strings(1, '\0');
+    std::map<std::string, std::uint32_t> offsets;
+    auto intern = [&](const std::string& s) {
+        auto it = offsets.find(s);
+        if (it != offsets.end()) {
+            return it->second;
+        }
+        std::uint32_t offset = static_cast<std::uint32_t>(strings.size());
+        strings.append(s);
+        strings.push_back('\0');
+        offsets.emplace(s, offset);
+        return offset;
+    };
+    std::vector<std::uint32_t> listTable;
+    auto addList = [&](const std::string& words, std::uint32_t& begin, std::uint32_t& count) {
+        std::vector<std::string> items = FileUtils::splitFields(words);
+        begin = static_cast<std::uint32_t>(listTable.size());
+        count = static_cast<std::uint32_t>(items.size());
+        for (const auto& item : items) {
+            listTable.push_back(intern(item));
+        }
+    };
+
+    std::vector<SceneRecord> scenes;
+    std::map<std::string, PluginRecord> plugins;
+    std::map<std::string, AliasRecord> aliases;
+    bool versioned = false;
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        std::vector<std::string> fields = splitTabs(lines[i]);
+        const std::string& kind = fields[0];
+        if (kind.empty() || kind[0] == '#') {
+            continue;
+        }
+        std::string where = "line " + std::to_string(i + 1) + ": ";
+        if (kind == "xkl-repo-1" && fields.size() == 2) {
+            header.version = std::strtoull(fields[1].c_str(), nullptr, 10);
+            versioned = header.version > 0;
+        } else if (kind == "S" && fields.size() == 6) {
+            SceneRecord r;
+            r.name = intern(fields[1]);
+            r.titleZh = intern(fields[2]);
+            r.titleEn = intern(fields[3]);
+            r.highlights = intern(fields[4]);
+            addList(fields[5], r.componentsBegin, r.componentsCount);
+            scenes.push_back(r);
+        } else if (kind == "A" && fields.size() == 3) {
+            aliases[fields[1]] = AliasRecord{intern(fields[1]), intern(fields[2])};
+        } else if (kind == "P" && fields.size() == 5) {
+            PluginRecord r;
+            r.name = intern(fields[1]);
+            r.description = intern(fields[2]);
+            addList(fields[3], r.packagesBegin, r.packagesCount);
+            addList(fields[4], r.requirementsBegin, r.requirementsCount);
+            plugins[fields[1]] = r;
+        } else {
+            error = where + "unrecognized entry";
+            return false;
+        }
+    }
+    if (!versioned) {
+        error = "missing 'xkl-repo-1<TAB><version>' header";
+        return false;
+    }
+
+    header.sceneCount = static_cast<std::uint32_t>(scenes.size());
+    header.pluginCount = static_cast<std::uint32_t>(plugins.size());
+    header.aliasCount = static_cast<std::uint32_t>(aliases.size());
+    header.listCount = static_cast<std::uint32_t>(listTable.size());
+    header.stringBytes = strings.size();
+
+    image.clear();
+    image.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    image.append(reinterpret_cast<const char*>(scenes.data()), scenes.size() * sizeof(SceneRecord));
+    for (const auto& plugin : plugins) {
+        image.append(reinterpret_cast<const char*>(&plugin.second), sizeof(PluginRecord));
+    }
+    for (const auto& alias : aliases) {
+        image.append(reinterpret_cast<const char*>(&alias.second), sizeof(AliasRecord));
+    }
+    image.append(reinterpret_cast<const char*>(listTable.data()), listTable.size() * sizeof(std::uint32_t));
+    image.append(strings);
+    return littleEndian();
+}
+
+std::string RepoIndex::sums(const std::string& image, std::size_t blockSize) {
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    if (image.size() >= sizeof(header)) {
+        std::memcpy(&header, image.data(), sizeof(header));
+    }
+    Sha256 sha;
+    sha.update(image.data(), image.size());
+
+    std::string content = "xkl-sums-1\n";
+    content += "version " + std::to_string(header.version) + "\n";
+    content += "length " + std::to_string(image.size()) + "\n";
+    content += "blocksize " + std::to_string(blockSize) + "\n";
+    content += "sha256 " + sha.hexDigest() + "\n";
+
+    std::string block(blockSize, '\0');
+    char line[40];
+    for (std::size_t offset = 0; offset < image.size(); offset += blockSize) {
+        // 末块补零，客户端在旧副本末尾同样补零后匹配
+        std::size_t n = std::min(blockSize, image.size() - offset);
+        std::memcpy(&block[0], image.data() + offset, n);
+        std::memset(&block[n], 0, blockSize - n);
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(block.data());
+        RollingSum weak;
+        weak.reset(data, blockSize);
+        std::snprintf(line, sizeof(line), "%08x %016llx\n", weak.value(),
+                      static_cast<unsigned long long>(blockHash(data, blockSize)));
+        content += line;
+    }
+    return content;
+}
+
+bool RepoIndex::update(const std::string& url, const std::string& path, UpdateReport& report) {
+    report = UpdateReport();
+    std::string sumsText;
+    if (!Process::capture("curl -fsSL " + shellQuote(joinUrl(url, kSumsName)) + " 2>/dev/null", sumsText)) {
+        report.error = "cannot fetch " + std::string(kSumsName);
+        return false;
+    }
+    report.fetched = sumsText.size();
+    Sums remote;
+    if (!remote.parse(sumsText)) {
+        report.error = "malformed " + std::string(kSumsName);
+        return false;
+    }
+    report.toVersion = remote.version;
+    report.length = remote.length;
+    report.blocks = remote.blocks.size();
+
+    std::string local;
+    FileUtils::readFile(path, local);
+    if (validate(local.data(), local.size())) {
+        Header header;
+        std::memcpy(&header, local.data(), sizeof(header));
+        report.fromVersion = header.version;
+    } else {
+        local.clear();
+    }
+    if (!local.empty()) {
+        Sha256 sha;
+        sha.update(local.data(), local.size());
+        if (sha.hexDigest() == remote.sha256) {
+            report.upToDate = true;
+            report.matchedBlocks = report.blocks;
+            return true;
+        }
+    }
+
+    // 在旧副本上滑动窗口：弱校验命中后再比较 XXH64，匹配成功跳过整块，否则前进一个字节
+    const std::size_t bs = remote.blockSize;
+    std::vector<std::int64_t> source(remote.blocks.size(), -1);   // 新块在旧副本中的位置
+    if (!local.empty()) {
+        std::unordered_multimap<std::uint32_t, std::size_t> byWeak;
+        for (std::size_t i = 0; i < remote.blocks.size(); ++i) {
+            byWeak.emplace(remote.blocks[i].first, i);
+        }
+        std::string padded = local + std::string(bs, '\0');
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(padded.data());
+        std::size_t limit = local.size();   // 窗口起点不超过旧副本末尾（其后是补零）
+        RollingSum weak;
+        weak.reset(data, bs);
+        for (std::size_t pos = 0; pos < limit;) {
+            bool matched = false;
+            auto range = byWeak.equal_range(weak.value());
+            if (range.first != range.second) {
+                std::uint64_t strong = blockHash(data + pos, bs);
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (remote.blocks[it->second].second == strong && source[it->second] < 0) {
+                        source[it->second] = static_cast<std::int64_t>(pos);
+                        matched = true;
+                    }
+                }
+            }
+            if (matched && pos + 2 * bs <= padded.size()) {
+                pos += bs;
+                weak.reset(data + pos, bs);
+            } else {
+                if (pos + bs >= padded.size()) {
+                    break;
+                }
+                weak.roll(data[pos], data[pos + bs], bs);
+                ++pos;
+            }
+        }
+    }
+
+    // 匹配不到的块合并成连续区间
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges;   // [起, 止)
+    for (std::size_t i = 0; i < source.size(); ++i) {
+        if (source[i] >= 0) {
+            ++report.matchedBlocks;
+            continue;
+        }
+        std::uint64_t begin = std::uint64_t(i) * bs;
+        std::uint64_t end = std::min<std::uint64_t>(begin + bs, remote.length);
+        if (!ranges.empty() && ranges.back().second == begin) {
+            ranges.back().second = end;
+        } else {
+            ranges.emplace_back(begin, end);
+        }
+    }
+
+    std::uint64_t missing = 0;
+    for (const auto& range : ranges) {
+        missing += range.second - range.first;
+    }
+
+    std::string image(remote.length, '\0');
+    std::string indexUrl = shellQuote(joinUrl(url, kIndexName));
+    std::string body;
+    if (!local.empty() && ranges.size() <= kMaxRanges && missing * 2 <= remote.length) {
+        // 一个 curl 进程依次请求各区间（--next 复用连接），响应按顺序写到标准输出
+        std::string cmd = "curl";
+        for (std::size_t i = 0; i < ranges.size(); ++i) {
+            cmd += std::string(i > 0 ? " --next" : "") + " -fsSL -r " + std::to_string(ranges[i].first) + "-" +
+                   std::to_string(ranges[i].second - 1) + " " + indexUrl;
+        }
+        bool fetched = ranges.empty() || Process::capture(cmd + " 2>/dev/null", body);
+        report.fetched += body.size();
+        if (fetched && body.size() == missing) {
+            for (std::size_t i = 0; i < source.size(); ++i) {
+                if (source[i] >= 0) {
+                    // 块可能延伸到旧副本末尾之后，那部分是补零，image 中本来就是 0
+                    std::size_t begin = i * bs;
+                    std::size_t n = std::min<std::size_t>(bs, remote.length - begin);
+                    n = std::min<std::size_t>(n, local.size() - static_cast<std::size_t>(source[i]));
+                    std::memcpy(&image[begin], local.data() + source[i], n);
+                }
+            }
+            std::size_t cursor = 0;
+            for (const auto& range : ranges) {
+                std::size_t n = static_cast<std::size_t>(range.second - range.first);
+                std::memcpy(&image[range.first], body.data() + cursor, n);
+                cursor += n;
+            }
+            report.ranges = ranges.size();
+        } else {
+            // 服务器不支持 Range（返回整个文件）时长度对不上，退回整个下载
+            report.full = true;
+        }
+    } else {
+        report.full = true;
+    }
+    if (report.full) {
+        body.clear();
+        if (!Process::capture("curl -fsSL " + indexUrl + " 2>/dev/null", body) || body.size() != remote.length) {
+            report.error = "cannot fetch " + std::string(kIndexName);
+            return false;
+        }
+        report.fetched += body.size();
+        image = std::move(body);
+        report.ranges = 1;
+    }
+
+    Sha256 sha;
+    sha.update(image.data(), image.size());
+    if (sha.hexDigest() != remote.sha256 || !validate(image.data(), image.size())) {
+        report.error = "digest mismatch";
+        return false;
+    }
+
+    std::string dir = path.substr(0, path.rfind('/'));
+    mkdir(dir.c_str(), 0755);
+    if (!FileUtils::writeFileAtomic(path, image)) {
+        report.error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace LinuxStudio
@@ -0,0 +1,151 @@
+#include "linuxstudio/scene_lock.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/stat.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+const char* const kHeader = "xkl-lock-1";
+
+bool charsIn(const std::string& text, const char* extra) {
+    return std::all_of(text.begin(), text.end(), [extra](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || (c != '\0' && std::strchr(extra, c) != nullptr);
+    });
+}
+
+/**
+ * @brief 场景、插件与软件包名：字母或数字开头，会拼进路径与命令行
+ */
+bool plainName(const std::string& name) {
+    return !name.empty() && std::isalnum(static_cast<unsigned char>(name[0])) && charsIn(name, "+.-_");
+}
+
+bool hexDigest(const std::string& text) {
+    return text.size() == 64 && std::all_of(text.begin(), text.end(), [](char c) {
+        return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+    });
+}
+
+/**
+ * @brief wheel 条目：不含 / 的文件名 + "#sha256=" + 64 位十六进制摘要（摘要用作仓库中的文件名）
+ */
+bool wheelEntry(const std::string& wheel) {
+    std::size_t hash = wheel.rfind("#sha256=");
+    return hash != std::string::npos && hash > 0 && wheel.find('/') == std::string::npos &&
+           hexDigest(wheel.substr(hash + 8));
+}
+
+/**
+ * @brief 锁文件可能来自离线包（不可信）：名字与版本会拼进解压路径和 apt 命令行，逐项检查
+ */
+bool validPackage(const SceneLock::Package& package) {
+    const std::string& version = package.version;
+    const std::string& filename = package.filename;
+    return plainName(package.name) && !version.empty() && std::isalnum(static_cast<unsigned char>(version[0])) &&
+           charsIn(version, "+.-~:") && (package.sha256.empty() || hexDigest(package.sha256)) &&
+           charsIn(filename, "+.-_~%/") && filename.find("..") == std::string::npos &&
+           (filename.empty() || filename[0] != '/');
+}
+
+} // namespace
+
+std::string SceneLock::directory() {
+    const char* override = std::getenv("XKL_LOCK_DIR");
+    if (override && *override) {
+        return override;
+    }
+    return kDefaultDir;
+}
+
+std::string SceneLock::defaultPath(const std::string& scene) {
+    return directory() + "/" + scene + ".lock";
+}
+
+bool SceneLock::load(const std::string& path) {
+    std::string content;
+    return FileUtils::readFile(path, content) && parse(content);
+}
+
+bool SceneLock::parse(const std::string& content) {
+    packages.clear();
+    wheels.clear();
+    std::vector<std::string> lines;
+    FileUtils::splitLines(content, lines);
+    if (lines.empty()) {
+        return false;
+    }
+    std::vector<std::string> header = FileUtils::splitFields(lines[0]);
+    if (header.size() != 2 || header[0] != kHeader) {
+        return false;
+    }
+    scene = header[1];
+    if (!plainName(scene)) {
+        return false;
+    }
+
+    for (size_t i = 1; i < lines.size(); ++i) {
+        std::vector<std::string> fields = FileUtils::splitFields(lines[i]);
+        if (fields.empty() || fields[0][0] == '#') {
+            continue;
+        }
+        if (fields[0] == "P" && fields.size() == 7) {
+            Package package;
+            package.level = static_cast<unsigned>(std::strtoul(fields[1].c_str(), nullptr, 10));
+            package.root = fields[2] == "1";
+            package.name = fields[3];
+            package.version = fields[4];
+            package.sha256 = fields[5] == "-" ? "" : fields[5];
+            package.filename = fields[6] == "-" ? "" : fields[6];
+            if (!validPackage(package)) {
+                return false;
+            }
+            packages.push_back(std::move(package));
+        } else if (fields[0] == "W" && fields.size() == 3 && plainName(fields[1]) && wheelEntry(fields[2])) {
+            wheels[fields[1]].push_back(fields[2]);
+        } else {
+            return false;
+        }
+    }
+    std::stable_sort(packages.begin(), packages.end(),
+                     [](const Package& a, const Package& b) { return a.level < b.level; });
+    return true;
+}
+
+bool SceneLock::save(const std::string& path) const {
+    size_t slash = path.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        std::string dir = path.substr(0, slash);
+        mkdir(dir.substr(0, dir.rfind('/')).c_str(), 0755);
+        mkdir(dir.c_str(), 0755);
+    }
+
+    std::string content = std::string(kHeader) + "\t" + scene + "\n";
+    for (const auto& package : packages) {
+        content += "P\t" + std::to_string(package.level) + "\t" + (package.root ? "1" : "0") + "\t" +
+                   package.name + "\t" + package.version + "\t" +
+                   (package.sha256.empty() ? "-" : package.sha256) + "\t" +
+                   (package.filename.empty() ? "-" : package.filename) + "\n";
+    }
+    for (const auto& plugin : wheels) {
+        for (const auto& wheel : plugin.second) {
+            content += "W\t" + plugin.first + "\t" + wheel + "\n";
+        }
+    }
+    return FileUtils::writeFileAtomic(path, content);
+}
+
+size_t SceneLock::levelCount() const {
+    unsigned levels = 0;
+    for (const auto& package : packages) {
+        levels = std::max(levels, package.level + 1);
+    }
+    return levels;
+}
+
+} // namespace LinuxStudio
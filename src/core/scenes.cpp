@@ -0,0 +1,239 @@
+#include "linuxstudio/scenes.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/repo_index.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+
+#include <sys/stat.h>
+
+namespace LinuxStudio {
+
+const std::vector<SceneDefinition>& builtinScenes() {
+    static const std::vector<SceneDefinition> scenes = {
+        {"web-development", "Web 开发", "Web Development",
+         "Nginx, PHP, Java, MySQL, Redis, Node.js",
+         {"nginx", "php", "java", "mysql", "redis", "nodejs"}},
+        {"embedded", "嵌入式开发", "Embedded Systems",
+         "ARM/RISC-V GCC, OpenOCD, GDB",
+         {"gcc-arm", "openocd", "gdb", "minicom", "i2c-tools", "spi-tools"}},
+        {"robotics", "机器人开发", "Robotics",
+         "ROS2, MoveIt2, Gazebo, OpenCV",
+         {"ros2", "opencv", "gazebo", "moveit2"}},
+        {"ai-ml", "AI/ML 开发", "AI/ML Development",
+         "Python, Jupyter, TensorFlow, PyTorch",
+         {"python", "jupyter", "tensorflow", "pytorch", "opencv"}},
+        {"game-dev", "游戏开发", "Game Development",
+         "SDL2, OpenGL, Vulkan, Godot",
+         {"sdl2", "opengl", "vulkan", "godot"}},
+        {"devops", "DevOps", "DevOps",
+         "Docker, Kubernetes, Jenkins, Prometheus",
+         {"docker", "kubernetes", "jenkins", "prometheus", "grafana"}},
+        {"security", "网络安全", "Security",
+         "Nmap, Wireshark, Metasploit",
+         {"nmap", "wireshark", "metasploit"}},
+        {"blockchain", "区块链开发", "Blockchain Development",
+         "Hardhat, Solidity, Web3.js",
+         {"hardhat", "web3js", "solidity", "ipfs"}},
+        {"iot", "物联网开发", "IoT Development",
+         "Mosquitto, Node-RED, InfluxDB",
+         {"mosquitto", "node-red", "influxdb", "grafana"}}
+    };
+    return scenes;
+}
+
+const std::vector<SceneDefinition>& availableScenes() {
+    // 按索引版本缓存；xkl repo update 重新映射索引后下次调用重建
+    static std::vector<SceneDefinition> scenes;
+    static std::uint64_t version = ~0ull;
+    const RepoIndex& index = RepoIndex::local();
+    if (version != index.version()) {
+        version = index.version();
+        scenes = builtinScenes();
+        for (auto& scene : index.scenes()) {
+            auto it = std::find_if(scenes.begin(), scenes.end(),
+                                   [&](const SceneDefinition& s) { return s.name == scene.name; });
+            if (it != scenes.end()) {
+                *it = std::move(scene);
+            } else {
+                scenes.push_back(std::move(scene));
+            }
+        }
+    }
+    return scenes;
+}
+
+const SceneDefinition* findScene(const std::string& name) {
+    for (const auto& scene : availableScenes()) {
+        if (scene.name == name) {
+            return &scene;
+        }
+    }
+    return nullptr;
+}
+
+std::string scenePackageName(const std::string& component) {
+    static const std::map<std::string, std::string> aliases = {
+        {"java", "default-jdk"},
+        {"mysql", "default-mysql-server"},
+        {"redis", "redis-server"},
+        {"gcc-arm", "gcc-arm-none-eabi"},
+        {"ros2", "ros-humble-desktop"},
+        {"moveit2", "ros-humble-moveit"},
+        {"opencv", "libopencv-dev"},
+        {"python", "python3"},
+        {"jupyter", "jupyter-notebook"},
+        {"pytorch", "python3-torch"},
+        {"sdl2", "libsdl2-dev"},
+        {"opengl", "libgl-dev"},
+        {"vulkan", "libvulkan-dev"},
+        {"godot", "godot3"},
+        {"docker", "docker.io"},
+        {"kubernetes", "kubectl"},
+    };
+    std::string package;
+    if (RepoIndex::local().alias(component, package)) {
+        return package;
+    }
+    auto it = aliases.find(component);
+    return it != aliases.end() ? it->second : component;
+}
+
+std::string SceneRecord::directory() {
+    const char* override = std::getenv("XKL_SCENES_DIR");
+    if (override && *override) {
+        return override;
+    }
+    return kDefaultDir;
+}
+
+// 记录格式：每行 "P<TAB>包名" 或 "W<TAB>插件名"
+bool SceneRecord::load(const std::string& scene) {
+    packages.clear();
+    plugins.clear();
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(directory() + "/" + scene + ".applied", lines)) {
+        return false;
+    }
+    for (const auto& line : lines) {
+        if (line.size() > 2 && line[1] == '\t') {
+            (line[0] == 'W' ? plugins : packages).insert(line.substr(2));
+        }
+    }
+    return true;
+}
+
+bool SceneRecord::merge(const std::string& scene) const {
+    SceneRecord merged;
+    merged.load(scene);
+    merged.packages.insert(packages.begin(), packages.end());
+    merged.plugins.insert(plugins.begin(), plugins.end());
+    return merged.save(scene);
+}
+
+bool SceneRecord::save(const std::string& scene) const {
+    std::string content;
+    for (const auto& package : packages) {
+        content += "P\t" + package + "\n";
+    }
+    for (const auto& plugin : plugins) {
+        content += "W\t" + plugin + "\n";
+    }
+    mkdir(directory().c_str(), 0755);
+    return FileUtils::writeFileAtomic(directory() + "/" + scene + ".applied", content);
+}
+
+std::string SceneState::path() {
+    return SceneRecord::directory() + "/state";
+}
+
+// 状态格式：每行 "A<TAB>场景名" 或 "K<TAB>保留的包名"
+bool SceneState::load() {
+    active.clear();
+    warm.clear();
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(path(), lines)) {
+        return false;
+    }
+    for (const auto& line : lines) {
+        if (line.size() > 2 && line[1] == '\t') {
+            (line[0] == 'K' ? warm : active).insert(line.substr(2));
+        }
+    }
+    return true;
+}
+
+bool SceneState::save() const {
+    std::string content;
+    for (const auto& scene : active) {
+        content += "A\t" + scene + "\n";
+    }
+    for (const auto& package : warm) {
+        content += "K\t" + package + "\n";
+    }
+    mkdir(SceneRecord::directory().c_str(), 0755);
+    return FileUtils::writeFileAtomic(path(), content);
+}
+
+bool SceneState::activate(const std::string& scene) {
+    SceneState state;
+    state.load();
+    return !state.active.insert(scene).second || state.save();
+}
+
+SceneSwitch::SceneSwitch(const SceneState& state, const std::string& target, const std::string& from) {
+    if (!from.empty()) {
+        leaving.insert(from);
+    } else {
+        leaving = state.active;
+    }
+    leaving.erase(target);
+    for (const auto& active : state.active) {
+        if (leaving.count(active) == 0) {
+            staying.insert(active);
+        }
+    }
+    staying.insert(target);
+}
+
+void SceneSwitch::classify(const SceneState& state, const std::set<std::string>& needed) {
+    std::set<std::string> candidates = state.warm;
+    for (const auto& left : leaving) {
+        records[left].load(left);
+        candidates.insert(records[left].packages.begin(), records[left].packages.end());
+    }
+    shared.clear();
+    orphans.clear();
+    for (const auto& package : candidates) {
+        (needed.count(package) > 0 ? shared : orphans).push_back(package);
+    }
+}
+
+std::vector<std::string> SceneSwitch::finish(SceneState& state, const std::vector<std::string>& removed,
+                                             bool keepWarm, bool removalOk) {
+    for (auto& entry : records) {
+        for (const auto& package : removed) {
+            entry.second.packages.erase(package);
+        }
+        entry.second.save(entry.first);
+    }
+
+    std::set<std::string> gone(removed.begin(), removed.end());
+    std::vector<std::string> required;
+    state.active = staying;
+    state.warm.clear();
+    for (const auto& package : orphans) {
+        if (gone.count(package) > 0) {
+            continue;
+        }
+        if (keepWarm || !removalOk) {
+            state.warm.insert(package);
+        } else {
+            required.push_back(package);
+        }
+    }
+    state.save();
+    return required;
+}
+
+} // namespace LinuxStudio
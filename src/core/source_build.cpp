@@ -0,0 +1,392 @@
+#include "linuxstudio/source_build.hpp"
+#include "linuxstudio/disk_usage.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/hash.hpp"
+#include "linuxstudio/process.hpp"
+#include "linuxstudio/resource_slice.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+// 内置配方：源码固定到发布标签，不在此处写入摘要
+const char* const kBuiltinRecipes[] = {
+    "name openocd\n"
+    "version 0.12.0\n"
+    "git https://github.com/openocd-org/openocd.git v0.12.0\n"
+    "system autotools\n"
+    "bootstrap ./bootstrap\n"
+    "depends libtool autoconf automake texinfo pkg-config libusb-1.0-0-dev libftdi1-dev libhidapi-dev\n"
+    "configure --enable-ftdi --enable-stlink --enable-cmsis-dap --disable-werror\n"
+    "link-memory 512M\n",
+
+    "name opencv\n"
+    "version 4.10.0\n"
+    "git https://github.com/opencv/opencv.git 4.10.0\n"
+    "system cmake\n"
+    "depends cmake ninja-build pkg-config libjpeg-dev libpng-dev libtiff-dev\n"
+    "configure -DBUILD_TESTS=OFF -DBUILD_PERF_TESTS=OFF -DBUILD_EXAMPLES=OFF -DBUILD_opencv_apps=OFF\n"
+    "configure.aarch64 -DCPU_BASELINE=NEON -DCPU_DISPATCH=NEON_FP16,NEON_BF16,NEON_DOTPROD\n"
+    "configure.armv7l -DENABLE_NEON=ON -DENABLE_VFPV3=ON -DCPU_BASELINE=NEON\n"
+    "link-memory 2G\n",
+};
+
+/**
+ * @brief 逐级创建目录
+ */
+bool makeDirs(const std::string& path) {
+    for (std::size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        std::string dir = path.substr(0, slash);
+        struct stat st;
+        if (stat(dir.c_str(), &st) != 0 && mkdir(dir.c_str(), 0755) != 0) {
+            return false;
+        }
+        if (slash == std::string::npos) {
+            return true;
+        }
+    }
+}
+
+bool exists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+std::string machine() {
+    struct utsname name;
+    return uname(&name) == 0 ? name.machine : "";
+}
+
+bool validName(const std::string& name) {
+    return !name.empty() && name[0] != '.' &&
+           std::all_of(name.begin(), name.end(), [](char c) {
+               return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.' || c == '+';
+           });
+}
+
+std::string joinArgs(const std::vector<std::string>& args) {
+    std::string joined;
+    for (const auto& arg : args) {
+        joined += " " + arg;
+    }
+    return joined;
+}
+
+} // namespace
+
+bool BuildRecipe::parse(const std::string& content) {
+    *this = BuildRecipe();
+    std::vector<std::string> lines;
+    FileUtils::splitLines(content, lines);
+    for (const auto& line : lines) {
+        std::vector<std::string> fields = FileUtils::splitFields(line);
+        if (fields.empty() || fields[0][0] == '#') {
+            continue;
+        }
+        const std::string& key = fields[0];
+        std::vector<std::string> values(fields.begin() + 1, fields.end());
+        if (values.empty()) {
+            continue;
+        }
+        if (key == "name") {
+            name = values[0];
+        } else if (key == "version") {
+            version = values[0];
+        } else if (key == "url" && values.size() >= 2) {
+            url = values[0];
+            sha256 = values[1];
+        } else if (key == "git" && values.size() >= 2) {
+            git = values[0];
+            ref = values[1];
+        } else if (key == "system") {
+            if (values[0] == "cmake") {
+                system = System::CMake;
+            } else if (values[0] == "autotools") {
+                system = System::Autotools;
+            } else if (values[0] == "make") {
+                system = System::Make;
+            } else {
+                return false;
+            }
+        } else if (key == "bootstrap") {
+            bootstrap = joinArgs(values).substr(1);
+        } else if (key == "depends") {
+            depends.insert(depends.end(), values.begin(), values.end());
+        } else if (key == "configure") {
+            configure.insert(configure.end(), values.begin(), values.end());
+        } else if (key.compare(0, 10, "configure.") == 0) {
+            auto& args = archConfigure[key.substr(10)];
+            args.insert(args.end(), values.begin(), values.end());
+        } else if (key == "link-memory") {
+            if (!DiskUsage::parseBytes(values[0], linkMemory)) {
+                return false;
+            }
+        } else if (key == "prefix") {
+            prefix = values[0];
+        } else {
+            continue;   // 未知的键不参与缓存键
+        }
+        text += key + joinArgs(values) + "\n";
+    }
+    return validName(name) && validName(version) && (!url.empty() || !git.empty()) && prefix[0] == '/';
+}
+
+bool BuildRecipe::find(const std::string& name, BuildRecipe& recipe) {
+    if (!validName(name)) {
+        return false;
+    }
+    std::string content;
+    if (FileUtils::readFile(std::string(kDefaultDir) + "/" + name + ".recipe", content)) {
+        return recipe.parse(content) && recipe.name == name;
+    }
+    for (const char* builtin : kBuiltinRecipes) {
+        if (recipe.parse(builtin) && recipe.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> BuildRecipe::available() {
+    std::vector<std::string> names;
+    BuildRecipe recipe;
+    for (const char* builtin : kBuiltinRecipes) {
+        if (recipe.parse(builtin)) {
+            names.push_back(recipe.name);
+        }
+    }
+    if (DIR* dir = opendir(kDefaultDir)) {
+        while (struct dirent* entry = readdir(dir)) {
+            std::string file = entry->d_name;
+            if (file.size() > 7 && file.compare(file.size() - 7, 7, ".recipe") == 0) {
+                names.push_back(file.substr(0, file.size() - 7));
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
+void SourceBuilder::loadConfig(const std::string& path) {
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(path, lines)) {
+        return;
+    }
+    for (const auto& line : lines) {
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> key = FileUtils::splitFields(line.substr(0, colon));
+        std::vector<std::string> value = FileUtils::splitFields(line.substr(colon + 1));
+        if (key.size() != 1 || value.empty()) {
+            continue;
+        }
+        const std::string& k = key[0];
+        const std::string& v = value[0];
+        if (k == "build_ccache") {
+            ccache_ = (v == "true" || v == "yes" || v == "on");
+        } else if (k == "build_ccache_size") {
+            ccacheSize_ = v;
+        } else if (k == "build_link_memory") {
+            DiskUsage::parseBytes(v, linkMemory_);
+        }
+    }
+}
+
+std::string SourceBuilder::toolchainIdentity() {
+    // 编译器升级或目标改变后旧构件不再可用；ccache 只是加速手段，不参与
+    std::string identity = machine() + "\n";
+    for (const char* cmd : {"cc -dumpmachine", "cc --version", "c++ --version"}) {
+        std::string output;
+        Process::capture(std::string(cmd) + " 2>/dev/null", output);
+        identity += output;
+    }
+    return identity;
+}
+
+bool SourceBuilder::fetch(const BuildRecipe& recipe, const std::string& sourceDir, Report& report) {
+    std::string sources = std::string(kCacheDir) + "/sources";
+    makeDirs(sources);
+
+    if (!recipe.git.empty()) {
+        // 浅克隆一次后缓存，之后的构建复制工作树
+        std::string mirror = sources + "/" + recipe.name + "-" + recipe.ref;
+        if (!exists(mirror + "/.git")) {
+            FileUtils::removeTree(mirror);
+            std::string cmd = "git clone --depth 1 --recurse-submodules --shallow-submodules --branch " +
+                              Process::quote(recipe.ref) + " " + Process::quote(recipe.git) + " " + Process::quote(mirror);
+            if (!Process::succeeded(cmd, "fetch " + recipe.name)) {
+                FileUtils::removeTree(mirror);
+                report.failedStep = "fetch";
+                return false;
+            }
+        }
+        if (!Process::succeeded("cp -a " + Process::quote(mirror) + " " + Process::quote(sourceDir))) {
+            report.failedStep = "fetch";
+            return false;
+        }
+        return true;
+    }
+
+    // 源码包按摘要命名，摘要不符的下载不会留在缓存中
+    std::string archive = sources + "/" + recipe.sha256 + "-" + recipe.url.substr(recipe.url.rfind('/') + 1);
+    std::string digest;
+    if (!Sha256::hashFile(archive, digest) || digest != recipe.sha256) {
+        std::string partial = archive + ".part";
+        if (!Process::succeeded("curl -fsSL -o " + Process::quote(partial) + " " + Process::quote(recipe.url),
+                                "fetch " + recipe.name) ||
+            !Sha256::hashFile(partial, digest) || digest != recipe.sha256 ||
+            rename(partial.c_str(), archive.c_str()) != 0) {
+            unlink(partial.c_str());
+            report.failedStep = digest.empty() ? "fetch" : "checksum";
+            return false;
+        }
+    }
+    if (!makeDirs(sourceDir) ||
+        !Process::succeeded("tar -xf " + Process::quote(archive) + " --strip-components=1 -C " + Process::quote(sourceDir))) {
+        report.failedStep = "extract";
+        return false;
+    }
+    return true;
+}
+
+bool SourceBuilder::build(const BuildRecipe& recipe, bool rebuild, Report& report) {
+    auto started = std::chrono::steady_clock::now();
+    auto finish = [&](bool ok) {
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return ok;
+    };
+    report = Report();
+
+    Sha256 key;
+    std::string identity = toolchainIdentity();
+    key.update(recipe.text.data(), recipe.text.size());
+    key.update(identity.data(), identity.size());
+    report.key = key.hexDigest();
+
+    std::string builds = std::string(kCacheDir) + "/builds";
+    makeDirs(builds);
+    report.artifact = builds + "/" + recipe.name + "-" + recipe.version + "-" + report.key.substr(0, 12) + ".tar.gz";
+    std::string install = "tar --no-overwrite-dir -xzf " + Process::quote(report.artifact) + " -C / && (ldconfig || true)";
+
+    if (!rebuild && exists(report.artifact)) {
+        report.cacheHit = true;
+        if (!Process::succeeded(install, "install " + recipe.name)) {
+            report.failedStep = "install";
+            return finish(false);
+        }
+        return finish(true);
+    }
+
+    if (!recipe.depends.empty() && Process::succeeded("which apt-get > /dev/null 2>&1") &&
+        !Process::succeeded("apt-get install -y --no-install-recommends" + joinArgs(recipe.depends),
+                            "build deps " + recipe.name)) {
+        report.failedStep = "depends";
+        return finish(false);
+    }
+
+    std::string work = std::string(kWorkDir) + "/xkl-build-" + recipe.name;
+    std::string sourceDir = work + "/src";
+    std::string buildDir = work + "/build";
+    std::string stageDir = work + "/stage";
+    FileUtils::removeTree(work);
+    if (!makeDirs(work) || !fetch(recipe, sourceDir, report)) {
+        if (report.failedStep.empty()) {
+            report.failedStep = "fetch";
+        }
+        FileUtils::removeTree(work);
+        return finish(false);
+    }
+    makeDirs(buildDir);
+
+    // 并行度：编译按默认的每任务内存，链接按配方的 link-memory
+    auto& slice = ResourceSlice::getInstance();
+    report.jobs = slice.jobsFor(0);
+    report.linkJobs = std::min(report.jobs, slice.jobsFor(recipe.linkMemory > 0 ? recipe.linkMemory : linkMemory_));
+
+    // 编译缓存：所有构建共用，CCACHE_BASEDIR 使不同构建目录的相同源码也能命中
+    std::string env;
+    report.ccache = ccache_ && Process::succeeded("which ccache > /dev/null 2>&1");
+    if (report.ccache) {
+        std::string dir = std::string(kCacheDir) + "/ccache";
+        makeDirs(dir);
+        env = "export CCACHE_DIR=" + Process::quote(dir) + " CCACHE_MAXSIZE=" + Process::quote(ccacheSize_) +
+              " CCACHE_BASEDIR=" + Process::quote(work) + "; ";
+    }
+
+    std::vector<std::string> args = recipe.configure;
+    auto arch = recipe.archConfigure.find(machine());
+    if (arch != recipe.archConfigure.end()) {
+        args.insert(args.end(), arch->second.begin(), arch->second.end());
+    }
+
+    std::vector<std::pair<std::string, std::string>> steps;   // 步骤名 -> 命令
+    std::string jobs = std::to_string(report.jobs);
+    if (recipe.system == BuildRecipe::System::CMake) {
+        std::string configure = "cmake -S " + Process::quote(sourceDir) + " -B " + Process::quote(buildDir) +
+                                " -DCMAKE_BUILD_TYPE=Release -DCMAKE_INSTALL_PREFIX=" + Process::quote(recipe.prefix);
+        if (report.ccache) {
+            configure += " -DCMAKE_C_COMPILER_LAUNCHER=ccache -DCMAKE_CXX_COMPILER_LAUNCHER=ccache";
+        }
+        if (Process::succeeded("which ninja > /dev/null 2>&1")) {
+            // Ninja 支持 job pool：编译满并行，链接单独限流
+            configure += " -G Ninja -DCMAKE_JOB_POOLS='compile=" + jobs + ";link=" + std::to_string(report.linkJobs) +
+                         "' -DCMAKE_JOB_POOL_COMPILE=compile -DCMAKE_JOB_POOL_LINK=link";
+        } else {
+            jobs = std::to_string(report.linkJobs);
+        }
+        steps.emplace_back("configure", configure + joinArgs(args));
+        steps.emplace_back("compile", "cmake --build " + Process::quote(buildDir) + " -j " + jobs);
+        steps.emplace_back("stage", "DESTDIR=" + Process::quote(stageDir) + " cmake --install " + Process::quote(buildDir));
+    } else {
+        // make 无法区分链接任务，取两者中较小的并行度
+        jobs = std::to_string(report.linkJobs);
+        std::string compilers = report.ccache ? "CC=\"ccache ${CC:-cc}\" CXX=\"ccache ${CXX:-c++}\" " : "";
+        std::string inSource = "cd " + Process::quote(sourceDir) + " && ";
+        if (recipe.system == BuildRecipe::System::Autotools) {
+            if (!recipe.bootstrap.empty()) {
+                steps.emplace_back("bootstrap", inSource + recipe.bootstrap);
+            }
+            steps.emplace_back("configure", "cd " + Process::quote(buildDir) + " && " + compilers +
+                               Process::quote(sourceDir + "/configure") + " --prefix=" + Process::quote(recipe.prefix) + joinArgs(args));
+            steps.emplace_back("compile", "make -C " + Process::quote(buildDir) + " -j" + jobs);
+            steps.emplace_back("stage", "make -C " + Process::quote(buildDir) + " install DESTDIR=" + Process::quote(stageDir));
+        } else {
+            std::string make = inSource + compilers + "make PREFIX=" + Process::quote(recipe.prefix) + joinArgs(args);
+            steps.emplace_back("compile", make + " -j" + jobs);
+            steps.emplace_back("stage", make + " install DESTDIR=" + Process::quote(stageDir));
+        }
+    }
+
+    // 暂存目录打包进构件缓存后再安装，与缓存命中走同一条路径
+    std::string partial = report.artifact + ".tmp";
+    steps.emplace_back("package", "tar -czf " + Process::quote(partial) + " -C " + Process::quote(stageDir) + " . && mv " +
+                                  Process::quote(partial) + " " + Process::quote(report.artifact));
+    steps.emplace_back("install", install);
+
+    for (const auto& step : steps) {
+        if (!Process::succeeded(env + step.second, step.first + " " + recipe.name)) {
+            report.failedStep = step.first;
+            unlink(partial.c_str());
+            FileUtils::removeTree(work);
+            return finish(false);
+        }
+    }
+    FileUtils::removeTree(work);
+    return finish(true);
+}
+
+} // namespace LinuxStudio
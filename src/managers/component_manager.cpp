@@ -1,106 +1,891 @@
 #include "linuxstudio/managers.hpp"
 #include "linuxstudio/core.hpp"
 #include "linuxstudio/logger.hpp"  // 添加 Logger 的完整定义
+#include "linuxstudio/process.hpp"
+#include "linuxstudio/completion.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/registry_watcher.hpp"
+#include "linuxstudio/hash.hpp"
+#include <algorithm>
+#include <cctype>
 #include <cstdlib>
-#include <fstream>
+#include <string_view>
 #ifdef _WIN32
     #include <direct.h>
     #define mkdir(path, mode) _mkdir(path)
 #else
+    #include <fcntl.h>
     #include <sys/stat.h>
     #include <sys/types.h>
+    #include <unistd.h>
 #endif
 
 namespace LinuxStudio {
 
+namespace {
+
+// 注册表值格式：version<TAB>description<TAB>installed<TAB>dep1,dep2
+std::string escapeField(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\t':  out += "\\t"; break;
+            case '\n':  out += "\\n"; break;
+            default:    out += c;
+        }
+    }
+    return out;
+}
+
+std::vector<std::string> splitFields(const std::string& s) {
+    std::vector<std::string> fields(1);
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c == '\t') {
+            fields.emplace_back();
+        } else if (c == '\\' && i + 1 < s.size()) {
+            char next = s[++i];
+            fields.back() += (next == 't') ? '\t' : (next == 'n') ? '\n' : next;
+        } else {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+std::string serializeComponent(const Component& comp) {
+    std::string deps;
+    for (size_t i = 0; i < comp.dependencies.size(); ++i) {
+        if (i > 0) {
+            deps += ',';
+        }
+        deps += comp.dependencies[i];
+    }
+    return escapeField(comp.version) + "\t" + escapeField(comp.description) + "\t" +
+           (comp.installed ? "1" : "0") + "\t" + escapeField(deps);
+}
+
+Component parseComponent(const std::string& name, const std::string& value) {
+    Component comp(name, "");
+    std::vector<std::string> fields = splitFields(value);
+    fields.resize(4);
+    comp.version = fields[0];
+    comp.description = fields[1];
+    comp.installed = (fields[2] == "1");
+    size_t pos = 0;
+    while (pos < fields[3].size()) {
+        size_t end = fields[3].find(',', pos);
+        if (end == std::string::npos) {
+            end = fields[3].size();
+        }
+        if (end > pos) {
+            comp.dependencies.push_back(fields[3].substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    return comp;
+}
+
+/**
+ * @brief 组件目录（环境变量 XKL_COMPONENTS_DIR 可覆盖，测试用）
+ */
+std::string componentsRoot() {
+    const char* override = std::getenv("XKL_COMPONENTS_DIR");
+    return override && *override ? override : "/opt/linuxstudio/components";
+}
+
+// apt 下载缓存目录
+const char* const kArchivesDir = "/var/cache/apt/archives";
+
+// 让 apt 把机器可读的进度（pmstatus/dlstatus）写到 stdout，dpkg 不再分配伪终端
+const char* const kAptProgress = " -o APT::Status-Fd=1 -o Dpkg::Use-Pty=0";
+
+/**
+ * @brief apt 缓存中 .deb 文件名的前缀：<包名>_<版本>_（epoch 的冒号写作 %3a）
+ */
+std::string archivePrefix(const std::string& name, const std::string& version) {
+    std::string prefix = name + "_";
+    for (char c : version) {
+        if (c == ':') {
+            prefix += "%3a";
+        } else {
+            prefix += c;
+        }
+    }
+    return prefix + "_";
+}
+
+/**
+ * @brief apt 缓存目录中的文件名（已排序）
+ */
+std::vector<std::string> listArchives() {
+    std::vector<std::string> names;
+    int fd = open(kArchivesDir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        FileUtils::readEntries(fd, [&names](const char* name, unsigned char) {
+            names.emplace_back(name);
+        });
+        close(fd);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+/**
+ * @brief 在缓存中找锁定版本的 .deb：软件源路径给出了架构时按完整文件名查找，否则按前缀
+ * @return 完整路径，没有返回空串
+ */
+std::string locateArchive(const std::vector<std::string>& names, const SceneLock::Package& package) {
+    std::string prefix = archivePrefix(package.name, package.version);
+    size_t archStart = package.filename.rfind('_');
+    if (archStart != std::string::npos) {
+        std::string exact = prefix + package.filename.substr(archStart + 1);
+        return std::binary_search(names.begin(), names.end(), exact) ? kArchivesDir + ("/" + exact) : "";
+    }
+    for (auto it = std::lower_bound(names.begin(), names.end(), prefix);
+         it != names.end() && it->compare(0, prefix.size(), prefix) == 0; ++it) {
+        if (it->size() > 4 && it->compare(it->size() - 4, 4, ".deb") == 0) {
+            return kArchivesDir + ("/" + *it);
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief 解析 apt-cache show 的输出：包名=版本 -> (SHA256, Filename)，同一版本只取第一条
+ */
+std::map<std::string, std::pair<std::string, std::string>> parseIndexEntries(const std::string& output) {
+    std::map<std::string, std::pair<std::string, std::string>> entries;
+    std::string package, version, sha256, filename;
+    auto commit = [&]() {
+        if (!package.empty() && !version.empty() && !sha256.empty()) {
+            entries.emplace(package + "=" + version, std::make_pair(sha256, filename));
+        }
+        package.clear();
+        version.clear();
+        sha256.clear();
+        filename.clear();
+    };
+
+    std::vector<std::string> lines;
+    FileUtils::splitLines(output, lines);
+    for (const auto& line : lines) {
+        if (line.empty()) {
+            commit();
+        } else if (line.compare(0, 9, "Package: ") == 0) {
+            package = line.substr(9);
+        } else if (line.compare(0, 9, "Version: ") == 0) {
+            version = line.substr(9);
+        } else if (line.compare(0, 8, "SHA256: ") == 0) {
+            sha256 = line.substr(8);
+        } else if (line.compare(0, 10, "Filename: ") == 0) {
+            filename = line.substr(10);
+        }
+    }
+    commit();
+    return entries;
+}
+
+} // namespace
+
 ComponentManager::ComponentManager() 
-    : componentsPath_("/opt/linuxstudio/components") {
+    : componentsPath_(componentsRoot()),
+      registry_(componentsPath_ + "/registry.db"),
+      registryVersion_(0) {
     loadComponentRegistry();
+    
+    // 长驻监视进程在运行时由它同步；否则检查 dpkg 状态自上次运行以来是否变化
+    if (!RegistryWatcher::active()) {
+        syncSystemPackages();
+    }
 }
 
 ComponentManager::~ComponentManager() {
-    saveComponentRegistry();
+    // 变更在每次操作时已合并提交，这里不再整体回写，避免覆盖其他进程的更新
+}
+
+std::uint64_t ComponentManager::registryVersion() const {
+    return registryVersion_;
+}
+
+std::vector<std::string> ComponentManager::syncSystemPackages() {
+    std::vector<std::string> changed;
+    std::string markerPath = componentsPath_ + "/.dpkg-status";
+    std::string statusPath = RegistryWatcher::dpkgStatusPath();
+    std::string marker = FileUtils::changeMarker(statusPath);
+    std::string stored;
+    FileUtils::readFile(markerPath, stored);
+    if (marker.empty() || marker == stored) {
+        return changed;
+    }
+    
+    // 长驻进程的内存视图可能落后于其他进程的提交，先刷新再比较
+    if (registry_.version() != registryVersion_) {
+        loadComponentRegistry();
+    }
+    
+    std::string content;
+    if (components_.size() > 0 && !FileUtils::readFile(statusPath, content)) {
+        return changed;
+    }
+    
+    // 只关心注册表中的组件：状态文件里其余的包跳过，不分配内存
+    std::map<std::string, Component> tracked;
+    components_.forEach([&tracked](const std::string& name, const Component& comp) {
+        tracked[name] = comp;
+    });
+    
+    RegistryStore::Changes changes;
+    std::set<std::string> seen;
+    auto apply = [&](const std::string& name, bool installed, const std::string& version) {
+        auto it = tracked.find(name);
+        if (it == tracked.end()) {
+            return;
+        }
+        seen.insert(name);
+        Component comp = it->second;
+        if (comp.installed == installed && (!installed || comp.version == version)) {
+            return;
+        }
+        comp.installed = installed;
+        if (installed) {
+            comp.version = version;
+        }
+        changes[name] = serializeComponent(comp);
+        changed.push_back(name);
+    };
+    
+    std::string name, version;
+    bool installed = false;
+    size_t pos = 0;
+    while (pos <= content.size()) {
+        size_t end = content.find('\n', pos);
+        if (end == std::string::npos) {
+            end = content.size();
+        }
+        std::string_view line(content.data() + pos, end - pos);
+        if (line.empty()) {
+            if (!name.empty()) {
+                apply(name, installed, version);
+            }
+            name.clear();
+            version.clear();
+            installed = false;
+        } else if (line.compare(0, 9, "Package: ") == 0) {
+            name = std::string(line.substr(9));
+        } else if (line.compare(0, 9, "Version: ") == 0) {
+            version = std::string(line.substr(9));
+        } else if (line.compare(0, 8, "Status: ") == 0) {
+            installed = line.size() >= 10 && line.compare(line.size() - 10, 10, " installed") == 0;
+        }
+        pos = end + 1;
+    }
+    
+    // 状态文件中已不存在的组件（被 purge）视为未安装
+    for (const auto& entry : tracked) {
+        if (seen.count(entry.first) == 0) {
+            apply(entry.first, false, std::string());
+        }
+    }
+    
+    if (changes.empty() || commitChanges(changes)) {
+        FileUtils::writeFileAtomic(markerPath, marker);
+    }
+    if (!changes.empty()) {
+        updateCompletionIndex();
+    }
+    return changed;
 }
 
 std::vector<Component> ComponentManager::listInstalled() {
     std::vector<Component> result;
-    for (const auto& pair : components_) {
-        if (pair.second.installed) {
-            result.push_back(pair.second);
+    forEachInstalled([&result](const Component& comp) {
+        result.push_back(comp);
+    });
+    return result;
+}
+
+void ComponentManager::forEachInstalled(const std::function<void(const Component&)>& visitor) const {
+    components_.forEach([&visitor](const std::string&, const Component& comp) {
+        if (comp.installed) {
+            visitor(comp);
+        }
+    });
+}
+
+std::vector<ComponentView> ComponentManager::search(const std::string& keyword) {
+    return catalog().search(keyword);
+}
+
+const ComponentCatalog& ComponentManager::catalog() {
+    std::call_once(catalogLoaded_, [this]() {
+        if (!catalog_.load()) {
+            CoreEngine::getInstance().getLogger().warning("Package catalog unavailable (no dpkg status or apt lists)");
         }
+    });
+    return catalog_;
+}
+
+Resolution ComponentManager::resolve(const std::vector<std::string>& packages, bool refresh, bool fullClosure) {
+    DependencyResolver resolver(catalog(), registryVersion());
+    // 注册表中声明的依赖也参与解析
+    forEachInstalled([&resolver](const Component& comp) {
+        resolver.addDependencies(comp.name, comp.dependencies);
+    });
+    return resolver.resolve(packages, refresh, fullClosure);
+}
+
+bool ComponentManager::installPlan(const Resolution& plan) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    
+    if (!plan.conflicts.empty()) {
+        logger.error("Refusing to install: " + std::to_string(plan.conflicts.size()) + " conflict(s)");
+        return false;
     }
-    return result;
+    if (plan.pendingCount() > 0 && !Process::succeeded("which apt-get > /dev/null 2>&1")) {
+        logger.error("Dependency-ordered installation requires apt-get");
+        return false;
+    }
+    
+    std::vector<std::string> roots;
+    for (const auto& root : plan.roots) {
+        if (plan.dependencies.count(root) == 0) {
+            continue;  // 目录中没有的根（已报告为缺失）
+        }
+        if (!acquire(root)) {
+            logger.warning("Component '" + root + "' is busy in another operation");
+            for (const auto& held : roots) {
+                release(held);
+            }
+            return false;
+        }
+        roots.push_back(root);
+    }
+    std::set<std::string> rootSet(roots.begin(), roots.end());
+    
+    bool ok = plan.pendingCount() == 0 || Process::succeeded("apt-get update -qq", "apt update");
+    for (size_t i = 0; ok && i < plan.levels.size(); ++i) {
+        const auto& level = plan.levels[i];
+        logger.info("Installing level " + std::to_string(i + 1) + "/" + std::to_string(plan.levels.size()) +
+                    " (" + std::to_string(level.size()) + " packages)");
+        
+        std::string names;
+        std::string autoNames;
+        for (const auto& name : level) {
+            names += " " + name;
+            if (rootSet.count(name) == 0) {
+                autoNames += " " + name;
+            }
+        }
+        // 同层互不依赖，交给 apt 一次处理（并行下载）；依赖包标记为自动安装，卸载根后可被 autoremove
+        ok = Process::succeeded(std::string("DEBIAN_FRONTEND=noninteractive apt-get install -y --no-install-recommends") +
+                                kAptProgress + names,
+                                "apt level " + std::to_string(i + 1));
+        if (ok && !autoNames.empty()) {
+            Process::succeeded("apt-mark auto" + autoNames + " > /dev/null");
+        }
+    }
+    
+    if (ok && !roots.empty()) {
+        RegistryStore::Changes changes;
+        for (const auto& root : roots) {
+            Component comp(root, "");
+            comp.installed = true;
+            comp.dependencies = plan.dependencies.at(root);
+            changes[root] = serializeComponent(comp);
+        }
+        commitChanges(changes);
+        updateCompletionIndex();
+    }
+    for (const auto& root : roots) {
+        release(root);
+    }
+    
+    if (!ok) {
+        logger.error("Dependency-ordered installation failed");
+    }
+    return ok;
 }
 
-std::vector<Component> ComponentManager::search(const std::string& keyword) {
-    std::vector<Component> result;
-    for (const auto& pair : components_) {
-        if (pair.first.find(keyword) != std::string::npos ||
-            pair.second.description.find(keyword) != std::string::npos) {
-            result.push_back(pair.second);
+bool ComponentManager::removeUnused(const std::vector<std::string>& packages, std::vector<std::string>& removed) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    removed.clear();
+    if (packages.empty()) {
+        return true;
+    }
+    if (!Process::succeeded("which apt-get > /dev/null 2>&1")) {
+        logger.error("Removing scene packages requires apt-get");
+        return false;
+    }
+    
+    // 只处理仍安装着的包（手动卸载过的包 apt-mark 会报错）
+    std::string names;
+    for (const auto& name : packages) {
+        names += " " + name;
+    }
+    std::string status;
+    Process::capture("dpkg-query -W -f='${Package}\\t${db:Status-Abbrev}\\n'" + names + " 2>/dev/null", status);
+    std::vector<std::string> lines;
+    FileUtils::splitLines(status, lines);
+    names.clear();
+    for (const auto& line : lines) {
+        std::vector<std::string> fields = FileUtils::splitFields(line);
+        if (fields.size() >= 2 && fields[1].compare(0, 2, "ii") == 0) {
+            names += " " + fields[0];
         }
     }
-    return result;
+    if (names.empty()) {
+        return true;
+    }
+    if (!Process::succeeded("apt-mark auto" + names + " > /dev/null 2>&1")) {
+        return false;
+    }
+    
+    // 模拟 autoremove，取其中属于候选的包：其余可自动卸载的包与本次切换无关
+    std::string simulated;
+    if (!Process::capture("apt-get -s autoremove 2>/dev/null", simulated)) {
+        return false;
+    }
+    std::set<std::string> candidates(packages.begin(), packages.end());
+    FileUtils::splitLines(simulated, lines);
+    std::string selected;
+    for (const auto& line : lines) {
+        std::vector<std::string> fields = FileUtils::splitFields(line);
+        if (fields.size() >= 2 && fields[0] == "Remv" && candidates.count(fields[1]) > 0) {
+            removed.push_back(fields[1]);
+            selected += " " + fields[1];
+        }
+    }
+    if (removed.empty()) {
+        return true;
+    }
+    
+    if (!Process::succeeded(std::string("DEBIAN_FRONTEND=noninteractive apt-get remove -y") + kAptProgress + selected,
+                            "remove " + std::to_string(removed.size()) + " packages")) {
+        removed.clear();
+        return false;
+    }
+    
+    RegistryStore::Changes changes;
+    for (const auto& name : removed) {
+        if (components_.contains(name)) {
+            changes[name] = std::nullopt;
+        }
+    }
+    if (!changes.empty()) {
+        commitChanges(changes);
+        updateCompletionIndex();
+    }
+    return true;
+}
+
+bool ComponentManager::lockPackages(const std::vector<std::string>& packages, SceneLock& lock, Resolution& plan) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    
+    // 锁文件要在任何机器上都能复现，已安装的包同样锁定
+    plan = resolve(packages, false, true);
+    if (!plan.conflicts.empty()) {
+        logger.error("Refusing to lock: " + std::to_string(plan.conflicts.size()) + " conflict(s)");
+        return false;
+    }
+    
+    const ComponentCatalog& packageCatalog = catalog();
+    lock.packages.clear();
+    std::string query;
+    for (size_t level = 0; level < plan.levels.size(); ++level) {
+        for (const auto& name : plan.levels[level]) {
+            SceneLock::Package package;
+            package.name = name;
+            package.version = std::string(packageCatalog.view(packageCatalog.find(name)).version());
+            package.level = static_cast<unsigned>(level);
+            package.root = plan.dependencies.count(name) > 0;
+            query += " " + name + "=" + package.version;
+            lock.packages.push_back(std::move(package));
+        }
+    }
+    
+    // 一次 apt-cache 调用取回全部版本的索引条目；软件源中已没有的版本（本地构建、已被替换）只锁版本
+    std::string output;
+    if (!query.empty()) {
+        Process::capture("apt-cache show" + query + " 2>/dev/null", output);
+    }
+    auto entries = parseIndexEntries(output);
+    size_t unverified = 0;
+    for (auto& package : lock.packages) {
+        auto entry = entries.find(package.name + "=" + package.version);
+        if (entry == entries.end()) {
+            ++unverified;
+            continue;
+        }
+        package.sha256 = entry->second.first;
+        package.filename = entry->second.second;
+    }
+    if (unverified > 0) {
+        logger.warning(std::to_string(unverified) + " package(s) not found in the repository index, locked by version only");
+    }
+    return true;
+}
+
+bool ComponentManager::stageArchives(const std::vector<const SceneLock::Package*>& packages,
+                                     std::vector<std::string>& paths, SceneLock::Report& report, bool download) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    paths.assign(packages.size(), std::string());
+    
+    // 缓存中的文件按锁定版本定位，并行校验摘要；没有摘要的只能按文件名认定
+    auto verifyArchives = [&](const std::vector<size_t>& indices, std::vector<size_t>& absent,
+                              std::vector<size_t>* mismatched) {
+        std::vector<std::string> names = listArchives();
+        std::vector<std::uint8_t> state(indices.size(), 0);  // 0 就绪，1 缺失，2 摘要不符
+        FileUtils::parallelFor(indices.size(), [&](size_t i) {
+            const SceneLock::Package& package = *packages[indices[i]];
+            std::string& path = paths[indices[i]];
+            path = locateArchive(names, package);
+            std::string digest;
+            if (path.empty()) {
+                state[i] = 1;
+            } else if (!package.sha256.empty() && (!Sha256::hashFile(path, digest) || digest != package.sha256)) {
+                state[i] = 2;
+            }
+        });
+        for (size_t i = 0; i < indices.size(); ++i) {
+            if (state[i] == 1 || (state[i] == 2 && mismatched == nullptr)) {
+                absent.push_back(indices[i]);
+                paths[indices[i]].clear();
+            } else if (state[i] == 2) {
+                mismatched->push_back(indices[i]);
+            }
+        }
+    };
+    
+    std::vector<size_t> all(packages.size());
+    for (size_t i = 0; i < all.size(); ++i) {
+        all[i] = i;
+    }
+    std::vector<size_t> absent;
+    verifyArchives(all, absent, nullptr);
+    report.cached = packages.size() - absent.size();
+    if (absent.empty() || !download) {
+        return true;
+    }
+    if (!Process::succeeded("which apt-get > /dev/null 2>&1")) {
+        logger.error("Locked installation requires apt-get");
+        return false;
+    }
+    
+    // 只下载锁定的确切版本（不做依赖解析）；本地软件源索引过旧时更新一次后重试
+    std::string command = std::string("cd ") + kArchivesDir + " && apt-get download -q";
+    for (size_t i : absent) {
+        command += " " + packages[i]->name + "=" + packages[i]->version;
+    }
+    logger.info("Downloading " + std::to_string(absent.size()) + " locked packages...");
+    if (!Process::succeeded(command, "apt download") &&
+        !(Process::succeeded("apt-get update -qq", "apt update") && Process::succeeded(command, "apt download"))) {
+        logger.error("Failed to download locked packages");
+        return false;
+    }
+    
+    std::vector<size_t> stillAbsent;
+    std::vector<size_t> mismatched;
+    verifyArchives(absent, stillAbsent, &mismatched);
+    for (size_t i : mismatched) {
+        report.mismatched.push_back(packages[i]->name + "=" + packages[i]->version);
+    }
+    if (!stillAbsent.empty() || !mismatched.empty()) {
+        logger.error("Downloaded packages do not match the lock (" +
+                     std::to_string(stillAbsent.size() + mismatched.size()) + " package(s))");
+        return false;
+    }
+    report.downloaded = absent.size();
+    return true;
+}
+
+bool ComponentManager::fetchLocked(const SceneLock& lock, std::vector<std::string>& paths, SceneLock::Report& report) {
+    report = SceneLock::Report();
+    std::vector<const SceneLock::Package*> packages;
+    for (const auto& package : lock.packages) {
+        packages.push_back(&package);
+    }
+    return stageArchives(packages, paths, report, true);
+}
+
+bool ComponentManager::installLocked(const SceneLock& lock, SceneLock::Report& report, const ArchiveSource& source) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    report = SceneLock::Report();
+    
+    // 已安装的包：版本一致即满足；不一致只报告，不降级系统软件包
+    const ComponentCatalog& packageCatalog = catalog();
+    std::vector<const SceneLock::Package*> pending;
+    for (const auto& package : lock.packages) {
+        std::uint32_t id = packageCatalog.find(package.name);
+        if (id != ComponentCatalog::kInvalidId && packageCatalog.view(id).installed()) {
+            std::string_view installed = packageCatalog.view(id).version();
+            if (installed == package.version) {
+                ++report.satisfied;
+            } else {
+                report.drifted.push_back(package.name + " " + std::string(installed) + " -> " + package.version);
+            }
+            continue;
+        }
+        pending.push_back(&package);
+    }
+    if (!pending.empty() && !Process::succeeded("which apt-get > /dev/null 2>&1")) {
+        logger.error("Locked installation requires apt-get");
+        return false;
+    }
+    
+    std::vector<std::string> paths;
+    if (!stageArchives(pending, paths, report, !source)) {
+        return false;
+    }
+    
+    std::vector<std::string> roots;
+    for (const auto& package : lock.packages) {
+        if (!package.root) {
+            continue;
+        }
+        if (!acquire(package.name)) {
+            logger.warning("Component '" + package.name + "' is busy in another operation");
+            for (const auto& held : roots) {
+                release(held);
+            }
+            return false;
+        }
+        roots.push_back(package.name);
+    }
+    
+    // 从 source 取出的文件放在缓存目录下的暂存目录，每层装完就删，磁盘上最多只有一层的 .deb
+    std::string staging = std::string(kArchivesDir) + "/xkl-staging." + std::to_string(getpid());
+    if (source) {
+        mkdir(staging.c_str(), 0755);
+    }
+    
+    // 锁文件中的包已按层排列：同层一次 apt 事务，直接安装校验过的文件
+    bool ok = true;
+    for (size_t begin = 0; ok && begin < pending.size();) {
+        size_t end = begin;
+        while (end < pending.size() && pending[end]->level == pending[begin]->level) {
+            ++end;
+        }
+        
+        std::vector<size_t> staged;
+        for (size_t i = begin; i < end; ++i) {
+            if (paths[i].empty()) {
+                paths[i] = staging + "/" + archivePrefix(pending[i]->name, pending[i]->version) + ".deb";
+                staged.push_back(i);
+            }
+        }
+        std::vector<std::uint8_t> failed(staged.size(), 0);
+        FileUtils::parallelFor(staged.size(), [&](size_t i) {
+            failed[i] = !source(*pending[staged[i]], paths[staged[i]]);
+        });
+        for (size_t i = 0; i < staged.size(); ++i) {
+            if (failed[i]) {
+                report.mismatched.push_back(pending[staged[i]]->name + "=" + pending[staged[i]]->version);
+                ok = false;
+            } else {
+                ++report.bundled;
+            }
+        }
+        
+        std::string files;
+        std::string autoNames;
+        for (size_t i = begin; i < end; ++i) {
+            files += " " + paths[i];
+            if (!pending[i]->root) {
+                autoNames += " " + pending[i]->name;
+            }
+        }
+        if (ok) {
+            logger.info("Installing level " + std::to_string(pending[begin]->level + 1) + " (" +
+                        std::to_string(end - begin) + " packages)");
+            ok = Process::succeeded(std::string("DEBIAN_FRONTEND=noninteractive apt-get install -y --no-install-recommends") +
+                                    kAptProgress + files,
+                                    "apt level " + std::to_string(pending[begin]->level + 1));
+        }
+        if (ok && !autoNames.empty()) {
+            Process::succeeded("apt-mark auto" + autoNames + " > /dev/null");
+        }
+        for (size_t i : staged) {
+            unlink(paths[i].c_str());
+        }
+        begin = end;
+    }
+    if (source) {
+        rmdir(staging.c_str());
+    }
+    
+    if (ok) {
+        for (const auto* package : pending) {
+            report.installed.push_back(package->name);
+        }
+    }
+    if (ok && !roots.empty()) {
+        RegistryStore::Changes changes;
+        for (const auto& package : lock.packages) {
+            if (package.root) {
+                Component comp(package.name, "");
+                comp.version = package.version;
+                comp.installed = true;
+                changes[package.name] = serializeComponent(comp);
+            }
+        }
+        commitChanges(changes);
+        updateCompletionIndex();
+    }
+    for (const auto& root : roots) {
+        release(root);
+    }
+    
+    if (!ok) {
+        logger.error("Locked installation failed");
+    }
+    return ok;
+}
+
+bool ComponentManager::acquire(const std::string& name) {
+    std::lock_guard<std::mutex> lock(busyMutex_);
+    return busy_.insert(name).second;
+}
+
+void ComponentManager::release(const std::string& name) {
+    std::lock_guard<std::mutex> lock(busyMutex_);
+    busy_.erase(name);
+}
+
+bool ComponentManager::validName(const std::string& name) {
+    if (name.empty() || name.size() > 128 || !std::isalnum(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '+' || c == '.' || c == '-' || c == '_';
+    });
 }
 
 bool ComponentManager::install(const std::string& name) {
     auto& logger = CoreEngine::getInstance().getLogger();
     
+    // 名字会拼进交给 /bin/sh 的命令行，先校验再引用，两道防线
+    if (!validName(name)) {
+        logger.error("Invalid component name: " + name);
+        return false;
+    }
     logger.info("Installing component: " + name);
     
+    // 同一组件同一时间只允许一个线程操作
+    if (!acquire(name)) {
+        logger.warning("Component '" + name + "' is busy in another operation");
+        return false;
+    }
+    
     // 使用系统包管理器安装
     std::string cmd;
     
     // 检测包管理器
-    if (system("which apt-get > /dev/null 2>&1") == 0) {
-        cmd = "apt-get update -qq && apt-get install -y " + name;
-    } else if (system("which yum > /dev/null 2>&1") == 0) {
-        cmd = "yum install -y " + name;
-    } else if (system("which dnf > /dev/null 2>&1") == 0) {
-        cmd = "dnf install -y " + name;
-    } else if (system("which pacman > /dev/null 2>&1") == 0) {
-        cmd = "pacman -S --noconfirm " + name;
+    if (Process::succeeded("which apt-get > /dev/null 2>&1")) {
+        cmd = std::string("apt-get update -qq && apt-get install -y") + kAptProgress + " " + Process::quote(name);
+    } else if (Process::succeeded("which yum > /dev/null 2>&1")) {
+        cmd = "yum install -y " + Process::quote(name);
+    } else if (Process::succeeded("which dnf > /dev/null 2>&1")) {
+        cmd = "dnf install -y " + Process::quote(name);
+    } else if (Process::succeeded("which pacman > /dev/null 2>&1")) {
+        cmd = "pacman -S --noconfirm " + Process::quote(name);
     } else {
         logger.error("Unsupported package manager");
+        release(name);
         return false;
     }
     
-    int ret = system(cmd.c_str());
+    int ret = Process::run(cmd, "install " + name);
+    release(name);
     
     if (ret == 0) {
         Component comp(name, "");
         comp.installed = true;
-        components_[name] = comp;
+        commitChanges({{name, serializeComponent(comp)}});
+        updateCompletionIndex();
         logger.success("Component '" + name + "' installed successfully");
         return true;
     }
     
+    // 发行版没有该软件包时改用源码配方
+    BuildRecipe recipe;
+    if (BuildRecipe::find(name, recipe)) {
+        logger.warning("Package '" + name + "' unavailable, building from source");
+        SourceBuilder::Report report;
+        return build(name, false, report);
+    }
+    
     logger.error("Failed to install component: " + name);
     return false;
 }
 
+bool ComponentManager::build(const std::string& name, bool rebuild, SourceBuilder::Report& report) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    
+    BuildRecipe recipe;
+    if (!BuildRecipe::find(name, recipe)) {
+        logger.error("No build recipe for component: " + name);
+        return false;
+    }
+    if (!acquire(name)) {
+        logger.warning("Component '" + name + "' is busy in another operation");
+        return false;
+    }
+    
+    logger.info("Building component from source: " + name + " " + recipe.version);
+    bool ok = builder_.build(recipe, rebuild, report);
+    release(name);
+    
+    if (!ok) {
+        logger.error("Failed to build component " + name + " (" + report.failedStep + ")");
+        return false;
+    }
+    logger.info(std::string(report.cacheHit ? "Build cache hit: " : "Built and cached: ") + report.artifact);
+    
+    Component comp(name, "Built from source");
+    comp.version = recipe.version;
+    comp.installed = true;
+    commitChanges({{name, serializeComponent(comp)}});
+    updateCompletionIndex();
+    logger.success("Component '" + name + "' installed successfully");
+    return true;
+}
+
 bool ComponentManager::uninstall(const std::string& name) {
     auto& logger = CoreEngine::getInstance().getLogger();
+    if (!validName(name)) {
+        logger.error("Invalid component name: " + name);
+        return false;
+    }
     logger.warning("Uninstalling component: " + name);
     
+    if (!acquire(name)) {
+        logger.warning("Component '" + name + "' is busy in another operation");
+        return false;
+    }
+    
     std::string cmd;
-    if (system("which apt-get > /dev/null 2>&1") == 0) {
-        cmd = "apt-get remove -y " + name;
-    } else if (system("which yum > /dev/null 2>&1") == 0) {
-        cmd = "yum remove -y " + name;
-    } else if (system("which dnf > /dev/null 2>&1") == 0) {
-        cmd = "dnf remove -y " + name;
-    } else if (system("which pacman > /dev/null 2>&1") == 0) {
-        cmd = "pacman -R --noconfirm " + name;
+    if (Process::succeeded("which apt-get > /dev/null 2>&1")) {
+        cmd = std::string("apt-get remove -y") + kAptProgress + " " + Process::quote(name);
+    } else if (Process::succeeded("which yum > /dev/null 2>&1")) {
+        cmd = "yum remove -y " + Process::quote(name);
+    } else if (Process::succeeded("which dnf > /dev/null 2>&1")) {
+        cmd = "dnf remove -y " + Process::quote(name);
+    } else if (Process::succeeded("which pacman > /dev/null 2>&1")) {
+        cmd = "pacman -R --noconfirm " + Process::quote(name);
     } else {
         logger.error("Unsupported package manager");
+        release(name);
         return false;
     }
     
-    int ret = system(cmd.c_str());
+    int ret = Process::run(cmd, "remove " + name);
+    release(name);
     
     if (ret == 0) {
-        components_.erase(name);
+        commitChanges({{name, std::nullopt}});
+        updateCompletionIndex();
         logger.success("Component '" + name + "' uninstalled successfully");
         return true;
     }
@@ -109,38 +894,72 @@ bool ComponentManager::uninstall(const std::string& name) {
 }
 
 bool ComponentManager::isInstalled(const std::string& name) {
-    return components_.find(name) != components_.end() && 
-           components_[name].installed;
+    bool installed = false;
+    components_.read(name, [&installed](const Component& comp) {
+        installed = comp.installed;
+    });
+    return installed;
 }
 
 Component ComponentManager::getInfo(const std::string& name) {
-    if (components_.find(name) != components_.end()) {
-        return components_[name];
-    }
-    return Component();
+    Component comp;
+    components_.find(name, comp);
+    return comp;
+}
+
+void ComponentManager::updateCompletionIndex() const {
+    std::vector<std::string> installed;
+    forEachInstalled([&installed](const Component& comp) {
+        installed.push_back(comp.name);
+    });
+    CompletionIndex::updateSection(CompletionIndex::kComponentsInstalled, installed);
 }
 
 void ComponentManager::loadComponentRegistry() {
-    // 从文件加载组件注册表
+    RegistryStore::Entries entries;
+    std::uint64_t version = 0;
+    if (registry_.read(entries, &version)) {
+        std::map<std::string, Component> loaded;
+        for (const auto& entry : entries) {
+            loaded[entry.first] = parseComponent(entry.first, entry.second);
+        }
+        components_.replaceAll(loaded);
+        registryVersion_ = version;
+        return;
+    }
+    
+    // 共享注册表尚不存在：从旧版 JSON 迁移
+    importLegacyRegistry();
+    if (components_.size() > 0) {
+        RegistryStore::Changes changes;
+        components_.forEach([&changes](const std::string& name, const Component& comp) {
+            changes[name] = serializeComponent(comp);
+        });
+        commitChanges(changes);
+    }
+}
+
+void ComponentManager::importLegacyRegistry() {
+    // 旧版本的 registry.json，仅在首次迁移时读取
     std::string registryPath = componentsPath_ + "/registry.json";
-    std::ifstream registryFile(registryPath);
+    std::vector<std::string> lines;
     
-    if (!registryFile.is_open()) {
+    if (!FileUtils::readLines(registryPath, lines)) {
         // 如果文件不存在，初始化为空注册表
         return;
     }
     
     // 简单的 JSON 解析（实际项目中应使用 JSON 库如 nlohmann/json）
-    std::string line;
+    std::map<std::string, Component> imported;
     std::string currentName;
     Component currentComponent;
     bool inComponent = false;
     
-    while (std::getline(registryFile, line)) {
+    for (const auto& raw : lines) {
         // 去除空白字符
-        size_t start = line.find_first_not_of(" \t\n\r");
+        size_t start = raw.find_first_not_of(" \t\n\r");
         if (start == std::string::npos) continue;
-        line = line.substr(start);
+        std::string line = raw.substr(start);
         
         // 解析组件名称
         if (line.find("\"name\":") != std::string::npos) {
@@ -168,18 +987,17 @@ void ComponentManager::loadComponentRegistry() {
         // 组件结束
         else if (line.find("}") != std::string::npos && inComponent) {
             if (!currentComponent.name.empty()) {
-                components_[currentComponent.name] = currentComponent;
+                imported[currentComponent.name] = currentComponent;
             }
             currentComponent = Component();
             inComponent = false;
         }
     }
     
-    registryFile.close();
+    components_.replaceAll(imported);
 }
 
-void ComponentManager::saveComponentRegistry() {
-    // 保存组件注册表到文件
+bool ComponentManager::commitChanges(const RegistryStore::Changes& changes) {
     // 确保目录存在
 #ifdef _WIN32
     _mkdir(componentsPath_.c_str());
@@ -187,42 +1005,33 @@ void ComponentManager::saveComponentRegistry() {
     mkdir(componentsPath_.c_str(), 0755);
 #endif
     
-    std::string registryPath = componentsPath_ + "/registry.json";
-    std::ofstream registryFile(registryPath);
-    
-    if (!registryFile.is_open()) {
-        return;
-    }
-    
-    // 写入 JSON 格式
-    registryFile << "{\n";
-    registryFile << "  \"components\": [\n";
-    
-    size_t count = 0;
-    for (const auto& pair : components_) {
-        const Component& comp = pair.second;
-        
-        registryFile << "    {\n";
-        registryFile << "      \"name\": \"" << comp.name << "\",\n";
-        registryFile << "      \"version\": \"" << comp.version << "\",\n";
-        registryFile << "      \"description\": \"" << comp.description << "\",\n";
-        registryFile << "      \"installed\": " << (comp.installed ? "true" : "false") << "\n";
-        registryFile << "    }";
-        
-        if (++count < components_.size()) {
-            registryFile << ",";
+    // 在写锁内与其他进程的更新合并，随后以合并结果刷新内存视图；
+    // 本进程内的提交也串行化，避免较旧的合并结果覆盖较新的视图
+    std::lock_guard<std::mutex> lock(commitMutex_);
+    RegistryStore::Entries merged;
+    std::uint64_t version = 0;
+    if (!registry_.commit(changes, &merged, &version)) {
+        for (const auto& change : changes) {
+            if (change.second) {
+                components_.insertOrAssign(change.first, parseComponent(change.first, *change.second));
+            } else {
+                components_.erase(change.first);
+            }
         }
-        registryFile << "\n";
+        return false;
     }
     
-    registryFile << "  ]\n";
-    registryFile << "}\n";
-    
-    registryFile.close();
+    std::map<std::string, Component> refreshed;
+    for (const auto& entry : merged) {
+        refreshed[entry.first] = parseComponent(entry.first, entry.second);
+    }
+    components_.replaceAll(refreshed);
+    registryVersion_ = version;
+    return true;
 }
 
 bool ComponentManager::executeSystemCommand(const std::string& cmd) {
-    return system(cmd.c_str()) == 0;
+    return Process::succeeded(cmd);
 }
 
 } // namespace LinuxStudio
@@ -0,0 +1,626 @@
+#include "linuxstudio/managers.hpp"
+#include "linuxstudio/core.hpp"
+#include "linuxstudio/logger.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+const long kDefaultTtlSeconds = 24 * 3600;
+const int kConnectTimeoutMs = 2000;
+const int kTransferTimeoutMs = 3000;
+const size_t kProbeBytes = 256 * 1024;  // 短传输大小：足以估计吞吐，又不拖慢测速
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+struct ParsedUrl {
+    bool https;
+    std::string host;
+    std::string port;
+    std::string path;
+};
+
+bool parseUrl(const std::string& url, ParsedUrl& parsed) {
+    size_t schemeEnd = url.find("://");
+    if (schemeEnd == std::string::npos) {
+        return false;
+    }
+    std::string scheme = url.substr(0, schemeEnd);
+    if (scheme != "http" && scheme != "https") {
+        return false;
+    }
+    parsed.https = (scheme == "https");
+
+    size_t hostStart = schemeEnd + 3;
+    size_t pathStart = url.find('/', hostStart);
+    std::string authority = url.substr(hostStart, pathStart == std::string::npos ?
+                                                  std::string::npos : pathStart - hostStart);
+    parsed.path = (pathStart == std::string::npos) ? "/" : url.substr(pathStart);
+
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']') == std::string::npos) {
+        parsed.host = authority.substr(0, colon);
+        parsed.port = authority.substr(colon + 1);
+    } else {
+        parsed.host = authority;
+        parsed.port = parsed.https ? "443" : "80";
+    }
+    return !parsed.host.empty();
+}
+
+/**
+ * @brief 非阻塞建连，超时返回 -1
+ */
+int connectWithTimeout(const ParsedUrl& url, int timeoutMs) {
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(url.host.c_str(), url.port.c_str(), &hints, &result) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = result; ai != nullptr && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0 && errno != EINPROGRESS) {
+            close(fd);
+            fd = -1;
+            continue;
+        }
+
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (poll(&pfd, 1, timeoutMs) != 1 ||
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+/**
+ * @brief 发送一个 Range 请求并读取至多 kProbeBytes 字节
+ * @return HTTP 状态码，失败返回 0
+ */
+int transfer(int fd, const ParsedUrl& url, size_t& received, double& elapsed) {
+    std::string request =
+        "GET " + url.path + " HTTP/1.1\r\n"
+        "Host: " + url.host + "\r\n"
+        "User-Agent: xkl-mirror-probe\r\n"
+        "Range: bytes=0-" + std::to_string(kProbeBytes - 1) + "\r\n"
+        "Connection: close\r\n\r\n";
+
+    Clock::time_point start = Clock::now();
+    size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EAGAIN) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            if (poll(&pfd, 1, kTransferTimeoutMs) != 1) {
+                return 0;
+            }
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        sent += static_cast<size_t>(n);
+    }
+
+    std::string head;
+    bool inBody = false;
+    received = 0;
+    char buffer[16384];
+    for (;;) {
+        int remaining = kTransferTimeoutMs - static_cast<int>(elapsedMs(start));
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (remaining <= 0 || poll(&pfd, 1, remaining) != 1) {
+            break;
+        }
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        if (inBody) {
+            received += static_cast<size_t>(n);
+        } else {
+            head.append(buffer, static_cast<size_t>(n));
+            size_t headerEnd = head.find("\r\n\r\n");
+            if (headerEnd != std::string::npos) {
+                inBody = true;
+                received = head.size() - headerEnd - 4;
+            } else if (head.size() > 16384) {
+                return 0;
+            }
+        }
+        if (received >= kProbeBytes) {
+            break;
+        }
+    }
+    elapsed = elapsedMs(start);
+
+    // 状态行：HTTP/1.1 206 Partial Content
+    if (head.compare(0, 5, "HTTP/") != 0) {
+        return 0;
+    }
+    size_t space = head.find(' ');
+    return space == std::string::npos ? 0 : std::atoi(head.c_str() + space + 1);
+}
+
+/**
+ * @brief 测速路径：大小稳定、所有镜像都提供的文件
+ */
+std::string probeUrl(MirrorKind kind, const std::string& base) {
+    std::string url = base;
+    if (url.empty() || url.back() != '/') {
+        url += '/';
+    }
+    switch (kind) {
+        case MirrorKind::APT: return url + "ls-lR.gz";
+        case MirrorKind::ROS: return url + "dists/";
+        case MirrorKind::PIP: return url;
+    }
+    return url;
+}
+
+MirrorProbe probeMirror(MirrorKind kind, const std::string& base) {
+    MirrorProbe probe;
+    probe.url = base;
+
+    ParsedUrl url;
+    if (!parseUrl(probeUrl(kind, base), url)) {
+        return probe;
+    }
+
+    Clock::time_point start = Clock::now();
+    int fd = connectWithTimeout(url, kConnectTimeoutMs);
+    if (fd < 0) {
+        return probe;
+    }
+    probe.connectMs = elapsedMs(start);
+    probe.reachable = true;
+
+    // https 需要 TLS 握手，这里只比较建连耗时
+    if (!url.https) {
+        size_t received = 0;
+        double elapsed = 0;
+        int status = transfer(fd, url, received, elapsed);
+        if (status >= 500 || status == 0) {
+            probe.reachable = false;
+        } else if (status >= 200 && status < 300 && received > 0 && elapsed > 0) {
+            probe.throughputKBps = static_cast<double>(received) / 1024.0 / (elapsed / 1000.0);
+        }
+    }
+    close(fd);
+    return probe;
+}
+
+/**
+ * @brief 排序：有吞吐数据的按下载 1 MiB 的估计耗时，其余按建连耗时，不可达的最后
+ */
+bool fasterThan(const MirrorProbe& a, const MirrorProbe& b) {
+    if (a.reachable != b.reachable) {
+        return a.reachable;
+    }
+    bool aMeasured = a.throughputKBps > 0;
+    bool bMeasured = b.throughputKBps > 0;
+    if (aMeasured != bMeasured) {
+        return aMeasured;
+    }
+    if (aMeasured) {
+        return a.connectMs + 1024.0 * 1000.0 / a.throughputKBps <
+               b.connectMs + 1024.0 * 1000.0 / b.throughputKBps;
+    }
+    return a.connectMs < b.connectMs;
+}
+
+std::string normalizeUrl(std::string url) {
+    size_t schemeEnd = url.find("://");
+    if (schemeEnd != std::string::npos) {
+        url = url.substr(schemeEnd + 3);
+    }
+    while (!url.empty() && url.back() == '/') {
+        url.pop_back();
+    }
+    return url;
+}
+
+std::string osReleaseId() {
+    std::vector<std::string> lines;
+    FileUtils::readLines("/etc/os-release", lines);
+    for (const auto& line : lines) {
+        if (line.compare(0, 3, "ID=") == 0) {
+            std::string id = line.substr(3);
+            id.erase(std::remove(id.begin(), id.end(), '"'), id.end());
+            return id;
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief 保留首次改写前的备份后，经临时文件原子替换
+ */
+bool replaceFile(const std::string& path, const std::string& original, const std::string& content) {
+    std::string backupPath = path + ".xkl-bak";
+    struct stat st;
+    if (stat(backupPath.c_str(), &st) != 0 && !FileUtils::writeFileAtomic(backupPath, original)) {
+        return false;
+    }
+    return FileUtils::writeFileAtomic(path, content);
+}
+
+} // namespace
+
+MirrorManager::MirrorManager()
+    : configPath_("/etc/linuxstudio/mirrors.conf"),
+      cachePath_("/opt/linuxstudio/data/mirrors.cache"),
+      ttlSeconds_(kDefaultTtlSeconds) {
+    const char* override = std::getenv("XKL_MIRRORS_CONF");
+    if (override && *override) {
+        configPath_ = override;
+    }
+    const char* cacheOverride = std::getenv("XKL_MIRRORS_CACHE");
+    if (cacheOverride && *cacheOverride) {
+        cachePath_ = cacheOverride;
+    }
+    loadConfig();
+}
+
+bool MirrorManager::parseKind(const std::string& name, MirrorKind& kind) {
+    if (name == "apt") {
+        kind = MirrorKind::APT;
+    } else if (name == "pip") {
+        kind = MirrorKind::PIP;
+    } else if (name == "ros") {
+        kind = MirrorKind::ROS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* MirrorManager::kindName(MirrorKind kind) {
+    switch (kind) {
+        case MirrorKind::APT: return "apt";
+        case MirrorKind::PIP: return "pip";
+        case MirrorKind::ROS: return "ros";
+    }
+    return "";
+}
+
+void MirrorManager::loadConfig() {
+    std::vector<std::string> lines;
+    FileUtils::readLines(configPath_, lines);
+    for (const auto& line : lines) {
+        std::vector<std::string> fields = FileUtils::splitFields(line);
+        if (fields.size() < 2 || fields[0][0] == '#') {
+            continue;
+        }
+        const std::string& key = fields[0];
+        const std::string& value = fields[1];
+        MirrorKind kind;
+        if (key == "ttl") {
+            ttlSeconds_ = std::atol(value.c_str());
+        } else if (parseKind(key, kind)) {
+            configured_[key].push_back(value);
+        }
+    }
+}
+
+std::vector<std::string> MirrorManager::candidates(MirrorKind kind) const {
+    std::vector<std::string> urls;
+    switch (kind) {
+        case MirrorKind::APT: {
+            struct utsname unameData;
+            std::string machine = (uname(&unameData) == 0) ? unameData.machine : "";
+            bool ports = (machine != "x86_64" && machine != "i686" && machine != "i386");
+            if (osReleaseId() == "debian") {
+                urls = {"http://deb.debian.org/debian/",
+                        "http://mirrors.tuna.tsinghua.edu.cn/debian/",
+                        "http://mirrors.ustc.edu.cn/debian/",
+                        "http://mirrors.aliyun.com/debian/"};
+            } else if (ports) {
+                urls = {"http://ports.ubuntu.com/ubuntu-ports/",
+                        "http://mirrors.tuna.tsinghua.edu.cn/ubuntu-ports/",
+                        "http://mirrors.ustc.edu.cn/ubuntu-ports/",
+                        "http://mirrors.aliyun.com/ubuntu-ports/"};
+            } else {
+                urls = {"http://archive.ubuntu.com/ubuntu/",
+                        "http://mirrors.tuna.tsinghua.edu.cn/ubuntu/",
+                        "http://mirrors.ustc.edu.cn/ubuntu/",
+                        "http://mirrors.aliyun.com/ubuntu/"};
+            }
+            break;
+        }
+        case MirrorKind::PIP:
+            urls = {"https://pypi.org/simple/",
+                    "https://pypi.tuna.tsinghua.edu.cn/simple/",
+                    "https://mirrors.aliyun.com/pypi/simple/",
+                    "https://mirrors.bfsu.edu.cn/pypi/web/simple/"};
+            break;
+        case MirrorKind::ROS:
+            urls = {"http://packages.ros.org/ros2/ubuntu/",
+                    "http://mirrors.tuna.tsinghua.edu.cn/ros2/ubuntu/",
+                    "http://mirrors.ustc.edu.cn/ros2/ubuntu/",
+                    "http://mirrors.aliyun.com/ros2/ubuntu/"};
+            break;
+    }
+
+    auto it = configured_.find(kindName(kind));
+    if (it != configured_.end()) {
+        for (const auto& url : it->second) {
+            if (std::find(urls.begin(), urls.end(), url) == urls.end()) {
+                urls.push_back(url);
+            }
+        }
+    }
+    return urls;
+}
+
+bool MirrorManager::loadCache(MirrorKind kind, std::vector<MirrorProbe>& probes) const {
+    // 每行：类型<TAB>测速时间<TAB>url<TAB>可达<TAB>建连毫秒<TAB>吞吐 KB/s
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(cachePath_, lines)) {
+        return false;
+    }
+
+    long now = static_cast<long>(std::time(nullptr));
+    probes.clear();
+    for (const auto& line : lines) {
+        std::vector<std::string> fields = FileUtils::splitFields(line);
+        if (fields.size() != 6 || fields[0] != kindName(kind)) {
+            continue;
+        }
+        if (now - std::atol(fields[1].c_str()) > ttlSeconds_) {
+            return false;
+        }
+        MirrorProbe probe;
+        probe.url = fields[2];
+        probe.reachable = (std::atoi(fields[3].c_str()) != 0);
+        probe.connectMs = std::atof(fields[4].c_str());
+        probe.throughputKBps = std::atof(fields[5].c_str());
+        probes.push_back(probe);
+    }
+
+    // 候选列表变化（如修改了配置文件）时缓存作废
+    std::vector<std::string> cached;
+    for (const auto& probe : probes) {
+        cached.push_back(probe.url);
+    }
+    std::vector<std::string> expected = candidates(kind);
+    std::sort(cached.begin(), cached.end());
+    std::sort(expected.begin(), expected.end());
+    return !probes.empty() && cached == expected;
+}
+
+void MirrorManager::saveCache(MirrorKind kind, const std::vector<MirrorProbe>& probes) const {
+    std::string content;
+    std::vector<std::string> lines;
+    FileUtils::readLines(cachePath_, lines);
+    std::string prefix = std::string(kindName(kind)) + "\t";
+    for (const auto& line : lines) {
+        if (line.compare(0, prefix.size(), prefix) != 0) {
+            content += line + "\n";
+        }
+    }
+
+    long now = static_cast<long>(std::time(nullptr));
+    for (const auto& probe : probes) {
+        char numbers[96];
+        std::snprintf(numbers, sizeof(numbers), "%d\t%.1f\t%.1f",
+                      probe.reachable ? 1 : 0, probe.connectMs, probe.throughputKBps);
+        content += prefix + std::to_string(now) + "\t" + probe.url + "\t" + numbers + "\n";
+    }
+
+    mkdir("/opt/linuxstudio/data", 0755);
+    FileUtils::writeFileAtomic(cachePath_, content);
+}
+
+std::vector<MirrorProbe> MirrorManager::rank(MirrorKind kind, bool refresh) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<MirrorProbe> probes;
+    if (!refresh && loadCache(kind, probes)) {
+        std::stable_sort(probes.begin(), probes.end(), fasterThan);
+        return probes;
+    }
+
+    auto& logger = CoreEngine::getInstance().getLogger();
+    logger.info(std::string("Probing ") + kindName(kind) + " mirrors...");
+
+    // 每个镜像一个线程：总耗时约等于最慢的一次超时，而不是逐个累加
+    std::vector<std::string> urls = candidates(kind);
+    probes.assign(urls.size(), MirrorProbe());
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < urls.size(); ++i) {
+        workers.emplace_back([&probes, &urls, kind, i]() {
+            probes[i] = probeMirror(kind, urls[i]);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::stable_sort(probes.begin(), probes.end(), fasterThan);
+    saveCache(kind, probes);
+    return probes;
+}
+
+std::string MirrorManager::fastest(MirrorKind kind) {
+    std::vector<MirrorProbe> probes = rank(kind);
+    if (!probes.empty() && probes.front().reachable) {
+        return probes.front().url;
+    }
+    return candidates(kind).front();
+}
+
+bool MirrorManager::rewriteSources(const std::string& path, MirrorKind kind, const std::string& url) const {
+    std::string content;
+    if (!FileUtils::readFile(path, content)) {
+        return false;
+    }
+
+    std::vector<std::string> known;
+    for (const auto& candidate : candidates(kind)) {
+        known.push_back(normalizeUrl(candidate));
+    }
+    std::string target = url;
+    while (!target.empty() && target.back() == '/') {
+        target.pop_back();
+    }
+
+    // 只替换 deb 行 / URIs: 字段中属于同一类镜像的 URL，其他源（如 security）保持不变
+    auto isKnown = [&known, kind](const std::string& token) {
+        std::string normalized = normalizeUrl(token);
+        if (std::find(known.begin(), known.end(), normalized) != known.end()) {
+            return true;
+        }
+        // 官方源的国家子域名，如 cn.archive.ubuntu.com/ubuntu
+        size_t slash = normalized.find('/');
+        std::string host = normalized.substr(0, slash);
+        const std::string suffix = ".archive.ubuntu.com";
+        return kind == MirrorKind::APT && slash != std::string::npos &&
+               normalized.compare(slash, std::string::npos, "/ubuntu") == 0 &&
+               host.size() > suffix.size() &&
+               host.compare(host.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+    std::string updated;
+    std::vector<std::string> lines;
+    FileUtils::splitLines(content, lines);
+    for (auto& line : lines) {
+        size_t first = line.find_first_not_of(" \t");
+        std::string trimmed = (first == std::string::npos) ? "" : line.substr(first);
+        bool sourceLine = trimmed.compare(0, 4, "deb ") == 0 ||
+                          trimmed.compare(0, 8, "deb-src ") == 0 ||
+                          trimmed.compare(0, 5, "URIs:") == 0;
+        size_t pos = 0;
+        while (sourceLine && (pos = line.find("://", pos)) != std::string::npos) {
+            size_t start = line.find_last_of(" \t", pos);
+            start = (start == std::string::npos) ? 0 : start + 1;
+            size_t end = line.find_first_of(" \t", pos);
+            if (end == std::string::npos) {
+                end = line.size();
+            }
+            if (isKnown(line.substr(start, end - start))) {
+                line.replace(start, end - start, target);
+                end = start + target.size();
+            }
+            pos = end;
+        }
+        updated += line + "\n";
+    }
+    return updated == content || replaceFile(path, content, updated);
+}
+
+bool MirrorManager::applyPip(const std::string& url) const {
+    std::string path = "/etc/pip.conf";
+    std::string content;
+    FileUtils::readFile(path, content);
+
+    // 在 [global] 段中替换或追加 index-url，保留其余配置
+    std::string updated;
+    std::vector<std::string> lines;
+    FileUtils::splitLines(content, lines);
+    bool inGlobal = false;
+    bool sawGlobal = false;
+    bool written = false;
+    for (const auto& line : lines) {
+        if (!line.empty() && line[0] == '[') {
+            if (inGlobal && !written) {
+                updated += "index-url = " + url + "\n";
+                written = true;
+            }
+            inGlobal = (line.compare(0, 8, "[global]") == 0);
+            sawGlobal = sawGlobal || inGlobal;
+        } else if (inGlobal && line.compare(0, 9, "index-url") == 0) {
+            if (!written) {
+                updated += "index-url = " + url + "\n";
+                written = true;
+            }
+            continue;
+        }
+        updated += line + "\n";
+    }
+    if (!written) {
+        if (!sawGlobal) {
+            updated += "[global]\n";
+        }
+        updated += "index-url = " + url + "\n";
+    }
+    return updated == content || replaceFile(path, content, updated);
+}
+
+bool MirrorManager::apply(MirrorKind kind) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    std::string url = fastest(kind);
+    logger.info(std::string("Using ") + kindName(kind) + " mirror: " + url);
+
+    if (kind == MirrorKind::PIP) {
+        return applyPip(url);
+    }
+
+    std::vector<std::string> files;
+    if (kind == MirrorKind::APT) {
+        files = {"/etc/apt/sources.list",
+                 "/etc/apt/sources.list.d/ubuntu.sources",
+                 "/etc/apt/sources.list.d/debian.sources"};
+    } else {
+        files = {"/etc/apt/sources.list.d/ros2.list"};
+    }
+
+    bool found = false;
+    bool ok = true;
+    for (const auto& file : files) {
+        struct stat st;
+        if (stat(file.c_str(), &st) != 0) {
+            continue;
+        }
+        found = true;
+        ok = rewriteSources(file, kind, url) && ok;
+    }
+    if (!found) {
+        logger.error(std::string("No ") + kindName(kind) + " source file to update");
+        return false;
+    }
+    if (ok) {
+        logger.info("Run 'apt-get update' to refresh package lists");
+    }
+    return ok;
+}
+
+} // namespace LinuxStudio
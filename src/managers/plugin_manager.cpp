@@ -1,11 +1,15 @@
 #include "linuxstudio/managers.hpp"
 #include "linuxstudio/core.hpp"
 #include "linuxstudio/logger.hpp"  // 添加 Logger 的完整定义
-#include <fstream>
-#include <sstream>
+#include "linuxstudio/process.hpp"
+#include "linuxstudio/completion.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/registry_watcher.hpp"
+#include "linuxstudio/repo_index.hpp"
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
-#include <chrono>
-#include <iomanip>
+#include <ctime>
 #ifdef _WIN32
     #include <direct.h>
     #include <io.h>
@@ -14,12 +18,109 @@
     #include <sys/stat.h>
     #include <sys/types.h>
     #include <dirent.h>
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <unistd.h>
 #endif
 
 namespace LinuxStudio {
 
+namespace {
+
+// 内置插件安装的系统软件包（以 * 结尾为前缀匹配），与各安装函数保持一致
+const std::map<std::string, std::vector<std::string>> kPluginPackages = {
+    {"ros2", {"ros-humble-*", "python3-colcon-common-extensions"}},
+    {"robot-arm", {"libmodbus-dev", "can-utils", "liburdfdom-dev"}},
+    {"opencv", {"libopencv-dev", "python3-opencv"}},
+};
+
+// Python 插件的 pip 依赖，与各安装函数保持一致
+const std::map<std::string, std::vector<std::string>> kPluginRequirements = {
+    {"robot-arm", {"roboticstoolbox-python"}},
+    {"pytorch", {"torch", "torchvision", "torchaudio"}},
+    {"tensorflow", {"tensorflow"}},
+};
+
+/**
+ * @brief 插件的系统软件包：内置插件取上表，否则取仓库索引
+ */
+std::vector<std::string> pluginPackages(const std::string& name) {
+    auto it = kPluginPackages.find(name);
+    if (it != kPluginPackages.end()) {
+        return it->second;
+    }
+    RepoIndex::PluginEntry entry;
+    return RepoIndex::local().plugin(name, entry) ? entry.packages : std::vector<std::string>();
+}
+
+/**
+ * @brief 插件的 pip 依赖：内置插件取上表，否则取仓库索引
+ */
+std::vector<std::string> pluginRequirements(const std::string& name) {
+    auto it = kPluginRequirements.find(name);
+    if (it != kPluginRequirements.end()) {
+        return it->second;
+    }
+    RepoIndex::PluginEntry entry;
+    return RepoIndex::local().plugin(name, entry) ? entry.requirements : std::vector<std::string>();
+}
+
+// 插件索引中记录插件目录自身变更标记的键（插件名不以 . 开头）
+const char* const kDirMarkerKey = ".";
+
+// 索引值格式：marker<TAB>version<TAB>enabled<TAB>installedAt<TAB>wheel1 wheel2
+std::string serializeIndexEntry(const std::string& marker, const Plugin& plugin) {
+    std::string wheels;
+    for (size_t i = 0; i < plugin.wheels.size(); ++i) {
+        wheels += (i > 0 ? " " : "") + plugin.wheels[i];
+    }
+    return marker + "\t" + plugin.version + "\t" + (plugin.enabled ? "1" : "0") + "\t" +
+           plugin.installedAt + "\t" + wheels;
+}
+
+void parseIndexEntry(const std::string& name, const std::string& value, std::string& marker, Plugin& plugin) {
+    std::vector<std::string> fields(1);
+    for (char c : value) {
+        if (c == '\t') {
+            fields.emplace_back();
+        } else {
+            fields.back() += c;
+        }
+    }
+    fields.resize(5);
+    marker = fields[0];
+    plugin = Plugin(name, "");
+    plugin.version = fields[1];
+    plugin.enabled = (fields[2] == "1");
+    plugin.installedAt = fields[3];
+    plugin.wheels = FileUtils::splitFields(fields[4]);
+}
+
+/**
+ * @brief 本地时间，格式 2024-01-31T08:00:00
+ */
+std::string currentTimestamp() {
+    std::time_t now = std::time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &local);
+    return buffer;
+}
+
+/**
+ * @brief 插件目录（环境变量 XKL_PLUGINS_DIR 可覆盖，测试用）
+ */
+std::string pluginsRoot() {
+    const char* override = std::getenv("XKL_PLUGINS_DIR");
+    return override && *override ? override : "/opt/linuxstudio/plugins";
+}
+
+} // namespace
+
 PluginManager::PluginManager() 
-    : pluginsPath_("/opt/linuxstudio/plugins") {
+    : pluginsPath_(pluginsRoot()),
+      index_(pluginsPath_ + "/.index.db") {
     // 创建插件目录
     mkdir(pluginsPath_.c_str(), 0755);
     
@@ -31,7 +132,7 @@ PluginManager::PluginManager()
 }
 
 PluginManager::~PluginManager() {
-    savePluginRegistry();
+    // 元数据在每次变更时已单独写入，这里不再整体回写，避免覆盖其他进程的更新
 }
 
 void PluginManager::registerBuiltinInstallers() {
@@ -45,27 +146,54 @@ void PluginManager::registerBuiltinInstallers() {
 
 std::vector<Plugin> PluginManager::listInstalled() {
     std::vector<Plugin> result;
-    for (const auto& pair : plugins_) {
-        result.push_back(pair.second);
-    }
+    forEachInstalled([&result](const Plugin& plugin) {
+        result.push_back(plugin);
+    });
     return result;
 }
 
+void PluginManager::forEachInstalled(const std::function<void(const Plugin&)>& visitor) const {
+    plugins_.forEach([&visitor](const std::string&, const Plugin& plugin) {
+        visitor(plugin);
+    });
+}
+
+bool PluginManager::acquire(const std::string& name) {
+    std::lock_guard<std::mutex> lock(busyMutex_);
+    return busy_.insert(name).second;
+}
+
+void PluginManager::release(const std::string& name) {
+    std::lock_guard<std::mutex> lock(busyMutex_);
+    busy_.erase(name);
+}
+
 bool PluginManager::install(const std::string& name) {
     auto& logger = CoreEngine::getInstance().getLogger();
     
     logger.info("Installing plugin: " + name);
     
+    // 同一插件同一时间只允许一个线程安装/卸载
+    if (!acquire(name)) {
+        logger.warning("Plugin '" + name + "' is busy in another operation");
+        return false;
+    }
+    
     // 检查是否已安装
     if (isInstalled(name)) {
         logger.warning("Plugin '" + name + "' is already installed");
+        release(name);
         return false;
     }
     
     // 执行安装
     bool success = false;
-    if (installers_.find(name) != installers_.end()) {
-        success = installers_[name]();
+    auto installer = installers_.find(name);
+    RepoIndex::PluginEntry entry;
+    if (installer != installers_.end()) {
+        success = installer->second();
+    } else if (RepoIndex::local().plugin(name, entry)) {
+        success = installFromRepository(name, entry);
     } else {
         logger.warning("Unknown plugin: " + name);
         logger.info("Creating custom plugin directory");
@@ -77,46 +205,71 @@ bool PluginManager::install(const std::string& name) {
     }
     
     if (success) {
-        // 创建插件信息
-        Plugin plugin(name, "");
-        plugin.enabled = true;
-        
-        // 获取当前时间
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time), "%Y-%m-%dT%H:%M:%S");
-        plugin.installedAt = ss.str();
+        // 保存到注册表（安装函数记录的 wheel 集合保留）
+        std::string installedAt = currentTimestamp();
+        updatePlugin(name, [&name, &installedAt](Plugin& current) {
+            current.name = name;
+            current.enabled = true;
+            current.installedAt = installedAt;
+        });
         
-        // 保存到注册表
-        plugins_[name] = plugin;
-        savePluginMetadata(name, plugin);
+        // 记录落盘文件的摘要，之后可用 xkl plugin verify 检查损坏
+        if (!recordManifest(name)) {
+            logger.warning("Could not record file manifest for plugin '" + name + "'");
+        }
+        release(name);
+        updateCompletionIndex();
         
         logger.success("Plugin '" + name + "' installed successfully");
         return true;
     }
     
+    release(name);
     logger.error("Failed to install plugin: " + name);
     return false;
 }
 
-bool PluginManager::uninstall(const std::string& name) {
+bool PluginManager::uninstall(const std::string& name, std::uint64_t* reclaimedBytes) {
     auto& logger = CoreEngine::getInstance().getLogger();
     
+    if (!acquire(name)) {
+        logger.warning("Plugin '" + name + "' is busy in another operation");
+        return false;
+    }
+    
     if (!isInstalled(name)) {
         logger.error("Plugin '" + name + "' is not installed");
+        release(name);
         return false;
     }
     
     logger.warning("Uninstalling plugin: " + name);
     
-    // 删除插件目录
-    std::string cmd = "rm -rf " + pluginsPath_ + "/" + name;
-    int ret = system(cmd.c_str());
+    // Python 插件的环境一并删除；共享仓库中的 wheel 由 xkl python gc 回收
+    std::uint64_t envBytes = 0;
+    if (!getInfo(name).wheels.empty()) {
+        CoreEngine::getInstance().getPythonEnvManager().removeEnv(name, &envBytes);
+    }
+    
+    // 插件目录 rename 进回收区即完成卸载，实际删除在后台进行
+    std::uint64_t dirBytes = 0;
+    std::string pluginDir = pluginsPath_ + "/" + name;
+    struct stat st;
+    bool ok = lstat(pluginDir.c_str(), &st) != 0 || FileUtils::discard(pluginDir, &dirBytes);
     
-    if (ret == 0) {
+    if (ok) {
         plugins_.erase(name);
-        logger.success("Plugin '" + name + "' uninstalled successfully");
+        index_.commit({{name, std::nullopt}});
+    }
+    release(name);
+    
+    if (ok) {
+        if (reclaimedBytes) {
+            *reclaimedBytes = envBytes + dirBytes;
+        }
+        updateCompletionIndex();
+        logger.success("Plugin '" + name + "' uninstalled successfully (" +
+                       DiskUsage::formatBytes(envBytes + dirBytes) + " reclaimed)");
         return true;
     }
     
@@ -131,8 +284,7 @@ bool PluginManager::enable(const std::string& name) {
         return false;
     }
     
-    plugins_[name].enabled = true;
-    savePluginMetadata(name, plugins_[name]);
+    updatePlugin(name, [](Plugin& plugin) { plugin.enabled = true; });
     logger.success("Plugin '" + name + "' enabled");
     return true;
 }
@@ -145,82 +297,245 @@ bool PluginManager::disable(const std::string& name) {
         return false;
     }
     
-    plugins_[name].enabled = false;
-    savePluginMetadata(name, plugins_[name]);
+    updatePlugin(name, [](Plugin& plugin) { plugin.enabled = false; });
     logger.warning("Plugin '" + name + "' disabled");
     return true;
 }
 
 bool PluginManager::isInstalled(const std::string& name) {
-    return plugins_.find(name) != plugins_.end();
+    return plugins_.contains(name);
 }
 
 bool PluginManager::isEnabled(const std::string& name) {
-    if (!isInstalled(name)) {
-        return false;
-    }
-    return plugins_[name].enabled;
+    bool enabled = false;
+    plugins_.read(name, [&enabled](const Plugin& plugin) {
+        enabled = plugin.enabled;
+    });
+    return enabled;
 }
 
 Plugin PluginManager::getInfo(const std::string& name) {
-    if (isInstalled(name)) {
-        return plugins_[name];
+    Plugin plugin;
+    plugins_.find(name, plugin);
+    return plugin;
+}
+
+std::vector<std::string> PluginManager::listAvailable() const {
+    std::vector<std::string> names;
+    for (const auto& pair : installers_) {
+        names.push_back(pair.first);
+    }
+    for (const auto& name : RepoIndex::local().pluginNames()) {
+        if (installers_.count(name) == 0) {
+            names.push_back(name);
+        }
     }
-    return Plugin();
+    return names;
+}
+
+void PluginManager::updateCompletionIndex() const {
+    std::vector<std::string> installed;
+    plugins_.forEach([&installed](const std::string& name, const Plugin&) {
+        installed.push_back(name);
+    });
+    CompletionIndex::updateSection(CompletionIndex::kPlugins, listAvailable());
+    CompletionIndex::updateSection(CompletionIndex::kPluginsInstalled, installed);
 }
 
 void PluginManager::loadPluginRegistry() {
-    // 扫描插件目录
-    DIR* dir = opendir(pluginsPath_.c_str());
-    if (dir == nullptr) {
+    // 从索引加载，不逐个解析 metadata.json
+    RegistryStore::Entries entries;
+    if (!index_.read(entries)) {
+        syncPlugins();  // 尚无索引：完整扫描一次并建立索引
         return;
     }
     
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != nullptr) {
-        if (entry->d_type == DT_DIR && entry->d_name[0] != '.') {
-            std::string name = entry->d_name;
-            
-            // 尝试读取元数据
-            std::string metaPath = pluginsPath_ + "/" + name + "/metadata.json";
-            std::ifstream metaFile(metaPath);
-            
-            if (metaFile.is_open()) {
-                // 简单解析（实际应使用 JSON 库）
-                Plugin plugin;
-                plugin.name = name;
-                plugin.enabled = true;
-                plugins_[name] = plugin;
-                metaFile.close();
+    std::map<std::string, Plugin> loaded;
+    for (const auto& entry : entries) {
+        if (entry.first == kDirMarkerKey) {
+            continue;
+        }
+        std::string marker;
+        parseIndexEntry(entry.first, entry.second, marker, loaded[entry.first]);
+    }
+    plugins_.replaceAll(loaded);
+    
+    // 长驻监视进程在运行时索引即为最新；否则按变更标记追赶外部修改
+    if (!RegistryWatcher::active()) {
+        syncPlugins();
+    }
+}
+
+std::vector<std::string> PluginManager::syncPlugins(const std::set<std::string>& names) {
+    RegistryStore::Entries entries;
+    index_.read(entries);
+    
+    RegistryStore::Changes changes;
+    std::set<std::string> candidates = names;
+    if (names.empty()) {
+        for (const auto& entry : entries) {
+            if (entry.first != kDirMarkerKey) {
+                candidates.insert(entry.first);
             }
         }
+        
+        // 插件目录的标记不变说明没有增删插件，不必读目录
+        std::string dirMarker = FileUtils::changeMarker(pluginsPath_);
+        auto stored = entries.find(kDirMarkerKey);
+        if (stored == entries.end() || stored->second != dirMarker) {
+            DIR* dir = opendir(pluginsPath_.c_str());
+            if (dir != nullptr) {
+                struct dirent* entry;
+                while ((entry = readdir(dir)) != nullptr) {
+                    if (entry->d_type == DT_DIR && entry->d_name[0] != '.') {
+                        candidates.insert(entry->d_name);
+                    }
+                }
+                closedir(dir);
+            }
+            changes[kDirMarkerKey] = dirMarker;
+        }
     }
-    closedir(dir);
+    
+    // 只重读标记变化的插件：元数据经 rename 写入，每次修改都会换 inode
+    std::vector<std::string> changed;
+    for (const auto& name : candidates) {
+        std::string marker = FileUtils::changeMarker(pluginsPath_ + "/" + name + "/metadata.json");
+        auto stored = entries.find(name);
+        std::string storedMarker;
+        Plugin plugin;
+        if (stored != entries.end()) {
+            parseIndexEntry(name, stored->second, storedMarker, plugin);
+            if (storedMarker == marker) {
+                continue;
+            }
+        }
+        
+        if (!marker.empty() && readPluginMetadata(name, plugin)) {
+            plugins_.insertOrAssign(name, plugin);
+            changes[name] = serializeIndexEntry(marker, plugin);
+        } else if (stored != entries.end()) {
+            plugins_.erase(name);
+            changes[name] = std::nullopt;
+        } else {
+            continue;
+        }
+        changed.push_back(name);
+    }
+    
+    if (!changes.empty()) {
+        index_.commit(changes);
+    }
+    return changed;
 }
 
-void PluginManager::savePluginRegistry() {
-    // 保存每个插件的元数据
-    for (const auto& pair : plugins_) {
-        savePluginMetadata(pair.first, pair.second);
+bool PluginManager::readPluginMetadata(const std::string& name, Plugin& plugin) const {
+    std::string metaPath = pluginsPath_ + "/" + name + "/metadata.json";
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(metaPath, lines)) {
+        return false;
     }
+    
+    // 简单解析（每行一个字段，与 savePluginMetadata 的输出格式对应）
+    auto stringValue = [](const std::string& line) {
+        size_t colon = line.find(':');
+        size_t start = line.find('"', colon + 1);
+        size_t end = line.rfind('"');
+        if (colon == std::string::npos || start == std::string::npos || end <= start) {
+            return std::string();
+        }
+        return line.substr(start + 1, end - start - 1);
+    };
+    
+    plugin = Plugin();
+    plugin.name = name;
+    plugin.enabled = true;
+    
+    for (const auto& line : lines) {
+        if (line.find("\"version\":") != std::string::npos) {
+            plugin.version = stringValue(line);
+        } else if (line.find("\"enabled\":") != std::string::npos) {
+            plugin.enabled = (line.find("false") == std::string::npos);
+        } else if (line.find("\"installedAt\":") != std::string::npos) {
+            plugin.installedAt = stringValue(line);
+        } else if (line.find("\"wheels\":") != std::string::npos) {
+            // 单行数组：["a.whl#sha256=...", ...]
+            size_t pos = line.find('[');
+            while (pos != std::string::npos) {
+                size_t start = line.find('"', pos + 1);
+                size_t end = (start == std::string::npos) ? start : line.find('"', start + 1);
+                if (end == std::string::npos) {
+                    break;
+                }
+                plugin.wheels.push_back(line.substr(start + 1, end - start - 1));
+                pos = end;
+            }
+        }
+    }
+    return true;
 }
 
-void PluginManager::savePluginMetadata(const std::string& name, const Plugin& plugin) {
+bool PluginManager::updatePlugin(const std::string& name, const std::function<void(Plugin&)>& mutate) {
     std::string pluginDir = pluginsPath_ + "/" + name;
     mkdir(pluginDir.c_str(), 0755);
     
-    std::string metaPath = pluginDir + "/metadata.json";
-    std::ofstream metaFile(metaPath);
+    // 每个插件一把锁：不同插件的更新互不阻塞，同一插件的读-改-写串行化
+    std::string lockPath = pluginDir + "/.lock";
+    int lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockFd >= 0) {
+        flock(lockFd, LOCK_EX);
+    }
+    
+    // 以磁盘上的最新状态为基础合并，而不是用本进程启动时的旧副本覆盖；
+    // 在分片写锁内完成，保证内存视图与磁盘按相同顺序更新
+    bool ok = false;
+    plugins_.update(name, [&](Plugin& current, bool existed) {
+        Plugin plugin;
+        if (!readPluginMetadata(name, plugin)) {
+            plugin = existed ? current : Plugin(name, "");
+        }
+        mutate(plugin);
+        ok = savePluginMetadata(name, plugin);
+        current = plugin;
+        return true;
+    });
     
-    if (metaFile.is_open()) {
-        metaFile << "{\n";
-        metaFile << "  \"name\": \"" << plugin.name << "\",\n";
-        metaFile << "  \"version\": \"" << plugin.version << "\",\n";
-        metaFile << "  \"enabled\": " << (plugin.enabled ? "true" : "false") << ",\n";
-        metaFile << "  \"installedAt\": \"" << plugin.installedAt << "\"\n";
-        metaFile << "}\n";
-        metaFile.close();
+    // 索引随元数据一起更新，其他进程启动时无需重读该插件
+    if (ok) {
+        Plugin saved;
+        plugins_.find(name, saved);
+        std::string marker = FileUtils::changeMarker(pluginDir + "/metadata.json");
+        index_.commit({{name, serializeIndexEntry(marker, saved)}});
     }
+    
+    if (lockFd >= 0) {
+        flock(lockFd, LOCK_UN);
+        close(lockFd);
+    }
+    return ok;
+}
+
+bool PluginManager::savePluginMetadata(const std::string& name, const Plugin& plugin) {
+    std::string pluginDir = pluginsPath_ + "/" + name;
+    mkdir(pluginDir.c_str(), 0755);
+    
+    // 先写临时文件再 rename，读者永远看到完整的元数据
+    std::string metaPath = pluginDir + "/metadata.json";
+    std::string content = "{\n";
+    content += "  \"name\": \"" + plugin.name + "\",\n";
+    content += "  \"version\": \"" + plugin.version + "\",\n";
+    content += std::string("  \"enabled\": ") + (plugin.enabled ? "true" : "false") + ",\n";
+    content += "  \"installedAt\": \"" + plugin.installedAt + "\"";
+    if (!plugin.wheels.empty()) {
+        content += ",\n  \"wheels\": [";
+        for (size_t i = 0; i < plugin.wheels.size(); ++i) {
+            content += (i > 0 ? ", \"" : "\"") + plugin.wheels[i] + "\"";
+        }
+        content += "]";
+    }
+    content += "\n";
+    content += "}\n";
+    return FileUtils::writeFileAtomic(metaPath, content);
 }
 
 // 内置插件安装函数
@@ -228,17 +543,24 @@ bool PluginManager::installROS2() {
     auto& logger = CoreEngine::getInstance().getLogger();
     logger.info("Installing ROS2 Humble...");
     
+    // 软件源使用测速最快的 ROS 镜像；签名密钥始终从官方获取
+    std::string mirror = CoreEngine::getInstance().getMirrorManager().fastest(MirrorKind::ROS);
+    if (!mirror.empty() && mirror.back() == '/') {
+        mirror.pop_back();
+    }
+    logger.info("ROS mirror: " + mirror);
+    
     // 执行安装命令
     std::string cmd = R"(
         apt-get update -qq && \
         apt-get install -y software-properties-common curl && \
         curl -sSL https://raw.githubusercontent.com/ros/rosdistro/master/ros.key -o /usr/share/keyrings/ros-archive-keyring.gpg && \
-        echo "deb [arch=$(dpkg --print-architecture) signed-by=/usr/share/keyrings/ros-archive-keyring.gpg] http://packages.ros.org/ros2/ubuntu $(lsb_release -cs) main" | tee /etc/apt/sources.list.d/ros2.list > /dev/null && \
+        echo "deb [arch=$(dpkg --print-architecture) signed-by=/usr/share/keyrings/ros-archive-keyring.gpg] )" + mirror + R"( $(lsb_release -cs) main" | tee /etc/apt/sources.list.d/ros2.list > /dev/null && \
         apt-get update -qq && \
         apt-get install -y ros-humble-desktop python3-colcon-common-extensions
     )";
     
-    int ret = system(cmd.c_str());
+    int ret = Process::run(cmd, "ROS2 Humble");
     return ret == 0;
 }
 
@@ -246,9 +568,9 @@ bool PluginManager::installRobotArm() {
     auto& logger = CoreEngine::getInstance().getLogger();
     logger.info("Installing Robot Arm control libraries...");
     
-    std::string cmd = "apt-get install -y libmodbus-dev can-utils liburdfdom-dev && pip3 install roboticstoolbox-python";
-    int ret = system(cmd.c_str());
-    return ret == 0;
+    std::string cmd = "apt-get install -y libmodbus-dev can-utils liburdfdom-dev";
+    int ret = Process::run(cmd, "robot-arm libraries");
+    return ret == 0 && installPythonPlugin("robot-arm");
 }
 
 bool PluginManager::installOpenCV() {
@@ -256,7 +578,7 @@ bool PluginManager::installOpenCV() {
     logger.info("Installing OpenCV...");
     
     std::string cmd = "apt-get install -y libopencv-dev python3-opencv";
-    int ret = system(cmd.c_str());
+    int ret = Process::run(cmd, "OpenCV");
     return ret == 0;
 }
 
@@ -264,18 +586,208 @@ bool PluginManager::installPyTorch() {
     auto& logger = CoreEngine::getInstance().getLogger();
     logger.info("Installing PyTorch...");
     
-    std::string cmd = "pip3 install torch torchvision torchaudio";
-    int ret = system(cmd.c_str());
-    return ret == 0;
+    return installPythonPlugin("pytorch");
 }
 
 bool PluginManager::installTensorFlow() {
     auto& logger = CoreEngine::getInstance().getLogger();
     logger.info("Installing TensorFlow...");
     
-    std::string cmd = "pip3 install tensorflow";
-    int ret = system(cmd.c_str());
-    return ret == 0;
+    return installPythonPlugin("tensorflow");
+}
+
+bool PluginManager::installFromRepository(const std::string& name, const RepoIndex::PluginEntry& entry) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    logger.info("Installing repository plugin: " + name + " (" + entry.description + ")");
+    
+    mkdir((pluginsPath_ + "/" + name).c_str(), 0755);
+    
+    // 前缀形式（* 结尾）只用于统计与清单，安装时跳过
+    std::string packages;
+    for (const auto& package : entry.packages) {
+        if (!package.empty() && package.back() != '*') {
+            packages += " " + package;
+        }
+    }
+    if (!packages.empty() && Process::run("apt-get install -y" + packages, name + " packages") != 0) {
+        return false;
+    }
+    return entry.requirements.empty() || installPythonPlugin(name);
+}
+
+bool PluginManager::installPythonPlugin(const std::string& name) {
+    // 装进插件自己的 venv，wheel 与其他环境共享；解析结果记入插件元数据
+    auto& python = CoreEngine::getInstance().getPythonEnvManager();
+    std::vector<std::string> wheels;
+    if (!python.resolve(pluginRequirements(name), wheels)) {
+        return false;
+    }
+    python.removeEnv(name);
+    if (!python.createEnv(name, wheels)) {
+        return false;
+    }
+    
+    updatePlugin(name, [&wheels](Plugin& plugin) { plugin.wheels = wheels; });
+    CoreEngine::getInstance().getLogger().info("Activate with: source " + python.envPath(name) + "/bin/activate");
+    return true;
+}
+
+bool PluginManager::isPythonPlugin(const std::string& name) {
+    return !pluginRequirements(name).empty();
+}
+
+bool PluginManager::lockWheels(const std::string& name, std::vector<std::string>& wheels) {
+    if (!isPythonPlugin(name)) {
+        return false;
+    }
+    // 已安装的插件锁定当前环境实际使用的集合，否则重新解析（wheel 同时收入仓库）
+    Plugin plugin;
+    if (plugins_.find(name, plugin) && !plugin.wheels.empty()) {
+        wheels = plugin.wheels;
+        return true;
+    }
+    return CoreEngine::getInstance().getPythonEnvManager().resolve(pluginRequirements(name), wheels);
+}
+
+bool PluginManager::installLocked(const std::string& name, const std::vector<std::string>& wheels,
+                                  bool* changed) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    auto& python = CoreEngine::getInstance().getPythonEnvManager();
+    if (changed) {
+        *changed = false;
+    }
+    
+    if (!acquire(name)) {
+        logger.warning("Plugin '" + name + "' is busy in another operation");
+        return false;
+    }
+    
+    std::vector<std::string> wanted = wheels;
+    std::sort(wanted.begin(), wanted.end());
+    Plugin current;
+    if (plugins_.find(name, current)) {
+        std::sort(current.wheels.begin(), current.wheels.end());
+        if (current.wheels == wanted) {
+            release(name);
+            return true;
+        }
+    }
+    
+    logger.info("Installing locked plugin: " + name + " (" + std::to_string(wanted.size()) + " wheels)");
+    bool ok = python.fetch(wanted);
+    if (ok) {
+        python.removeEnv(name);
+        ok = python.createEnv(name, wanted);
+    }
+    if (ok) {
+        std::string installedAt = currentTimestamp();
+        updatePlugin(name, [&](Plugin& plugin) {
+            plugin.name = name;
+            plugin.enabled = true;
+            plugin.installedAt = installedAt;
+            plugin.wheels = wanted;
+        });
+        if (!recordManifest(name)) {
+            logger.warning("Could not record file manifest for plugin '" + name + "'");
+        }
+    }
+    release(name);
+    
+    if (!ok) {
+        logger.error("Failed to install plugin: " + name);
+        return false;
+    }
+    if (changed) {
+        *changed = true;
+    }
+    updateCompletionIndex();
+    return true;
+}
+
+std::vector<std::string> PluginManager::payloadFiles(const std::string& name) const {
+    std::string pluginDir = pluginsPath_ + "/" + name;
+    std::set<std::string> exclude = {pluginDir + "/metadata.json", pluginDir + "/.lock", manifestPath(name)};
+    std::vector<std::string> files;
+    std::mutex filesMutex;
+    FileUtils::walkParallel({pluginDir}, [&](const std::string& dir, std::vector<std::string>& children) {
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        FileUtils::readEntries(fd, [&](const char* entry, unsigned char type) {
+            std::string path = dir + "/" + entry;
+            struct stat st;
+            if (type == DT_UNKNOWN && lstat(path.c_str(), &st) == 0) {
+                type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN);
+            }
+            if (type == DT_DIR) {
+                children.push_back(path);
+            } else if (type == DT_REG && exclude.count(path) == 0) {
+                std::lock_guard<std::mutex> lock(filesMutex);
+                files.push_back(path.substr(pluginDir.size() + 1));
+            }
+        });
+        close(fd);
+    });
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+PluginFootprint PluginManager::diskUsage(const std::string& name, DiskUsage& usage) const {
+    PluginFootprint footprint;
+    
+    // Python 环境里的文件硬链接自共享 wheel 仓库，只计一次
+    std::vector<std::string> roots = {pluginsPath_ + "/" + name};
+    roots.push_back(CoreEngine::getInstance().getPythonEnvManager().envPath(name));
+    footprint.files = usage.measureTrees(roots);
+    
+    std::vector<std::string> patterns = pluginPackages(name);
+    if (!patterns.empty()) {
+        std::vector<std::string> packages = usage.matchPackages(patterns);
+        footprint.packageCount = packages.size();
+        for (const auto& entry : usage.measurePackages(packages)) {
+            footprint.packages += entry.second;
+        }
+    }
+    return footprint;
+}
+
+std::string PluginManager::manifestPath(const std::string& name) const {
+    return pluginsPath_ + "/" + name + "/.manifest";
+}
+
+bool PluginManager::recordManifest(const std::string& name, std::size_t* entries) {
+    std::string pluginDir = pluginsPath_ + "/" + name;
+    std::vector<std::string> roots = {pluginDir};
+    roots.push_back(CoreEngine::getInstance().getPythonEnvManager().envPath(name));
+    
+    std::vector<std::string> files;
+    std::vector<std::string> patterns = pluginPackages(name);
+    if (!patterns.empty()) {
+        DiskUsage usage;
+        for (const auto& package : usage.matchPackages(patterns)) {
+            std::vector<std::string> owned = usage.packageFiles(package);
+            files.insert(files.end(), owned.begin(), owned.end());
+        }
+    }
+    
+    // 元数据随启用/禁用改变，锁文件与清单本身也不记录
+    std::set<std::string> exclude = {pluginDir + "/metadata.json", pluginDir + "/.lock", manifestPath(name)};
+    Manifest manifest;
+    manifest.build(roots, files, exclude);
+    if (entries) {
+        *entries = manifest.entries().size();
+    }
+    return manifest.save(manifestPath(name));
+}
+
+bool PluginManager::verify(const std::string& name, Manifest::Report& report) const {
+    Manifest manifest;
+    if (!manifest.load(manifestPath(name))) {
+        return false;
+    }
+    report = manifest.verify();
+    return true;
 }
 
 bool PluginManager::installCUDA() {
@@ -283,7 +795,7 @@ bool PluginManager::installCUDA() {
     logger.info("Checking for NVIDIA GPU...");
     
     // 检测 NVIDIA GPU
-    int ret = system("lspci | grep -i nvidia > /dev/null");
+    int ret = Process::run("lspci | grep -i nvidia > /dev/null");
     if (ret == 0) {
         logger.warning("NVIDIA GPU detected");
         logger.info("Please install CUDA from NVIDIA website:");
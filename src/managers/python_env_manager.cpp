@@ -0,0 +1,554 @@
+#include "linuxstudio/managers.hpp"
+#include "linuxstudio/core.hpp"
+#include "linuxstudio/logger.hpp"
+#include "linuxstudio/process.hpp"
+#include "linuxstudio/hash.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstdio>
+#include <set>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+/**
+ * @brief 文件放置方式统计
+ */
+struct LinkStats {
+    size_t hardlinked = 0;
+    size_t reflinked = 0;
+    size_t copied = 0;
+};
+
+std::vector<std::string> listDirectory(const std::string& path) {
+    std::vector<std::string> names;
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        return names;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * @brief "文件名#sha256=摘要" -> 摘要
+ */
+std::string wheelDigest(const std::string& entry) {
+    size_t pos = entry.rfind("#sha256=");
+    return pos == std::string::npos ? "" : entry.substr(pos + 8);
+}
+
+/**
+ * @brief 把仓库中的文件放到环境里，按放置方式计数
+ */
+bool placeFile(const std::string& src, const std::string& dst, const struct stat& st, LinkStats& stats) {
+    // 同名文件以后安装的 wheel 为准（与 pip 一致）
+    switch (FileUtils::placeFile(src, dst, st.st_mode & 0777)) {
+        case FileUtils::Placement::Hardlinked: ++stats.hardlinked; return true;
+        case FileUtils::Placement::Reflinked: ++stats.reflinked; return true;
+        case FileUtils::Placement::Copied: ++stats.copied; return true;
+        case FileUtils::Placement::Failed: break;
+    }
+    return false;
+}
+
+bool linkTree(const std::string& from, const std::string& to, LinkStats& stats) {
+    mkdir(to.c_str(), 0755);
+    for (const auto& name : listDirectory(from)) {
+        std::string src = from + "/" + name;
+        std::string dst = to + "/" + name;
+        struct stat st;
+        if (lstat(src.c_str(), &st) != 0) {
+            return false;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            if (!linkTree(src, dst, stats)) {
+                return false;
+            }
+        } else if (S_ISLNK(st.st_mode)) {
+            char target[4096];
+            ssize_t len = readlink(src.c_str(), target, sizeof(target) - 1);
+            if (len < 0) {
+                return false;
+            }
+            target[len] = '\0';
+            unlink(dst.c_str());
+            if (symlink(target, dst.c_str()) != 0) {
+                return false;
+            }
+        } else if (!placeFile(src, dst, st, stats)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 仓库文件设为只读，防止在某个环境中原地修改而影响其他环境
+ */
+void makeReadOnly(const std::string& path) {
+    for (const auto& name : listDirectory(path)) {
+        std::string child = path + "/" + name;
+        struct stat st;
+        if (lstat(child.c_str(), &st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            makeReadOnly(child);
+        } else if (S_ISREG(st.st_mode)) {
+            chmod(child.c_str(), st.st_mode & ~static_cast<mode_t>(0222));
+        }
+    }
+}
+
+/**
+ * @brief 复制 .data/scripts 下的脚本，把 "#!python" 改写为环境的解释器
+ */
+bool installScripts(const std::string& from, const std::string& binDir, const std::string& python) {
+    for (const auto& name : listDirectory(from)) {
+        std::string script;
+        FileUtils::readFile(from + "/" + name, script);
+        if (script.compare(0, 8, "#!python") == 0) {
+            script = "#!" + python + script.substr(script.find('\n') == std::string::npos ?
+                                                   script.size() : script.find('\n'));
+        }
+        std::string dst = binDir + "/" + name;
+        if (!FileUtils::writeFileAtomic(dst, script) || chmod(dst.c_str(), 0755) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 按 entry_points.txt 生成 console_scripts / gui_scripts 启动脚本
+ */
+void installEntryPoints(const std::string& distInfo, const std::string& binDir, const std::string& python) {
+    std::vector<std::string> lines;
+    FileUtils::readLines(distInfo + "/entry_points.txt", lines);
+    bool inScripts = false;
+    for (const auto& line : lines) {
+        if (!line.empty() && line[0] == '[') {
+            inScripts = (line == "[console_scripts]" || line == "[gui_scripts]");
+            continue;
+        }
+        size_t eq = line.find('=');
+        size_t colon = line.find(':', eq);
+        if (!inScripts || eq == std::string::npos || colon == std::string::npos) {
+            continue;
+        }
+        auto trim = [](std::string s) {
+            size_t start = s.find_first_not_of(" \t");
+            size_t end = s.find_last_not_of(" \t\r");
+            return start == std::string::npos ? std::string() : s.substr(start, end - start + 1);
+        };
+        std::string name = trim(line.substr(0, eq));
+        std::string module = trim(line.substr(eq + 1, colon - eq - 1));
+        std::string attr = trim(line.substr(colon + 1, line.find('[', colon) - colon - 1));
+        if (name.empty() || module.empty() || attr.empty()) {
+            continue;
+        }
+
+        std::string dst = binDir + "/" + name;
+        FileUtils::writeFileAtomic(dst, "#!" + python + "\n"
+                                        "import sys\n"
+                                        "from " + module + " import " + attr.substr(0, attr.find('.')) + "\n"
+                                        "if __name__ == '__main__':\n"
+                                        "    sys.exit(" + attr + "())\n");
+        chmod(dst.c_str(), 0755);
+    }
+}
+
+/**
+ * @brief 解包 wheel 并按 zip 外部属性恢复权限位（python3 -m zipfile -e 会丢掉可执行位）
+ * zipfile.extract 会去掉成员名中的绝对路径与 .. 路径段
+ */
+const char* const kUnpackScript =
+    "import os, sys, zipfile\n"
+    "with zipfile.ZipFile(sys.argv[1]) as wheel:\n"
+    "    for info in wheel.infolist():\n"
+    "        path = wheel.extract(info, sys.argv[2])\n"
+    "        mode = (info.external_attr >> 16) & 0o777\n"
+    "        if mode and not info.is_dir():\n"
+    "            os.chmod(path, mode)\n";
+
+} // namespace
+
+PythonEnvManager::PythonEnvManager()
+    : rootPath_("/opt/linuxstudio/python") {
+    const char* override = std::getenv("XKL_PYTHON_ROOT");
+    if (override && *override) {
+        rootPath_ = override;
+    }
+}
+
+bool PythonEnvManager::validEnvName(const std::string& name) {
+    if (name.empty() || name.size() > 64 || !std::isalnum(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-' || c == '_';
+    });
+}
+
+std::string PythonEnvManager::envPath(const std::string& name) const {
+    return rootPath_ + "/envs/" + name;
+}
+
+bool PythonEnvManager::resolve(const std::vector<std::string>& requirements,
+                               std::vector<std::string>& wheels) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    logger.info("Resolving Python packages...");
+    if (!download(requirements, false, wheels)) {
+        logger.error("Failed to resolve Python packages");
+        return false;
+    }
+    std::sort(wheels.begin(), wheels.end());
+    logger.info("Resolved " + std::to_string(wheels.size()) + " wheels");
+    return true;
+}
+
+bool PythonEnvManager::fetch(const std::vector<std::string>& wheels, size_t* downloaded) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+
+    // 仓库中已有的 wheel 只需确认已解包；缺少的按确切版本和摘要下载
+    std::vector<std::string> pins;
+    std::set<std::string> wanted;
+    for (const auto& wheel : wheels) {
+        std::string digest = wheelDigest(wheel);
+        if (digest.empty()) {
+            logger.error("Invalid wheel entry: " + wheel);
+            return false;
+        }
+        struct stat st;
+        if (stat((rootPath_ + "/wheels/" + digest + ".whl").c_str(), &st) == 0) {
+            if (!unpackWheel(digest)) {
+                return false;
+            }
+            continue;
+        }
+        // 文件名：{名称}-{版本}(-{构建号})?-{python}-{abi}-{平台}.whl
+        std::string file = wheel.substr(0, wheel.rfind('#'));
+        size_t nameEnd = file.find('-');
+        size_t versionEnd = nameEnd == std::string::npos ? nameEnd : file.find('-', nameEnd + 1);
+        if (versionEnd == std::string::npos) {
+            logger.error("Invalid wheel entry: " + wheel);
+            return false;
+        }
+        pins.push_back(file.substr(0, nameEnd) + "==" + file.substr(nameEnd + 1, versionEnd - nameEnd - 1) +
+                       " --hash=sha256:" + digest);
+        wanted.insert(digest);
+    }
+    if (downloaded) {
+        *downloaded = pins.size();
+    }
+    if (pins.empty()) {
+        return true;
+    }
+
+    logger.info("Downloading " + std::to_string(pins.size()) + " locked wheels...");
+    std::vector<std::string> entries;
+    if (!download(pins, true, entries)) {
+        logger.error("Failed to download locked wheels");
+        return false;
+    }
+    for (const auto& entry : entries) {
+        wanted.erase(wheelDigest(entry));
+    }
+    if (!wanted.empty()) {
+        logger.error(std::to_string(wanted.size()) + " wheel(s) do not match the lock");
+        return false;
+    }
+    return true;
+}
+
+std::string PythonEnvManager::wheelPath(const std::string& wheel) const {
+    return rootPath_ + "/wheels/" + wheelDigest(wheel) + ".whl";
+}
+
+bool PythonEnvManager::importWheel(const std::string& wheel,
+                                   const std::function<bool(const std::string& path)>& write) {
+    if (wheelDigest(wheel).empty()) {
+        return false;
+    }
+    std::string path = wheelPath(wheel);
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+        return true;
+    }
+    mkdir(rootPath_.c_str(), 0755);
+    mkdir((rootPath_ + "/wheels").c_str(), 0755);
+    return write(path);
+}
+
+bool PythonEnvManager::download(const std::vector<std::string>& requirements, bool pinned,
+                                std::vector<std::string>& entries) {
+    mkdir(rootPath_.c_str(), 0755);
+    mkdir((rootPath_ + "/wheels").c_str(), 0755);
+    mkdir((rootPath_ + "/store").c_str(), 0755);
+
+    // 下载到与仓库同一文件系统的暂存目录，收入仓库时只需 rename
+    static std::atomic<unsigned> sequence(0);
+    std::string staging = rootPath_ + "/staging." + std::to_string(getpid()) + "." +
+                          std::to_string(sequence++);
+    mkdir(staging.c_str(), 0755);
+
+    std::string index = CoreEngine::getInstance().getMirrorManager().fastest(MirrorKind::PIP);
+    std::string cmd = "python3 -m pip download --only-binary=:all: --disable-pip-version-check -q"
+                      " -d " + Process::quote(staging) + " -i " + Process::quote(index);
+    if (pinned) {
+        // 带摘要的依赖文件：pip 进入哈希校验模式，只接受摘要相符的文件
+        std::string content;
+        for (const auto& requirement : requirements) {
+            content += requirement + "\n";
+        }
+        std::string file = staging + "/requirements.txt";
+        FileUtils::writeFileAtomic(file, content);
+        cmd += " --no-deps --require-hashes -r " + Process::quote(file);
+    } else {
+        for (const auto& requirement : requirements) {
+            cmd += " " + Process::quote(requirement);
+        }
+    }
+
+    bool ok = Process::run(cmd, "pip download") == 0;
+    entries.clear();
+    for (const auto& name : listDirectory(staging)) {
+        std::string path = staging + "/" + name;
+        std::string entry;
+        if (ok && endsWith(name, ".whl")) {
+            ok = ingestWheel(path, entry);
+            entries.push_back(entry);
+        } else {
+            unlink(path.c_str());
+        }
+    }
+    rmdir(staging.c_str());
+    return ok;
+}
+
+bool PythonEnvManager::ingestWheel(const std::string& path, std::string& entry) {
+    std::string digest;
+    if (!Sha256::hashFile(path, digest)) {
+        return false;
+    }
+
+    // 内容相同的 wheel 只保留一份
+    std::string target = rootPath_ + "/wheels/" + digest + ".whl";
+    struct stat st;
+    if (stat(target.c_str(), &st) == 0) {
+        unlink(path.c_str());
+    } else if (std::rename(path.c_str(), target.c_str()) != 0) {
+        return false;
+    }
+
+    entry = path.substr(path.rfind('/') + 1) + "#sha256=" + digest;
+    return unpackWheel(digest);
+}
+
+bool PythonEnvManager::unpackWheel(const std::string& digest) {
+    std::string dir = rootPath_ + "/store/" + digest;
+    struct stat st;
+    if (stat(dir.c_str(), &st) == 0) {
+        return true;
+    }
+
+    // 解包到临时目录后 rename：并发解包同一个 wheel 时只有一个生效
+    std::string tmp = rootPath_ + "/store/." + digest + ".tmp." + std::to_string(getpid());
+    std::string wheel = rootPath_ + "/wheels/" + digest + ".whl";
+    if (Process::run("python3 -c " + Process::quote(kUnpackScript) + " " + Process::quote(wheel) + " " +
+                     Process::quote(tmp)) != 0) {
+        FileUtils::removeTree(tmp);
+        return false;
+    }
+    makeReadOnly(tmp);
+    if (std::rename(tmp.c_str(), dir.c_str()) != 0) {
+        FileUtils::removeTree(tmp);
+        return stat(dir.c_str(), &st) == 0;
+    }
+    return true;
+}
+
+bool PythonEnvManager::createEnv(const std::string& name, const std::vector<std::string>& wheels) {
+    auto& logger = CoreEngine::getInstance().getLogger();
+    if (!validEnvName(name)) {
+        logger.error("Invalid Python environment name: " + name);
+        return false;
+    }
+    std::string env = envPath(name);
+
+    struct stat st;
+    if (stat(env.c_str(), &st) == 0) {
+        logger.error("Python environment '" + name + "' already exists");
+        return false;
+    }
+    mkdir(rootPath_.c_str(), 0755);
+    mkdir((rootPath_ + "/envs").c_str(), 0755);
+
+    logger.info("Creating Python environment: " + name);
+    if (Process::run("python3 -m venv " + Process::quote(env)) != 0) {
+        logger.error("Failed to create venv: " + env);
+        return false;
+    }
+
+    std::string python = env + "/bin/python";
+    std::string purelib;
+    if (!Process::capture(Process::quote(python) +
+                          " -c 'import sysconfig; print(sysconfig.get_paths()[\"purelib\"])'",
+                          purelib)) {
+        return false;
+    }
+    purelib.erase(purelib.find_last_not_of("\n") + 1);
+
+    LinkStats stats;
+    for (const auto& wheel : wheels) {
+        std::string digest = wheelDigest(wheel);
+        if (digest.empty() || !unpackWheel(digest)) {
+            logger.error("Wheel not in store: " + wheel);
+            return false;
+        }
+
+        // 普通文件进 site-packages；<名称>.data/ 按 wheel 规范分别放置
+        std::string store = rootPath_ + "/store/" + digest;
+        for (const auto& top : listDirectory(store)) {
+            std::string src = store + "/" + top;
+            bool ok = true;
+            if (endsWith(top, ".data")) {
+                for (const auto& scheme : listDirectory(src)) {
+                    std::string dataDir = src + "/" + scheme;
+                    if (scheme == "purelib" || scheme == "platlib") {
+                        ok = linkTree(dataDir, purelib, stats) && ok;
+                    } else if (scheme == "scripts") {
+                        ok = installScripts(dataDir, env + "/bin", python) && ok;
+                    } else if (scheme == "data") {
+                        ok = linkTree(dataDir, env, stats) && ok;
+                    } else if (scheme == "headers") {
+                        ok = linkTree(dataDir, env + "/include", stats) && ok;
+                    }
+                }
+            } else {
+                struct stat entry;
+                if (lstat(src.c_str(), &entry) != 0) {
+                    ok = false;
+                } else if (S_ISDIR(entry.st_mode)) {
+                    ok = linkTree(src, purelib + "/" + top, stats);
+                    if (endsWith(top, ".dist-info")) {
+                        installEntryPoints(src, env + "/bin", python);
+                    }
+                } else {
+                    ok = placeFile(src, purelib + "/" + top, entry, stats);
+                }
+            }
+            if (!ok) {
+                logger.error("Failed to populate environment from " + wheel);
+                return false;
+            }
+        }
+    }
+
+    std::string manifest;
+    for (const auto& wheel : wheels) {
+        manifest += wheel + "\n";
+    }
+    bool written = FileUtils::writeFileAtomic(env + "/.xkl-wheels", manifest);
+
+    logger.success("Python environment '" + name + "' ready: " +
+                   std::to_string(stats.hardlinked) + " hardlinked, " +
+                   std::to_string(stats.reflinked) + " reflinked, " +
+                   std::to_string(stats.copied) + " copied");
+    return written;
+}
+
+bool PythonEnvManager::removeEnv(const std::string& name, std::uint64_t* reclaimedBytes) {
+    std::string env = envPath(name);
+    struct stat st;
+    if (!validEnvName(name) || stat(env.c_str(), &st) != 0) {
+        return false;
+    }
+    return FileUtils::discard(env, reclaimedBytes);
+}
+
+std::vector<std::string> PythonEnvManager::listEnvs() const {
+    std::vector<std::string> envs;
+    for (const auto& name : listDirectory(rootPath_ + "/envs")) {
+        struct stat st;
+        if (stat((envPath(name) + "/pyvenv.cfg").c_str(), &st) == 0) {
+            envs.push_back(name);
+        }
+    }
+    return envs;
+}
+
+bool PythonEnvManager::readEnvWheels(const std::string& name, std::vector<std::string>& wheels) const {
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(envPath(name) + "/.xkl-wheels", lines)) {
+        return false;
+    }
+    wheels.clear();
+    for (const auto& line : lines) {
+        if (!line.empty()) {
+            wheels.push_back(line);
+        }
+    }
+    return true;
+}
+
+size_t PythonEnvManager::collectGarbage() {
+    std::set<std::string> referenced;
+    for (const auto& name : listEnvs()) {
+        std::vector<std::string> wheels;
+        readEnvWheels(name, wheels);
+        for (const auto& wheel : wheels) {
+            referenced.insert(wheelDigest(wheel));
+        }
+    }
+    // 锁文件固定的 wheel 同样保留：按锁文件应用时直接从仓库取，不再下载
+    for (const auto& file : listDirectory(SceneLock::directory())) {
+        SceneLock lock;
+        if (!endsWith(file, ".lock") || !lock.load(SceneLock::directory() + "/" + file)) {
+            continue;
+        }
+        for (const auto& plugin : lock.wheels) {
+            for (const auto& wheel : plugin.second) {
+                referenced.insert(wheelDigest(wheel));
+            }
+        }
+    }
+
+    size_t removed = 0;
+    for (const auto& file : listDirectory(rootPath_ + "/wheels")) {
+        if (!endsWith(file, ".whl")) {
+            continue;
+        }
+        std::string digest = file.substr(0, file.size() - 4);
+        if (referenced.count(digest) == 0) {
+            unlink((rootPath_ + "/wheels/" + file).c_str());
+            FileUtils::removeTree(rootPath_ + "/store/" + digest);
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+} // namespace LinuxStudio
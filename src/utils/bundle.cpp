@@ -0,0 +1,516 @@
+#include "linuxstudio/bundle.hpp"
+#include "linuxstudio/hash.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef LINUXSTUDIO_HAVE_ZSTD
+    #include <zstd.h>
+#endif
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+    #include <zlib.h>
+#endif
+
+namespace LinuxStudio {
+
+namespace {
+
+const char kMagic[8] = {'X', 'K', 'L', 'B', 'N', 'D', 'L', '1'};
+const char kIndexMagic[8] = {'X', 'K', 'L', 'I', 'N', 'D', 'X', '1'};
+const std::size_t kHeaderSize = 16;
+const std::size_t kTrailerSize = 32;
+const std::size_t kFrameHeader = 8;
+
+// 帧越小，解压时占用的内存越少；帧之间互相独立，同一成员的多个帧也可以并行压缩
+#ifdef LINUXSTUDIO_EMBEDDED
+const std::uint32_t kFrameSize = 1024 * 1024;
+#else
+const std::uint32_t kFrameSize = 4 * 1024 * 1024;
+#endif
+
+const int kZstdLevel = 3;
+const int kZlibLevel = 6;
+
+// 索引直接映射为 Entry 数组，两端的字节序与结构布局必须一致
+static_assert(sizeof(Bundle::Entry) == 72, "Bundle::Entry is an on-disk format");
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+const bool kLittleEndian = false;
+#else
+const bool kLittleEndian = true;
+#endif
+
+bool writeAll(int fd, const void* data, std::size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = ::write(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool preadAll(int fd, char* data, std::size_t size, std::uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+    return true;
+}
+
+void putU32(char* p, std::uint32_t value) {
+    std::memcpy(p, &value, sizeof(value));
+}
+
+std::uint32_t getU32(const unsigned char* p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::uint64_t getU64(const unsigned char* p) {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief 64 位十六进制摘要 -> 32 字节
+ */
+void digestBytes(const std::string& hex, unsigned char* out) {
+    for (std::size_t i = 0; i < 32; ++i) {
+        out[i] = static_cast<unsigned char>(std::strtoul(hex.substr(i * 2, 2).c_str(), nullptr, 16));
+    }
+}
+
+std::string digestHex(const unsigned char* bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(64, '0');
+    for (std::size_t i = 0; i < 32; ++i) {
+        hex[i * 2] = digits[bytes[i] >> 4];
+        hex[i * 2 + 1] = digits[bytes[i] & 0x0f];
+    }
+    return hex;
+}
+
+bool codecSupported(Bundle::Codec codec) {
+    switch (codec) {
+        case Bundle::Codec::None:
+            return true;
+        case Bundle::Codec::Zlib:
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Bundle::Codec::Zstd:
+#ifdef LINUXSTUDIO_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+/**
+ * @brief 压缩一帧（含 8 字节帧头）；压缩后不比原始数据小时原样保存
+ */
+void encodeFrame(Bundle::Codec codec, const char* raw, std::size_t size, std::string& frame) {
+    std::size_t stored = 0;
+    if (codec == Bundle::Codec::Zstd) {
+#ifdef LINUXSTUDIO_HAVE_ZSTD
+        frame.resize(kFrameHeader + ZSTD_compressBound(size));
+        std::size_t n = ZSTD_compress(&frame[kFrameHeader], frame.size() - kFrameHeader, raw, size, kZstdLevel);
+        stored = ZSTD_isError(n) ? 0 : n;
+#endif
+    } else if (codec == Bundle::Codec::Zlib) {
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+        uLongf n = compressBound(static_cast<uLong>(size));
+        frame.resize(kFrameHeader + n);
+        int rc = compress2(reinterpret_cast<Bytef*>(&frame[kFrameHeader]), &n,
+                           reinterpret_cast<const Bytef*>(raw), static_cast<uLong>(size), kZlibLevel);
+        stored = rc == Z_OK ? n : 0;
+#endif
+    }
+    if (stored == 0 || stored >= size) {
+        frame.resize(kFrameHeader + size);
+        std::memcpy(&frame[kFrameHeader], raw, size);
+        stored = size;
+    }
+    frame.resize(kFrameHeader + stored);
+    putU32(&frame[0], static_cast<std::uint32_t>(stored));
+    putU32(&frame[4], static_cast<std::uint32_t>(size));
+}
+
+bool decodeFrame(Bundle::Codec codec, const unsigned char* data, std::size_t stored, char* raw, std::size_t size) {
+    if (stored == size) {
+        std::memcpy(raw, data, size);
+        return true;
+    }
+    if (codec == Bundle::Codec::Zstd) {
+#ifdef LINUXSTUDIO_HAVE_ZSTD
+        std::size_t n = ZSTD_decompress(raw, size, data, stored);
+        return !ZSTD_isError(n) && n == size;
+#endif
+    } else if (codec == Bundle::Codec::Zlib) {
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+        uLongf n = static_cast<uLongf>(size);
+        return uncompress(reinterpret_cast<Bytef*>(raw), &n, data, static_cast<uLong>(stored)) == Z_OK && n == size;
+#endif
+    }
+    return false;
+}
+
+} // namespace
+
+Bundle::Codec Bundle::defaultCodec() {
+#if defined(LINUXSTUDIO_HAVE_ZSTD)
+    return Codec::Zstd;
+#elif defined(LINUXSTUDIO_HAVE_ZLIB)
+    return Codec::Zlib;
+#else
+    return Codec::None;
+#endif
+}
+
+const char* Bundle::codecName(Codec codec) {
+    switch (codec) {
+        case Codec::Zstd:
+            return "zstd";
+        case Codec::Zlib:
+            return "zlib";
+        default:
+            return "none";
+    }
+}
+
+bool Bundle::safeName(std::string_view name) {
+    if (name.empty() || name.front() == '/' || name.find('\0') != std::string_view::npos) {
+        return false;
+    }
+    std::size_t begin = 0;
+    for (;;) {
+        std::size_t end = name.find('/', begin);
+        std::string_view segment = name.substr(begin, end - begin);   // end 为 npos 时取到末尾
+        if (segment.empty() || segment == "." || segment == "..") {
+            return false;
+        }
+        if (end == std::string_view::npos) {
+            return true;
+        }
+        begin = end + 1;
+    }
+}
+
+void Bundle::add(const std::string& name, const std::string& source) {
+    sources_.push_back({name, source});
+}
+
+bool Bundle::write(const std::string& path, Report& report) const {
+    auto start = std::chrono::steady_clock::now();
+    report = Report();
+    if (!kLittleEndian) {
+        return false;
+    }
+
+    for (const auto& source : sources_) {
+        if (!safeName(source.name)) {
+            return false;
+        }
+    }
+
+    // 按名称排序后索引可以直接二分查找；同名成员只保留第一个
+    std::vector<Source> sources = sources_;
+    std::stable_sort(sources.begin(), sources.end(),
+                     [](const Source& a, const Source& b) { return a.name < b.name; });
+    sources.erase(std::unique(sources.begin(), sources.end(),
+                              [](const Source& a, const Source& b) { return a.name == b.name; }),
+                  sources.end());
+
+    // 先并行计算摘要：索引里要有，缺失的源文件也能在写任何数据之前发现
+    std::vector<Entry> entries(sources.size());
+    std::vector<std::string> digests(sources.size());
+    FileUtils::parallelFor(sources.size(), [&](std::size_t i) {
+        struct stat st;
+        if (stat(sources[i].path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) ||
+            !Sha256::hashFile(sources[i].path, digests[i])) {
+            digests[i].clear();
+            return;
+        }
+        Entry& entry = entries[i];
+        std::memset(&entry, 0, sizeof(entry));
+        entry.size = static_cast<std::uint64_t>(st.st_size);
+        entry.mode = static_cast<std::uint32_t>(st.st_mode & 07777);
+        entry.frames = static_cast<std::uint32_t>((entry.size + kFrameSize - 1) / kFrameSize);
+    });
+    std::string names;
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        if (digests[i].size() != 64) {
+            return false;
+        }
+        digestBytes(digests[i], entries[i].sha256);
+        entries[i].nameOffset = static_cast<std::uint32_t>(names.size());
+        entries[i].nameLength = static_cast<std::uint32_t>(sources[i].name.size());
+        names += sources[i].name;
+    }
+
+    std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    Codec codec = defaultCodec();
+    char header[kHeaderSize] = {};
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    putU32(header + 8, kFrameSize);
+    header[12] = static_cast<char>(codec);
+    bool ok = writeAll(fd, header, sizeof(header));
+    std::uint64_t offset = kHeaderSize;
+
+    // 所有成员的帧排成一列，每批交给工作线程读取并压缩，再按顺序写出；
+    // 同时在途的只有一批，内存占用与成员大小无关
+    std::vector<std::pair<std::size_t, std::uint32_t>> jobs;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        for (std::uint32_t frame = 0; frame < entries[i].frames; ++frame) {
+            jobs.emplace_back(i, frame);
+        }
+    }
+    std::size_t batch = std::max<std::size_t>(2, FileUtils::ioThreads() * 2);
+    std::vector<std::string> frames(batch);
+    std::vector<std::uint8_t> failed(batch);
+    for (std::size_t first = 0; ok && first < jobs.size(); first += batch) {
+        std::size_t count = std::min(batch, jobs.size() - first);
+        FileUtils::parallelFor(count, [&](std::size_t i) {
+            const Entry& entry = entries[jobs[first + i].first];
+            std::uint64_t begin = static_cast<std::uint64_t>(jobs[first + i].second) * kFrameSize;
+            std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(kFrameSize, entry.size - begin));
+            std::string raw(size, '\0');
+            int in = ::open(sources[jobs[first + i].first].path.c_str(), O_RDONLY | O_CLOEXEC);
+            failed[i] = in < 0 || !preadAll(in, &raw[0], size, begin);
+            if (in >= 0) {
+                close(in);
+            }
+            if (!failed[i]) {
+                encodeFrame(codec, raw.data(), size, frames[i]);
+            }
+        });
+        for (std::size_t i = 0; ok && i < count; ++i) {
+            Entry& entry = entries[jobs[first + i].first];
+            if (jobs[first + i].second == 0) {
+                entry.offset = offset;
+            }
+            ok = !failed[i] && writeAll(fd, frames[i].data(), frames[i].size());
+            entry.stored += frames[i].size();
+            offset += frames[i].size();
+        }
+    }
+    for (auto& entry : entries) {
+        if (entry.frames == 0) {
+            entry.offset = offset;
+        }
+        report.bytes += entry.size;
+    }
+
+    // 索引按 8 字节对齐，映射后可以直接当作 Entry 数组使用
+    std::uint64_t padding = (8 - offset % 8) % 8;
+    std::uint64_t indexOffset = offset + padding;
+    char trailer[kTrailerSize] = {};
+    std::uint64_t count = entries.size();
+    std::uint64_t namesSize = names.size();
+    std::memcpy(trailer, &indexOffset, 8);
+    std::memcpy(trailer + 8, &count, 8);
+    std::memcpy(trailer + 16, &namesSize, 8);
+    std::memcpy(trailer + 24, kIndexMagic, sizeof(kIndexMagic));
+    const char zeros[8] = {};
+    ok = ok && writeAll(fd, zeros, padding) &&
+         writeAll(fd, entries.data(), entries.size() * sizeof(Entry)) &&
+         writeAll(fd, names.data(), names.size()) &&
+         writeAll(fd, trailer, sizeof(trailer));
+    ok = (fdatasync(fd) == 0) && ok;
+    ok = (close(fd) == 0) && ok;
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    report.members = entries.size();
+    report.stored = indexOffset + count * sizeof(Entry) + namesSize + kTrailerSize;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+Bundle::~Bundle() {
+    if (map_ != nullptr) {
+        munmap(const_cast<unsigned char*>(map_), mapSize_);
+    }
+}
+
+bool Bundle::open(const std::string& path) {
+    if (!kLittleEndian || map_ != nullptr) {
+        return false;
+    }
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < kHeaderSize + kTrailerSize) {
+        close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    map_ = static_cast<const unsigned char*>(map);
+    mapSize_ = static_cast<std::size_t>(st.st_size);
+
+    const unsigned char* trailer = map_ + mapSize_ - kTrailerSize;
+    std::uint64_t indexOffset = getU64(trailer);
+    std::uint64_t count = getU64(trailer + 8);
+    std::uint64_t namesSize = getU64(trailer + 16);
+    codec_ = static_cast<Codec>(map_[12]);
+    frameSize_ = getU32(map_ + 8);
+    bool valid = std::memcmp(map_, kMagic, sizeof(kMagic)) == 0 &&
+                 std::memcmp(trailer + 24, kIndexMagic, sizeof(kIndexMagic)) == 0 &&
+                 codecSupported(codec_) && frameSize_ > 0 && indexOffset % 8 == 0 &&
+                 indexOffset >= kHeaderSize && count <= mapSize_ / sizeof(Entry) &&
+                 indexOffset + count * sizeof(Entry) + namesSize + kTrailerSize == mapSize_;
+    if (!valid) {
+        munmap(const_cast<unsigned char*>(map_), mapSize_);
+        map_ = nullptr;
+        return false;
+    }
+    entries_ = reinterpret_cast<const Entry*>(map_ + indexOffset);
+    count_ = static_cast<std::size_t>(count);
+    names_ = reinterpret_cast<const char*>(map_ + indexOffset + count * sizeof(Entry));
+
+    // 只检查索引项是否越界与成员名，帧内容在解压时校验
+    for (std::size_t i = 0; i < count_; ++i) {
+        const Entry& entry = entries_[i];
+        if (entry.nameOffset + static_cast<std::uint64_t>(entry.nameLength) > namesSize ||
+            entry.offset + entry.stored > indexOffset || !safeName(name(entry))) {
+            munmap(const_cast<unsigned char*>(map_), mapSize_);
+            map_ = nullptr;
+            count_ = 0;
+            return false;
+        }
+    }
+    // 成员大多只读一遍
+    madvise(const_cast<unsigned char*>(map_), mapSize_, MADV_SEQUENTIAL);
+    return true;
+}
+
+std::string_view Bundle::name(const Entry& entry) const {
+    return std::string_view(names_ + entry.nameOffset, entry.nameLength);
+}
+
+std::string Bundle::digest(const Entry& entry) {
+    return digestHex(entry.sha256);
+}
+
+const Bundle::Entry* Bundle::find(std::string_view name) const {
+    const Entry* end = entries_ + count_;
+    const Entry* it = std::lower_bound(entries_, end, name, [this](const Entry& entry, std::string_view key) {
+        return this->name(entry) < key;
+    });
+    return (it != end && this->name(*it) == name) ? it : nullptr;
+}
+
+std::vector<const Bundle::Entry*> Bundle::list(std::string_view prefix) const {
+    std::vector<const Entry*> found;
+    const Entry* end = entries_ + count_;
+    const Entry* it = std::lower_bound(entries_, end, prefix, [this](const Entry& entry, std::string_view key) {
+        return this->name(entry) < key;
+    });
+    for (; it != end && name(*it).substr(0, prefix.size()) == prefix; ++it) {
+        found.push_back(it);
+    }
+    return found;
+}
+
+template <typename Sink>
+bool Bundle::decode(const Entry& entry, Sink&& sink) const {
+    std::string raw;
+    Sha256 hasher;
+    std::uint64_t position = entry.offset;
+    std::uint64_t end = entry.offset + entry.stored;
+    std::uint64_t total = 0;
+    for (std::uint32_t frame = 0; frame < entry.frames; ++frame) {
+        if (position + kFrameHeader > end) {
+            return false;
+        }
+        std::uint32_t stored = getU32(map_ + position);
+        std::uint32_t size = getU32(map_ + position + 4);
+        if (size > frameSize_ || position + kFrameHeader + stored > end) {
+            return false;
+        }
+        raw.resize(size);
+        if (!decodeFrame(codec_, map_ + position + kFrameHeader, stored, &raw[0], size)) {
+            return false;
+        }
+        hasher.update(raw.data(), raw.size());
+        if (!sink(raw)) {
+            return false;
+        }
+        // 已解压的部分不再需要，小内存设备上及早让出页缓存
+        std::uint64_t pageMask = ~static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE) - 1);
+        std::uint64_t dropBegin = position & pageMask;
+        std::uint64_t dropEnd = (position + kFrameHeader + stored) & pageMask;
+        if (dropEnd > dropBegin) {
+            madvise(const_cast<unsigned char*>(map_) + dropBegin, dropEnd - dropBegin, MADV_DONTNEED);
+        }
+        position += kFrameHeader + stored;
+        total += size;
+    }
+    return total == entry.size && position == end && hasher.hexDigest() == digestHex(entry.sha256);
+}
+
+bool Bundle::extract(const Entry& entry, const std::string& path) const {
+    std::string tmpPath = path + ".part." + std::to_string(getpid());
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = decode(entry, [fd](const std::string& raw) { return writeAll(fd, raw.data(), raw.size()); });
+    ok = ok && fchmod(fd, static_cast<mode_t>(entry.mode & 07777)) == 0;
+    ok = (close(fd) == 0) && ok;
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool Bundle::read(const Entry& entry, std::string& content) const {
+    content.clear();
+    content.reserve(static_cast<std::size_t>(entry.size));
+    return decode(entry, [&content](const std::string& raw) {
+        content += raw;
+        return true;
+    });
+}
+
+} // namespace LinuxStudio
@@ -0,0 +1,475 @@
+#include "linuxstudio/disk_usage.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <climits>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+const char* kDpkgInfoDir = "/var/lib/dpkg/info";
+
+using InodeKey = std::pair<std::uint64_t, std::uint64_t>;
+
+std::int64_t toNs(const struct statx_timestamp& ts) {
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+std::uint64_t deviceOf(const struct statx& st) {
+    return static_cast<std::uint64_t>(makedev(st.stx_dev_major, st.stx_dev_minor));
+}
+
+// 缓存为制表符分隔的文本，名字里带制表符/换行的目录不缓存
+bool cacheable(const std::string& name) {
+    return name.find_first_of("\t\n") == std::string::npos;
+}
+
+} // namespace
+
+DiskUsage::DiskUsage(const std::string& cachePath, bool refresh)
+    : cachePath_(cachePath), refresh_(refresh), dirty_(false), dpkgIndexed_(false) {
+    loadCache();
+}
+
+DiskUsage::~DiskUsage() {
+    save();
+}
+
+void DiskUsage::loadCache() {
+    if (refresh_) {
+        return;
+    }
+    // D<TAB>mtime<TAB>字节<TAB>文件数<TAB>路径，随后是该目录的 S（子目录）与 H（硬链接）行
+    // P<TAB>list mtime<TAB>字节<TAB>文件数<TAB>包名
+    std::vector<std::string> lines;
+    FileUtils::readLines(cachePath_, lines);
+    DirRecord* current = nullptr;
+    for (const auto& line : lines) {
+        if (line.size() < 2 || line[1] != '\t') {
+            continue;
+        }
+        const char* fields = line.c_str() + 2;
+        char* end = nullptr;
+        if (line[0] == 'D') {
+            DirRecord record;
+            record.mtimeNs = std::strtoll(fields, &end, 10);
+            record.bytes = std::strtoull(end, &end, 10);
+            record.files = std::strtoull(end, &end, 10);
+            if (*end == '\t' && end[1] != '\0') {
+                current = &(dirs_[end + 1] = std::move(record));
+            } else {
+                current = nullptr;
+            }
+        } else if (line[0] == 'S' && current) {
+            current->subdirs.push_back(fields);
+        } else if (line[0] == 'H' && current) {
+            InodeKey key;
+            key.first = std::strtoull(fields, &end, 10);
+            key.second = std::strtoull(end, &end, 10);
+            std::uint64_t bytes = std::strtoull(end, &end, 10);
+            current->hardlinks.push_back({key, bytes});
+        } else if (line[0] == 'P') {
+            PackageRecord record;
+            record.listMtimeNs = std::strtoll(fields, &end, 10);
+            record.totals.bytes = std::strtoull(end, &end, 10);
+            record.totals.files = std::strtoull(end, &end, 10);
+            if (*end == '\t' && end[1] != '\0') {
+                packages_[end + 1] = record;
+            }
+        }
+    }
+}
+
+bool DiskUsage::save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_) {
+        return true;
+    }
+
+    std::string content;
+    // 本次统计过的目录树里没再遍历到的目录（已删除）随之淘汰，其他目录树的记录原样保留
+    for (const auto& entry : dirs_) {
+        if (visitedDirs_.count(entry.first) == 0 && underMeasuredRoot(entry.first)) {
+            continue;
+        }
+        const DirRecord& record = entry.second;
+        content += "D\t" + std::to_string(record.mtimeNs) + "\t" + std::to_string(record.bytes) +
+                   "\t" + std::to_string(record.files) + "\t" + entry.first + "\n";
+        for (const auto& subdir : record.subdirs) {
+            content += "S\t" + subdir + "\n";
+        }
+        for (const auto& link : record.hardlinks) {
+            content += "H\t" + std::to_string(link.first.first) + "\t" +
+                       std::to_string(link.first.second) + "\t" + std::to_string(link.second) + "\n";
+        }
+    }
+    for (const auto& entry : packages_) {
+        const PackageRecord& record = entry.second;
+        content += "P\t" + std::to_string(record.listMtimeNs) + "\t" +
+                   std::to_string(record.totals.bytes) + "\t" + std::to_string(record.totals.files) +
+                   "\t" + entry.first + "\n";
+    }
+
+    mkdir("/opt/linuxstudio/data", 0755);
+    if (!FileUtils::writeFileAtomic(cachePath_, content)) {
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+bool DiskUsage::underMeasuredRoot(const std::string& path) const {
+    for (const auto& root : measuredRoots_) {
+        if (path.compare(0, root.size(), root) == 0 &&
+            (path.size() == root.size() || path[root.size()] == '/')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DiskUsage::forget(const std::string& path) {
+    char resolved[PATH_MAX];
+    std::string root = realpath(path.c_str(), resolved) ? resolved : path;
+    std::lock_guard<std::mutex> lock(mutex_);
+    measuredRoots_.push_back(root);
+    for (auto it = visitedDirs_.begin(); it != visitedDirs_.end();) {
+        it = underMeasuredRoot(*it) ? visitedDirs_.erase(it) : std::next(it);
+    }
+    dirty_ = true;
+}
+
+bool DiskUsage::readDirectory(const std::string& path, std::int64_t mtimeNs, std::uint64_t dirBytes,
+                              DirRecord& record) {
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    record.mtimeNs = mtimeNs;
+    record.bytes = dirBytes;
+    record.files = 0;
+    record.subdirs.clear();
+    record.hardlinks.clear();
+
+    bool ok = FileUtils::readEntries(fd, [&](const char* name, unsigned char type) {
+        if (type == DT_DIR) {
+            record.subdirs.push_back(name);
+            return;
+        }
+        struct statx st;
+        if (statx(fd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT,
+                  STATX_TYPE | STATX_BLOCKS | STATX_INO | STATX_NLINK, &st) != 0) {
+            return;
+        }
+        if (S_ISDIR(st.stx_mode)) {
+            // 部分文件系统不填 d_type（DT_UNKNOWN）
+            record.subdirs.push_back(name);
+            return;
+        }
+        std::uint64_t bytes = st.stx_blocks * 512;
+        ++record.files;
+        if (st.stx_nlink > 1) {
+            record.hardlinks.push_back({InodeKey(deviceOf(st), st.stx_ino), bytes});
+        } else {
+            record.bytes += bytes;
+        }
+    });
+    close(fd);
+    return ok;
+}
+
+DiskUsage::Totals DiskUsage::measureTrees(const std::vector<std::string>& roots) {
+    std::vector<std::string> resolvedRoots;
+    for (const auto& root : roots) {
+        char resolved[PATH_MAX];
+        if (realpath(root.c_str(), resolved) != nullptr) {
+            resolvedRoots.push_back(resolved);
+        }
+    }
+    if (resolvedRoots.empty()) {
+        return Totals();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        measuredRoots_.insert(measuredRoots_.end(), resolvedRoots.begin(), resolvedRoots.end());
+    }
+
+    std::set<InodeKey> seenInodes;
+    std::set<std::string> seenDirs;
+    std::mutex totalsMutex;
+    Totals totals;
+
+    FileUtils::walkParallel(resolvedRoots, [&](const std::string& path, std::vector<std::string>& children) {
+        // 多个根可能互相包含，同一目录只统计一次
+        {
+            std::lock_guard<std::mutex> lock(totalsMutex);
+            if (!seenDirs.insert(path).second) {
+                return;
+            }
+        }
+
+        struct statx st;
+        if (statx(AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT,
+                  STATX_TYPE | STATX_MTIME | STATX_BLOCKS, &st) != 0 || !S_ISDIR(st.stx_mode)) {
+            return;
+        }
+        std::int64_t mtimeNs = toNs(st.stx_mtime);
+
+        DirRecord record;
+        bool cached = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = dirs_.find(path);
+            if (it != dirs_.end() && it->second.mtimeNs == mtimeNs) {
+                record = it->second;
+                visitedDirs_.insert(path);
+                cached = true;
+            }
+        }
+        if (!cached) {
+            if (!readDirectory(path, mtimeNs, st.stx_blocks * 512, record)) {
+                return;
+            }
+            if (cacheable(path)) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                dirs_[path] = record;
+                visitedDirs_.insert(path);
+                dirty_ = true;
+            }
+        }
+
+        for (const auto& subdir : record.subdirs) {
+            children.push_back(path + "/" + subdir);
+        }
+
+        std::lock_guard<std::mutex> lock(totalsMutex);
+        totals.bytes += record.bytes;
+        totals.files += record.files;
+        for (const auto& link : record.hardlinks) {
+            if (seenInodes.insert(link.first).second) {
+                totals.bytes += link.second;
+                totals.linkedBytes += link.second;
+            }
+        }
+    });
+    return totals;
+}
+
+void DiskUsage::indexDpkg() {
+    if (dpkgIndexed_) {
+        return;
+    }
+    dpkgIndexed_ = true;
+
+    int fd = open(kDpkgInfoDir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    FileUtils::readEntries(fd, [this](const char* name, unsigned char) {
+        size_t length = std::strlen(name);
+        if (length <= 5 || std::strcmp(name + length - 5, ".list") != 0) {
+            return;
+        }
+        // 多架构包的列表名为 <包>:<架构>.list
+        std::string package(name, length - 5);
+        size_t colon = package.find(':');
+        if (colon != std::string::npos) {
+            package.resize(colon);
+        }
+        dpkgLists_[package] = std::string(kDpkgInfoDir) + "/" + name;
+    });
+    close(fd);
+}
+
+std::vector<std::string> DiskUsage::matchPackages(const std::vector<std::string>& patterns) {
+    indexDpkg();
+    std::vector<std::string> matched;
+    for (const auto& pattern : patterns) {
+        if (!pattern.empty() && pattern.back() == '*') {
+            std::string prefix = pattern.substr(0, pattern.size() - 1);
+            for (auto it = dpkgLists_.lower_bound(prefix);
+                 it != dpkgLists_.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+                matched.push_back(it->first);
+            }
+        } else if (dpkgLists_.count(pattern)) {
+            matched.push_back(pattern);
+        }
+    }
+    std::sort(matched.begin(), matched.end());
+    matched.erase(std::unique(matched.begin(), matched.end()), matched.end());
+    return matched;
+}
+
+DiskUsage::Totals DiskUsage::measurePackage(const std::string& listPath) {
+    // 只统计普通文件和符号链接：目录由多个包共享，不归属任何一个包
+    Totals totals;
+    std::set<InodeKey> seen;
+    std::vector<std::string> paths;
+    FileUtils::readLines(listPath, paths);
+    for (const auto& path : paths) {
+        struct statx st;
+        if (path.empty() || statx(AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT,
+                                  STATX_TYPE | STATX_BLOCKS | STATX_INO | STATX_NLINK, &st) != 0 ||
+            S_ISDIR(st.stx_mode)) {
+            continue;
+        }
+        if (st.stx_nlink > 1) {
+            if (!seen.insert(InodeKey(deviceOf(st), st.stx_ino)).second) {
+                continue;
+            }
+            totals.linkedBytes += st.stx_blocks * 512;
+        }
+        totals.bytes += st.stx_blocks * 512;
+        ++totals.files;
+    }
+    return totals;
+}
+
+std::vector<std::string> DiskUsage::packageFiles(const std::string& package) {
+    indexDpkg();
+    std::vector<std::string> files;
+    auto list = dpkgLists_.find(package);
+    if (list == dpkgLists_.end()) {
+        return files;
+    }
+
+    std::vector<std::string> conffiles;
+    std::string base = list->second.substr(0, list->second.size() - 5);
+    FileUtils::readLines(base + ".conffiles", conffiles);
+    std::set<std::string> skipped;
+    for (const auto& line : conffiles) {
+        skipped.insert(line.substr(0, line.find(' ')));  // 可能带 " remove-on-upgrade" 等标记
+    }
+
+    std::vector<std::string> paths;
+    FileUtils::readLines(list->second, paths);
+    for (const auto& path : paths) {
+        struct stat st;
+        if (path.empty() || skipped.count(path) > 0 || lstat(path.c_str(), &st) != 0 || S_ISDIR(st.st_mode)) {
+            continue;
+        }
+        files.push_back(path);
+    }
+    return files;
+}
+
+std::vector<std::string> DiskUsage::packageContents(const std::string& package) {
+    // dpkg 为每个包维护的元数据文件（维护脚本、摘要、触发器等）
+    static const char* const kInfoSuffixes[] = {
+        ".list", ".md5sums", ".conffiles", ".preinst", ".postinst", ".prerm", ".postrm",
+        ".config", ".templates", ".triggers", ".shlibs", ".symbols",
+    };
+
+    indexDpkg();
+    std::vector<std::string> paths;
+    auto list = dpkgLists_.find(package);
+    if (list == dpkgLists_.end()) {
+        return paths;
+    }
+    FileUtils::readLines(list->second, paths);
+    paths.erase(std::remove(paths.begin(), paths.end(), std::string()), paths.end());
+
+    std::string base = list->second.substr(0, list->second.size() - 5);
+    for (const char* suffix : kInfoSuffixes) {
+        struct stat st;
+        if (lstat((base + suffix).c_str(), &st) == 0) {
+            paths.push_back(base + suffix);
+        }
+    }
+    return paths;
+}
+
+std::map<std::string, DiskUsage::Totals> DiskUsage::measurePackages(const std::vector<std::string>& packages) {
+    indexDpkg();
+    std::map<std::string, Totals> results;
+    std::vector<std::string> pending;
+    for (const auto& package : packages) {
+        results[package] = Totals();
+        if (dpkgLists_.count(package)) {
+            pending.push_back(package);
+        }
+    }
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            const std::string& package = pending[i];
+            const std::string& listPath = dpkgLists_.at(package);
+            struct statx st;
+            if (statx(AT_FDCWD, listPath.c_str(), 0, STATX_MTIME, &st) != 0) {
+                continue;
+            }
+            std::int64_t mtimeNs = toNs(st.stx_mtime);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = packages_.find(package);
+                if (it != packages_.end() && it->second.listMtimeNs == mtimeNs) {
+                    results[package] = it->second.totals;
+                    continue;
+                }
+            }
+
+            Totals totals = measurePackage(listPath);
+            std::lock_guard<std::mutex> lock(mutex_);
+            results[package] = totals;
+            packages_[package] = PackageRecord{mtimeNs, totals};
+            dirty_ = true;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    unsigned count = static_cast<unsigned>(std::min<size_t>(FileUtils::ioThreads(), pending.size()));
+    for (unsigned i = 0; i < count; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    return results;
+}
+
+std::string DiskUsage::formatBytes(std::uint64_t bytes) {
+    static const char* kUnits[] = {"B", "KB", "MB", "GB", "TB"};
+    double value = static_cast<double>(bytes);
+    int unit = 0;
+    while (value >= 1024 && unit < 4) {
+        value /= 1024;
+        ++unit;
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.1f %s", value, kUnits[unit]);
+    return text;
+}
+
+bool DiskUsage::parseBytes(const std::string& text, std::uint64_t& bytes) {
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str()) {
+        return false;
+    }
+    switch (*end) {
+        case 'k': case 'K': value <<= 10; break;
+        case 'm': case 'M': value <<= 20; break;
+        case 'g': case 'G': value <<= 30; break;
+        case '\0': break;
+        default: return false;
+    }
+    bytes = value;
+    return true;
+}
+
+} // namespace LinuxStudio
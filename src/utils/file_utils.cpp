@@ -1,5 +1,497 @@
-#include <string>
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/disk_usage.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
 
-// 文件工具函数
-// 此文件保留用于未来扩展
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
+namespace LinuxStudio {
+
+namespace {
+
+// getdents64 目录项布局：d_ino(8) d_off(8) d_reclen(2) d_type(1) d_name（glibc 不导出该结构）
+const size_t kDirentReclenOffset = 16;
+const size_t kDirentTypeOffset = 18;
+const size_t kDirentNameOffset = 19;
+
+// 后台删除进程的可执行文件，由 setPurger 设置；为空时同步删除
+std::mutex purgerMutex;
+std::string purgerBinary;
+
+/**
+ * @brief 启动后台删除进程（两次 fork 脱离当前会话，不留僵尸进程）
+ * @param binary xkl 可执行文件；fork 之后不再分配内存
+ */
+void spawnPurger(const std::string& binary) {
+    const char* path = binary.c_str();
+    pid_t child = fork();
+    if (child < 0) {
+        return;
+    }
+    if (child == 0) {
+        // fork 与 exec 之间只调用异步信号安全的函数
+        setsid();
+        if (fork() != 0) {
+            _exit(0);
+        }
+        int null = open("/dev/null", O_RDWR);
+        if (null >= 0) {
+            dup2(null, STDIN_FILENO);
+            dup2(null, STDOUT_FILENO);
+            dup2(null, STDERR_FILENO);
+        }
+        setpriority(PRIO_PROCESS, 0, 10);
+        execl(path, "xkl", "__purge-trash", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    int status;
+    while (waitpid(child, &status, 0) < 0 && errno == EINTR) {
+    }
+}
+
+bool copyContents(int from, int to) {
+    char buffer[1 << 16];
+    for (;;) {
+        ssize_t n = read(from, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n == 0;
+        }
+        for (ssize_t done = 0; done < n;) {
+            ssize_t w = write(to, buffer + done, static_cast<size_t>(n - done));
+            if (w < 0 && errno == EINTR) {
+                continue;
+            }
+            if (w <= 0) {
+                return false;
+            }
+            done += w;
+        }
+    }
+}
+
+} // namespace
+
+bool FileUtils::readFile(const std::string& path, std::string& content) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    content.clear();
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        content.reserve(static_cast<size_t>(st.st_size));
+    }
+    char buffer[1 << 14];
+    for (;;) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            close(fd);
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        content.append(buffer, static_cast<size_t>(n));
+    }
+    close(fd);
+    return true;
+}
+
+bool FileUtils::readLines(const std::string& path, std::vector<std::string>& lines) {
+    std::string content;
+    if (!readFile(path, content)) {
+        return false;
+    }
+    splitLines(content, lines);
+    return true;
+}
+
+bool FileUtils::writeFileAtomic(const std::string& path, const std::string& content) {
+    std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    size_t written = 0;
+    while (written < content.size()) {
+        ssize_t n = write(fd, content.data() + written, content.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    bool ok = (close(fd) == 0) && written == content.size();
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+FileUtils::Placement FileUtils::placeFile(const std::string& src, const std::string& dst, unsigned mode) {
+    unlink(dst.c_str());
+    if (link(src.c_str(), dst.c_str()) == 0) {
+        return Placement::Hardlinked;
+    }
+
+    int in = open(src.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return Placement::Failed;
+    }
+    int out = open(dst.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, static_cast<mode_t>(mode & 07777));
+    if (out < 0) {
+        close(in);
+        return Placement::Failed;
+    }
+    Placement placement = Placement::Reflinked;
+    if (ioctl(out, FICLONE, in) != 0) {
+        placement = copyContents(in, out) ? Placement::Copied : Placement::Failed;
+    }
+    close(in);
+    if (close(out) != 0 || placement == Placement::Failed) {
+        unlink(dst.c_str());
+        return Placement::Failed;
+    }
+    return placement;
+}
+
+std::string FileUtils::changeMarker(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return std::string();
+    }
+    return std::to_string(st.st_ino) + ":" + std::to_string(st.st_size) + ":" +
+           std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+}
+
+void FileUtils::splitLines(const std::string& content, std::vector<std::string>& lines) {
+    lines.clear();
+    size_t start = 0;
+    while (start < content.size()) {
+        size_t end = content.find('\n', start);
+        if (end == std::string::npos) {
+            end = content.size();
+        }
+        lines.emplace_back(content, start, end - start);
+        start = end + 1;
+    }
+}
+
+std::vector<std::string> FileUtils::splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    for (;;) {
+        size_t start = line.find_first_not_of(" \t\r", pos);
+        if (start == std::string::npos) {
+            break;
+        }
+        pos = line.find_first_of(" \t\r", start);
+        fields.push_back(line.substr(start, pos == std::string::npos ? std::string::npos : pos - start));
+        if (pos == std::string::npos) {
+            break;
+        }
+    }
+    return fields;
+}
+
+bool FileUtils::readEntries(int fd, const std::function<void(const char*, unsigned char)>& visitor) {
+    alignas(8) static thread_local char buffer[1 << 15];
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        for (long offset = 0; offset < n;) {
+            const char* entry = buffer + offset;
+            unsigned short length;
+            std::memcpy(&length, entry + kDirentReclenOffset, sizeof(length));
+            offset += length;
+            const char* name = entry + kDirentNameOffset;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+            visitor(name, static_cast<unsigned char>(entry[kDirentTypeOffset]));
+        }
+    }
+}
+
+unsigned FileUtils::ioThreads() {
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+#ifdef LINUXSTUDIO_EMBEDDED
+    // 每个线程都有自己的栈和目录项缓冲，小内存板子上少开线程
+    return std::min(2u, cores * 2);
+#else
+    return std::min(16u, std::max(4u, cores * 2));
+#endif
+}
+
+void FileUtils::parallelFor(size_t count, const std::function<void(size_t)>& work) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            work(i);
+        }
+    };
+    unsigned threads = static_cast<unsigned>(std::min<size_t>(ioThreads(), count));
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+
+void FileUtils::walkParallel(const std::vector<std::string>& roots,
+                             const std::function<void(const std::string&, std::vector<std::string>&)>& visitor) {
+    // 动态工作队列：目录树通常不平衡，按目录分发比按根分发更均匀
+    std::deque<std::string> queue(roots.begin(), roots.end());
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    size_t active = 0;
+
+    auto worker = [&]() {
+        std::vector<std::string> children;
+        for (;;) {
+            std::string path;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [&]() { return !queue.empty() || active == 0; });
+                if (queue.empty()) {
+                    break;
+                }
+                path = std::move(queue.front());
+                queue.pop_front();
+                ++active;
+            }
+
+            children.clear();
+            visitor(path, children);
+
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                for (auto& child : children) {
+                    queue.push_back(std::move(child));
+                }
+                --active;
+            }
+            queueReady.notify_all();
+        }
+    };
+
+    unsigned count = ioThreads();
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < count; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+
+bool FileUtils::removeTree(const std::string& path, std::uint64_t* reclaimedBytes) {
+    struct statx st;
+    if (statx(AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW, STATX_TYPE | STATX_BLOCKS | STATX_NLINK, &st) != 0) {
+        return errno == ENOENT;
+    }
+    if (!S_ISDIR(st.stx_mode)) {
+        if (unlink(path.c_str()) != 0) {
+            return false;
+        }
+        if (reclaimedBytes) {
+            *reclaimedBytes = (st.stx_nlink == 1) ? st.stx_blocks * 512 : 0;
+        }
+        return true;
+    }
+
+    // 第一阶段：多线程删除所有非目录项，记下目录；第二阶段：由深到浅 rmdir
+    std::atomic<std::uint64_t> bytes(0);
+    std::atomic<bool> ok(true);
+    std::mutex dirsMutex;
+    std::vector<std::pair<size_t, std::string>> dirs;  // (深度, 路径)
+
+    walkParallel({path}, [&](const std::string& dir, std::vector<std::string>& subdirs) {
+        struct statx self;
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0 || statx(fd, "", AT_EMPTY_PATH, STATX_BLOCKS, &self) != 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            ok = false;
+            return;
+        }
+
+        std::uint64_t local = self.stx_blocks * 512;
+        bool readOk = readEntries(fd, [&](const char* name, unsigned char type) {
+            if (type == DT_DIR) {
+                subdirs.push_back(dir + "/" + name);
+                return;
+            }
+            struct statx entry;
+            bool known = statx(fd, name, AT_SYMLINK_NOFOLLOW,
+                               STATX_TYPE | STATX_BLOCKS | STATX_NLINK, &entry) == 0;
+            if (known && S_ISDIR(entry.stx_mode)) {
+                // 部分文件系统不填 d_type（DT_UNKNOWN）
+                subdirs.push_back(dir + "/" + name);
+                return;
+            }
+            if (unlinkat(fd, name, 0) != 0) {
+                ok = false;
+            } else if (known && entry.stx_nlink == 1) {
+                local += entry.stx_blocks * 512;
+            }
+        });
+        close(fd);
+        if (!readOk) {
+            ok = false;
+        }
+        bytes += local;
+
+        size_t depth = static_cast<size_t>(std::count(dir.begin(), dir.end(), '/'));
+        std::lock_guard<std::mutex> lock(dirsMutex);
+        dirs.emplace_back(depth, dir);
+    });
+
+    std::sort(dirs.begin(), dirs.end(), [](const std::pair<size_t, std::string>& a,
+                                           const std::pair<size_t, std::string>& b) {
+        return a.first > b.first;
+    });
+    for (const auto& dir : dirs) {
+        if (rmdir(dir.second.c_str()) != 0) {
+            ok = false;
+        }
+    }
+
+    if (reclaimedBytes) {
+        *reclaimedBytes = bytes;
+    }
+    return ok;
+}
+
+std::string FileUtils::trashPath() {
+    const char* override = std::getenv("XKL_TRASH_DIR");
+    if (override && *override) {
+        return override;
+    }
+    return kTrashPath;
+}
+
+void FileUtils::setPurger(const std::string& binary) {
+    std::lock_guard<std::mutex> lock(purgerMutex);
+    purgerBinary = binary;
+}
+
+bool FileUtils::discard(const std::string& path, std::uint64_t* reclaimedBytes) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) {
+        return false;
+    }
+
+    if (reclaimedBytes) {
+        // 借用磁盘占用缓存估算，xkl plugin du 之后几乎不需要额外遍历
+        DiskUsage usage;
+        DiskUsage::Totals totals = usage.measureTrees({path});
+        *reclaimedBytes = totals.bytes - totals.linkedBytes;
+        usage.forget(path);
+    }
+
+    std::string trash = trashPath();
+    mkdir(trash.c_str(), 0700);
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::string trashed = trash + "/" + name + "." + std::to_string(getpid()) + "." + std::to_string(stamp);
+    if (std::rename(path.c_str(), trashed.c_str()) != 0) {
+        return removeTree(path);
+    }
+
+    std::string binary;
+    {
+        std::lock_guard<std::mutex> lock(purgerMutex);
+        binary = purgerBinary;
+    }
+    if (binary.empty()) {
+        purgeTrash();
+    } else {
+        spawnPurger(binary);
+    }
+    return true;
+}
+
+std::uint64_t FileUtils::purgeTrash() {
+    std::string trash = trashPath();
+    mkdir(trash.c_str(), 0700);
+    std::string lockPath = trash + "/.lock";
+    int lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lockFd < 0) {
+        return 0;
+    }
+    // 排队而不是放弃：正在运行的进程可能已经列完目录，错过刚移入的条目
+    flock(lockFd, LOCK_EX);
+
+    std::uint64_t total = 0;
+    for (;;) {
+        std::vector<std::string> entries;
+        int fd = open(trash.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            break;
+        }
+        readEntries(fd, [&entries, &trash](const char* name, unsigned char) {
+            if (std::strcmp(name, ".lock") != 0) {
+                entries.push_back(trash + "/" + name);
+            }
+        });
+        close(fd);
+
+        size_t removed = 0;
+        for (const auto& entry : entries) {
+            std::uint64_t bytes = 0;
+            if (removeTree(entry, &bytes)) {
+                ++removed;
+            }
+            total += bytes;
+        }
+        if (removed == 0) {
+            break;
+        }
+    }
+
+    flock(lockFd, LOCK_UN);
+    close(lockFd);
+    return total;
+}
+
+} // namespace LinuxStudio
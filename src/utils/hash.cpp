@@ -0,0 +1,313 @@
+#include "linuxstudio/hash.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+const std::uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline std::uint32_t rotr(std::uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+const std::uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+const std::uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+const std::uint64_t kPrime64_3 = 0x165667B19E3779F9ULL;
+const std::uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+const std::uint64_t kPrime64_5 = 0x27D4EB2F165667C5ULL;
+
+inline std::uint64_t rotl64(std::uint64_t x, int n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+// XXH64 按小端读取
+inline std::uint64_t read64(const unsigned char* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+inline std::uint32_t read32(const unsigned char* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+inline std::uint64_t xxhRound(std::uint64_t acc, std::uint64_t input) {
+    acc += input * kPrime64_2;
+    acc = rotl64(acc, 31);
+    return acc * kPrime64_1;
+}
+
+inline std::uint64_t xxhMerge(std::uint64_t acc, std::uint64_t value) {
+    acc ^= xxhRound(0, value);
+    return acc * kPrime64_1 + kPrime64_4;
+}
+
+} // namespace
+
+Sha256::Sha256() : length_(0), blockSize_(0) {
+    static const std::uint32_t kInitial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    std::memcpy(state_, kInitial, sizeof(state_));
+}
+
+void Sha256::transform(const unsigned char* block) {
+    std::uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (std::uint32_t(block[i * 4]) << 24) | (std::uint32_t(block[i * 4 + 1]) << 16) |
+               (std::uint32_t(block[i * 4 + 2]) << 8) | std::uint32_t(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    std::uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    std::uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (int i = 0; i < 64; ++i) {
+        std::uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        std::uint32_t ch = (e & f) ^ (~e & g);
+        std::uint32_t t1 = h + s1 + ch + kRoundConstants[i] + w[i];
+        std::uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        std::uint32_t t2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+    state_[4] += e; state_[5] += f; state_[6] += g; state_[7] += h;
+}
+
+void Sha256::update(const void* data, std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    length_ += size;
+
+    if (blockSize_ > 0) {
+        std::size_t take = std::min(size, sizeof(block_) - blockSize_);
+        std::memcpy(block_ + blockSize_, bytes, take);
+        blockSize_ += take;
+        bytes += take;
+        size -= take;
+        if (blockSize_ < sizeof(block_)) {
+            return;
+        }
+        transform(block_);
+        blockSize_ = 0;
+    }
+    while (size >= sizeof(block_)) {
+        transform(bytes);
+        bytes += sizeof(block_);
+        size -= sizeof(block_);
+    }
+    std::memcpy(block_, bytes, size);
+    blockSize_ = size;
+}
+
+std::string Sha256::hexDigest() {
+    std::uint64_t bits = length_ * 8;
+    unsigned char padding[72] = {0x80};
+    std::size_t padSize = (blockSize_ < 56) ? (56 - blockSize_) : (120 - blockSize_);
+    update(padding, padSize);
+    unsigned char lengthBytes[8];
+    for (int i = 0; i < 8; ++i) {
+        lengthBytes[i] = static_cast<unsigned char>(bits >> (56 - i * 8));
+    }
+    update(lengthBytes, sizeof(lengthBytes));
+
+    static const char kHex[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(64);
+    for (std::uint32_t word : state_) {
+        for (int shift = 28; shift >= 0; shift -= 4) {
+            hex += kHex[(word >> shift) & 0xf];
+        }
+    }
+    return hex;
+}
+
+bool Sha256::hashFile(const std::string& path, std::string& hex) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    Sha256 hasher;
+    static thread_local unsigned char buffer[1 << 16];
+    for (;;) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            close(fd);
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        hasher.update(buffer, static_cast<std::size_t>(n));
+    }
+    close(fd);
+    hex = hasher.hexDigest();
+    return true;
+}
+
+Xxh64::Xxh64(std::uint64_t seed) : seed_(seed), length_(0), stripeSize_(0) {
+    acc_[0] = seed + kPrime64_1 + kPrime64_2;
+    acc_[1] = seed + kPrime64_2;
+    acc_[2] = seed;
+    acc_[3] = seed - kPrime64_1;
+}
+
+void Xxh64::update(const void* data, std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    length_ += size;
+
+    if (stripeSize_ > 0) {
+        std::size_t take = std::min(size, sizeof(stripe_) - stripeSize_);
+        std::memcpy(stripe_ + stripeSize_, bytes, take);
+        stripeSize_ += take;
+        bytes += take;
+        size -= take;
+        if (stripeSize_ < sizeof(stripe_)) {
+            return;
+        }
+        for (int i = 0; i < 4; ++i) {
+            acc_[i] = xxhRound(acc_[i], read64(stripe_ + i * 8));
+        }
+        stripeSize_ = 0;
+    }
+
+    // 四条独立的累加链，编译器可以交错执行
+    std::uint64_t a0 = acc_[0], a1 = acc_[1], a2 = acc_[2], a3 = acc_[3];
+    while (size >= sizeof(stripe_)) {
+        a0 = xxhRound(a0, read64(bytes));
+        a1 = xxhRound(a1, read64(bytes + 8));
+        a2 = xxhRound(a2, read64(bytes + 16));
+        a3 = xxhRound(a3, read64(bytes + 24));
+        bytes += sizeof(stripe_);
+        size -= sizeof(stripe_);
+    }
+    acc_[0] = a0; acc_[1] = a1; acc_[2] = a2; acc_[3] = a3;
+
+    std::memcpy(stripe_, bytes, size);
+    stripeSize_ = size;
+}
+
+std::uint64_t Xxh64::digest() const {
+    std::uint64_t h;
+    if (length_ >= sizeof(stripe_)) {
+        h = rotl64(acc_[0], 1) + rotl64(acc_[1], 7) + rotl64(acc_[2], 12) + rotl64(acc_[3], 18);
+        for (int i = 0; i < 4; ++i) {
+            h = xxhMerge(h, acc_[i]);
+        }
+    } else {
+        h = seed_ + kPrime64_5;
+    }
+    h += length_;
+
+    const unsigned char* p = stripe_;
+    const unsigned char* end = stripe_ + stripeSize_;
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxhRound(0, read64(p));
+        h = rotl64(h, 27) * kPrime64_1 + kPrime64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<std::uint64_t>(read32(p)) * kPrime64_1;
+        h = rotl64(h, 23) * kPrime64_2 + kPrime64_3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (*p) * kPrime64_5;
+        h = rotl64(h, 11) * kPrime64_1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime64_2;
+    h ^= h >> 29;
+    h *= kPrime64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+std::string Xxh64::hexDigest() const {
+    static const char kHex[] = "0123456789abcdef";
+    std::uint64_t value = digest();
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        hex[i] = kHex[value & 0xf];
+        value >>= 4;
+    }
+    return hex;
+}
+
+bool Xxh64::hashFile(const std::string& path, std::string& hex, std::uint64_t* size) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOATIME);
+    if (fd < 0 && errno == EPERM) {
+        fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);  // 非属主不能用 O_NOATIME
+    }
+    if (fd < 0) {
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // 大缓冲区减少系统调用；哈希本身远快于磁盘，瓶颈在读取
+#ifdef LINUXSTUDIO_EMBEDDED
+    static thread_local unsigned char buffer[1 << 16];
+#else
+    static thread_local unsigned char buffer[1 << 20];
+#endif
+    Xxh64 hasher;
+    for (;;) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            close(fd);
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        hasher.update(buffer, static_cast<std::size_t>(n));
+    }
+    close(fd);
+    hex = hasher.hexDigest();
+    if (size) {
+        *size = hasher.length_;
+    }
+    return true;
+}
+
+} // namespace LinuxStudio
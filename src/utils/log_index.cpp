@@ -0,0 +1,724 @@
+#include "linuxstudio/log_index.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/hash.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+    #include <zlib.h>
+#endif
+
+namespace LinuxStudio {
+
+namespace {
+
+// 索引块大小：越小跳过得越精确，索引也越大
+#ifdef LINUXSTUDIO_EMBEDDED
+const std::size_t kBlockSize = 16 << 10;
+#else
+const std::size_t kBlockSize = 64 << 10;
+#endif
+
+const std::size_t kBloomBits = 2048;
+const std::size_t kBloomBytes = kBloomBits / 8;
+const char* const kIndexMagic = "xkl-logidx-1";
+
+// 日志行布局："[YYYY-MM-DD HH:MM:SS] [LEVEL] 消息"
+const std::size_t kStampLength = 19;
+const std::size_t kTagOffset = 20;      // "] [LEVEL] " 的起点
+const std::size_t kLevelOffset = 23;    // 级别名首字母
+
+const unsigned kDebug = 1;
+const unsigned kInfo = 2;
+const unsigned kWarning = 4;
+const unsigned kError = 8;
+const unsigned kSuccess = 16;
+
+struct Block {
+    std::uint64_t offset = 0;
+    std::uint64_t length = 0;
+    std::string first;                  // 首行时间，块内没有带时间的行时为空
+    std::string last;
+    unsigned levels = 0;
+    unsigned char bloom[kBloomBytes] = {};
+};
+
+bool endsWith(const std::string& s, const char* suffix) {
+    std::size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+bool hasStamp(const char* line, std::size_t length) {
+    return length > kLevelOffset && line[0] == '[' && line[kTagOffset] == ']' && line[kTagOffset + 2] == '[';
+}
+
+/**
+ * @brief 行的级别位：五个级别名首字母互不相同，只看一个字节
+ */
+unsigned lineLevel(const char* line) {
+    switch (line[kLevelOffset]) {
+        case 'D': return kDebug;
+        case 'I': return kInfo;
+        case 'W': return kWarning;
+        case 'E': return kError;
+        case 'S': return kSuccess;
+        default:  return 0;
+    }
+}
+
+/**
+ * @brief 消息部分（跳过时间与级别标记）
+ */
+const char* messageOf(const char* line, std::size_t length) {
+    const char* close = static_cast<const char*>(std::memchr(line + kLevelOffset, ']', length - kLevelOffset));
+    return close == nullptr || close + 2 > line + length ? line + length : close + 2;
+}
+
+bool isTokenChar(unsigned char c) {
+    return std::isalnum(c) != 0 || c == '_' || c == '-' || c == '.' || c == '+';
+}
+
+/**
+ * @brief 消息中的单词（包名可含 . + -，去掉句末的点），索引与匹配使用同一规则
+ */
+template <typename Visitor>
+void forEachToken(const char* text, std::size_t length, Visitor&& visit) {
+    std::size_t i = 0;
+    while (i < length) {
+        while (i < length && !isTokenChar(static_cast<unsigned char>(text[i]))) {
+            ++i;
+        }
+        std::size_t start = i;
+        while (i < length && isTokenChar(static_cast<unsigned char>(text[i]))) {
+            ++i;
+        }
+        std::size_t end = i;
+        while (end > start && text[end - 1] == '.') {
+            --end;
+        }
+        if (end > start && visit(text + start, end - start)) {
+            return;
+        }
+    }
+}
+
+void bloomPositions(const char* token, std::size_t length, std::size_t positions[3]) {
+    Xxh64 hash;
+    hash.update(token, length);
+    std::uint64_t digest = hash.digest();
+    positions[0] = digest % kBloomBits;
+    positions[1] = (digest >> 21) % kBloomBits;
+    positions[2] = (digest >> 42) % kBloomBits;
+}
+
+void bloomAdd(unsigned char* bloom, const char* token, std::size_t length) {
+    std::size_t positions[3];
+    bloomPositions(token, length, positions);
+    for (std::size_t bit : positions) {
+        bloom[bit / 8] |= static_cast<unsigned char>(1u << (bit % 8));
+    }
+}
+
+/**
+ * @brief 纯数字（含版本号、时长等）不进入布隆过滤器：每块数量很多，会让过滤器饱和
+ */
+bool isNumeric(const char* token, std::size_t length) {
+    for (std::size_t i = 0; i < length; ++i) {
+        if (std::isdigit(static_cast<unsigned char>(token[i])) == 0 && token[i] != '.') {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool bloomMayContain(const unsigned char* bloom, const std::string& token) {
+    if (isNumeric(token.data(), token.size())) {
+        return true;
+    }
+    std::size_t positions[3];
+    bloomPositions(token.data(), token.size(), positions);
+    for (std::size_t bit : positions) {
+        if ((bloom[bit / 8] & (1u << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> splitTabs(const std::string& line) {
+    std::vector<std::string> fields;
+    std::size_t start = 0;
+    for (;;) {
+        std::size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+        if (tab == std::string::npos) {
+            return fields;
+        }
+        start = tab + 1;
+    }
+}
+
+bool loadIndex(const std::string& path, std::vector<Block>& blocks) {
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(path, lines) || lines.empty() || lines[0].compare(0, 12, kIndexMagic) != 0) {
+        return false;
+    }
+    for (std::size_t i = 1; i < lines.size(); ++i) {
+        std::vector<std::string> fields = splitTabs(lines[i]);
+        if (fields.size() != 7 || fields[0] != "B" || fields[6].size() != kBloomBytes * 2) {
+            return false;
+        }
+        Block block;
+        block.offset = std::strtoull(fields[1].c_str(), nullptr, 10);
+        block.length = std::strtoull(fields[2].c_str(), nullptr, 10);
+        block.first = fields[3] == "-" ? std::string() : fields[3];
+        block.last = fields[4] == "-" ? std::string() : fields[4];
+        block.levels = static_cast<unsigned>(std::strtoul(fields[5].c_str(), nullptr, 10));
+        for (std::size_t b = 0; b < kBloomBytes; ++b) {
+            block.bloom[b] = static_cast<unsigned char>(std::strtoul(fields[6].substr(b * 2, 2).c_str(), nullptr, 16));
+        }
+        blocks.push_back(block);
+    }
+    return true;
+}
+
+bool blockMatches(const Block& block, const LogIndex::Query& query) {
+    // 块内没有带时间的行（只有续行）时无法判断，保守地扫描
+    if (!block.first.empty()) {
+        if (!query.since.empty() && block.last < query.since) {
+            return false;
+        }
+        if (!query.until.empty() && block.first > query.until) {
+            return false;
+        }
+        if (query.levels != 0 && (block.levels & query.levels) == 0) {
+            return false;
+        }
+    }
+    return query.component.empty() || bloomMayContain(block.bloom, query.component);
+}
+
+/**
+ * @brief 逐行筛选；不带时间的续行跟随上一行的结果
+ */
+struct Scanner {
+    const LogIndex::Query& query;
+    std::vector<std::string>& lines;
+    bool lastMatched = false;
+
+    void line(const char* start, std::size_t length) {
+        if (hasStamp(start, length)) {
+            lastMatched = LogIndex::matches(start, length, query);
+        } else if (query.empty()) {
+            lastMatched = true;
+        }
+        if (lastMatched) {
+            lines.emplace_back(start, length);
+        }
+    }
+
+    /**
+     * @brief 扫描若干完整的行
+     */
+    void scan(const char* data, std::size_t size) {
+        const char* end = data + size;
+        std::string tag;
+        switch (query.levels) {
+            case kDebug:   tag = "] [DEBUG] "; break;
+            case kInfo:    tag = "] [INFO] "; break;
+            case kWarning: tag = "] [WARNING] "; break;
+            case kError:   tag = "] [ERROR] "; break;
+            case kSuccess: tag = "] [SUCCESS] "; break;
+            default: break;
+        }
+        if (!tag.empty()) {
+            // 只查一个级别（最常见的是 --level error）：memmem 直接跳到下一个级别标记，
+            // 不逐行检查；这种情况下错误行之后的续行不输出
+            const char* p = data;
+            while (p < end) {
+                const char* hit = static_cast<const char*>(memmem(p, end - p, tag.data(), tag.size()));
+                if (hit == nullptr) {
+                    return;
+                }
+                const char* newline = static_cast<const char*>(memrchr(p, '\n', hit - p));
+                const char* start = newline == nullptr ? p : newline + 1;
+                const char* stop = static_cast<const char*>(std::memchr(hit, '\n', end - hit));
+                if (stop == nullptr) {
+                    stop = end;
+                }
+                std::size_t length = static_cast<std::size_t>(stop - start);
+                if (hit == start + kTagOffset && LogIndex::matches(start, length, query)) {
+                    lines.emplace_back(start, length);
+                }
+                p = stop + 1;
+            }
+            return;
+        }
+        for (const char* p = data; p < end;) {
+            const char* stop = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (stop == nullptr) {
+                stop = end;
+            }
+            line(p, static_cast<std::size_t>(stop - p));
+            p = stop + 1;
+        }
+    }
+};
+
+std::vector<std::size_t> selectBlocks(const std::vector<Block>& blocks, const LogIndex::Query& query,
+                                      LogIndex::Stats& stats) {
+    std::vector<std::size_t> selected;
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        if (blockMatches(blocks[i], query)) {
+            selected.push_back(i);
+        }
+    }
+    stats.blocks += blocks.size();
+    stats.scannedBlocks += selected.size();
+    return selected;
+}
+
+void scanPlain(const std::string& path, const std::vector<Block>* blocks, const std::vector<std::size_t>& selected,
+               Scanner& scanner) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return;
+    }
+    std::size_t size = static_cast<std::size_t>(info.st_size);
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+    const char* data = static_cast<const char*>(map);
+    if (blocks == nullptr) {
+        madvise(map, size, MADV_SEQUENTIAL);
+        // 当前段可能正被写入：只扫描到最后一个换行
+        const char* last = static_cast<const char*>(memrchr(data, '\n', size));
+        if (last != nullptr) {
+            scanner.scan(data, static_cast<std::size_t>(last - data));
+        }
+    } else {
+        for (std::size_t i : selected) {
+            const Block& block = (*blocks)[i];
+            if (block.offset < size) {
+                scanner.scan(data + block.offset, std::min<std::uint64_t>(block.length, size - block.offset));
+            }
+        }
+    }
+    munmap(map, size);
+}
+
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+void scanCompressed(const std::string& path, const std::vector<Block>* blocks, const std::vector<std::size_t>& selected,
+                    Scanner& scanner) {
+    gzFile gz = gzopen(path.c_str(), "rbe");
+    if (gz == nullptr) {
+        return;
+    }
+    gzbuffer(gz, 128 << 10);
+    std::string buffer;
+    if (blocks != nullptr) {
+        // 命中块按偏移有序：向前 gzseek 只解压不保留，最后一个命中块之后的内容不解压
+        for (std::size_t i : selected) {
+            const Block& block = (*blocks)[i];
+            if (gzseek(gz, static_cast<z_off_t>(block.offset), SEEK_SET) < 0) {
+                break;
+            }
+            buffer.resize(block.length);
+            int n = gzread(gz, &buffer[0], static_cast<unsigned>(block.length));
+            if (n <= 0) {
+                break;
+            }
+            scanner.scan(buffer.data(), static_cast<std::size_t>(n));
+        }
+    } else {
+        // 没有索引：分块解压，不完整的行留到下一块
+        std::string partial;
+        buffer.resize(1 << 20);
+        int n;
+        while ((n = gzread(gz, &buffer[0], static_cast<unsigned>(buffer.size()))) > 0) {
+            partial.append(buffer.data(), static_cast<std::size_t>(n));
+            std::size_t last = partial.rfind('\n');
+            if (last != std::string::npos) {
+                scanner.scan(partial.data(), last);
+                partial.erase(0, last + 1);
+            }
+        }
+        if (!partial.empty()) {
+            scanner.scan(partial.data(), partial.size());
+        }
+    }
+    gzclose(gz);
+}
+#endif
+
+/**
+ * @brief 分段的排序键：名称中的轮转时间与同一秒内的序号（<文件>.YYYYmmdd-HHMMSS[-N][.gz]）
+ * 压缩与补压缩会改写修改时间，只有名称不符合该格式时才用修改时间代替轮转时间
+ */
+struct SegmentKey {
+    std::string stamp;
+    unsigned long sequence = 0;
+    std::string path;
+
+    bool operator<(const SegmentKey& other) const {
+        if (stamp != other.stamp) {
+            return stamp < other.stamp;
+        }
+        return sequence != other.sequence ? sequence < other.sequence : path < other.path;
+    }
+};
+
+SegmentKey segmentKey(const std::string& path, std::string suffix, std::time_t mtime) {
+    SegmentKey key;
+    key.path = path;
+    if (endsWith(suffix, ".gz")) {
+        suffix.resize(suffix.size() - 3);
+    }
+    auto digits = [&suffix](std::size_t from, std::size_t to) {
+        for (std::size_t i = from; i < to; ++i) {
+            if (std::isdigit(static_cast<unsigned char>(suffix[i])) == 0) {
+                return false;
+            }
+        }
+        return to > from;
+    };
+    if (suffix.size() >= 15 && digits(0, 8) && suffix[8] == '-' && digits(9, 15) &&
+        (suffix.size() == 15 || (suffix[15] == '-' && digits(16, suffix.size())))) {
+        key.stamp = suffix.substr(0, 15);
+        key.sequence = suffix.size() == 15 ? 0 : std::strtoul(suffix.c_str() + 16, nullptr, 10);
+        return key;
+    }
+    struct tm local;
+    localtime_r(&mtime, &local);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+    key.stamp = stamp;
+    return key;
+}
+
+/**
+ * @brief 查询一个分段
+ */
+void scanSegment(const std::string& path, bool active, const LogIndex::Query& query,
+                 std::vector<std::string>& lines, LogIndex::Stats& stats) {
+    std::vector<Block> blocks;
+    std::vector<std::size_t> selected;
+    bool indexed = !active && !query.empty() && loadIndex(LogIndex::indexPath(path), blocks);
+    if (indexed) {
+        selected = selectBlocks(blocks, query, stats);
+        if (selected.empty()) {
+            ++stats.skipped;
+            return;
+        }
+    }
+    Scanner scanner{query, lines};
+    if (endsWith(path, ".gz")) {
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+        scanCompressed(path, indexed ? &blocks : nullptr, selected, scanner);
+#endif
+    } else {
+        scanPlain(path, indexed ? &blocks : nullptr, selected, scanner);
+    }
+}
+
+} // namespace
+
+unsigned LogIndex::levelBit(const std::string& name) {
+    std::string upper;
+    for (char c : name) {
+        upper += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    if (upper == "DEBUG") return kDebug;
+    if (upper == "INFO") return kInfo;
+    if (upper == "WARNING" || upper == "WARN") return kWarning;
+    if (upper == "ERROR") return kError;
+    if (upper == "SUCCESS") return kSuccess;
+    return 0;
+}
+
+bool LogIndex::parseTime(const std::string& text, bool endOfRange, std::string& stamp) {
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (end != text.c_str() && end[0] != '\0' && end[1] == '\0' && std::strchr("smhd", end[0]) != nullptr) {
+        long unit = end[0] == 's' ? 1 : end[0] == 'm' ? 60 : end[0] == 'h' ? 3600 : 86400;
+        std::time_t at = std::time(nullptr) - value * unit;
+        struct tm local;
+        localtime_r(&at, &local);
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+        stamp = buffer;
+        return true;
+    }
+
+    std::string full = text;
+    if (full.size() > 10 && full[10] == 'T') {
+        full[10] = ' ';
+    }
+    if (full.size() == 10) {
+        full += endOfRange ? " 23:59:59" : " 00:00:00";
+    } else if (full.size() == 16) {
+        full += endOfRange ? ":59" : ":00";
+    }
+    struct tm parsed;
+    std::memset(&parsed, 0, sizeof(parsed));
+    const char* rest = full.size() == kStampLength ? strptime(full.c_str(), "%Y-%m-%d %H:%M:%S", &parsed) : nullptr;
+    if (rest == nullptr || *rest != '\0') {
+        return false;
+    }
+    stamp = full;
+    return true;
+}
+
+std::string LogIndex::indexPath(const std::string& segment) {
+    return (endsWith(segment, ".gz") ? segment.substr(0, segment.size() - 3) : segment) + ".idx";
+}
+
+bool LogIndex::build(const std::string& segment) {
+    int fd = open(segment.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(info.st_size);
+    void* map = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    const char* data = static_cast<const char*>(map);
+    if (map != nullptr) {
+        madvise(map, size, MADV_SEQUENTIAL);
+    }
+
+    std::string content = std::string(kIndexMagic) + "\t" + std::to_string(kBlockSize) + "\n";
+    for (std::size_t offset = 0; offset < size;) {
+        // 块在行边界结束，扫描时不用处理跨块的行
+        std::size_t limit = std::min(size, offset + kBlockSize);
+        const char* cut = limit == size ? nullptr
+                                        : static_cast<const char*>(std::memchr(data + limit, '\n', size - limit));
+        std::size_t blockEnd = cut == nullptr ? size : static_cast<std::size_t>(cut - data) + 1;
+
+        Block block;
+        block.offset = offset;
+        block.length = blockEnd - offset;
+        for (const char* p = data + offset; p < data + blockEnd;) {
+            const char* stop = static_cast<const char*>(std::memchr(p, '\n', data + blockEnd - p));
+            if (stop == nullptr) {
+                stop = data + blockEnd;
+            }
+            std::size_t length = static_cast<std::size_t>(stop - p);
+            const char* message = p;
+            if (hasStamp(p, length)) {
+                std::string stamp(p + 1, kStampLength);
+                if (block.first.empty()) {
+                    block.first = stamp;
+                }
+                block.last = stamp;
+                block.levels |= lineLevel(p);
+                message = messageOf(p, length);
+            }
+            forEachToken(message, static_cast<std::size_t>(stop - message), [&](const char* token, std::size_t n) {
+                if (!isNumeric(token, n)) {
+                    bloomAdd(block.bloom, token, n);
+                }
+                return false;
+            });
+            p = stop + 1;
+        }
+
+        char hex[kBloomBytes * 2 + 1];
+        for (std::size_t b = 0; b < kBloomBytes; ++b) {
+            std::snprintf(hex + b * 2, 3, "%02x", block.bloom[b]);
+        }
+        content += "B\t" + std::to_string(block.offset) + "\t" + std::to_string(block.length) + "\t" +
+                   (block.first.empty() ? "-" : block.first) + "\t" + (block.last.empty() ? "-" : block.last) + "\t" +
+                   std::to_string(block.levels) + "\t" + hex + "\n";
+        offset = blockEnd;
+    }
+    if (map != nullptr) {
+        munmap(map, size);
+    }
+    return FileUtils::writeFileAtomic(indexPath(segment), content);
+}
+
+std::vector<std::string> LogIndex::segments(const std::string& logPath) {
+    std::vector<SegmentKey> closed;
+    std::size_t slash = logPath.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : logPath.substr(0, slash);
+    std::string prefix = logPath.substr(slash == std::string::npos ? 0 : slash + 1) + ".";
+    DIR* handle = opendir(dir.c_str());
+    if (handle != nullptr) {
+        while (struct dirent* entry = readdir(handle)) {
+            std::string name = entry->d_name;
+            if (name.compare(0, prefix.size(), prefix) != 0 || endsWith(name, ".idx") || endsWith(name, ".tmp")) {
+                continue;
+            }
+            std::string path = dir + "/" + name;
+            struct stat info;
+            if (stat(path.c_str(), &info) == 0) {
+                closed.push_back(segmentKey(path, name.substr(prefix.size()), info.st_mtime));
+            }
+        }
+        closedir(handle);
+    }
+    std::sort(closed.begin(), closed.end());
+
+    std::vector<std::string> paths;
+    for (const auto& segment : closed) {
+        paths.push_back(segment.path);
+    }
+    if (access(logPath.c_str(), R_OK) == 0) {
+        paths.push_back(logPath);
+    }
+    return paths;
+}
+
+bool LogIndex::matches(const char* line, std::size_t length, const Query& query) {
+    if (!hasStamp(line, length)) {
+        return query.empty();
+    }
+    if (!query.since.empty() && std::memcmp(line + 1, query.since.data(), kStampLength) < 0) {
+        return false;
+    }
+    if (!query.until.empty() && std::memcmp(line + 1, query.until.data(), kStampLength) > 0) {
+        return false;
+    }
+    if (query.levels != 0 && (lineLevel(line) & query.levels) == 0) {
+        return false;
+    }
+    if (query.component.empty()) {
+        return true;
+    }
+    const char* message = messageOf(line, length);
+    bool found = false;
+    forEachToken(message, static_cast<std::size_t>(line + length - message), [&](const char* token, std::size_t n) {
+        found = n == query.component.size() && std::memcmp(token, query.component.data(), n) == 0;
+        return found;
+    });
+    return found;
+}
+
+void LogIndex::query(const std::string& logPath, const Query& query,
+                     const std::function<void(const std::string&)>& onLine, Stats& stats) {
+    std::vector<std::string> paths = segments(logPath);
+    stats.segments = paths.size();
+    // 每批与 I/O 线程数相同的分段并行解压扫描，按时间顺序输出；分批限制同时驻留的结果
+    std::size_t batch = FileUtils::ioThreads();
+    for (std::size_t begin = 0; begin < paths.size(); begin += batch) {
+        std::size_t count = std::min(batch, paths.size() - begin);
+        std::vector<std::vector<std::string>> lines(count);
+        std::vector<Stats> partial(count);
+        FileUtils::parallelFor(count, [&](std::size_t i) {
+            const std::string& path = paths[begin + i];
+            scanSegment(path, path == logPath, query, lines[i], partial[i]);
+        });
+        for (std::size_t i = 0; i < count; ++i) {
+            stats.skipped += partial[i].skipped;
+            stats.blocks += partial[i].blocks;
+            stats.scannedBlocks += partial[i].scannedBlocks;
+            for (const auto& line : lines[i]) {
+                onLine(line);
+            }
+        }
+    }
+}
+
+bool LogIndex::follow(const std::string& logPath, const Query& query, const std::atomic<bool>& stop,
+                      const std::function<void(const std::string&)>& onLine) {
+    int notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notify < 0) {
+        return false;
+    }
+    std::size_t slash = logPath.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : logPath.substr(0, slash);
+    if (inotify_add_watch(notify, dir.c_str(), IN_MODIFY | IN_CREATE | IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+        close(notify);
+        return false;
+    }
+    int fd = open(logPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        close(notify);
+        return false;
+    }
+    lseek(fd, 0, SEEK_END);
+
+    std::vector<std::string> lines;
+    Scanner scanner{query, lines};
+    std::string partial;
+    auto drain = [&]() {
+        char buffer[65536];
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+            partial.append(buffer, static_cast<std::size_t>(n));
+        }
+        std::size_t last = partial.rfind('\n');
+        if (last == std::string::npos) {
+            return;
+        }
+        scanner.scan(partial.data(), last);
+        partial.erase(0, last + 1);
+        for (const auto& line : lines) {
+            onLine(line);
+        }
+        lines.clear();
+    };
+
+    alignas(struct inotify_event) char events[4096];
+    while (!stop) {
+        struct pollfd pfd = {notify, POLLIN, 0};
+        if (poll(&pfd, 1, 1000) < 0 && errno != EINTR) {
+            break;
+        }
+        while (read(notify, events, sizeof(events)) > 0) {
+            // 事件只用来唤醒，具体变化直接看文件
+        }
+        drain();
+
+        // 轮转：路径已指向新文件，读完旧文件剩余内容后从头读新文件
+        struct stat opened;
+        struct stat current;
+        if (fstat(fd, &opened) == 0 && stat(logPath.c_str(), &current) == 0 &&
+            (opened.st_ino != current.st_ino || opened.st_dev != current.st_dev)) {
+            int next = open(logPath.c_str(), O_RDONLY | O_CLOEXEC);
+            if (next >= 0) {
+                close(fd);
+                fd = next;
+                partial.clear();
+                drain();
+            }
+        } else if (fstat(fd, &opened) == 0 && lseek(fd, 0, SEEK_CUR) > opened.st_size) {
+            lseek(fd, 0, SEEK_SET);   // 被截断
+            partial.clear();
+        }
+    }
+    close(fd);
+    close(notify);
+    return true;
+}
+
+} // namespace LinuxStudio
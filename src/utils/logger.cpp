@@ -1,5 +1,14 @@
 #include "linuxstudio/logger.hpp"
+#include "linuxstudio/output.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/disk_usage.hpp"
+#include "linuxstudio/log_index.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <vector>
 
 #ifdef _WIN32
     #include <io.h>
@@ -7,12 +16,175 @@
     #define fileno _fileno
 #else
     #include <unistd.h>
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+#endif
+
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+    #include <zlib.h>
 #endif
 
 namespace LinuxStudio {
 
+namespace {
+
+// 默认分段策略：嵌入式设备分区小、闪存怕频繁小写，段更小并攒批写入
+#ifdef LINUXSTUDIO_EMBEDDED
+const Logger::Rotation kDefaultRotation = {1ull << 20, 7 * 86400, 8ull << 20, 16 << 10, 5, true};
+#else
+const Logger::Rotation kDefaultRotation = {8ull << 20, 30 * 86400, 64ull << 20, 0, 0, true};
+#endif
+
+/**
+ * @brief 解析时长（如 30s、15m、12h、7d；无后缀为秒）
+ */
+bool parseDuration(const std::string& text, long& seconds) {
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (end == text.c_str()) {
+        return false;
+    }
+    switch (*end) {
+        case 's': case '\0': break;
+        case 'm': value *= 60; break;
+        case 'h': value *= 3600; break;
+        case 'd': value *= 86400; break;
+        default: return false;
+    }
+    seconds = value;
+    return true;
+}
+
+/**
+ * @brief 读出日志文件第一行的时间（"[YYYY-MM-DD HH:MM:SS] ..."），失败返回 0
+ */
+std::time_t firstLineTime(int fd) {
+    char text[22];
+    if (pread(fd, text, 21, 0) != 21 || text[0] != '[') {
+        return 0;
+    }
+    text[21] = '\0';
+    struct tm local;
+    std::memset(&local, 0, sizeof(local));
+    if (strptime(text + 1, "%Y-%m-%d %H:%M:%S", &local) == nullptr) {
+        return 0;
+    }
+    local.tm_isdst = -1;
+    return mktime(&local);
+}
+
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+/**
+ * @brief 把分段压缩为 <分段>.gz（先写 .tmp 再改名），成功后删除原文件
+ */
+bool compressSegment(const std::string& segment) {
+    int in = open(segment.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+    std::string target = segment + ".gz";
+    std::string tmp = target + ".tmp";
+    gzFile gz = gzopen(tmp.c_str(), "wb6e");
+    if (gz == nullptr) {
+        close(in);
+        return false;
+    }
+    std::vector<char> buffer(64 << 10);
+    bool ok = true;
+    for (;;) {
+        ssize_t n = read(in, buffer.data(), buffer.size());
+        if (n < 0) {
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        if (gzwrite(gz, buffer.data(), static_cast<unsigned>(n)) != static_cast<int>(n)) {
+            ok = false;
+            break;
+        }
+    }
+    close(in);
+    ok = gzclose(gz) == Z_OK && ok;
+    if (!ok || rename(tmp.c_str(), target.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    unlink(segment.c_str());
+    return true;
+}
+#endif
+
+bool endsWith(const std::string& s, const char* suffix) {
+    std::size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+/**
+ * @brief 日志文件的已关闭分段（<文件>.<时间戳>[.gz]，不含索引 .idx）
+ * @param uncompressed 同时收集尚未压缩的分段
+ */
+std::vector<std::string> listSegments(const std::string& logPath, std::vector<std::string>* uncompressed) {
+    std::vector<std::string> segments;
+    std::size_t slash = logPath.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : logPath.substr(0, slash);
+    std::string prefix = logPath.substr(slash == std::string::npos ? 0 : slash + 1) + ".";
+    DIR* handle = opendir(dir.c_str());
+    if (handle == nullptr) {
+        return segments;
+    }
+    while (struct dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        std::string path = dir + "/" + name;
+        if (endsWith(name, ".tmp")) {
+            unlink(path.c_str());   // 上次压缩被中断留下的
+            continue;
+        }
+        if (endsWith(name, ".idx")) {
+            continue;
+        }
+        segments.push_back(path);
+        if (uncompressed != nullptr && !endsWith(name, ".gz")) {
+            uncompressed->push_back(path);
+        }
+    }
+    closedir(handle);
+    return segments;
+}
+
+/**
+ * @brief 从最旧的分段开始删除，直到总大小不超过上限（顺序与 xkl logs 相同，见 LogIndex::segments）
+ */
+void pruneSegments(const std::string& logPath, std::uint64_t retainBytes) {
+    std::vector<std::string> segments = LogIndex::segments(logPath);
+    if (!segments.empty() && segments.back() == logPath) {
+        segments.pop_back();
+    }
+    std::vector<std::uint64_t> sizes;
+    std::uint64_t total = 0;
+    for (const auto& path : segments) {
+        struct stat info;
+        sizes.push_back(stat(path.c_str(), &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0);
+        total += sizes.back();
+    }
+    for (std::size_t i = 0; i < segments.size() && total > retainBytes; ++i) {
+        if (unlink(segments[i].c_str()) == 0) {
+            unlink(LogIndex::indexPath(segments[i]).c_str());
+            total -= sizes[i];
+        }
+    }
+}
+
+} // namespace
+
 Logger::Logger() 
-    : minLevel_(LogLevel::INFO), useColors_(true) {
+    : logFd_(-1), segmentBytes_(0), segmentStart_(0), lastWrite_(0), rotation_(kDefaultRotation),
+      minLevel_(LogLevel::INFO), useColors_(true), stopping_(false) {
     // 检查是否支持颜色输出
 #ifdef _WIN32
     useColors_ = false;  // Windows 终端颜色支持较差
@@ -22,19 +194,96 @@ Logger::Logger()
 }
 
 Logger::~Logger() {
-    if (logFile_.is_open()) {
-        logFile_.close();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (logFd_ >= 0) {
+            flushFile();
+            close(logFd_);
+            logFd_ = -1;
+        }
+    }
+    // 等后台线程处理完已排队的分段（通常只有一个，压缩很快）
+    {
+        std::lock_guard<std::mutex> lock(closedMutex_);
+        stopping_ = true;
+    }
+    closedReady_.notify_all();
+    if (compressor_.joinable()) {
+        compressor_.join();
+    }
+}
+
+void Logger::loadConfig(const std::string& path) {
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(path, lines)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& line : lines) {
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> key = FileUtils::splitFields(line.substr(0, colon));
+        std::vector<std::string> value = FileUtils::splitFields(line.substr(colon + 1));
+        if (key.size() != 1 || value.empty()) {
+            continue;
+        }
+        const std::string& k = key[0];
+        const std::string& v = value[0];
+        std::uint64_t bytes = 0;
+        long seconds = 0;
+        if (k == "log_max_size" && DiskUsage::parseBytes(v, bytes) && bytes > 0) {
+            rotation_.maxBytes = bytes;
+        } else if (k == "log_max_age" && parseDuration(v, seconds)) {
+            rotation_.maxAgeSeconds = seconds;
+        } else if (k == "log_retain" && DiskUsage::parseBytes(v, bytes)) {
+            rotation_.retainBytes = bytes;
+        } else if (k == "log_batch_size" && DiskUsage::parseBytes(v, bytes)) {
+            rotation_.batchBytes = static_cast<std::size_t>(bytes);
+        } else if (k == "log_batch_interval" && parseDuration(v, seconds)) {
+            rotation_.batchSeconds = seconds;
+        } else if (k == "log_compress") {
+            rotation_.compress = (v == "true" || v == "yes" || v == "on");
+        }
     }
 }
 
 void Logger::setLogFile(const std::string& path) {
-    if (logFile_.is_open()) {
-        logFile_.close();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (logFd_ >= 0) {
+        flushFile();
+        close(logFd_);
     }
-    logFile_.open(path, std::ios::app);
-    if (!logFile_.is_open()) {
+    logPath_ = path;
+    openSegment();
+    if (logFd_ < 0) {
         // 如果打开失败，静默失败（不影响程序运行）
         // 日志将只输出到控制台
+        return;
+    }
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+    // 上次退出前未及压缩的分段（或中途被杀）交给后台线程补上
+    if (rotation_.compress) {
+        std::vector<std::string> uncompressed;
+        listSegments(logPath_, &uncompressed);
+        for (const auto& segment : uncompressed) {
+            enqueueClosed(segment);
+        }
+    }
+#endif
+}
+
+void Logger::openSegment() {
+    logFd_ = open(logPath_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (logFd_ < 0) {
+        return;
+    }
+    struct stat info;
+    segmentBytes_ = fstat(logFd_, &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+    segmentStart_ = segmentBytes_ > 0 ? firstLineTime(logFd_) : 0;
+    if (segmentBytes_ > 0 && segmentStart_ == 0) {
+        segmentStart_ = info.st_mtime;
     }
 }
 
@@ -47,9 +296,10 @@ void Logger::log(LogLevel level, const std::string& message) {
         return;
     }
     
+    std::lock_guard<std::mutex> lock(mutex_);
     writeToConsole(level, message);
     
-    if (logFile_.is_open()) {
+    if (logFd_ >= 0) {
         writeToFile(level, message);
     }
 }
@@ -75,11 +325,12 @@ void Logger::success(const std::string& message) {
 }
 
 std::string Logger::getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S");
-    return ss.str();
+    std::time_t now = std::time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+    return text;
 }
 
 std::string Logger::getLevelString(LogLevel level) {
@@ -122,15 +373,125 @@ void Logger::writeToConsole(LogLevel level, const std::string& message) {
         case LogLevel::SUCCESS: icon = "✅"; break;
     }
     
-    std::cout << getColorCode(level) 
-              << icon << " " << message 
-              << getColorReset() << std::endl;
+    // 文本模式写入输出缓冲区（与命令输出保持顺序，不逐行刷新）；
+    // JSON/TSV 模式下 stdout 只留给结构化结果，日志改写 stderr
+    auto& out = Output::getInstance();
+    if (out.isText()) {
+        out << getColorCode(level) + icon + " " + message + getColorReset() + "\n";
+    } else {
+        std::string line = getLevelString(level) + ": " + message + "\n";
+        fwrite(line.data(), 1, line.size(), stderr);
+    }
 }
 
 void Logger::writeToFile(LogLevel level, const std::string& message) {
-    logFile_ << "[" << getCurrentTime() << "] "
-             << "[" << getLevelString(level) << "] "
-             << message << std::endl;
+    std::string line = "[" + getCurrentTime() + "] [" + getLevelString(level) + "] " + message + "\n";
+    pending_ += line;
+    std::time_t now = std::time(nullptr);
+    if (lastWrite_ == 0) {
+        lastWrite_ = now;
+    }
+    if (level == LogLevel::ERROR || pending_.size() >= rotation_.batchBytes ||
+        now - lastWrite_ >= rotation_.batchSeconds) {
+        flushFile();
+    }
+}
+
+void Logger::flushFile() {
+    if (pending_.empty() || logFd_ < 0) {
+        return;
+    }
+    std::time_t now = std::time(nullptr);
+    bool full = segmentBytes_ > 0 && segmentBytes_ + pending_.size() > rotation_.maxBytes;
+    bool expired = segmentStart_ != 0 && rotation_.maxAgeSeconds > 0 &&
+                   now - segmentStart_ >= rotation_.maxAgeSeconds;
+    if (full || expired) {
+        rotate();
+        if (logFd_ < 0) {
+            pending_.clear();
+            return;
+        }
+    }
+    if (segmentBytes_ == 0) {
+        segmentStart_ = now;
+    }
+    const char* data = pending_.data();
+    std::size_t remaining = pending_.size();
+    while (remaining > 0) {
+        ssize_t n = write(logFd_, data, remaining);
+        if (n <= 0) {
+            break;   // 磁盘满等：丢弃这一批，不影响程序运行
+        }
+        data += n;
+        remaining -= static_cast<std::size_t>(n);
+    }
+    segmentBytes_ += pending_.size() - remaining;
+    pending_.clear();
+    lastWrite_ = now;
+}
+
+void Logger::rotate() {
+    // 多个 xkl 进程（如 cron 与交互使用）可能同时写同一文件：
+    // 只有路径仍指向本进程打开的文件时才改名，否则别的进程已轮转过，直接打开新段
+    struct stat opened;
+    struct stat current;
+    if (fstat(logFd_, &opened) == 0 && stat(logPath_.c_str(), &current) == 0 &&
+        opened.st_dev == current.st_dev && opened.st_ino == current.st_ino) {
+        char stamp[32];
+        std::time_t now = std::time(nullptr);
+        struct tm local;
+        localtime_r(&now, &local);
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+        std::string segment = logPath_ + "." + stamp;
+        for (int i = 1; access(segment.c_str(), F_OK) == 0 || access((segment + ".gz").c_str(), F_OK) == 0; ++i) {
+            segment = logPath_ + "." + stamp + "-" + std::to_string(i);
+        }
+        if (rename(logPath_.c_str(), segment.c_str()) == 0) {
+            enqueueClosed(segment);
+        }
+    }
+    close(logFd_);
+    openSegment();
+}
+
+void Logger::enqueueClosed(const std::string& segment) {
+    {
+        std::lock_guard<std::mutex> lock(closedMutex_);
+        closed_.push_back(segment);
+        if (!compressor_.joinable()) {
+            compressor_ = std::thread(&Logger::compressLoop, this);
+        }
+    }
+    closedReady_.notify_one();
+}
+
+void Logger::compressLoop() {
+    std::unique_lock<std::mutex> lock(closedMutex_);
+    for (;;) {
+        closedReady_.wait(lock, [this] { return stopping_ || !closed_.empty(); });
+        if (closed_.empty()) {
+            return;
+        }
+        std::string segment = closed_.front();
+        closed_.pop_front();
+        bool compress = rotation_.compress;
+        std::uint64_t retain = rotation_.retainBytes;
+        std::string logPath = logPath_;
+        lock.unlock();
+        // 先建索引（偏移指未压缩的内容），xkl logs 据此跳过不相关的分段和块
+        if (access(LogIndex::indexPath(segment).c_str(), F_OK) != 0) {
+            LogIndex::build(segment);
+        }
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+        if (compress) {
+            compressSegment(segment);
+        }
+#else
+        (void)compress;
+#endif
+        pruneSegments(logPath, retain);
+        lock.lock();
+    }
 }
 
 } // namespace LinuxStudio
@@ -0,0 +1,229 @@
+#include "linuxstudio/manifest.hpp"
+#include "linuxstudio/hash.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+const char* const kHeader = "xkl-manifest-1 xxh64 ";
+
+/**
+ * @brief 计算单个条目的摘要：普通文件哈希内容，符号链接哈希链接目标
+ */
+bool hashEntry(const std::string& path, char type, std::string& digest, std::uint64_t& size) {
+    if (type == 'l') {
+        char target[4096];
+        ssize_t n = readlink(path.c_str(), target, sizeof(target));
+        if (n < 0) {
+            return false;
+        }
+        Xxh64 hasher;
+        hasher.update(target, static_cast<std::size_t>(n));
+        digest = hasher.hexDigest();
+        size = static_cast<std::uint64_t>(n);
+        return true;
+    }
+    return Xxh64::hashFile(path, digest, &size);
+}
+
+/**
+ * @brief 按大小降序排列的下标
+ */
+std::vector<std::size_t> largestFirst(const std::vector<Manifest::Entry>& entries) {
+    std::vector<std::size_t> order(entries.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&entries](std::size_t a, std::size_t b) {
+        return entries[a].size > entries[b].size;
+    });
+    return order;
+}
+
+} // namespace
+
+bool Manifest::build(const std::vector<std::string>& roots, const std::vector<std::string>& files,
+                     const std::set<std::string>& exclude) {
+    entries_.clear();
+    std::mutex entriesMutex;
+
+    auto add = [&](const std::string& path) {
+        struct stat st;
+        if (exclude.count(path) > 0 || lstat(path.c_str(), &st) != 0) {
+            return;
+        }
+        Entry entry;
+        entry.path = path;
+        if (S_ISREG(st.st_mode)) {
+            entry.type = 'f';
+        } else if (S_ISLNK(st.st_mode)) {
+            entry.type = 'l';
+        } else {
+            return;  // 目录、设备文件等不记录
+        }
+        entry.size = static_cast<std::uint64_t>(st.st_size);
+        std::lock_guard<std::mutex> lock(entriesMutex);
+        entries_.push_back(std::move(entry));
+    };
+
+    std::vector<std::string> existing;
+    for (const auto& root : roots) {
+        struct stat st;
+        if (lstat(root.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            existing.push_back(root);
+        }
+    }
+    FileUtils::walkParallel(existing, [&](const std::string& dir, std::vector<std::string>& children) {
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        FileUtils::readEntries(fd, [&](const char* name, unsigned char type) {
+            std::string path = dir + "/" + name;
+            struct stat st;
+            if (type == DT_UNKNOWN && lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+                type = DT_DIR;  // 部分文件系统不提供 d_type
+            }
+            if (type == DT_DIR) {
+                if (exclude.count(path) == 0) {
+                    children.push_back(path);
+                }
+            } else {
+                add(path);
+            }
+        });
+        close(fd);
+    });
+    for (const auto& file : files) {
+        add(file);
+    }
+
+    // 多个来源可能重叠（如软件包文件落在插件目录里）
+    std::sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) { return a.path < b.path; });
+    entries_.erase(std::unique(entries_.begin(), entries_.end(),
+                               [](const Entry& a, const Entry& b) { return a.path == b.path; }),
+                   entries_.end());
+
+    std::atomic<bool> complete(true);
+    std::vector<std::size_t> order = largestFirst(entries_);
+    FileUtils::parallelFor(order.size(), [&](std::size_t i) {
+        Entry& entry = entries_[order[i]];
+        if (!hashEntry(entry.path, entry.type, entry.digest, entry.size)) {
+            entry.digest.clear();
+            complete = false;
+        }
+    });
+    if (!complete) {
+        // 构建期间消失或无法读取的文件不记录
+        entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                      [](const Entry& entry) { return entry.digest.empty(); }),
+                       entries_.end());
+    }
+    return !entries_.empty();
+}
+
+bool Manifest::load(const std::string& path) {
+    entries_.clear();
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(path, lines) || lines.empty() ||
+        lines[0].compare(0, std::char_traits<char>::length(kHeader), kHeader) != 0) {
+        return false;
+    }
+    std::size_t expected = std::strtoull(lines[0].c_str() + std::char_traits<char>::length(kHeader), nullptr, 10);
+
+    for (std::size_t i = 1; i < lines.size(); ++i) {
+        const std::string& line = lines[i];
+        std::size_t t1 = line.find('\t');
+        std::size_t t2 = (t1 == std::string::npos) ? t1 : line.find('\t', t1 + 1);
+        std::size_t t3 = (t2 == std::string::npos) ? t2 : line.find('\t', t2 + 1);
+        if (t3 == std::string::npos || t1 != 1) {
+            return false;
+        }
+        Entry entry;
+        entry.type = line[0];
+        entry.size = std::strtoull(line.c_str() + t1 + 1, nullptr, 10);
+        entry.digest = line.substr(t2 + 1, t3 - t2 - 1);
+        entry.path = line.substr(t3 + 1);
+        entries_.push_back(std::move(entry));
+    }
+    return entries_.size() == expected;
+}
+
+bool Manifest::save(const std::string& path) const {
+    std::string content = kHeader + std::to_string(entries_.size()) + "\n";
+    for (const auto& entry : entries_) {
+        content += entry.type;
+        content += "\t" + std::to_string(entry.size) + "\t" + entry.digest + "\t" + entry.path + "\n";
+    }
+    return FileUtils::writeFileAtomic(path, content);
+}
+
+Manifest::Report Manifest::verify() const {
+    auto start = std::chrono::steady_clock::now();
+    Report report;
+    std::vector<const char*> reasons(entries_.size(), nullptr);
+    std::atomic<std::uint64_t> bytes(0);
+
+    std::vector<std::size_t> order = largestFirst(entries_);
+    FileUtils::parallelFor(order.size(), [&](std::size_t i) {
+        std::size_t index = order[i];
+        const Entry& entry = entries_[index];
+        struct stat st;
+        if (lstat(entry.path.c_str(), &st) != 0) {
+            reasons[index] = "missing";
+            return;
+        }
+        if ((entry.type == 'l') != S_ISLNK(st.st_mode) || (entry.type == 'f' && !S_ISREG(st.st_mode))) {
+            reasons[index] = "type";
+            return;
+        }
+        // 大小不同不必再读内容
+        if (entry.type == 'f' && static_cast<std::uint64_t>(st.st_size) != entry.size) {
+            reasons[index] = "modified";
+            return;
+        }
+        std::string digest;
+        std::uint64_t size = 0;
+        if (!hashEntry(entry.path, entry.type, digest, size)) {
+            reasons[index] = "unreadable";
+            return;
+        }
+        bytes += size;
+        if (digest != entry.digest || size != entry.size) {
+            reasons[index] = "modified";
+        }
+    });
+
+    report.files = entries_.size();
+    report.bytes = bytes;
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+        if (reasons[i] != nullptr) {
+            report.mismatches.push_back({entries_[i].path, reasons[i]});
+        }
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+std::uint64_t Manifest::totalBytes() const {
+    std::uint64_t total = 0;
+    for (const auto& entry : entries_) {
+        if (entry.type == 'f') {
+            total += entry.size;
+        }
+    }
+    return total;
+}
+
+} // namespace LinuxStudio
@@ -0,0 +1,752 @@
+#include "linuxstudio/oci_image.hpp"
+#include "linuxstudio/hash.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+    #include <zlib.h>
+#endif
+
+namespace LinuxStudio {
+
+namespace {
+
+const std::size_t kTarBlock = 512;
+
+// 压缩块大小与映射窗口：小内存板子上同时在途的块更少、更小
+#ifdef LINUXSTUDIO_EMBEDDED
+const std::size_t kChunkSize = 128 * 1024;
+const std::size_t kMapWindow = 8 * 1024 * 1024;
+#else
+const std::size_t kChunkSize = 1024 * 1024;
+const std::size_t kMapWindow = 64 * 1024 * 1024;
+#endif
+
+// deflate 的窗口大小：下一块以前一块末尾这么多字节作字典
+const std::size_t kDictionarySize = 32 * 1024;
+
+// ustar 大小字段（11 位八进制）能表示的上限，更大的文件用 PAX 记录
+const std::uint64_t kUstarMaxSize = 077777777777ULL;
+
+const char* const kManifestType = "application/vnd.oci.image.manifest.v1+json";
+const char* const kConfigType = "application/vnd.oci.image.config.v1+json";
+
+/**
+ * @brief 待写入层的条目
+ */
+struct Entry {
+    std::string path;        // 源路径（绝对路径）
+    char type = '0';         // '0' 普通文件，'1' 硬链接，'2' 符号链接，'5' 目录
+    struct stat st;
+    std::string link;        // 符号链接目标，或硬链接指向的层内路径
+};
+
+/**
+ * @brief 源路径 -> 层内路径（去掉开头的 /，目录以 / 结尾）
+ */
+std::string archiveName(const std::string& path, bool directory) {
+    std::string name = path.substr(path.find_first_not_of('/'));
+    if (directory && !name.empty() && name.back() != '/') {
+        name += '/';
+    }
+    return name;
+}
+
+/**
+ * @brief 上级目录按真实路径展开（/lib -> /usr/lib 等符号链接目录），文件名本身不解析
+ */
+std::string canonicalPath(const std::string& path) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos || slash == 0) {
+        return path;
+    }
+    char resolved[PATH_MAX];
+    if (realpath(path.substr(0, slash).c_str(), resolved) == nullptr) {
+        return path;
+    }
+    std::string parent = resolved;
+    return (parent == "/" ? "" : parent) + path.substr(slash);
+}
+
+void putOctal(char* field, std::size_t width, std::uint64_t value) {
+    // 超出字段宽度的值由调用方改写进 PAX 头，这里只取低位
+    char digits[32];
+    std::snprintf(digits, sizeof(digits), "%0*llo", static_cast<int>(width - 1), static_cast<unsigned long long>(value));
+    std::size_t length = std::strlen(digits);
+    std::memcpy(field, digits + (length - (width - 1)), width - 1);
+    field[width - 1] = '\0';
+}
+
+/**
+ * @brief PAX 扩展记录 "<长度> <键>=<值>\n"，长度包含自身的位数
+ */
+std::string paxRecord(const std::string& key, const std::string& value) {
+    std::string body = " " + key + "=" + value + "\n";
+    std::size_t length = body.size() + 1;
+    while (std::to_string(length).size() + body.size() != length) {
+        length = std::to_string(length).size() + body.size();
+    }
+    return std::to_string(length) + body;
+}
+
+/**
+ * @brief 填写 ustar 头（名称、链接超长或文件过大时由调用方先写 PAX 头）
+ */
+void makeHeader(char* header, const std::string& name, char type, const struct stat& st,
+                std::uint64_t size, const std::string& link) {
+    std::memset(header, 0, kTarBlock);
+    std::memcpy(header, name.data(), std::min<std::size_t>(name.size(), 100));
+    putOctal(header + 100, 8, st.st_mode & 07777);
+    putOctal(header + 108, 8, std::min<std::uint64_t>(st.st_uid, 07777777));
+    putOctal(header + 116, 8, std::min<std::uint64_t>(st.st_gid, 07777777));
+    putOctal(header + 124, 12, std::min(size, kUstarMaxSize));
+    putOctal(header + 136, 12, static_cast<std::uint64_t>(std::max<time_t>(st.st_mtime, 0)));
+    std::memset(header + 148, ' ', 8);
+    header[156] = type;
+    std::memcpy(header + 157, link.data(), std::min<std::size_t>(link.size(), 100));
+    std::memcpy(header + 257, "ustar\0" "00", 8);
+
+    unsigned sum = 0;
+    for (std::size_t i = 0; i < kTarBlock; ++i) {
+        sum += static_cast<unsigned char>(header[i]);
+    }
+    std::snprintf(header + 148, 8, "%06o", sum);
+    header[155] = ' ';
+}
+
+/**
+ * @brief 本机架构的 OCI 名称
+ */
+std::string ociArchitecture() {
+    struct utsname info;
+    std::string machine = uname(&info) == 0 ? info.machine : "";
+    if (machine == "x86_64") {
+        return "amd64";
+    }
+    if (machine == "aarch64") {
+        return "arm64";
+    }
+    if (machine.compare(0, 3, "arm") == 0) {
+        return "arm";
+    }
+    if (machine == "i686" || machine == "i386") {
+        return "386";
+    }
+    return machine;
+}
+
+/**
+ * @brief 层数据流：同时计算未压缩 tar 的摘要（diff_id）与层文件的摘要
+ *
+ * 不压缩时文件内容由内核直接拷贝，摘要在映射的页面上计算；
+ * 压缩时 tar 流切成块交给工作线程，按顺序写出并合并各块的 CRC32。
+ */
+class LayerStream {
+public:
+    LayerStream(int fd, bool compress, unsigned threads)
+        : fd_(fd), compress_(compress), failed_(false), tarBytes_(0), blobBytes_(0) {
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+        if (compress_) {
+            static const unsigned char kGzipHeader[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+            emit(kGzipHeader, sizeof(kGzipHeader));
+            window_ = threads * 2;
+            for (unsigned i = 0; i < threads; ++i) {
+                workers_.emplace_back([this]() { compressLoop(); });
+            }
+        }
+#else
+        (void)threads;
+#endif
+    }
+
+    ~LayerStream() {
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+        if (compress_) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            queueReady_.notify_all();
+            for (auto& worker : workers_) {
+                worker.join();
+            }
+        }
+#endif
+    }
+
+    bool write(const void* data, std::size_t size) {
+        tarHash_.update(data, size);
+        tarBytes_ += size;
+        if (!compress_) {
+            return emit(data, size);
+        }
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        while (size > 0 && !failed_) {
+            std::size_t n = std::min(size, kChunkSize - chunk_.size());
+            chunk_.insert(chunk_.end(), p, p + n);
+            p += n;
+            size -= n;
+            if (chunk_.size() == kChunkSize) {
+                submit(false);
+            }
+        }
+        return !failed_;
+    }
+
+    /**
+     * @brief 写入整个文件的内容（size 为开始时 lstat 得到的大小）
+     */
+    bool copyFile(int src, std::uint64_t size) {
+        posix_fadvise(src, 0, 0, POSIX_FADV_SEQUENTIAL);
+        return compress_ ? readInto(src, size) : copyDirect(src, size);
+    }
+
+    /**
+     * @brief 结束数据流
+     */
+    bool finish() {
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+        if (compress_ && !failed_) {
+            submit(true);
+            drain(true);
+            unsigned char trailer[8];
+            std::uint32_t isize = static_cast<std::uint32_t>(tarBytes_);
+            for (int i = 0; i < 4; ++i) {
+                trailer[i] = static_cast<unsigned char>(crc_ >> (8 * i));
+                trailer[4 + i] = static_cast<unsigned char>(isize >> (8 * i));
+            }
+            emit(trailer, sizeof(trailer));
+        }
+#endif
+        diffId_ = tarHash_.hexDigest();
+        digest_ = compress_ ? blobHash_.hexDigest() : diffId_;
+        return !failed_;
+    }
+
+    const std::string& diffId() const { return diffId_; }
+    const std::string& digest() const { return digest_; }
+    std::uint64_t tarBytes() const { return tarBytes_; }
+    std::uint64_t blobBytes() const { return blobBytes_; }
+
+private:
+    int fd_;
+    bool compress_;
+    bool failed_;
+    std::uint64_t tarBytes_;
+    std::uint64_t blobBytes_;
+    Sha256 tarHash_;
+    Sha256 blobHash_;
+    std::string diffId_;
+    std::string digest_;
+    std::vector<unsigned char> chunk_;
+
+    bool emit(const void* data, std::size_t size) {
+        if (compress_) {
+            blobHash_.update(data, size);
+        }
+        const char* p = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = ::write(fd_, p, size);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                failed_ = true;
+                return false;
+            }
+            p += n;
+            size -= static_cast<std::size_t>(n);
+            blobBytes_ += static_cast<std::uint64_t>(n);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 不压缩：copy_file_range（同一文件系统上可能直接共享数据块），
+     * 跨文件系统不支持时退回 sendfile，再退回从映射写出；摘要在映射的页面上计算
+     */
+    bool copyDirect(int src, std::uint64_t size) {
+        for (std::uint64_t offset = 0; offset < size && !failed_;) {
+            std::size_t length = static_cast<std::size_t>(std::min<std::uint64_t>(kMapWindow, size - offset));
+            void* map = mmap(nullptr, length, PROT_READ, MAP_SHARED, src, static_cast<off_t>(offset));
+            if (map == MAP_FAILED) {
+                failed_ = true;
+                break;
+            }
+            madvise(map, length, MADV_SEQUENTIAL);
+
+            loff_t in = static_cast<loff_t>(offset);
+            std::size_t done = 0;
+            while (done < length) {
+                ssize_t n = copy_file_range(src, &in, fd_, nullptr, length - done, 0);
+                if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                    off_t sendOffset = static_cast<off_t>(in);
+                    n = sendfile(fd_, src, &sendOffset, length - done);
+                    if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                        n = ::write(fd_, static_cast<const char*>(map) + done, length - done);
+                    }
+                    if (n > 0) {
+                        in += n;
+                    }
+                }
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    failed_ = true;  // 文件在导出过程中被截短，或写入失败
+                    break;
+                }
+                done += static_cast<std::size_t>(n);
+            }
+            if (!failed_) {
+                tarHash_.update(map, length);
+                tarBytes_ += length;
+                blobBytes_ += length;
+            }
+            munmap(map, length);
+            offset += length;
+        }
+        return !failed_;
+    }
+
+    /**
+     * @brief 压缩：文件内容直接读进当前块
+     */
+    bool readInto(int src, std::uint64_t size) {
+        std::uint64_t offset = 0;
+        while (offset < size && !failed_) {
+            std::size_t used = chunk_.size();
+            std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(kChunkSize - used, size - offset));
+            chunk_.resize(used + n);
+            std::size_t got = 0;
+            while (got < n) {
+                ssize_t r = pread(src, chunk_.data() + used + got, n - got, static_cast<off_t>(offset + got));
+                if (r < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (r <= 0) {
+                    failed_ = true;
+                    return false;
+                }
+                got += static_cast<std::size_t>(r);
+            }
+            tarHash_.update(chunk_.data() + used, n);
+            tarBytes_ += n;
+            offset += n;
+            if (chunk_.size() == kChunkSize) {
+                submit(false);
+            }
+        }
+        return !failed_;
+    }
+
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+    struct Job {
+        std::vector<unsigned char> input;
+        std::vector<unsigned char> dictionary;
+        std::vector<unsigned char> output;
+        std::size_t inputSize = 0;
+        uLong crc = 0;
+        bool last = false;
+        bool done = false;
+        bool ok = false;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable queueReady_;
+    std::condition_variable jobDone_;
+    std::deque<Job*> queue_;                       // 等待压缩
+    std::deque<std::unique_ptr<Job>> inflight_;    // 按顺序等待写出
+    std::vector<std::thread> workers_;
+    std::vector<unsigned char> dictionary_;
+    std::size_t window_ = 0;
+    bool stopping_ = false;
+    uLong crc_ = 0;
+
+    void submit(bool last) {
+        std::unique_ptr<Job> job(new Job());
+        job->input.swap(chunk_);
+        job->inputSize = job->input.size();
+        job->dictionary = dictionary_;
+        job->last = last;
+        // 下一块的字典取本块末尾（不足时与更早的数据拼接）
+        dictionary_.insert(dictionary_.end(), job->input.begin(), job->input.end());
+        if (dictionary_.size() > kDictionarySize) {
+            dictionary_.erase(dictionary_.begin(), dictionary_.end() - kDictionarySize);
+        }
+        chunk_.reserve(kChunkSize);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(job.get());
+            inflight_.push_back(std::move(job));
+        }
+        queueReady_.notify_one();
+        drain(false);
+    }
+
+    /**
+     * @brief 按顺序写出已压缩的块；all 为 false 时只在在途块过多时等待
+     */
+    void drain(bool all) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!inflight_.empty()) {
+            Job* front = inflight_.front().get();
+            if (!front->done) {
+                if (!all && inflight_.size() < window_) {
+                    return;
+                }
+                jobDone_.wait(lock, [front]() { return front->done; });
+            }
+            std::unique_ptr<Job> job = std::move(inflight_.front());
+            inflight_.pop_front();
+            lock.unlock();
+            if (!job->ok) {
+                failed_ = true;
+            } else {
+                crc_ = crc32_combine(crc_, job->crc, static_cast<z_off_t>(job->inputSize));
+                emit(job->output.data(), job->output.size());
+            }
+            lock.lock();
+        }
+    }
+
+    void compressLoop() {
+        for (;;) {
+            Job* job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                queueReady_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                job = queue_.front();
+                queue_.pop_front();
+            }
+            compress(*job);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                job->done = true;
+            }
+            jobDone_.notify_all();
+        }
+    }
+
+    /**
+     * @brief 原始 deflate 一块：非末块以 Z_SYNC_FLUSH 对齐到字节边界，各块可直接拼接
+     */
+    static void compress(Job& job) {
+        job.crc = crc32(0L, job.input.data(), static_cast<uInt>(job.input.size()));
+        z_stream zs;
+        std::memset(&zs, 0, sizeof(zs));
+        if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return;
+        }
+        if (!job.dictionary.empty()) {
+            deflateSetDictionary(&zs, job.dictionary.data(), static_cast<uInt>(job.dictionary.size()));
+        }
+        job.output.resize(deflateBound(&zs, static_cast<uLong>(job.input.size())) + 16);
+        zs.next_in = job.input.data();
+        zs.avail_in = static_cast<uInt>(job.input.size());
+        int rc;
+        do {
+            if (zs.total_out == job.output.size()) {
+                job.output.resize(job.output.size() * 2);
+            }
+            zs.next_out = job.output.data() + zs.total_out;
+            zs.avail_out = static_cast<uInt>(job.output.size() - zs.total_out);
+            rc = deflate(&zs, job.last ? Z_FINISH : Z_SYNC_FLUSH);
+        } while (rc == Z_OK && zs.avail_out == 0);
+        job.ok = job.last ? rc == Z_STREAM_END : rc == Z_OK;
+        job.output.resize(zs.total_out);
+        deflateEnd(&zs);
+        std::vector<unsigned char>().swap(job.input);
+        std::vector<unsigned char>().swap(job.dictionary);
+    }
+#else
+    void submit(bool) {
+    }
+#endif
+};
+
+/**
+ * @brief 写入内容寻址的 blob
+ */
+bool writeBlob(const std::string& outDir, const std::string& content, std::string& digest) {
+    Sha256 hasher;
+    hasher.update(content.data(), content.size());
+    digest = hasher.hexDigest();
+    return FileUtils::writeFileAtomic(outDir + "/blobs/sha256/" + digest, content);
+}
+
+} // namespace
+
+OciImageWriter::OciImageWriter(const std::string& outDir) : outDir_(outDir) {
+}
+
+bool OciImageWriter::compressionAvailable() {
+#ifdef LINUXSTUDIO_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void OciImageWriter::addPath(const std::string& path) {
+    if (path.empty() || path == "/" || path == "/.") {
+        return;  // dpkg 的 .list 以 "/." 表示根目录
+    }
+    std::string canonical = canonicalPath(path);
+    for (size_t slash = canonical.find('/', 1); slash != std::string::npos; slash = canonical.find('/', slash + 1)) {
+        paths_.insert(canonical.substr(0, slash));
+    }
+    paths_.insert(canonical);
+}
+
+void OciImageWriter::addTree(const std::string& root) {
+    std::string canonical = canonicalPath(root);
+    struct stat st;
+    if (lstat(canonical.c_str(), &st) != 0) {
+        return;
+    }
+    addPath(canonical);
+    if (!S_ISDIR(st.st_mode)) {
+        return;
+    }
+
+    std::mutex pathsMutex;
+    FileUtils::walkParallel({canonical}, [&](const std::string& dir, std::vector<std::string>& children) {
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        std::vector<std::string> found;
+        FileUtils::readEntries(fd, [&](const char* name, unsigned char type) {
+            std::string path = dir + "/" + name;
+            struct stat child;
+            if (type == DT_UNKNOWN && lstat(path.c_str(), &child) == 0 && S_ISDIR(child.st_mode)) {
+                type = DT_DIR;  // 部分文件系统不提供 d_type
+            }
+            if (type == DT_DIR) {
+                children.push_back(path);
+            }
+            found.push_back(path);
+        });
+        close(fd);
+        std::lock_guard<std::mutex> lock(pathsMutex);
+        paths_.insert(found.begin(), found.end());
+    });
+}
+
+bool OciImageWriter::write(const Options& options, Report& report) {
+    auto start = std::chrono::steady_clock::now();
+    report = Report();
+
+    // 收集条目（有序集合保证上级目录先于其内容写入）
+    std::vector<Entry> entries;
+    entries.reserve(paths_.size());
+    for (const auto& path : paths_) {
+        Entry entry;
+        entry.path = path;
+        if (lstat(path.c_str(), &entry.st) != 0) {
+            continue;
+        }
+        if (S_ISDIR(entry.st.st_mode)) {
+            entry.type = '5';
+        } else if (S_ISLNK(entry.st.st_mode)) {
+            char target[PATH_MAX];
+            ssize_t n = readlink(path.c_str(), target, sizeof(target));
+            if (n < 0) {
+                continue;
+            }
+            entry.type = '2';
+            entry.link.assign(target, static_cast<size_t>(n));
+        } else if (!S_ISREG(entry.st.st_mode)) {
+            continue;  // 设备文件、套接字等不导出
+        }
+        entries.push_back(std::move(entry));
+    }
+
+    // 去重：同一 inode 直接成为硬链接；大小、权限、属主都相同的文件再比较内容摘要
+    std::map<std::pair<dev_t, ino_t>, size_t> inodes;
+    std::map<std::tuple<off_t, mode_t, uid_t, gid_t>, std::vector<size_t>> candidates;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Entry& entry = entries[i];
+        if (entry.type != '0') {
+            continue;
+        }
+        if (entry.st.st_nlink > 1) {
+            auto inserted = inodes.emplace(std::make_pair(entry.st.st_dev, entry.st.st_ino), i);
+            if (!inserted.second) {
+                entry.type = '1';
+                entry.link = archiveName(entries[inserted.first->second].path, false);
+                continue;
+            }
+        }
+        if (entry.st.st_size > 0) {
+            candidates[std::make_tuple(entry.st.st_size, entry.st.st_mode, entry.st.st_uid, entry.st.st_gid)]
+                .push_back(i);
+        }
+    }
+    std::vector<size_t> toHash;
+    for (const auto& group : candidates) {
+        if (group.second.size() > 1) {
+            toHash.insert(toHash.end(), group.second.begin(), group.second.end());
+        }
+    }
+    std::sort(toHash.begin(), toHash.end());
+    std::vector<std::string> digests(entries.size());
+    FileUtils::parallelFor(toHash.size(), [&](size_t i) {
+        Xxh64::hashFile(entries[toHash[i]].path, digests[toHash[i]]);
+    });
+    std::map<std::pair<off_t, std::string>, size_t> contents;
+    for (size_t i : toHash) {
+        if (digests[i].empty()) {
+            continue;
+        }
+        auto inserted = contents.emplace(std::make_pair(entries[i].st.st_size, digests[i]), i);
+        if (!inserted.second) {
+            entries[i].type = '1';
+            entries[i].link = archiveName(entries[inserted.first->second].path, false);
+        }
+    }
+
+    std::string blobDir = outDir_ + "/blobs/sha256";
+    mkdir(outDir_.c_str(), 0755);
+    mkdir((outDir_ + "/blobs").c_str(), 0755);
+    mkdir(blobDir.c_str(), 0755);
+    std::string tmpPath = blobDir + "/.layer." + std::to_string(getpid()) + ".tmp";
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool compress = options.compress && compressionAvailable();
+    unsigned threads = options.threads;
+    if (threads == 0) {
+#ifdef LINUXSTUDIO_EMBEDDED
+        threads = 2;
+#else
+        threads = std::max(1u, std::thread::hardware_concurrency());
+#endif
+    }
+
+    bool ok = true;
+    {
+        LayerStream stream(fd, compress, threads);
+        static const char kZeros[kTarBlock * 2] = {};
+        char header[kTarBlock];
+        for (const auto& entry : entries) {
+            if (!ok) {
+                break;
+            }
+            int src = -1;
+            std::uint64_t size = 0;
+            if (entry.type == '0') {
+                src = open(entry.path.c_str(), O_RDONLY | O_CLOEXEC | O_NOATIME);
+                if (src < 0) {
+                    src = open(entry.path.c_str(), O_RDONLY | O_CLOEXEC);  // O_NOATIME 只允许文件属主
+                }
+                if (src < 0) {
+                    continue;
+                }
+                size = static_cast<std::uint64_t>(entry.st.st_size);
+            }
+
+            // 名称、链接目标超出 ustar 字段或文件过大：先写 PAX 扩展头
+            std::string name = archiveName(entry.path, entry.type == '5');
+            std::string pax;
+            if (name.size() > 100) {
+                pax += paxRecord("path", name);
+            }
+            if (entry.link.size() > 100) {
+                pax += paxRecord("linkpath", entry.link);
+            }
+            if (size > kUstarMaxSize) {
+                pax += paxRecord("size", std::to_string(size));
+            }
+            if (!pax.empty()) {
+                makeHeader(header, "PaxHeaders/" + name.substr(0, 80), 'x', entry.st, pax.size(), "");
+                ok = stream.write(header, kTarBlock) && stream.write(pax.data(), pax.size()) &&
+                     stream.write(kZeros, (kTarBlock - pax.size() % kTarBlock) % kTarBlock);
+            }
+
+            makeHeader(header, name, entry.type, entry.st, size, entry.link);
+            ok = ok && stream.write(header, kTarBlock);
+            if (src >= 0) {
+                ok = ok && stream.copyFile(src, size) && stream.write(kZeros, (kTarBlock - size % kTarBlock) % kTarBlock);
+                close(src);
+            }
+
+            switch (entry.type) {
+                case '0': ++report.files; break;
+                case '1': ++report.deduplicated; break;
+                case '2': ++report.symlinks; break;
+                default:  ++report.directories; break;
+            }
+        }
+        ok = ok && stream.write(kZeros, sizeof(kZeros)) && stream.finish();
+        report.tarBytes = stream.tarBytes();
+        report.blobBytes = stream.blobBytes();
+        report.layerDigest = "sha256:" + stream.digest();
+
+        ok = (close(fd) == 0) && ok;
+        ok = ok && std::rename(tmpPath.c_str(), (blobDir + "/" + stream.digest()).c_str()) == 0;
+        if (!ok) {
+            unlink(tmpPath.c_str());
+            return false;
+        }
+
+        // 配置中不写时间戳：输入相同则镜像摘要相同
+        std::string config = "{\"architecture\":\"" + ociArchitecture() + "\",\"os\":\"linux\",\"config\":{},"
+                             "\"rootfs\":{\"type\":\"layers\",\"diff_ids\":[\"sha256:" + stream.diffId() + "\"]}}";
+        std::string configDigest;
+        ok = writeBlob(outDir_, config, configDigest);
+
+        std::string layerType = compress ? "application/vnd.oci.image.layer.v1.tar+gzip"
+                                         : "application/vnd.oci.image.layer.v1.tar";
+        std::string manifest = std::string("{\"schemaVersion\":2,\"mediaType\":\"") + kManifestType + "\","
+                               "\"config\":{\"mediaType\":\"" + kConfigType + "\",\"digest\":\"sha256:" +
+                               configDigest + "\",\"size\":" + std::to_string(config.size()) + "},"
+                               "\"layers\":[{\"mediaType\":\"" + layerType + "\",\"digest\":\"" +
+                               report.layerDigest + "\",\"size\":" + std::to_string(report.blobBytes) + "}]}";
+        std::string manifestDigest;
+        ok = ok && writeBlob(outDir_, manifest, manifestDigest);
+        report.manifestDigest = "sha256:" + manifestDigest;
+
+        std::string annotations;
+        if (!options.reference.empty()) {
+            annotations = ",\"annotations\":{\"org.opencontainers.image.ref.name\":\"" + options.reference + "\"}";
+        }
+        std::string index = std::string("{\"schemaVersion\":2,\"manifests\":[{\"mediaType\":\"") + kManifestType +
+                            "\",\"digest\":\"" + report.manifestDigest + "\",\"size\":" +
+                            std::to_string(manifest.size()) + annotations + "}]}";
+        ok = ok && FileUtils::writeFileAtomic(outDir_ + "/index.json", index) &&
+             FileUtils::writeFileAtomic(outDir_ + "/oci-layout", "{\"imageLayoutVersion\":\"1.0.0\"}");
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+} // namespace LinuxStudio
@@ -0,0 +1,359 @@
+#include "linuxstudio/output.hpp"
+#include <cerrno>
+#include <cstdio>
+
+#ifdef _WIN32
+    #include <io.h>
+    #define write_fd _write
+#else
+    #include <unistd.h>
+    #define write_fd ::write
+#endif
+
+namespace LinuxStudio {
+
+namespace {
+// 超过该大小即刷新，保证大列表输出时内存不随条目数增长
+#ifdef LINUXSTUDIO_EMBEDDED
+const size_t kFlushThreshold = 8 * 1024;
+#else
+const size_t kFlushThreshold = 64 * 1024;
+#endif
+}
+
+Output& Output::getInstance() {
+    static Output instance;
+    return instance;
+}
+
+Output::Output() : format_(OutputFormat::TEXT) {
+    buffer_.reserve(kFlushThreshold + 4096);
+}
+
+Output::~Output() {
+    flush();
+}
+
+bool Output::parseFormat(const std::string& name, OutputFormat& format) {
+    if (name == "json") {
+        format = OutputFormat::JSON;
+    } else if (name == "tsv") {
+        format = OutputFormat::TSV;
+    } else if (name == "text") {
+        format = OutputFormat::TEXT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+Output& Output::operator<<(const std::string& s) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText()) {
+        buffer_ += s;
+        maybeFlush();
+    }
+    return *this;
+}
+
+Output& Output::operator<<(std::string_view s) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText()) {
+        buffer_ += s;
+        maybeFlush();
+    }
+    return *this;
+}
+
+Output& Output::operator<<(const char* s) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText()) {
+        buffer_ += s;
+        maybeFlush();
+    }
+    return *this;
+}
+
+Output& Output::operator<<(char c) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText()) {
+        buffer_ += c;
+    }
+    return *this;
+}
+
+void Output::beginMember(const std::string& key) {
+    if (scopes_.empty()) {
+        return;
+    }
+    Scope& scope = scopes_.back();
+    if (format_ == OutputFormat::JSON) {
+        if (!scope.first) {
+            buffer_ += ',';
+        }
+        if (scope.type != ScopeType::LIST) {
+            appendJsonString(key);
+            buffer_ += ':';
+        }
+    }
+    scope.first = false;
+}
+
+void Output::beginObject(const std::string& key) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText()) {
+        return;
+    }
+    std::string prefix;
+    if (!scopes_.empty()) {
+        beginMember(key);
+        prefix = scopes_.back().prefix + key + ".";
+    }
+    if (format_ == OutputFormat::JSON) {
+        buffer_ += '{';
+    }
+    scopes_.push_back({ScopeType::OBJECT, true, prefix});
+}
+
+void Output::endObject() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText() || scopes_.empty()) {
+        return;
+    }
+    scopes_.pop_back();
+    if (format_ == OutputFormat::JSON) {
+        buffer_ += '}';
+        if (scopes_.empty()) {
+            buffer_ += '\n';
+        }
+    }
+    if (scopes_.empty()) {
+        flush();
+    }
+}
+
+void Output::beginList(const std::string& key, std::initializer_list<const char*> columns) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText()) {
+        return;
+    }
+    beginMember(key);
+    if (format_ == OutputFormat::JSON) {
+        buffer_ += '[';
+    } else if (columns.size() > 0) {
+        bool first = true;
+        for (const char* column : columns) {
+            if (!first) {
+                buffer_ += '\t';
+            }
+            buffer_ += column;
+            first = false;
+        }
+        buffer_ += '\n';
+    }
+    scopes_.push_back({ScopeType::LIST, true, ""});
+}
+
+void Output::endList() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText() || scopes_.empty()) {
+        return;
+    }
+    scopes_.pop_back();
+    if (format_ == OutputFormat::JSON) {
+        buffer_ += ']';
+    }
+}
+
+void Output::beginRow() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText()) {
+        return;
+    }
+    beginMember("");
+    if (format_ == OutputFormat::JSON) {
+        buffer_ += '{';
+    }
+    scopes_.push_back({ScopeType::ROW, true, ""});
+}
+
+void Output::endRow() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText() || scopes_.empty()) {
+        return;
+    }
+    scopes_.pop_back();
+    buffer_ += (format_ == OutputFormat::JSON) ? '}' : '\n';
+    maybeFlush();
+}
+
+void Output::writeScalar(const std::string& key, const std::string& raw, bool quoted) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText() || scopes_.empty()) {
+        return;
+    }
+    if (format_ == OutputFormat::JSON) {
+        beginMember(key);
+        if (quoted) {
+            appendJsonString(raw);
+        } else {
+            buffer_ += raw;
+        }
+        return;
+    }
+
+    // TSV：行内字段以制表符分隔，其余字段输出为 "键<TAB>值"
+    Scope& scope = scopes_.back();
+    if (scope.type == ScopeType::ROW) {
+        if (!scope.first) {
+            buffer_ += '\t';
+        }
+        scope.first = false;
+        appendTsvValue(raw);
+    } else {
+        buffer_ += scope.prefix;
+        buffer_ += key;
+        buffer_ += '\t';
+        appendTsvValue(raw);
+        buffer_ += '\n';
+    }
+}
+
+void Output::field(const std::string& key, const std::string& value) {
+    writeScalar(key, value, true);
+}
+
+void Output::field(const std::string& key, const char* value) {
+    writeScalar(key, value ? value : "", true);
+}
+
+void Output::field(const std::string& key, long long value) {
+    writeScalar(key, std::to_string(value), false);
+}
+
+void Output::field(const std::string& key, bool value) {
+    writeScalar(key, value ? "true" : "false", false);
+}
+
+void Output::field(const std::string& key, const std::vector<std::string>& values) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (isText() || scopes_.empty()) {
+        return;
+    }
+    if (format_ == OutputFormat::JSON) {
+        beginMember(key);
+        buffer_ += '[';
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i > 0) {
+                buffer_ += ',';
+            }
+            appendJsonString(values[i]);
+        }
+        buffer_ += ']';
+        return;
+    }
+
+    // TSV 中数组以逗号连接
+    std::string joined;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i > 0) {
+            joined += ',';
+        }
+        joined += values[i];
+    }
+    writeScalar(key, joined, true);
+}
+
+void Output::appendJsonString(const std::string& s) {
+    buffer_ += '"';
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  buffer_ += "\\\""; break;
+            case '\\': buffer_ += "\\\\"; break;
+            case '\n': buffer_ += "\\n"; break;
+            case '\r': buffer_ += "\\r"; break;
+            case '\t': buffer_ += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char esc[8];
+                    std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+                    buffer_ += esc;
+                } else {
+                    buffer_ += static_cast<char>(c);
+                }
+        }
+    }
+    buffer_ += '"';
+}
+
+void Output::appendTsvValue(const std::string& s) {
+    for (char c : s) {
+        switch (c) {
+            case '\t': buffer_ += "\\t"; break;
+            case '\n': buffer_ += "\\n"; break;
+            case '\\': buffer_ += "\\\\"; break;
+            default:   buffer_ += c;
+        }
+    }
+}
+
+void Output::write(const char* data, size_t size) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    buffer_.append(data, size);
+    maybeFlush();
+}
+
+void Output::maybeFlush() {
+    if (buffer_.size() >= kFlushThreshold) {
+        flush();
+    }
+}
+
+void Output::flush() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (statusLines_ > 0 && !buffer_.empty()) {
+        // 状态区始终在最下方：擦掉后写出新内容再重绘，一次 write 完成，不会闪烁出半帧
+        writeOut(eraseStatus() + buffer_ + status_);
+    } else {
+        writeOut(buffer_);
+    }
+    buffer_.clear();
+}
+
+void Output::setStatus(const std::string& block) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::string frame = eraseStatus() + buffer_ + block;
+    buffer_.clear();
+    status_ = block;
+    statusLines_ = 0;
+    for (char c : block) {
+        statusLines_ += (c == '\n') ? 1 : 0;
+    }
+    writeOut(frame);
+}
+
+std::string Output::eraseStatus() const {
+    if (statusLines_ == 0) {
+        return std::string();
+    }
+    // 光标回到状态区第一行行首，清除到屏幕末尾
+    return "\x1b[" + std::to_string(statusLines_) + "F\x1b[J";
+}
+
+void Output::writeOut(const std::string& content) {
+    const char* data = content.data();
+    size_t remaining = content.size();
+    while (remaining > 0) {
+        auto n = write_fd(1, data, static_cast<unsigned int>(remaining));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;  // stdout 已关闭（如管道提前退出），丢弃剩余输出
+        }
+        data += n;
+        remaining -= static_cast<size_t>(n);
+    }
+}
+
+} // namespace LinuxStudio
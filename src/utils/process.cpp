@@ -0,0 +1,86 @@
+#include "linuxstudio/process.hpp"
+#include "linuxstudio/output.hpp"
+#include "linuxstudio/progress.hpp"
+#include "linuxstudio/resource_slice.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+/**
+ * @brief 嵌入式模式下 xkl 自身带数据段软限制，外部命令（apt、pip）启动前恢复到硬限制
+ */
+std::string withoutBudget(const std::string& cmd) {
+#ifdef LINUXSTUDIO_EMBEDDED
+    return "ulimit -S -d \"$(ulimit -H -d)\" 2>/dev/null; " + cmd;
+#else
+    return cmd;
+#endif
+}
+
+} // namespace
+
+int Process::run(const std::string& cmd) {
+    // 子进程直接写 fd 1，先把已缓冲的内容写出去
+    Output::getInstance().flush();
+    return system(withoutBudget(cmd).c_str());
+}
+
+int Process::run(const std::string& cmd, const std::string& label) {
+    Output::getInstance().flush();
+    auto& progress = ProgressEngine::getInstance();
+    std::string wrapped = ResourceSlice::getInstance().wrap("(" + cmd + ") 2>&1 < /dev/null");
+    FILE* pipe = popen(withoutBudget(wrapped).c_str(), "r");
+    if (pipe == nullptr) {
+        return -1;
+    }
+    int task = progress.begin(label);
+    char buffer[4096];
+    for (;;) {
+        ssize_t n = read(fileno(pipe), buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        progress.feed(task, buffer, static_cast<size_t>(n));
+    }
+    int status = pclose(pipe);
+    progress.end(task, status == 0);
+    return status;
+}
+
+bool Process::capture(const std::string& cmd, std::string& output) {
+    Output::getInstance().flush();
+    output.clear();
+    FILE* pipe = popen(withoutBudget(cmd).c_str(), "r");
+    if (pipe == nullptr) {
+        return false;
+    }
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        output.append(buffer, n);
+    }
+    return pclose(pipe) == 0;
+}
+
+std::string Process::quote(const std::string& arg) {
+    std::string quoted = "'";
+    for (char c : arg) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+} // namespace LinuxStudio
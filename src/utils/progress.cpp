@@ -0,0 +1,322 @@
+#include "linuxstudio/progress.hpp"
+#include "linuxstudio/output.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+// 状态区最高帧率与非终端摘要间隔：串口等慢速终端上输出本身就会拖慢安装
+#ifdef LINUXSTUDIO_EMBEDDED
+const auto kFrameInterval = std::chrono::milliseconds(250);
+const auto kSummaryInterval = std::chrono::seconds(30);
+#else
+const auto kFrameInterval = std::chrono::milliseconds(100);
+const auto kSummaryInterval = std::chrono::seconds(10);
+#endif
+
+const std::size_t kRecentLines = 12;    // 失败时附带的输出行数
+const std::size_t kMaxRows = 8;         // 状态区最多显示的任务数
+const std::size_t kBarWidth = 20;
+
+const char* const kSpinner[] = {"⠋", "⠙", "⠹", "⠸", "⠼", "⠴", "⠦", "⠧", "⠇", "⠏"};
+
+bool startsWith(const std::string& s, const char* prefix) {
+    return s.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+/**
+ * @brief 第 index 个空白分隔的字段
+ */
+std::string word(const std::string& line, std::size_t index) {
+    std::size_t pos = 0;
+    for (std::size_t i = 0;; ++i) {
+        pos = line.find_first_not_of(" \t", pos);
+        if (pos == std::string::npos) {
+            return std::string();
+        }
+        std::size_t end = line.find_first_of(" \t", pos);
+        if (i == index) {
+            return line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        }
+        if (end == std::string::npos) {
+            return std::string();
+        }
+        pos = end;
+    }
+}
+
+/**
+ * @brief 按显示宽度截断（按字节近似，不截断 UTF-8 字符）
+ */
+std::string clip(const std::string& s, std::size_t width) {
+    if (s.size() <= width) {
+        return s;
+    }
+    std::size_t cut = width;
+    while (cut > 0 && (static_cast<unsigned char>(s[cut]) & 0xC0) == 0x80) {
+        --cut;
+    }
+    return s.substr(0, cut);
+}
+
+std::size_t terminalWidth() {
+    struct winsize ws;
+    if (ioctl(1, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 20) {
+        return ws.ws_col;
+    }
+    return 80;
+}
+
+std::string elapsed(std::chrono::steady_clock::time_point start) {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1fs", seconds);
+    return text;
+}
+
+} // namespace
+
+ProgressEngine& ProgressEngine::getInstance() {
+    static ProgressEngine instance;
+    return instance;
+}
+
+ProgressEngine::ProgressEngine() {
+    const char* term = std::getenv("TERM");
+    interactive_ = Output::getInstance().isText() && isatty(1) != 0 &&
+                   !(term != nullptr && std::strcmp(term, "dumb") == 0);
+}
+
+int ProgressEngine::begin(const std::string& label) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int id = nextId_++;
+    Task& task = tasks_[id];
+    task.label = label;
+    task.start = std::chrono::steady_clock::now();
+    render(true);
+    return id;
+}
+
+void ProgressEngine::feed(int id, const char* data, std::size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tasks_.find(id);
+    if (it == tasks_.end()) {
+        return;
+    }
+    Task& task = it->second;
+    // pip 的进度条以 \r 覆盖同一行，按行处理时与 \n 等同
+    for (std::size_t i = 0; i < size; ++i) {
+        char c = data[i];
+        if (c == '\n' || c == '\r') {
+            if (!task.partial.empty()) {
+                parseLine(task, task.partial);
+                task.partial.clear();
+            }
+        } else {
+            task.partial += c;
+        }
+    }
+    render(false);
+}
+
+void ProgressEngine::end(int id, bool ok) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tasks_.find(id);
+    if (it == tasks_.end()) {
+        return;
+    }
+    Task& task = it->second;
+    if (!task.partial.empty()) {
+        parseLine(task, task.partial);
+    }
+
+    std::string result = std::string(ok ? "  ✅ " : "  ❌ ") + task.label + " (" + elapsed(task.start) + ")\n";
+    if (!ok) {
+        for (const auto& line : task.recent) {
+            result += "     │ " + line + "\n";
+        }
+    }
+    tasks_.erase(it);
+
+    auto& out = Output::getInstance();
+    if (out.isText()) {
+        out << result;
+        if (!interactive_) {
+            out.flush();
+        }
+    } else {
+        std::fwrite(result.data(), 1, result.size(), stderr);
+    }
+    render(true);
+}
+
+void ProgressEngine::parseLine(Task& task, const std::string& line) {
+    ++task.lines;
+    task.recent.push_back(line);
+    if (task.recent.size() > kRecentLines) {
+        task.recent.pop_front();
+    }
+
+    std::string phase = task.phase;
+    std::string item = task.item;
+    double percent = task.percent;
+
+    if (startsWith(line, "pmstatus:") || startsWith(line, "dlstatus:") || startsWith(line, "pmerror:")) {
+        // APT::Status-Fd：<类型>:<包>:<百分比>:<说明>
+        std::size_t a = line.find(':');
+        std::size_t b = line.find(':', a + 1);
+        std::size_t c = b == std::string::npos ? b : line.find(':', b + 1);
+        if (c != std::string::npos) {
+            std::string kind = line.substr(0, a);
+            std::string message = line.substr(c + 1);
+            percent = std::strtod(line.c_str() + b + 1, nullptr);
+            if (kind == "dlstatus") {
+                phase = "download";
+            } else if (kind == "pmerror") {
+                task.error = message;
+            } else {
+                item = line.substr(a + 1, b - a - 1);
+                if (startsWith(message, "Unpacking") || startsWith(message, "Preparing")) {
+                    phase = "unpack";
+                } else if (startsWith(message, "Configuring") || startsWith(message, "Installed") ||
+                           startsWith(message, "Setting up")) {
+                    phase = "configure";
+                } else if (startsWith(message, "Removing") || startsWith(message, "Removed")) {
+                    phase = "remove";
+                }
+            }
+        }
+    } else if (startsWith(line, "Get:")) {
+        // Get:3 <URI> [<发行版/分区> <架构>] <包> <架构> <版本> [<大小>]：包名是大小之前的第三个字段
+        phase = "download";
+        for (std::size_t i = 4;; ++i) {
+            std::string field = word(line, i);
+            if (field.empty()) {
+                break;
+            }
+            if (field[0] == '[') {
+                item = word(line, i - 3);
+                break;
+            }
+        }
+    } else if (startsWith(line, "Unpacking ") || startsWith(line, "Selecting previously unselected package ")) {
+        phase = "unpack";
+        item = startsWith(line, "Unpacking ") ? word(line, 1) : word(line, 4);
+        if (!item.empty() && item.back() == '.') {
+            item.pop_back();
+        }
+    } else if (startsWith(line, "Setting up ")) {
+        phase = "configure";
+        item = word(line, 2);
+    } else if (startsWith(line, "Removing ")) {
+        phase = "remove";
+        item = word(line, 1);
+    } else if (startsWith(line, "Progress: [")) {
+        // Dpkg::Progress-Fancy 在非终端上的输出
+        percent = std::strtod(line.c_str() + 11, nullptr);
+    } else if (startsWith(line, "Collecting ")) {
+        phase = "resolve";
+        item = word(line, 1);
+    } else if (startsWith(line, "Downloading ") || startsWith(line, "Using cached ")) {
+        phase = "download";
+        item = word(line, startsWith(line, "Using cached ") ? 2 : 1);
+        std::size_t slash = item.rfind('/');
+        if (slash != std::string::npos) {
+            item = item.substr(slash + 1);
+        }
+    } else if (startsWith(line, "Installing collected packages:")) {
+        phase = "install";
+        item.clear();
+    } else if (startsWith(line, "Successfully ")) {
+        percent = 100;
+    } else if (startsWith(line, "E: ") || startsWith(line, "ERROR:") || startsWith(line, "dpkg: error")) {
+        task.error = line;
+    }
+
+    if (phase != task.phase || item != task.item || percent != task.percent) {
+        task.phase = phase;
+        task.item = item;
+        task.percent = percent;
+        task.changed = true;
+    }
+}
+
+std::string ProgressEngine::statusLine(const Task& task, std::size_t width) const {
+    std::string line = task.label;
+    if (!task.phase.empty()) {
+        line += "  " + task.phase;
+    }
+    if (task.percent >= 0) {
+        int percent = static_cast<int>(task.percent);
+        if (interactive_) {
+            std::size_t filled = static_cast<std::size_t>(task.percent / 100.0 * kBarWidth);
+            line += "  [" + std::string(std::min(filled, kBarWidth), '#') +
+                    std::string(kBarWidth - std::min(filled, kBarWidth), '.') + "]";
+        }
+        line += " " + std::to_string(percent) + "%";
+    }
+    if (!task.item.empty()) {
+        line += "  " + task.item;
+    }
+    if (!interactive_) {
+        line += "  (" + elapsed(task.start) + ")";
+    }
+    return clip(line, width);
+}
+
+void ProgressEngine::render(bool force) {
+    auto now = std::chrono::steady_clock::now();
+    auto& out = Output::getInstance();
+
+    if (interactive_) {
+        if (!force && now - lastFrame_ < kFrameInterval) {
+            return;
+        }
+        lastFrame_ = now;
+        std::size_t frame = static_cast<std::size_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() / 100);
+        std::size_t width = terminalWidth() - 6;
+        std::string block;
+        std::size_t rows = 0;
+        for (const auto& entry : tasks_) {
+            if (rows++ == kMaxRows) {
+                block += "  … +" + std::to_string(tasks_.size() - kMaxRows) + "\n";
+                break;
+            }
+            block += std::string("  ") + kSpinner[(frame + rows) % 10] + " " + statusLine(entry.second, width) + "\n";
+        }
+        out.setStatus(block);
+        return;
+    }
+
+    // 非终端：定期输出有变化的任务，结束时由 end() 输出结果
+    if (force || now - lastFrame_ < kSummaryInterval) {
+        return;
+    }
+    lastFrame_ = now;
+    std::string summary;
+    for (auto& entry : tasks_) {
+        if (entry.second.changed) {
+            summary += "  … " + statusLine(entry.second, 160) + "\n";
+            entry.second.changed = false;
+        }
+    }
+    if (summary.empty()) {
+        return;
+    }
+    if (out.isText()) {
+        out << summary;
+        out.flush();
+    } else {
+        std::fwrite(summary.data(), 1, summary.size(), stderr);
+    }
+}
+
+} // namespace LinuxStudio
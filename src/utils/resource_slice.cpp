@@ -0,0 +1,407 @@
+#include "linuxstudio/resource_slice.hpp"
+#include "linuxstudio/disk_usage.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace LinuxStudio {
+
+namespace {
+
+// 每个编译任务预留的内存：并行度不超过 内存上限 / 该值，避免 -j 过大触发持续回收
+#ifdef LINUXSTUDIO_EMBEDDED
+const std::uint64_t kMemoryPerJob = 256ull << 20;
+#else
+const std::uint64_t kMemoryPerJob = 1ull << 30;
+#endif
+
+const long kCpuPeriodUs = 100000;
+const long kCpuMinQuotaUs = 1000;    // 内核接受的最小 quota
+
+// 等待 systemd 创建 scope 的上限
+const int kScopeWaitMs = 2000;
+
+/**
+ * @brief cgroup v2 的挂载点（纯 v2 为 /sys/fs/cgroup，混合模式常见 /sys/fs/cgroup/unified）
+ */
+std::string cgroup2Root() {
+    std::vector<std::string> mounts;
+    FileUtils::readLines("/proc/self/mounts", mounts);
+    for (const auto& line : mounts) {
+        std::vector<std::string> fields = FileUtils::splitFields(line);
+        if (fields.size() >= 3 && fields[2] == "cgroup2") {
+            return fields[1];
+        }
+    }
+    return std::string();
+}
+
+/**
+ * @brief 写 cgroup 接口文件（内核要求一次 write 写完）
+ */
+bool writeValue(const std::string& path, const std::string& value) {
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = write(fd, value.data(), value.size()) == static_cast<ssize_t>(value.size());
+    close(fd);
+    return ok;
+}
+
+unsigned usableCores() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+        return static_cast<unsigned>(CPU_COUNT(&set));
+    }
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? static_cast<unsigned>(cores) : 1;
+}
+
+std::uint64_t availableMemory() {
+    std::vector<std::string> lines;
+    FileUtils::readLines("/proc/meminfo", lines);
+    for (const auto& line : lines) {
+        if (line.compare(0, 13, "MemAvailable:") == 0) {
+            return std::strtoull(line.c_str() + 13, nullptr, 10) << 10;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief "key value" 格式统计文件（cpu.stat、memory.events）中的一项
+ */
+std::uint64_t statField(const std::string& content, const char* key) {
+    std::vector<std::string> lines;
+    FileUtils::splitLines(content, lines);
+    for (const auto& line : lines) {
+        std::vector<std::string> fields = FileUtils::splitFields(line);
+        if (fields.size() == 2 && fields[0] == key) {
+            return std::strtoull(fields[1].c_str(), nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief PSI 文件中 "some ... total=<微秒>" 的累计等待时间（秒）
+ */
+double stallSeconds(const std::string& path) {
+    std::string content;
+    if (!FileUtils::readFile(path, content) || content.compare(0, 4, "some") != 0) {
+        return 0;
+    }
+    std::size_t total = content.find("total=");
+    return total == std::string::npos ? 0 : std::strtod(content.c_str() + total + 6, nullptr) / 1e6;
+}
+
+/**
+ * @brief 百分比（相对于 base）、绝对值或 max；max 与无效值返回 0（不限制）
+ */
+double parseShare(const std::string& text, double base, bool bytes) {
+    if (text.empty() || text == "max") {
+        return 0;
+    }
+    if (text.back() == '%') {
+        return base * std::strtod(text.c_str(), nullptr) / 100.0;
+    }
+    if (bytes) {
+        std::uint64_t value = 0;
+        return DiskUsage::parseBytes(text, value) ? static_cast<double>(value) : 0;
+    }
+    return std::strtod(text.c_str(), nullptr);
+}
+
+/**
+ * @brief cpu.max 的值：按核数比例计算 quota（可以小于一个周期），不取整到整核
+ */
+std::string cpuMaxValue(double cores) {
+    long quota = std::max(static_cast<long>(cores * kCpuPeriodUs), kCpuMinQuotaUs);
+    return std::to_string(quota) + " " + std::to_string(kCpuPeriodUs);
+}
+
+/**
+ * @brief 内存能容纳的任务数（至少 1，内存未知时不限制）
+ */
+unsigned fitMemory(unsigned jobs, std::uint64_t memory, std::uint64_t memoryPerJob) {
+    if (memory > 0 && memoryPerJob > 0) {
+        jobs = std::min<unsigned>(jobs, static_cast<unsigned>(std::max<std::uint64_t>(memory / memoryPerJob, 1)));
+    }
+    return std::max(jobs, 1u);
+}
+
+} // namespace
+
+ResourceSlice& ResourceSlice::getInstance() {
+    static ResourceSlice instance;
+    return instance;
+}
+
+ResourceSlice::~ResourceSlice() {
+    // 子进程都已退出：结束占位进程后 scope 为空，由 systemd 回收；自己创建的 cgroup 为空即可删除
+    if (holder_ > 0) {
+        kill(holder_, SIGTERM);
+        waitpid(holder_, nullptr, 0);
+    } else if (!path_.empty()) {
+        rmdir(path_.c_str());
+    }
+}
+
+void ResourceSlice::loadConfig(const std::string& path) {
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(path, lines)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& line : lines) {
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> key = FileUtils::splitFields(line.substr(0, colon));
+        std::vector<std::string> value = FileUtils::splitFields(line.substr(colon + 1));
+        if (key.size() != 1 || value.empty()) {
+            continue;
+        }
+        const std::string& k = key[0];
+        const std::string& v = value[0];
+        if (k == "install_cgroup") {
+            enabled_ = (v == "true" || v == "yes" || v == "on");
+        } else if (k == "install_cpu_max") {
+            cpuMax_ = v;
+        } else if (k == "install_memory_high") {
+            memoryHigh_ = v;
+        } else if (k == "install_io_weight") {
+            ioWeight_ = static_cast<unsigned>(std::strtoul(v.c_str(), nullptr, 10));
+        } else if (k == "install_jobs") {
+            jobs_ = static_cast<unsigned>(std::strtoul(v.c_str(), nullptr, 10));
+        }
+    }
+}
+
+void ResourceSlice::prepare() {
+    prepared_ = true;
+    unsigned cores = usableCores();
+    std::uint64_t available = availableMemory();
+
+    double cpuCores = std::min<double>(parseShare(cpuMax_, cores, false), cores);
+    std::uint64_t memoryHigh = static_cast<std::uint64_t>(parseShare(memoryHigh_, static_cast<double>(available), true));
+
+    // 并行度：不超过 CPU 限额，也不超过内存限额能容纳的编译任务数
+    memoryBudget_ = memoryHigh > 0 ? memoryHigh : available;
+    if (jobs_ > 0) {
+        effectiveJobs_ = jobs_;
+    } else {
+        unsigned cpuJobs = cpuCores > 0 ? static_cast<unsigned>(std::max(cpuCores, 1.0)) : cores;
+        effectiveJobs_ = fitMemory(cpuJobs, memoryBudget_, kMemoryPerJob);
+    }
+
+    if (!enabled_ || geteuid() != 0) {
+        return;
+    }
+    std::string root = cgroup2Root();
+    std::string controllers;
+    if (root.empty() || !FileUtils::readFile(root + "/cgroup.controllers", controllers)) {
+        return;
+    }
+
+    std::vector<std::string> offered = FileUtils::splitFields(controllers);
+    auto has = [&](const char* name) {
+        return std::find(offered.begin(), offered.end(), name) != offered.end();
+    };
+    if (!has("cpu") && !has("memory") && !has("io")) {
+        return;   // 混合模式下控制器都还挂在 v1 上
+    }
+
+    // systemd 管理的 cgroup 树中不自己建目录，由它创建带限额的 scope
+    if (access("/run/systemd/system", F_OK) == 0 && startScope(root, cpuCores, memoryHigh)) {
+        return;
+    }
+
+    // 逐个启用控制器：缺少某个控制器（如容器内没有 io）不影响其他限制
+    std::string slice = root + "/" + kSliceName;
+    if (mkdir(slice.c_str(), 0755) != 0 && errno != EEXIST) {
+        return;
+    }
+    // 清理异常退出的 xkl 留下的空 cgroup
+    int dir = open(slice.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir >= 0) {
+        FileUtils::readEntries(dir, [&](const char* name, unsigned char) {
+            if (std::strncmp(name, "install-", 8) == 0) {
+                pid_t owner = static_cast<pid_t>(std::atoi(name + 8));
+                if (owner != getpid() && kill(owner, 0) != 0 && errno == ESRCH) {
+                    rmdir((slice + "/" + name).c_str());
+                }
+            }
+        });
+        close(dir);
+    }
+    for (const char* name : {"cpu", "memory", "io"}) {
+        if (has(name)) {
+            writeValue(root + "/cgroup.subtree_control", std::string("+") + name);
+            writeValue(slice + "/cgroup.subtree_control", std::string("+") + name);
+        }
+    }
+
+    std::string path = slice + "/install-" + std::to_string(getpid());
+    if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+        return;
+    }
+    path_ = path;
+
+    if (cpuCores > 0) {
+        std::string value = cpuMaxValue(cpuCores);
+        if (writeValue(path_ + "/cpu.max", value)) {
+            applied_.push_back("cpu.max " + value);
+        }
+    }
+    if (memoryHigh > 0 && writeValue(path_ + "/memory.high", std::to_string(memoryHigh))) {
+        applied_.push_back("memory.high " + DiskUsage::formatBytes(memoryHigh));
+    }
+    if (ioWeight_ > 0) {
+        std::string value = "default " + std::to_string(std::min(ioWeight_, 10000u));
+        if (writeValue(path_ + "/io.weight", value)) {
+            applied_.push_back("io.weight " + std::to_string(std::min(ioWeight_, 10000u)));
+        }
+    }
+}
+
+bool ResourceSlice::startScope(const std::string& root, double cpuCores, std::uint64_t memoryHigh) {
+    std::string unit = "xkl-install-" + std::to_string(getpid()) + ".scope";
+    std::vector<std::string> limits;
+    std::vector<std::string> applied;
+    if (cpuCores > 0) {
+        std::string percent = std::to_string(std::max(static_cast<long>(cpuCores * 100 + 0.5), 1L)) + "%";
+        limits.push_back("CPUQuota=" + percent);
+        applied.push_back("CPUQuota " + percent);
+    }
+    if (memoryHigh > 0) {
+        limits.push_back("MemoryHigh=" + std::to_string(memoryHigh));
+        applied.push_back("MemoryHigh " + DiskUsage::formatBytes(memoryHigh));
+    }
+    if (ioWeight_ > 0) {
+        std::string weight = std::to_string(std::min(ioWeight_, 10000u));
+        limits.push_back("IOWeight=" + weight);
+        applied.push_back("IOWeight " + weight);
+    }
+
+    // systemd-run 把自己登记进新建的 scope 后 exec 占位的 sleep，之后的命令逐个移入该 scope
+    std::vector<std::string> args = {"systemd-run", "--scope", "--quiet", "--collect", "--unit=" + unit,
+                                     std::string("--slice=") + kSliceName};
+    for (const auto& limit : limits) {
+        args.push_back("-p");
+        args.push_back(limit);
+    }
+    args.push_back("sleep");
+    args.push_back("infinity");
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        setpgid(0, 0);
+        int null = open("/dev/null", O_RDWR);
+        if (null >= 0) {
+            dup2(null, STDIN_FILENO);
+            dup2(null, STDOUT_FILENO);
+            dup2(null, STDERR_FILENO);
+        }
+        execvp("systemd-run", argv.data());
+        _exit(127);
+    }
+
+    std::string path = root + "/" + kSliceName + "/" + unit;
+    for (int waited = 0; waited < kScopeWaitMs; waited += 20) {
+        if (access((path + "/cgroup.procs").c_str(), F_OK) == 0) {
+            holder_ = pid;
+            path_ = path;
+            applied_ = applied;
+            return true;
+        }
+        if (waitpid(pid, nullptr, WNOHANG) == pid) {
+            return false;   // 没有 systemd-run 或 systemd 拒绝了 scope
+        }
+        usleep(20000);
+    }
+    kill(pid, SIGTERM);
+    waitpid(pid, nullptr, 0);
+    return false;
+}
+
+std::string ResourceSlice::wrap(const std::string& cmd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    used_ = true;
+    if (!prepared_) {
+        prepare();
+    }
+
+    // 由 popen 的 shell 自己进入 cgroup（echo 是内建命令），随后派生的所有进程都继承；
+    // 已设置的并行度环境变量保持不变
+    std::string jobs = std::to_string(effectiveJobs_);
+    std::string prefix;
+    if (!path_.empty()) {
+        prefix = "{ echo $$ > " + path_ + "/cgroup.procs; } 2>/dev/null; ";
+    } else if (enabled_) {
+        prefix = "{ renice -n 10 -p $$; ionice -c 3 -p $$; } > /dev/null 2>&1; ";
+    }
+    prefix += "export MAKEFLAGS=\"${MAKEFLAGS:--j" + jobs + "}\" CMAKE_BUILD_PARALLEL_LEVEL=\"${CMAKE_BUILD_PARALLEL_LEVEL:-" +
+              jobs + "}\" MAX_JOBS=\"${MAX_JOBS:-" + jobs + "}\"; ";
+    return prefix + cmd;
+}
+
+unsigned ResourceSlice::jobsFor(std::uint64_t memoryPerJob) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!prepared_) {
+        prepare();
+    }
+    // 链接等大内存任务即使配置了 install_jobs 也按内存收紧，避免触发 OOM
+    return memoryPerJob == 0 ? effectiveJobs_ : fitMemory(effectiveJobs_, memoryBudget_, memoryPerJob);
+}
+
+ResourceSlice::Usage ResourceSlice::usage() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Usage usage;
+    usage.isolated = !path_.empty();
+    usage.path = path_;
+    usage.applied = applied_;
+    usage.jobs = effectiveJobs_;
+    if (path_.empty()) {
+        return usage;
+    }
+
+    std::string content;
+    if (FileUtils::readFile(path_ + "/cpu.stat", content)) {
+        usage.periods = statField(content, "nr_periods");
+        usage.throttledPeriods = statField(content, "nr_throttled");
+        usage.throttledSeconds = static_cast<double>(statField(content, "throttled_usec")) / 1e6;
+    }
+    if (FileUtils::readFile(path_ + "/memory.events", content)) {
+        usage.memoryHighEvents = statField(content, "high");
+    }
+    if (FileUtils::readFile(path_ + "/memory.peak", content)) {
+        usage.memoryPeak = std::strtoull(content.c_str(), nullptr, 10);
+    }
+    usage.memoryStallSeconds = stallSeconds(path_ + "/memory.pressure");
+    usage.ioStallSeconds = stallSeconds(path_ + "/io.pressure");
+    return usage;
+}
+
+} // namespace LinuxStudio
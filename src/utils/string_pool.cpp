@@ -0,0 +1,40 @@
+#include "linuxstudio/string_pool.hpp"
+#include <cstring>
+
+namespace LinuxStudio {
+
+StringPool::StringPool() : blockUsed_(0), arenaBytes_(0) {
+}
+
+std::uint32_t StringPool::intern(std::string_view s) {
+    auto it = index_.find(s);
+    if (it != index_.end()) {
+        return it->second;
+    }
+    std::string_view stored(store(s), s.size());
+    std::uint32_t id = static_cast<std::uint32_t>(strings_.size());
+    strings_.push_back(stored);
+    index_.emplace(stored, id);
+    return id;
+}
+
+const char* StringPool::store(std::string_view s) {
+    if (s.size() > kBlockSize / 4) {
+        // 超长字符串单独分配，当前块的剩余空间留给后续短字符串
+        large_.emplace_back(new char[s.size()]);
+        arenaBytes_ += s.size();
+        std::memcpy(large_.back().get(), s.data(), s.size());
+        return large_.back().get();
+    }
+    if (blocks_.empty() || kBlockSize - blockUsed_ < s.size()) {
+        blocks_.emplace_back(new char[kBlockSize]);
+        blockUsed_ = 0;
+        arenaBytes_ += kBlockSize;
+    }
+    char* data = blocks_.back().get() + blockUsed_;
+    std::memcpy(data, s.data(), s.size());
+    blockUsed_ += s.size();
+    return data;
+}
+
+} // namespace LinuxStudio
@@ -0,0 +1,131 @@
+#include "linuxstudio/bundle.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/scene_lock.hpp"
+#include "test_support.hpp"
+
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+/**
+ * @brief 离线包成员名与锁文件的安全检查
+ *
+ * 离线包以 root 身份解压，成员名与锁文件中的名字都会拼成目标路径：
+ * - safeName 拒绝绝对路径、空路径段与 . / .. 路径段；
+ * - write 拒绝不安全的成员名；
+ * - 改写包文件中的成员名（如 plugin/x/../../../../etc/cron.d/evil）后 open 失败，
+ *   正常的包可以打开并逐字节解压；
+ * - 锁文件中不安全的插件名、wheel 摘要、包名与版本使 parse 失败。
+ */
+
+using LinuxStudio::Bundle;
+using LinuxStudio::FileUtils;
+using LinuxStudio::SceneLock;
+
+namespace {
+
+std::string readLocal(const std::string& path) {
+    std::string content;
+    FileUtils::readFile(path, content);
+    return content;
+}
+
+/**
+ * @brief 写一个只含 member 的包，再把包文件中的成员名原地替换为等长的 crafted
+ */
+bool craft(const LinuxStudioTest::TempDir& dir, const std::string& member, const std::string& crafted,
+           const std::string& path) {
+    Bundle bundle;
+    bundle.add(member, dir.file("payload"));
+    Bundle::Report report;
+    if (!bundle.write(path, report)) {
+        return false;
+    }
+    std::string content = readLocal(path);
+    std::size_t pos = content.rfind(member);
+    if (pos == std::string::npos || crafted.size() != member.size()) {
+        return false;
+    }
+    content.replace(pos, member.size(), crafted);
+    return FileUtils::writeFileAtomic(path, content);
+}
+
+const char* const kDigest = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+
+std::string lock(const std::string& body) {
+    return std::string("xkl-lock-1\tml-dev\n") + body;
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const std::string payload = "#!/bin/sh\necho plugin\n";
+    CHECK(FileUtils::writeFileAtomic(dir.file("payload"), payload));
+
+    for (const char* name : {"scene.lock", "deb/gcc=4:12.2.0-3", "plugin/ros2/setup.sh", "plugin/x/a/b.py",
+                             "wheel/abc", "plugin/x/..hidden"}) {
+        CHECK(Bundle::safeName(name));
+    }
+    for (const char* name : {"", "/etc/passwd", "plugin/x/../../etc/cron.d/evil", "..", "plugin/./x",
+                             "plugin//x", "plugin/x/", "plugin/x/.."}) {
+        CHECK(!Bundle::safeName(name));
+    }
+
+    // 写入时拒绝
+    {
+        Bundle bundle;
+        bundle.add("plugin/x/../../../../tmp/evil", dir.file("payload"));
+        Bundle::Report report;
+        CHECK(!bundle.write(dir.file("rejected.xklb"), report));
+        CHECK(access(dir.file("rejected.xklb").c_str(), F_OK) != 0);
+    }
+
+    // 正常的包：打开、查找、解压
+    {
+        const std::string member = "plugin/x/aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+        CHECK(craft(dir, member, member, dir.file("good.xklb")));
+        Bundle bundle;
+        CHECK(bundle.open(dir.file("good.xklb")));
+        const Bundle::Entry* entry = bundle.find(member);
+        CHECK(entry != nullptr && bundle.extract(*entry, dir.file("extracted")));
+        CHECK(readLocal(dir.file("extracted")) == payload);
+    }
+
+    // 篡改成员名：目录穿越、绝对路径、空路径段
+    for (const std::string& crafted : {std::string("plugin/x/../../../../etc/cron.d/evil"),
+                                       std::string("/etc/cron.d/evil-from-bundle"),
+                                       std::string("plugin/x//etc/cron.d/evil"),
+                                       std::string("plugin/x/./../../../root/.bashrc")}) {
+        const std::string path = dir.file("crafted.xklb");
+        CHECK(craft(dir, "plugin/x/" + std::string(crafted.size() - 9, 'a'), crafted, path));
+        Bundle bundle;
+        CHECK(!bundle.open(path));
+        unlink(path.c_str());
+    }
+
+    // 锁文件
+    const std::string wheel = std::string("numpy-1.26.4-cp311-cp311-manylinux_2_17_x86_64.whl#sha256=") + kDigest;
+    const std::string package = std::string("P\t0\t1\tlibgcc-s1\t1:12.2.0-14+deb12u1\t") + kDigest +
+                                "\tpool/main/g/gcc-12/libgcc-s1_12.2.0-14+deb12u1_amd64.deb\n";
+    SceneLock parsed;
+    CHECK(parsed.parse(lock(package + "W\tros2\t" + wheel + "\n")));
+    CHECK(parsed.packages.size() == 1 && parsed.wheels["ros2"].size() == 1);
+    for (const std::string& body : {
+             "W\t../../../etc\t" + wheel + "\n",
+             "W\tros2/evil\t" + wheel + "\n",
+             std::string("W\tros2\tnumpy.whl#sha256=../../../../etc/passwd\n"),
+             "W\tros2\t../numpy.whl#sha256=" + std::string(kDigest) + "\n",
+             std::string("P\t0\t1\tvim;id\t1.0\t-\t-\n"),
+             std::string("P\t0\t1\tvim\t1.0 && id\t-\t-\n"),
+             std::string("P\t0\t1\tvim\t1.0\t-\t../../../etc/passwd\n"),
+             std::string("P\t0\t1\tvim\t1.0\tnot-a-digest\t-\n")}) {
+        CHECK(!parsed.parse(lock(body)));
+    }
+    CHECK(!parsed.parse("xkl-lock-1\t../scene\n"));
+
+    std::printf("bundle_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include "linuxstudio/managers.hpp"
+#include "linuxstudio/process.hpp"
+#include "test_support.hpp"
+
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+/**
+ * @brief 组件名校验与命令行引用测试
+ *
+ * 组件名会拼进交给 /bin/sh 执行的包管理器命令：
+ * - validName 拒绝空白、shell 元字符与以 - 开头的名字，接受常见的软件包名；
+ * - Process::quote 引用后的参数经 sh 原样传回，其中的命令不会执行；
+ * - ComponentManager::install/uninstall 对不合法的名字直接失败，不调用包管理器。
+ */
+
+using LinuxStudio::ComponentManager;
+using LinuxStudio::Process;
+
+namespace {
+
+bool exists(const std::string& path) {
+    return access(path.c_str(), F_OK) == 0;
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const std::string marker = dir.file("injected");
+
+    for (const char* name : {"vim", "libssl-dev", "g++", "python3.11", "libstdc++6", "perl-Foo_Bar", "SDL2",
+                             "0ad"}) {
+        CHECK(ComponentManager::validName(name));
+    }
+    for (const char* name : {"", "vim; rm -rf /", "vim && id", "$(id)", "`id`", "a b", "vim|cat", "-y",
+                             "--purge", ".hidden", "../etc", "vim\n", "name'quote", "a>b"}) {
+        CHECK(!ComponentManager::validName(name));
+    }
+    CHECK(!ComponentManager::validName(std::string(129, 'a')));
+
+    // 引用后经 sh 原样传回
+    for (const std::string& arg : {std::string("plain"), std::string("it's"), "x; touch " + marker,
+                                   "$(touch " + marker + ")", "'; touch " + marker + "; '", std::string("a\\b \"c\"")}) {
+        std::string output;
+        CHECK(Process::capture("printf %s " + Process::quote(arg), output));
+        CHECK(output == arg);
+    }
+    CHECK(!exists(marker));
+
+    // 安装、卸载入口自己校验，不依赖命令行层
+    ComponentManager components;
+    CHECK(!components.install("vim; touch " + marker));
+    CHECK(!components.install("$(touch " + marker + ")"));
+    CHECK(!components.uninstall("vim; touch " + marker));
+    CHECK(!components.uninstall("`touch " + marker + "`"));
+    CHECK(!exists(marker));
+
+    std::printf("component_manager_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
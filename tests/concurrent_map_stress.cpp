@@ -0,0 +1,153 @@
+#include "linuxstudio/concurrent_map.hpp"
+#include "test_support.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief ShardedMap 多线程压力测试
+ *
+ * 用 -DLINUXSTUDIO_ENABLE_TSAN=ON 构建时由 ThreadSanitizer 检查数据竞争：
+ * - 混合阶段：写线程 update/erase、替换线程 replaceAll、读线程 find/read/forEach 同时运行，
+ *   读到的值必须完整（不是写到一半的快照），forEach 的键严格递增；
+ * - 计数阶段：多个线程对同一批键做读-改-写，结束后计数不丢失。
+ */
+
+using LinuxStudio::ShardedMap;
+
+namespace {
+
+const int kKeys = 64;
+const int kWriters = 4;
+const int kReaders = 4;
+const int kIterations = 4000;
+const int kReplaces = 200;
+
+std::string keyFor(int i) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "key-%03d", i);
+    return buf;
+}
+
+/**
+ * @brief 自校验的值：同一个字母重复若干次，读到混杂内容即说明快照不完整
+ */
+std::string valueFor(unsigned n) {
+    return std::string(1 + n % 97, static_cast<char>('a' + n % 26));
+}
+
+bool validValue(const std::string& value) {
+    if (value.empty() || value.size() > 97 || value[0] < 'a' || value[0] > 'z') {
+        return false;
+    }
+    return value.find_first_not_of(value[0]) == std::string::npos;
+}
+
+void mixedPhase() {
+    using Map = ShardedMap<std::string, std::string>;
+    Map map;
+    std::atomic<bool> done(false);
+    std::atomic<int> errors(0);
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < kWriters; ++w) {
+        threads.emplace_back([&map, &errors, w]() {
+            for (int i = 0; i < kIterations; ++i) {
+                std::string key = keyFor((i * 7 + w) % kKeys);
+                if (i % 11 == 0) {
+                    map.erase(key);
+                    continue;
+                }
+                map.update(key, [&errors, i](std::string& value, bool existed) {
+                    if (existed && !validValue(value)) {
+                        ++errors;
+                    }
+                    value = valueFor(static_cast<unsigned>(i));
+                    return i % 5 != 0;  // 偶尔放弃修改
+                });
+            }
+        });
+    }
+
+    threads.emplace_back([&map]() {
+        for (int r = 0; r < kReplaces; ++r) {
+            Map::MapType entries;
+            for (int i = r % 3; i < kKeys; i += 3) {
+                entries.emplace(keyFor(i), valueFor(static_cast<unsigned>(r + i)));
+            }
+            map.replaceAll(entries);
+            std::this_thread::yield();
+        }
+    });
+
+    for (int r = 0; r < kReaders; ++r) {
+        threads.emplace_back([&map, &done, &errors, r]() {
+            while (!done.load(std::memory_order_acquire)) {
+                std::string value;
+                std::string key = keyFor(r % kKeys);
+                if (map.find(key, value) && !validValue(value)) {
+                    ++errors;
+                }
+                map.read(keyFor((r + 1) % kKeys), [&errors](const std::string& v) {
+                    if (!validValue(v)) {
+                        ++errors;
+                    }
+                });
+                std::string previous;
+                std::size_t visited = 0;
+                map.forEach([&](const std::string& k, const std::string& v) {
+                    if ((visited > 0 && !(previous < k)) || !validValue(v)) {
+                        ++errors;
+                    }
+                    previous = k;
+                    ++visited;
+                });
+                if (visited > static_cast<std::size_t>(kKeys) || map.size() > static_cast<std::size_t>(kKeys)) {
+                    ++errors;
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < kWriters + 1; ++i) {
+        threads[i].join();
+    }
+    done.store(true, std::memory_order_release);
+    for (std::size_t i = kWriters + 1; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    CHECK(errors.load() == 0);
+}
+
+void countingPhase() {
+    ShardedMap<int, long> map;
+    std::vector<std::thread> threads;
+    for (int w = 0; w < kWriters; ++w) {
+        threads.emplace_back([&map]() {
+            for (int i = 0; i < kIterations; ++i) {
+                map.update(i % kKeys, [](long& value, bool) { ++value; return true; });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    long total = 0;
+    map.forEach([&total](const int&, const long& value) { total += value; });
+    CHECK(map.size() == static_cast<std::size_t>(kKeys));
+    CHECK(total == static_cast<long>(kWriters) * kIterations);
+}
+
+} // namespace
+
+int main() {
+    mixedPhase();
+    countingPhase();
+    std::printf("concurrent_map_stress: %d writers, %d readers, %d failures\n",
+                kWriters, kReaders, LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+#include "linuxstudio/component_catalog.hpp"
+#include "linuxstudio/dependency_resolver.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 依赖解析测试
+ *
+ * 用合成的 dpkg 状态文件与 Packages 文件构建软件包目录：
+ * - 待安装的包按拓扑分层，依赖在前；已安装的包不展开（完整闭包模式下展开并参与分层）；
+ * - 备选依赖（a | b）与虚包优先取已安装的提供者；
+ * - 依赖环整环放在同一层并列入 cycles；
+ * - 与已安装或同批待安装的包冲突、目录中找不到的包分别列入 conflicts 与 missing；
+ * - 第二次解析读取缓存，refresh 或追加依赖后重新计算。
+ */
+
+using LinuxStudio::ComponentCatalog;
+using LinuxStudio::DependencyResolver;
+using LinuxStudio::FileUtils;
+using LinuxStudio::Resolution;
+
+namespace {
+
+const char* const kStatus =
+    "Package: libc6\n"
+    "Status: install ok installed\n"
+    "Version: 2.36-9\n"
+    "\n"
+    "Package: oldedit\n"
+    "Status: install ok installed\n"
+    "Version: 1.0\n"
+    "Provides: editor\n"
+    "\n"
+    "Package: removed\n"
+    "Status: deinstall ok config-files\n"
+    "Version: 0.1\n"
+    "\n";
+
+const char* const kPackages =
+    "Package: app\n"
+    "Version: 3.0\n"
+    "Depends: liba (>= 1.0), libb | libalt, editor\n"
+    "\n"
+    "Package: liba\n"
+    "Version: 1.2\n"
+    "Depends: libbase\n"
+    "\n"
+    "Package: libb\n"
+    "Version: 2.0\n"
+    "Pre-Depends: libc6\n"
+    "Depends: libbase\n"
+    "\n"
+    "Package: libalt\n"
+    "Version: 2.0\n"
+    "\n"
+    "Package: libbase\n"
+    "Version: 1.0\n"
+    "\n"
+    "Package: newedit\n"
+    "Version: 2.0\n"
+    "Provides: editor\n"
+    "\n"
+    "Package: top\n"
+    "Version: 1.0\n"
+    "Depends: cycle-a\n"
+    "\n"
+    "Package: cycle-a\n"
+    "Version: 1.0\n"
+    "Depends: cycle-b, libbase\n"
+    "\n"
+    "Package: cycle-b\n"
+    "Version: 1.0\n"
+    "Depends: cycle-a\n"
+    "\n"
+    "Package: rival\n"
+    "Version: 1.0\n"
+    "Conflicts: oldedit\n"
+    "\n"
+    "Package: left\n"
+    "Version: 1.0\n"
+    "Conflicts: right\n"
+    "\n"
+    "Package: right\n"
+    "Version: 1.0\n"
+    "\n"
+    "Package: broken\n"
+    "Version: 1.0\n"
+    "Depends: ghost\n"
+    "\n";
+
+using Levels = std::vector<std::vector<std::string>>;
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const std::string status = dir.file("status");
+    const std::string packages = dir.file("example_Packages");
+    const std::string cache = dir.file("resolve");
+    CHECK(FileUtils::writeFileAtomic(status, kStatus));
+    CHECK(FileUtils::writeFileAtomic(packages, kPackages));
+
+    ComponentCatalog catalog(dir.file("catalog.bin"));
+    CHECK(catalog.load({status, packages}));
+    CHECK(catalog.view(catalog.find("libc6")).installed());
+    CHECK(!catalog.view(catalog.find("libb")).installed());
+    CHECK(catalog.view(catalog.find("editor")).isVirtual());
+
+    DependencyResolver resolver(catalog, 1, cache);
+
+    // 分层：依赖在前，已安装的 libc6 与虚包 editor 的已安装提供者不在待装列表中
+    Resolution app = resolver.resolve({"app"});
+    CHECK(app.ok() && !app.fromCache);
+    CHECK((app.levels == Levels{{"libbase"}, {"liba", "libb"}, {"app"}}));
+    CHECK((app.dependencies["app"] == std::vector<std::string>{"liba", "libb", "oldedit"}));
+    CHECK(app.pendingCount() == 4);
+    CHECK(app.installedCount == 2);
+    CHECK(app.closureSize == 6);
+    CHECK(app.cycles.empty());
+
+    // 缓存：结果相同；refresh 重新计算；追加依赖改变缓存键
+    Resolution cached = resolver.resolve({"app"});
+    CHECK(cached.fromCache && cached.levels == app.levels && cached.dependencies == app.dependencies);
+    CHECK(!resolver.resolve({"app"}, true).fromCache);
+    {
+        DependencyResolver extended(catalog, 1, cache);
+        extended.addDependencies("app", {"libalt"});
+        Resolution more = extended.resolve({"app"});
+        CHECK(!more.fromCache);
+        CHECK((more.levels == Levels{{"libalt", "libbase"}, {"liba", "libb"}, {"app"}}));
+    }
+    CHECK(!DependencyResolver(catalog, 2, cache).resolve({"app"}).fromCache);
+
+    // 完整闭包：已安装的包也参与分层
+    Resolution full = resolver.resolve({"libb"}, false, true);
+    CHECK((full.levels == Levels{{"libbase", "libc6"}, {"libb"}}));
+
+    // 依赖环
+    Resolution cycle = resolver.resolve({"top"});
+    CHECK(cycle.ok());
+    CHECK((cycle.cycles == Levels{{"cycle-a", "cycle-b"}}));
+    CHECK((cycle.levels == Levels{{"libbase"}, {"cycle-a", "cycle-b"}, {"top"}}));
+
+    // 冲突：与已安装的包、与同批待装的包；单独安装 left 没有冲突
+    Resolution rival = resolver.resolve({"rival"});
+    CHECK(!rival.ok());
+    CHECK((rival.conflicts == std::vector<std::pair<std::string, std::string>>{{"oldedit", "rival"}}));
+    Resolution pair = resolver.resolve({"right", "left"});
+    CHECK((pair.conflicts == std::vector<std::pair<std::string, std::string>>{{"left", "right"}}));
+    CHECK(pair.roots == (std::vector<std::string>{"left", "right"}));
+    CHECK(resolver.resolve({"left"}).ok());
+
+    // 缺失：根不存在、依赖不在目录中、只剩配置文件的包
+    Resolution missing = resolver.resolve({"broken", "nonexistent", "removed"});
+    CHECK(!missing.ok());
+    CHECK((missing.missing == std::vector<std::string>{"ghost", "nonexistent", "removed"}));
+    CHECK((missing.levels == Levels{{"broken"}}));
+
+    FileUtils::removeTree(cache);
+    std::printf("dependency_resolver_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include "linuxstudio/file_utils.hpp"
+#include "test_support.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief 并行删除与回收区测试
+ *
+ * 回收区由 XKL_TRASH_DIR 指到临时目录：
+ * - removeTree 删除多层目录树，不跟随符号链接，仍有其他硬链接的文件不计入释放的字节；
+ * - 未设置后台删除进程时 discard 在调用线程同步清空回收区，不会重新执行测试程序自己；
+ * - purgeTrash 清空回收区中的全部条目（保留锁文件）；
+ * - setPurger 设为 xkl 后 discard 立即返回，由后台的 xkl __purge-trash 清空回收区。
+ */
+
+using LinuxStudio::FileUtils;
+
+namespace {
+
+bool exists(const std::string& path) {
+    struct stat st;
+    return lstat(path.c_str(), &st) == 0;
+}
+
+/**
+ * @brief 建一棵多层目录树：每层若干 64 KB 文件与一个子目录
+ */
+void makeTree(const std::string& root, int depth) {
+    mkdir(root.c_str(), 0755);
+    std::string level = root;
+    for (int d = 0; d < depth; ++d) {
+        for (int f = 0; f < 4; ++f) {
+            FileUtils::writeFileAtomic(level + "/file" + std::to_string(f), std::string(64 * 1024, 'x'));
+        }
+        level += "/sub" + std::to_string(d);
+        mkdir(level.c_str(), 0755);
+    }
+}
+
+/**
+ * @brief 回收区中除锁文件以外的条目数
+ */
+int trashEntries(const std::string& trash) {
+    int count = 0;
+    if (DIR* dir = opendir(trash.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            count += (name != "." && name != ".." && name != ".lock") ? 1 : 0;
+        }
+        closedir(dir);
+    }
+    return count;
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const std::string trash = dir.file("trash");
+    setenv("XKL_TRASH_DIR", trash.c_str(), 1);
+    CHECK(FileUtils::trashPath() == trash);
+
+    // removeTree：多层目录、符号链接与硬链接
+    const std::string outside = dir.file("outside");
+    CHECK(FileUtils::writeFileAtomic(outside, std::string(64 * 1024, 'o')));
+    const std::string tree = dir.file("tree");
+    makeTree(tree, 5);
+    CHECK(symlink(outside.c_str(), (tree + "/link").c_str()) == 0);
+    CHECK(symlink(dir.path().c_str(), (tree + "/sub0/dirlink").c_str()) == 0);
+    CHECK(link(outside.c_str(), (tree + "/sub0/hardlink").c_str()) == 0);
+    std::uint64_t reclaimed = 0;
+    CHECK(FileUtils::removeTree(tree, &reclaimed));
+    CHECK(!exists(tree));
+    CHECK(exists(outside) && exists(dir.path()));
+    CHECK(reclaimed >= 20 * 64 * 1024 && reclaimed < 24 * 64 * 1024 + 64 * 4096);
+    CHECK(FileUtils::removeTree(dir.file("missing")));
+
+    // discard，未设置后台删除进程：同步清空
+    const std::string plugin = dir.file("plugin");
+    makeTree(plugin, 3);
+    reclaimed = 0;
+    CHECK(FileUtils::discard(plugin, &reclaimed));
+    CHECK(!exists(plugin));
+    CHECK(reclaimed >= 12 * 64 * 1024);
+    CHECK(trashEntries(trash) == 0);
+    CHECK(!FileUtils::discard(dir.file("missing")));
+
+    // purgeTrash：清空已在回收区中的条目
+    makeTree(trash + "/left.1", 2);
+    makeTree(trash + "/left.2", 2);
+    CHECK(trashEntries(trash) == 2);
+    CHECK(FileUtils::purgeTrash() >= 16 * 64 * 1024);
+    CHECK(trashEntries(trash) == 0);
+
+    // 后台删除进程：discard 立即返回，回收区随后被清空
+    FileUtils::setPurger(XKL_BINARY);
+    const std::string env = dir.file("env");
+    makeTree(env, 3);
+    CHECK(FileUtils::discard(env));
+    CHECK(!exists(env));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (trashEntries(trash) > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    CHECK(trashEntries(trash) == 0);
+
+    unlink((trash + "/.lock").c_str());
+    rmdir(trash.c_str());
+    std::printf("file_utils_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace LinuxStudioTest {
+
+/**
+ * @brief 测试用的本地 HTTP 服务器
+ *
+ * 监听 127.0.0.1 的随机端口，每个连接一个线程，处理一个请求后关闭连接。
+ * 响应可注入延迟、挂起（不回应直到服务器停止）和错误状态码；
+ * 支持单个 "Range: bytes=a-b" 区间（可关闭以模拟忽略 Range 的服务器）。
+ */
+class HttpServer {
+public:
+    struct Response {
+        int status = 200;
+        std::string body;
+        int delayMs = 0;        // 发送响应头之前等待
+        bool hang = false;      // 读完请求后不回应
+        std::size_t truncate = std::string::npos;  // 只发送前若干字节的正文后断开
+    };
+
+    struct Request {
+        std::string path;
+        std::string range;      // Range 头的值，没有时为空
+    };
+
+    using Handler = std::function<Response(const Request&)>;
+
+    explicit HttpServer(Handler handler) : handler_(std::move(handler)) {
+        listenFd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(listenFd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listenFd_, 64) != 0 ||
+            getsockname(listenFd_, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0) {
+            close(listenFd_);
+            listenFd_ = -1;
+            return;
+        }
+        port_ = ntohs(addr.sin_port);
+        acceptor_ = std::thread([this]() { acceptLoop(); });
+    }
+
+    ~HttpServer() { stop(); }
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    /**
+     * @brief 停止监听并等待所有连接结束；之后的连接被拒绝
+     */
+    void stop() {
+        if (stopping_.exchange(true)) {
+            return;
+        }
+        if (listenFd_ >= 0) {
+            shutdown(listenFd_, SHUT_RDWR);
+        }
+        if (acceptor_.joinable()) {
+            acceptor_.join();
+        }
+        if (listenFd_ >= 0) {
+            close(listenFd_);
+            listenFd_ = -1;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        workers_.clear();
+    }
+
+    bool valid() const { return port_ != 0; }
+    int port() const { return port_; }
+    std::string url(const std::string& path = "/") const {
+        return "http://127.0.0.1:" + std::to_string(port_) + path;
+    }
+
+    /**
+     * @brief 是否按 Range 头返回 206（默认是）
+     */
+    void setRanges(bool enabled) { ranges_ = enabled; }
+
+    std::vector<Request> requests() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requests_;
+    }
+
+    void clearRequests() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_.clear();
+    }
+
+private:
+    Handler handler_;
+    int listenFd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> ranges_{true};
+    std::thread acceptor_;
+    mutable std::mutex mutex_;
+    std::vector<std::thread> workers_;
+    std::vector<Request> requests_;
+
+    void acceptLoop() {
+        for (;;) {
+            int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (stopping_) {
+                    return;
+                }
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            workers_.emplace_back([this, fd]() {
+                serve(fd);
+                close(fd);
+            });
+        }
+    }
+
+    /**
+     * @brief 可被 stop() 打断的等待
+     */
+    void sleepMs(int ms) const {
+        auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+        while (!stopping_ && std::chrono::steady_clock::now() < until) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    static bool sendAll(int fd, const char* data, std::size_t size) {
+        while (size > 0) {
+            ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    static std::string headerValue(const std::string& head, const std::string& name) {
+        std::size_t pos = 0;
+        while ((pos = head.find("\r\n", pos)) != std::string::npos) {
+            pos += 2;
+            if (strncasecmp(head.c_str() + pos, name.c_str(), name.size()) == 0 &&
+                head.compare(pos + name.size(), 1, ":") == 0) {
+                std::size_t start = head.find_first_not_of(' ', pos + name.size() + 1);
+                std::size_t end = head.find("\r\n", start);
+                return head.substr(start, end - start);
+            }
+        }
+        return "";
+    }
+
+    void serve(int fd) {
+        std::string head;
+        char buffer[4096];
+        while (head.find("\r\n\r\n") == std::string::npos) {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            if (poll(&pfd, 1, 2000) != 1) {
+                return;
+            }
+            ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return;
+            }
+            head.append(buffer, static_cast<std::size_t>(n));
+        }
+
+        Request request;
+        std::size_t pathStart = head.find(' ');
+        std::size_t pathEnd = head.find(' ', pathStart + 1);
+        request.path = head.substr(pathStart + 1, pathEnd - pathStart - 1);
+        request.range = headerValue(head, "Range");
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requests_.push_back(request);
+        }
+
+        Response response = handler_(request);
+        if (response.hang) {
+            sleepMs(60 * 1000);
+            return;
+        }
+        sleepMs(response.delayMs);
+        if (stopping_) {
+            return;
+        }
+
+        std::string body = response.body;
+        std::string extra;
+        int status = response.status;
+        unsigned long first = 0;
+        unsigned long last = 0;
+        if (status == 200 && ranges_ && !body.empty() &&
+            std::sscanf(request.range.c_str(), "bytes=%lu-%lu", &first, &last) == 2 && first <= last &&
+            first < body.size()) {
+            last = std::min<unsigned long>(last, body.size() - 1);
+            extra = "Content-Range: bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" +
+                    std::to_string(body.size()) + "\r\n";
+            body = body.substr(first, last - first + 1);
+            status = 206;
+        }
+
+        std::string reply = "HTTP/1.1 " + std::to_string(status) + " " + (status < 400 ? "OK" : "Error") + "\r\n" +
+                            "Content-Length: " + std::to_string(body.size()) + "\r\n" + extra +
+                            "Connection: close\r\n\r\n";
+        if (!sendAll(fd, reply.data(), reply.size())) {
+            return;
+        }
+        sendAll(fd, body.data(), std::min(body.size(), response.truncate));
+    }
+};
+
+} // namespace LinuxStudioTest
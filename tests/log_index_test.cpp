@@ -0,0 +1,267 @@
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/log_index.hpp"
+#include "linuxstudio/oci_image.hpp"
+#include "linuxstudio/process.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * @brief 日志索引与查询测试（xkl logs）
+ *
+ * 在临时目录中合成三个已关闭分段（其一压缩）与当前段：
+ * - 索引按行边界切块，块首尾相接覆盖整个分段；
+ * - 分段按名称中的轮转时间与序号排序（序号按数值比较），当前段在最后；
+ * - 时间、级别、组件条件的结果与逐行筛选一致，索引整段跳过不相关的分段、只扫描可能命中的块；
+ *   多级别查询时续行跟随上一行，单级别查询不输出续行；
+ * - parseTime、levelBit 与 matches 的边界；
+ * - follow 输出新增的行，并跟随轮转后的新文件。
+ * 压缩分段只在编译时找到 zlib 时生成。
+ */
+
+using LinuxStudio::FileUtils;
+using LinuxStudio::LogIndex;
+using LinuxStudio::OciImageWriter;
+using LinuxStudio::Process;
+
+namespace {
+
+const int kLines = 4000;      // 第一个分段的行数：前一半提到 alpha，后一半提到 beta
+const int kErrorLine = 3000;  // 其后跟一行不带时间的续行
+
+std::string stamp(const char* day, int seconds) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%s %02d:%02d:%02d", day, seconds / 3600, seconds / 60 % 60, seconds % 60);
+    return text;
+}
+
+std::string line(const char* day, int seconds, const char* level, const std::string& message) {
+    return "[" + stamp(day, seconds) + "] [" + level + "] " + message + "\n";
+}
+
+bool append(const std::string& path, const std::string& text) {
+    int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+    return close(fd) == 0 && ok;
+}
+
+struct Result {
+    std::vector<std::string> lines;
+    LogIndex::Stats stats;
+};
+
+Result run(const std::string& logPath, const LogIndex::Query& query) {
+    Result result;
+    LogIndex::query(logPath, query, [&result](const std::string& text) { result.lines.push_back(text); },
+                    result.stats);
+    return result;
+}
+
+/**
+ * @brief 检查索引：块首尾相接、在行边界结束，总长度等于分段大小
+ */
+bool indexCoversSegment(const std::string& segment, const std::string& content) {
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(LogIndex::indexPath(segment), lines) || lines.size() < 3 ||
+        lines[0].compare(0, 13, "xkl-logidx-1\t") != 0) {
+        return false;
+    }
+    unsigned long long offset = 0;
+    for (std::size_t i = 1; i < lines.size(); ++i) {
+        std::size_t first = lines[i].find('\t');
+        std::size_t second = lines[i].find('\t', first + 1);
+        if (lines[i].compare(0, 2, "B\t") != 0 || second == std::string::npos ||
+            std::strtoull(lines[i].c_str() + first + 1, nullptr, 10) != offset) {
+            return false;
+        }
+        offset += std::strtoull(lines[i].c_str() + second + 1, nullptr, 10);
+        if (offset > content.size() || content[offset - 1] != '\n') {
+            return false;
+        }
+    }
+    return offset == content.size();
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const bool zlib = OciImageWriter::compressionAvailable();  // 与日志压缩同一个编译开关
+    const std::string log = dir.file("app.log");
+
+    // 分段 1：alpha/beta 与一条带续行的错误
+    std::string first;
+    for (int i = 0; i < kLines; ++i) {
+        std::string message = std::string("install ") + (i < kLines / 2 ? "alpha" : "beta") + " step " +
+                              std::to_string(i);
+        first += line("2024-01-01", i, i == kErrorLine ? "ERROR" : "INFO",
+                      i == kErrorLine ? "beta failed to unpack." : message);
+        if (i == kErrorLine) {
+            first += "  detail: no space left on device\n";
+        }
+    }
+    const std::string segmentA = log + ".20240101-000000";
+    CHECK(FileUtils::writeFileAtomic(segmentA, first));
+    CHECK(LogIndex::build(segmentA));
+    CHECK(indexCoversSegment(segmentA, first));
+
+    // 分段 2、3：同一秒内轮转出的序号 2 与 10；序号 2 的分段建好索引后压缩
+    std::string second;
+    std::string third;
+    for (int i = 0; i < 100; ++i) {
+        second += line("2024-01-02", i, "WARNING", "mirror slow " + std::to_string(i));
+        third += line("2024-01-02", 3600 + i, "SUCCESS", "installed beta-tools " + std::to_string(i));
+    }
+    const std::string segmentB = log + ".20240102-000000-2";
+    const std::string segmentC = log + ".20240102-000000-10";
+    CHECK(FileUtils::writeFileAtomic(segmentB, second) && LogIndex::build(segmentB));
+    CHECK(FileUtils::writeFileAtomic(segmentC, third) && LogIndex::build(segmentC));
+    std::string segmentBPath = segmentB;
+    if (zlib && Process::run("gzip -n " + Process::quote(segmentB)) == 0) {
+        segmentBPath = segmentB + ".gz";
+        CHECK(LogIndex::indexPath(segmentBPath) == segmentB + ".idx");
+    }
+
+    // 当前段：没有索引
+    std::string current = line("2024-01-03", 0, "DEBUG", "gamma ready") + line("2024-01-03", 1, "INFO", "gamma started");
+    CHECK(FileUtils::writeFileAtomic(log, current));
+    CHECK((LogIndex::segments(log) == std::vector<std::string>{segmentA, segmentBPath, segmentC, log}));
+
+    // 不带条件：全部行按时间顺序
+    Result all = run(log, LogIndex::Query());
+    CHECK(all.lines.size() == kLines + 1 + 200 + 2);
+    CHECK(all.stats.segments == 4 && all.stats.skipped == 0);
+    if (all.lines.size() == kLines + 1 + 200 + 2) {
+        CHECK(all.lines.front() + "\n" == line("2024-01-01", 0, "INFO", "install alpha step 0"));
+        CHECK(all.lines[kErrorLine + 1] == "  detail: no space left on device");
+        CHECK(all.lines[kLines + 1].find("mirror slow 0") != std::string::npos);
+        CHECK(all.lines[kLines + 101].find("beta-tools 0") != std::string::npos);
+        CHECK(all.lines.back().find("gamma started") != std::string::npos);
+    }
+
+    // 时间：只有 1 月 2 日的两个分段，第一个分段由索引整段跳过
+    LogIndex::Query day;
+    CHECK(LogIndex::parseTime("2024-01-02", false, day.since) && LogIndex::parseTime("2024-01-02", true, day.until));
+    Result dayResult = run(log, day);
+    CHECK(dayResult.lines.size() == 200);
+    CHECK(dayResult.stats.skipped == 1);
+
+    // 单一级别：只扫描含错误的块，不输出续行
+    LogIndex::Query errors;
+    errors.levels = LogIndex::levelBit("error");
+    Result errorResult = run(log, errors);
+    CHECK(errorResult.lines.size() == 1 && errorResult.lines[0].find("beta failed to unpack.") != std::string::npos);
+    CHECK(errorResult.stats.skipped == 2 && errorResult.stats.scannedBlocks == 1);
+    CHECK(errorResult.stats.blocks >= 4);
+
+    // 多个级别：续行跟随错误行
+    LogIndex::Query problems;
+    problems.levels = LogIndex::levelBit("ERROR") | LogIndex::levelBit("warn");
+    Result problemResult = run(log, problems);
+    CHECK(problemResult.lines.size() == 1 + 1 + 100);
+    CHECK(problemResult.lines.size() > 1 && problemResult.lines[1] == "  detail: no space left on device");
+
+    // 组件：按独立单词匹配（句末的点不算，beta-tools 不是 beta），只提到 alpha 的块不扫描
+    LogIndex::Query beta;
+    beta.component = "beta";
+    Result betaResult = run(log, beta);
+    CHECK(betaResult.lines.size() == kLines / 2 + 1);
+    CHECK(betaResult.stats.scannedBlocks < betaResult.stats.blocks);
+    CHECK(betaResult.stats.skipped == 2);
+    for (const auto& text : betaResult.lines) {
+        CHECK(text.find("alpha") == std::string::npos && text.find("beta-tools") == std::string::npos);
+    }
+
+    // 只在当前段出现的组件：三个已关闭分段都由索引跳过
+    LogIndex::Query gamma;
+    gamma.component = "gamma";
+    Result gammaResult = run(log, gamma);
+    CHECK(gammaResult.lines.size() == 2 && gammaResult.stats.skipped == 3);
+
+    // 组合条件
+    LogIndex::Query early;
+    early.component = "alpha";
+    early.levels = LogIndex::levelBit("INFO");
+    CHECK(LogIndex::parseTime("2024-01-01 00:05", true, early.until));
+    CHECK(run(log, early).lines.size() == 5 * 60 + 60);
+
+    // parseTime、levelBit、matches
+    std::string parsed;
+    CHECK(LogIndex::parseTime("2024-01-02T10:30", true, parsed) && parsed == "2024-01-02 10:30:59");
+    CHECK(LogIndex::parseTime("2024-01-02 10:30", false, parsed) && parsed == "2024-01-02 10:30:00");
+    CHECK(LogIndex::parseTime("2024-01-02 10:30:15", true, parsed) && parsed == "2024-01-02 10:30:15");
+    CHECK(LogIndex::parseTime("30m", false, parsed) && parsed.size() == 19);
+    for (const char* bad : {"", "yesterday", "2024-13-01", "2024-01-02 10", "30x", "2024-01-02 10:30:15 extra"}) {
+        CHECK(!LogIndex::parseTime(bad, false, parsed));
+    }
+    CHECK(LogIndex::levelBit("Warning") == LogIndex::levelBit("WARN") && LogIndex::levelBit("warning") != 0);
+    CHECK(LogIndex::levelBit("fatal") == 0);
+    const std::string sample = "[2024-01-02 00:00:05] [WARNING] mirror slow for libfoo1.2+dfsg.";
+    LogIndex::Query exact;
+    exact.component = "libfoo1.2+dfsg";
+    CHECK(LogIndex::matches(sample.data(), sample.size(), exact));
+    exact.component = "libfoo1";
+    CHECK(!LogIndex::matches(sample.data(), sample.size(), exact));
+    exact.component = "WARNING";   // 级别标记不属于消息
+    CHECK(!LogIndex::matches(sample.data(), sample.size(), exact));
+    CHECK(!LogIndex::matches("  continuation", 14, errors) && LogIndex::matches("  continuation", 14, LogIndex::Query()));
+
+    // follow：追加、轮转后继续读新文件
+    std::atomic<bool> stop(false);
+    std::mutex mutex;
+    std::vector<std::string> followed;
+    bool followOk = false;
+    std::thread follower([&]() {
+        followOk = LogIndex::follow(log, gamma, stop, [&](const std::string& text) {
+            std::lock_guard<std::mutex> lock(mutex);
+            followed.push_back(text);
+        });
+    });
+    auto waitFor = [&](std::size_t count) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (followed.size() >= count) {
+                    return followed.size() == count;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        return false;
+    };
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));   // follow 从文件末尾开始
+    CHECK(append(log, line("2024-01-03", 2, "INFO", "unrelated") +
+                                         line("2024-01-03", 3, "ERROR", "gamma crashed")));
+    CHECK(waitFor(1));
+    CHECK(rename(log.c_str(), (log + ".20240103-000004").c_str()) == 0);
+    CHECK(FileUtils::writeFileAtomic(log, line("2024-01-03", 5, "INFO", "gamma restarted")));
+    CHECK(waitFor(2));
+    stop = true;
+    follower.join();
+    CHECK(followOk);
+    CHECK(followed.size() == 2 && followed[0].find("gamma crashed") != std::string::npos &&
+          followed[1].find("gamma restarted") != std::string::npos);
+
+    for (const auto& segment : LogIndex::segments(log)) {
+        unlink(LogIndex::indexPath(segment).c_str());
+        unlink(segment.c_str());
+    }
+    std::printf("log_index_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
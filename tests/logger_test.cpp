@@ -0,0 +1,190 @@
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/log_index.hpp"
+#include "linuxstudio/logger.hpp"
+#include "linuxstudio/oci_image.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief 日志分段、压缩与攒批测试
+ *
+ * 日志文件与配置都在临时目录中：
+ * - 当前段写满后改名为分段，后台线程为关闭的分段建立索引并压缩，分段（未压缩）不超过 log_max_size，
+ *   按时间顺序读回所有分段与当前段得到完整的日志；
+ * - 已关闭分段的总大小超过 log_retain 时删除最旧的，留下的是最新的连续日志；
+ * - 攒批时普通级别的行留在内存中，ERROR 立即连同之前的行写出，析构时写出剩余的行；
+ * - 打开日志时补压缩上次未及压缩的分段。
+ * 压缩相关的检查只在编译时找到 zlib 时进行。
+ */
+
+using LinuxStudio::FileUtils;
+using LinuxStudio::LogIndex;
+using LinuxStudio::Logger;
+using LinuxStudio::OciImageWriter;
+
+namespace {
+
+std::string entry(int i) {
+    char text[64];
+    std::snprintf(text, sizeof(text), "entry %04d installing demo-package from the local mirror", i);
+    return text;
+}
+
+/**
+ * @brief 按时间顺序读回全部分段与当前段中的消息（去掉时间与级别）
+ */
+std::vector<std::string> readBack(const std::string& logPath) {
+    std::vector<std::string> messages;
+    LogIndex::Stats stats;
+    LogIndex::query(logPath, LogIndex::Query(), [&messages](const std::string& line) {
+        std::size_t close = line.find("] ", 23);
+        messages.push_back(close == std::string::npos ? line : line.substr(close + 2));
+    }, stats);
+    return messages;
+}
+
+/**
+ * @brief 索引记录的未压缩分段大小（各块长度之和）；没有索引返回 -1
+ */
+long long indexedSize(const std::string& segment) {
+    std::vector<std::string> lines;
+    if (!FileUtils::readLines(LogIndex::indexPath(segment), lines) || lines.empty() ||
+        lines[0].compare(0, 12, "xkl-logidx-1") != 0) {
+        return -1;
+    }
+    long long total = 0;
+    for (std::size_t i = 1; i < lines.size(); ++i) {
+        // B <偏移> <长度> ...：块首尾相接
+        std::size_t offset = lines[i].find('\t');
+        std::size_t length = lines[i].find('\t', offset + 1);
+        if (lines[i].compare(0, 2, "B\t") != 0 || length == std::string::npos ||
+            std::atoll(lines[i].c_str() + offset + 1) != total) {
+            return -1;
+        }
+        total += std::atoll(lines[i].c_str() + length + 1);
+    }
+    return total;
+}
+
+std::uint64_t fileSize(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? static_cast<std::uint64_t>(st.st_size) : 0;
+}
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void removeLogs(const std::string& logPath) {
+    for (const auto& segment : LogIndex::segments(logPath)) {
+        unlink(LogIndex::indexPath(segment).c_str());
+        unlink(segment.c_str());
+    }
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const bool zlib = OciImageWriter::compressionAvailable();  // 与日志压缩同一个编译开关
+
+    // 分段、索引与压缩
+    const std::string config = dir.file("rotate.yaml");
+    CHECK(FileUtils::writeFileAtomic(config, "# 日志项\nlog_max_size: 4K\nlog_retain: 1M\nlog_batch_size: 0\n"
+                                             "log_compress: true\nother_key: ignored\n"));
+    const std::string rotated = dir.file("rotate.log");
+    {
+        Logger logger;
+        logger.loadConfig(config);
+        logger.setLogFile(rotated);
+        for (int i = 0; i < 300; ++i) {
+            logger.info(entry(i));
+        }
+    }
+    std::vector<std::string> segments = LogIndex::segments(rotated);
+    CHECK(segments.size() >= 5 && segments.back() == rotated);
+    CHECK(fileSize(rotated) <= 4096);
+    for (std::size_t i = 0; i + 1 < segments.size(); ++i) {
+        CHECK(endsWith(segments[i], ".gz") == zlib);
+        long long size = indexedSize(segments[i]);
+        CHECK(size > 0 && size <= 4096);
+    }
+    std::vector<std::string> expected;
+    for (int i = 0; i < 300; ++i) {
+        expected.push_back(entry(i));
+    }
+    CHECK(readBack(rotated) == expected);
+    removeLogs(rotated);
+
+    // 按总大小清理最旧的分段
+    CHECK(FileUtils::writeFileAtomic(config, "log_max_size: 2K\nlog_retain: 6K\nlog_batch_size: 0\nlog_compress: false\n"));
+    const std::string retained = dir.file("retain.log");
+    {
+        Logger logger;
+        logger.loadConfig(config);
+        logger.setLogFile(retained);
+        for (int i = 0; i < 200; ++i) {
+            logger.warning(entry(i));
+        }
+    }
+    segments = LogIndex::segments(retained);
+    std::uint64_t closedBytes = 0;
+    for (std::size_t i = 0; i + 1 < segments.size(); ++i) {
+        CHECK(!endsWith(segments[i], ".gz") && fileSize(segments[i]) <= 2048);
+        closedBytes += fileSize(segments[i]);
+    }
+    CHECK(closedBytes > 0 && closedBytes <= 6 * 1024);
+    std::vector<std::string> kept = readBack(retained);
+    CHECK(kept.size() > 50 && kept.size() < 200);
+    CHECK(std::equal(kept.begin(), kept.end(), expected.begin() + static_cast<long>(200 - kept.size())));
+    removeLogs(retained);
+
+    // 攒批：ERROR 立即写出，析构时写出剩余的行
+    CHECK(FileUtils::writeFileAtomic(config, "log_batch_size: 64K\nlog_batch_interval: 1h\nlog_compress: false\n"));
+    const std::string batched = dir.file("batch.log");
+    {
+        Logger logger;
+        logger.loadConfig(config);
+        logger.setLogFile(batched);
+        logger.info(entry(0));
+        logger.success(entry(1));
+        CHECK(fileSize(batched) == 0);
+        logger.error(entry(2));
+        CHECK((readBack(batched) == std::vector<std::string>{entry(0), entry(1), entry(2)}));
+        logger.info(entry(3));
+        CHECK(readBack(batched).size() == 3);
+    }
+    CHECK((readBack(batched) == std::vector<std::string>{entry(0), entry(1), entry(2), entry(3)}));
+    removeLogs(batched);
+
+    // 补压缩上次未及压缩的分段
+    if (zlib) {
+        const std::string resumed = dir.file("resume.log");
+        const std::string leftover = resumed + ".20240101-000000";
+        CHECK(FileUtils::writeFileAtomic(leftover, "[2024-01-01 00:00:00] [INFO] " + entry(0) + "\n"));
+        CHECK(FileUtils::writeFileAtomic(leftover + ".gz.tmp", "partial"));
+        {
+            Logger logger;
+            logger.loadConfig(dir.file("absent.yaml"));
+            logger.setLogFile(resumed);
+        }
+        CHECK(access(leftover.c_str(), F_OK) != 0 && access((leftover + ".gz").c_str(), F_OK) == 0);
+        CHECK(access((leftover + ".gz.tmp").c_str(), F_OK) != 0);
+        CHECK(indexedSize(leftover + ".gz") > 0);
+        CHECK((readBack(resumed) == std::vector<std::string>{entry(0)}));
+        removeLogs(resumed);
+    }
+
+    unlink(config.c_str());
+    std::printf("logger_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
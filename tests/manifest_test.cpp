@@ -0,0 +1,137 @@
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/hash.hpp"
+#include "linuxstudio/manifest.hpp"
+#include "test_support.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief 文件哈希清单测试
+ *
+ * - build 递归收集目录树（不跟随符号链接，跳过 exclude）与单独的文件，按路径排序去重；
+ * - save/load 往返后条目逐字段一致，截断的清单与错误的文件头被拒绝；
+ * - verify 对未改动的文件通过，改写（含大小不变）、删除、换成符号链接分别报告 modified、missing、type。
+ */
+
+using LinuxStudio::FileUtils;
+using LinuxStudio::Manifest;
+using LinuxStudio::Xxh64;
+
+namespace {
+
+const Manifest::Entry* findEntry(const Manifest& manifest, const std::string& path) {
+    for (const auto& entry : manifest.entries()) {
+        if (entry.path == path) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+std::string reasonFor(const Manifest::Report& report, const std::string& path) {
+    for (const auto& mismatch : report.mismatches) {
+        if (mismatch.path == path) {
+            return mismatch.reason;
+        }
+    }
+    return "";
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const std::string tree = dir.file("plugin");
+    mkdir(tree.c_str(), 0755);
+    mkdir((tree + "/lib").c_str(), 0755);
+    mkdir((tree + "/lib/deep").c_str(), 0755);
+    mkdir((tree + "/cache").c_str(), 0755);
+    CHECK(FileUtils::writeFileAtomic(tree + "/setup.sh", "#!/bin/sh\necho setup\n"));
+    CHECK(FileUtils::writeFileAtomic(tree + "/lib/module.py", "print('module')\n"));
+    CHECK(FileUtils::writeFileAtomic(tree + "/lib/deep/big.bin", std::string(256 * 1024, 'b')));
+    CHECK(FileUtils::writeFileAtomic(tree + "/cache/skip.tmp", "skipped\n"));
+    CHECK(FileUtils::writeFileAtomic(tree + "/lib/empty", ""));
+    CHECK(symlink("module.py", (tree + "/lib/current").c_str()) == 0);
+    CHECK(symlink(dir.path().c_str(), (tree + "/outside").c_str()) == 0);
+    const std::string extra = dir.file("extra.conf");
+    CHECK(FileUtils::writeFileAtomic(extra, "key: value\n"));
+
+    Manifest manifest;
+    CHECK(manifest.build({tree, dir.file("missing-root")}, {extra, tree + "/setup.sh", dir.file("missing-file")},
+                         {tree + "/cache"}));
+    const std::vector<std::string> expected = {
+        extra,
+        tree + "/lib/current",
+        tree + "/lib/deep/big.bin",
+        tree + "/lib/empty",
+        tree + "/lib/module.py",
+        tree + "/outside",
+        tree + "/setup.sh",
+    };
+    std::vector<std::string> paths;
+    for (const auto& entry : manifest.entries()) {
+        paths.push_back(entry.path);
+    }
+    CHECK(paths == expected);
+    CHECK(manifest.totalBytes() == 256 * 1024 + 16 + 21 + 11);
+
+    // 符号链接记录链接目标的摘要，不跟随
+    const Manifest::Entry* link = findEntry(manifest, tree + "/lib/current");
+    CHECK(link != nullptr && link->type == 'l' && link->size == 9);
+    Xxh64 target;
+    target.update("module.py", 9);
+    CHECK(link != nullptr && link->digest == target.hexDigest());
+    const Manifest::Entry* big = findEntry(manifest, tree + "/lib/deep/big.bin");
+    std::string digest;
+    CHECK(Xxh64::hashFile(tree + "/lib/deep/big.bin", digest));
+    CHECK(big != nullptr && big->type == 'f' && big->digest == digest);
+
+    // 往返
+    const std::string path = dir.file("manifest");
+    CHECK(manifest.save(path));
+    Manifest loaded;
+    CHECK(loaded.load(path));
+    CHECK(loaded.entries().size() == manifest.entries().size());
+    for (std::size_t i = 0; i < loaded.entries().size() && i < manifest.entries().size(); ++i) {
+        const auto& a = manifest.entries()[i];
+        const auto& b = loaded.entries()[i];
+        CHECK(a.path == b.path && a.type == b.type && a.size == b.size && a.digest == b.digest);
+    }
+    Manifest::Report clean = loaded.verify();
+    CHECK(clean.ok() && clean.files == expected.size());
+    CHECK(clean.bytes == manifest.totalBytes() + 9 + std::string(dir.path()).size());
+
+    // 截断与错误的文件头
+    std::string content;
+    CHECK(FileUtils::readFile(path, content));
+    std::string truncated = content.substr(0, content.rfind('\n', content.size() - 2) + 1);
+    CHECK(FileUtils::writeFileAtomic(dir.file("truncated"), truncated));
+    CHECK(!Manifest().load(dir.file("truncated")));
+    CHECK(FileUtils::writeFileAtomic(dir.file("header"), "xkl-manifest-0 md5 7\n" + content.substr(content.find('\n') + 1)));
+    CHECK(!Manifest().load(dir.file("header")));
+    CHECK(!Manifest().load(dir.file("absent")));
+
+    // 改动
+    CHECK(FileUtils::writeFileAtomic(tree + "/setup.sh", "#!/bin/sh\necho SETUP\n"));
+    CHECK(FileUtils::writeFileAtomic(tree + "/lib/module.py", "print('changed!!')\n"));
+    CHECK(unlink((tree + "/lib/empty").c_str()) == 0);
+    CHECK(unlink(extra.c_str()) == 0);
+    CHECK(symlink("elsewhere", extra.c_str()) == 0);
+    Manifest::Report report = loaded.verify();
+    CHECK(report.mismatches.size() == 4);
+    CHECK(reasonFor(report, tree + "/setup.sh") == "modified");
+    CHECK(reasonFor(report, tree + "/lib/module.py") == "modified");
+    CHECK(reasonFor(report, tree + "/lib/empty") == "missing");
+    CHECK(reasonFor(report, extra) == "type");
+
+    unlink(extra.c_str());
+    FileUtils::removeTree(tree);
+    std::printf("manifest_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+#include "linuxstudio/managers.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "http_server.hpp"
+#include "test_support.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief MirrorManager 测速与排名测试
+ *
+ * 在本机起若干 HTTP 服务器充当镜像，通过 XKL_MIRRORS_CONF 加为 apt 候选：
+ * - 注入不同延迟，排名按速度从快到慢，fastest() 返回最快的一个；
+ * - 不回应的镜像在传输超时后判为不可达，并行测速的总耗时不随镜像数累加；
+ * - 5xx、拒绝连接的镜像排在所有可达镜像之后；最快的镜像下线后重新测速改选次快的。
+ * 内置的公网候选同样参与测速（离线时不可达），断言只看本机镜像的相对顺序。
+ */
+
+using LinuxStudio::MirrorKind;
+using LinuxStudio::MirrorManager;
+using LinuxStudio::MirrorProbe;
+using LinuxStudioTest::HttpServer;
+
+namespace {
+
+// 与 mirror_manager.cpp 中的建连、传输超时一致，外加余量
+const double kProbeBudgetMs = 2000 + 3000 + 1500;
+
+std::unique_ptr<HttpServer> mirror(int delayMs, int status = 200, bool hang = false) {
+    std::string body(256 * 1024, 'm');
+    return std::unique_ptr<HttpServer>(new HttpServer([=](const HttpServer::Request&) {
+        HttpServer::Response response;
+        response.status = status;
+        response.body = status == 200 ? body : "error";
+        response.delayMs = delayMs;
+        response.hang = hang;
+        return response;
+    }));
+}
+
+/**
+ * @brief 只保留本机镜像，保持排名顺序
+ */
+std::vector<MirrorProbe> local(const std::vector<MirrorProbe>& probes) {
+    std::vector<MirrorProbe> result;
+    for (const auto& probe : probes) {
+        if (probe.url.find("://127.0.0.1:") != std::string::npos) {
+            result.push_back(probe);
+        }
+    }
+    return result;
+}
+
+std::size_t position(const std::vector<MirrorProbe>& probes, const std::string& url) {
+    for (std::size_t i = 0; i < probes.size(); ++i) {
+        if (probes[i].url == url) {
+            return i;
+        }
+    }
+    return probes.size();
+}
+
+double rankMs(MirrorManager& manager, std::vector<MirrorProbe>& probes) {
+    auto start = std::chrono::steady_clock::now();
+    probes = manager.rank(MirrorKind::APT, true);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+
+    auto slow = mirror(400);
+    auto fast = mirror(0);
+    auto medium = mirror(150);
+    auto hanging = mirror(0, 200, true);
+    auto broken = mirror(0, 503);
+    // 拒绝连接：取得端口后立即关闭
+    auto closed = mirror(0);
+    std::string closedUrl = closed->url("/debian/");
+    closed->stop();
+
+    for (const auto* server : {slow.get(), fast.get(), medium.get(), hanging.get(), broken.get()}) {
+        CHECK(server->valid());
+    }
+
+    const std::string slowUrl = slow->url("/debian/");
+    const std::string fastUrl = fast->url("/debian/");
+    const std::string mediumUrl = medium->url("/debian/");
+    const std::string hangingUrl = hanging->url("/debian/");
+    const std::string brokenUrl = broken->url("/debian/");
+
+    std::string conf;
+    for (const auto& url : {slowUrl, hangingUrl, brokenUrl, fastUrl, closedUrl, mediumUrl}) {
+        conf += "apt " + url + "\n";
+    }
+    CHECK(LinuxStudio::FileUtils::writeFileAtomic(dir.file("mirrors.conf"), conf));
+    setenv("XKL_MIRRORS_CONF", dir.file("mirrors.conf").c_str(), 1);
+    setenv("XKL_MIRRORS_CACHE", dir.file("mirrors.cache").c_str(), 1);
+
+    MirrorManager manager;
+
+    // 最快选择与超时
+    std::vector<MirrorProbe> probes;
+    double elapsed = rankMs(manager, probes);
+    std::vector<MirrorProbe> ranked = local(probes);
+    CHECK(ranked.size() == 6);
+    CHECK(elapsed < kProbeBudgetMs);
+    CHECK(position(ranked, fastUrl) == 0);
+    CHECK(position(ranked, mediumUrl) == 1);
+    CHECK(position(ranked, slowUrl) == 2);
+    for (std::size_t i = 0; i < 3 && i < ranked.size(); ++i) {
+        CHECK(ranked[i].reachable);
+        CHECK(ranked[i].throughputKBps > 0);
+    }
+    CHECK(manager.fastest(MirrorKind::APT) == fastUrl);
+
+    // 不可达的镜像排在所有可达镜像之后
+    for (const auto& url : {hangingUrl, brokenUrl, closedUrl}) {
+        std::size_t index = position(ranked, url);
+        CHECK(index >= 3 && index < ranked.size());
+        CHECK(index < ranked.size() && !ranked[index].reachable);
+    }
+    bool seenUnreachable = false;
+    for (const auto& probe : probes) {
+        CHECK(!(seenUnreachable && probe.reachable));
+        seenUnreachable = seenUnreachable || !probe.reachable;
+    }
+
+    // 排名写入缓存，不刷新时直接使用
+    fast->clearRequests();
+    std::vector<MirrorProbe> cached = local(manager.rank(MirrorKind::APT, false));
+    CHECK(fast->requests().empty());
+    CHECK(cached.size() == ranked.size() && position(cached, fastUrl) == 0);
+
+    // 故障转移：最快的镜像下线后改选次快的
+    fast->stop();
+    elapsed = rankMs(manager, probes);
+    ranked = local(probes);
+    CHECK(elapsed < kProbeBudgetMs);
+    CHECK(position(ranked, mediumUrl) == 0);
+    CHECK(position(ranked, slowUrl) == 1);
+    std::size_t fastIndex = position(ranked, fastUrl);
+    CHECK(fastIndex >= 2 && fastIndex < ranked.size() && !ranked[fastIndex].reachable);
+    CHECK(manager.fastest(MirrorKind::APT) == mediumUrl);
+
+    std::printf("mirror_manager_test: %zu local mirrors ranked, %d failures\n", ranked.size(),
+                LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
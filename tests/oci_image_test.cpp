@@ -0,0 +1,212 @@
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/hash.hpp"
+#include "linuxstudio/oci_image.hpp"
+#include "linuxstudio/process.hpp"
+#include "test_support.hpp"
+
+#include <cstdio>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief OCI 镜像布局测试
+ *
+ * 对同一棵目录树分别写出不压缩与压缩（多线程、跨多个分块）的镜像，用 python3 按 OCI 规范核对布局：
+ * - oci-layout 版本、index.json → 清单 → 配置与层的引用链，每个 blob 的 sha256 与大小和描述符一致，
+ *   blobs/ 下没有多余文件；
+ * - 配置中的 diff_id 是解压后层的摘要；
+ * - 用 tar 解开两种层：内容、权限与符号链接不变，同一 inode 与内容相同的文件解出后是硬链接。
+ */
+
+using LinuxStudio::FileUtils;
+using LinuxStudio::OciImageWriter;
+using LinuxStudio::Process;
+using LinuxStudio::Sha256;
+
+namespace {
+
+/**
+ * @brief 校验布局，输出一行：清单摘要 层摘要 diff_id 镜像名；不符时以非零状态退出
+ */
+const char* const kLayoutScript =
+    "import gzip, hashlib, json, os, sys\n"
+    "root = sys.argv[1]\n"
+    "blobs = os.path.join(root, 'blobs', 'sha256')\n"
+    "seen = set()\n"
+    "def blob(desc):\n"
+    "    algo, hexdigest = desc['digest'].split(':')\n"
+    "    assert algo == 'sha256', desc\n"
+    "    with open(os.path.join(blobs, hexdigest), 'rb') as f:\n"
+    "        data = f.read()\n"
+    "    assert hashlib.sha256(data).hexdigest() == hexdigest, desc\n"
+    "    assert len(data) == desc['size'], desc\n"
+    "    seen.add(hexdigest)\n"
+    "    return data\n"
+    "with open(os.path.join(root, 'oci-layout')) as f:\n"
+    "    assert json.load(f) == {'imageLayoutVersion': '1.0.0'}\n"
+    "with open(os.path.join(root, 'index.json')) as f:\n"
+    "    index = json.load(f)\n"
+    "assert index['schemaVersion'] == 2 and len(index['manifests']) == 1\n"
+    "desc = index['manifests'][0]\n"
+    "assert desc['mediaType'] == 'application/vnd.oci.image.manifest.v1+json'\n"
+    "manifest = json.loads(blob(desc))\n"
+    "assert manifest['schemaVersion'] == 2 and manifest['mediaType'] == desc['mediaType']\n"
+    "assert manifest['config']['mediaType'] == 'application/vnd.oci.image.config.v1+json'\n"
+    "config = json.loads(blob(manifest['config']))\n"
+    "assert config['os'] == 'linux' and config['architecture'] and config['rootfs']['type'] == 'layers'\n"
+    "assert len(manifest['layers']) == 1\n"
+    "layer = manifest['layers'][0]\n"
+    "data = blob(layer)\n"
+    "if layer['mediaType'] == 'application/vnd.oci.image.layer.v1.tar+gzip':\n"
+    "    data = gzip.decompress(data)\n"
+    "else:\n"
+    "    assert layer['mediaType'] == 'application/vnd.oci.image.layer.v1.tar', layer\n"
+    "diff_id = 'sha256:' + hashlib.sha256(data).hexdigest()\n"
+    "assert config['rootfs']['diff_ids'] == [diff_id]\n"
+    "assert set(os.listdir(blobs)) == seen, os.listdir(blobs)\n"
+    "ref = desc.get('annotations', {}).get('org.opencontainers.image.ref.name', '-')\n"
+    "print(desc['digest'], layer['digest'], diff_id, ref)\n";
+
+struct Layout {
+    std::string manifest;
+    std::string layer;
+    std::string diffId;
+    std::string reference;
+};
+
+bool checkLayout(const std::string& root, Layout& layout) {
+    std::string output;
+    if (!Process::capture("python3 -c " + Process::quote(kLayoutScript) + " " + Process::quote(root), output)) {
+        return false;
+    }
+    std::string* fields[] = {&layout.manifest, &layout.layer, &layout.diffId, &layout.reference};
+    std::size_t start = 0;
+    for (std::string* field : fields) {
+        std::size_t end = output.find_first_of(" \n", start);
+        if (end == std::string::npos) {
+            return false;
+        }
+        *field = output.substr(start, end - start);
+        start = end + 1;
+    }
+    return true;
+}
+
+std::string blobPath(const std::string& root, const std::string& digest) {
+    return root + "/blobs/sha256/" + digest.substr(digest.find(':') + 1);
+}
+
+bool sameInode(const std::string& a, const std::string& b) {
+    struct stat sa;
+    struct stat sb;
+    return lstat(a.c_str(), &sa) == 0 && lstat(b.c_str(), &sb) == 0 && S_ISREG(sa.st_mode) &&
+           sa.st_ino == sb.st_ino && sa.st_dev == sb.st_dev;
+}
+
+bool sameContent(const std::string& a, const std::string& b) {
+    std::string left;
+    std::string right;
+    return FileUtils::readFile(a, left) && FileUtils::readFile(b, right) && left == right;
+}
+
+/**
+ * @brief 用 tar 解开层（路径去掉开头的 /，上级目录一并写入），核对内容、权限、符号链接与硬链接
+ */
+bool checkExtracted(const std::string& tree, const std::string& layer, const std::string& extract,
+                    const std::string& flags) {
+    mkdir(extract.c_str(), 0755);
+    bool ok = Process::run("tar -x" + flags + "f " + Process::quote(layer) + " -C " + Process::quote(extract)) == 0;
+    const std::string out = extract + tree;
+    struct stat st;
+    char target[64] = {};
+    ok = ok && sameContent(tree + "/bin/tool", out + "/bin/tool") &&
+         sameContent(tree + "/share/readme", out + "/share/readme") &&
+         sameContent(tree + "/share/big.txt", out + "/share/big.txt") &&
+         sameInode(out + "/bin/tool", out + "/bin/tool-alias") &&
+         sameInode(out + "/share/readme", out + "/share/readme.copy") &&
+         !sameInode(out + "/bin/tool", out + "/share/readme") &&
+         stat((out + "/bin/tool").c_str(), &st) == 0 && (st.st_mode & 07777) == 0755 &&
+         stat((out + "/share/empty").c_str(), &st) == 0 && S_ISDIR(st.st_mode) && (st.st_mode & 07777) == 0700 &&
+         readlink((out + "/share/tool-link").c_str(), target, sizeof(target) - 1) == 11 &&
+         std::string(target) == "../bin/tool";
+    FileUtils::removeTree(extract);
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    if (!Process::succeeded("python3 -c 'import gzip, hashlib, json' > /dev/null 2>&1") ||
+        !Process::succeeded("tar --version > /dev/null 2>&1")) {
+        std::printf("oci_image_test: python3 or tar unavailable, skipped\n");
+        return 0;
+    }
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+
+    // 源目录树：普通文件、可执行文件、内容相同的副本、硬链接、符号链接、空目录、跨多个压缩分块的大文件
+    const std::string tree = dir.file("rootfs");
+    mkdir(tree.c_str(), 0755);
+    mkdir((tree + "/bin").c_str(), 0755);
+    mkdir((tree + "/share").c_str(), 0755);
+    mkdir((tree + "/share/empty").c_str(), 0700);
+    CHECK(FileUtils::writeFileAtomic(tree + "/bin/tool", "#!/bin/sh\necho tool\n"));
+    CHECK(chmod((tree + "/bin/tool").c_str(), 0755) == 0);
+    CHECK(FileUtils::writeFileAtomic(tree + "/share/readme", "same content\n"));
+    CHECK(FileUtils::writeFileAtomic(tree + "/share/readme.copy", "same content\n"));
+    CHECK(link((tree + "/bin/tool").c_str(), (tree + "/bin/tool-alias").c_str()) == 0);
+    CHECK(symlink("../bin/tool", (tree + "/share/tool-link").c_str()) == 0);
+    std::string big;
+    for (unsigned i = 0; big.size() < 3 * 1024 * 1024; ++i) {
+        big += "line " + std::to_string(i * 2654435761u) + "\n";
+    }
+    CHECK(FileUtils::writeFileAtomic(tree + "/share/big.txt", big));
+
+    // 不压缩
+    const std::string plain = dir.file("plain");
+    OciImageWriter::Report plainReport;
+    {
+        OciImageWriter writer(plain);
+        writer.addTree(tree);
+        CHECK(writer.write(OciImageWriter::Options{false, 1, "demo:1.0"}, plainReport));
+    }
+    CHECK(plainReport.files == 3 && plainReport.deduplicated == 2 && plainReport.symlinks == 1);
+    CHECK(plainReport.directories >= 4);
+    CHECK(plainReport.tarBytes == plainReport.blobBytes);
+    Layout plainLayout;
+    CHECK(checkLayout(plain, plainLayout));
+    CHECK(plainLayout.manifest == plainReport.manifestDigest);
+    CHECK(plainLayout.layer == plainReport.layerDigest && plainLayout.diffId == plainReport.layerDigest);
+    CHECK(plainLayout.reference == "demo:1.0");
+    std::string digest;
+    CHECK(Sha256::hashFile(blobPath(plain, plainReport.layerDigest), digest) &&
+          "sha256:" + digest == plainReport.layerDigest);
+
+    const std::string extract = dir.file("extract");
+    CHECK(checkExtracted(tree, blobPath(plain, plainReport.layerDigest), extract, ""));
+
+    // 压缩：多线程分块拼成的 gzip 解压后与不压缩的层相同
+    if (OciImageWriter::compressionAvailable()) {
+        const std::string packed = dir.file("packed");
+        OciImageWriter::Report packedReport;
+        {
+            OciImageWriter writer(packed);
+            writer.addTree(tree);
+            CHECK(writer.write(OciImageWriter::Options{true, 4, ""}, packedReport));
+        }
+        CHECK(packedReport.tarBytes == plainReport.tarBytes && packedReport.blobBytes < packedReport.tarBytes);
+        Layout packedLayout;
+        CHECK(checkLayout(packed, packedLayout));
+        CHECK(packedLayout.manifest == packedReport.manifestDigest && packedLayout.layer == packedReport.layerDigest);
+        CHECK(packedLayout.diffId != packedLayout.layer && packedLayout.reference == "-");
+        CHECK(checkExtracted(tree, blobPath(packed, packedReport.layerDigest), extract, "z"));
+        FileUtils::removeTree(packed);
+    }
+
+    FileUtils::removeTree(plain);
+    FileUtils::removeTree(tree);
+    std::printf("oci_image_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
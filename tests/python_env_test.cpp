@@ -0,0 +1,178 @@
+#include "linuxstudio/managers.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/hash.hpp"
+#include "linuxstudio/process.hpp"
+#include "linuxstudio/scene_lock.hpp"
+#include "test_support.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Python 环境与 wheel 仓库测试
+ *
+ * 仓库、锁文件目录与回收区分别由 XKL_PYTHON_ROOT、XKL_LOCK_DIR、XKL_TRASH_DIR 指到临时目录，
+ * 用 python3 zipfile 现场生成 wheel（不联网）：
+ * - 解包保留 zip 外部属性中的可执行位（扩展模块、.data/scripts）；
+ * - 环境中的文件硬链接到仓库；跨文件系统时 placeFile 退回 reflink 或复制，内容与权限不变；
+ * - 环境名含 / 或 .. 时 createEnv/removeEnv 失败，不在 envs/ 之外建目录；
+ * - gc 保留环境引用与默认目录下锁文件固定的 wheel，回收其余的。
+ */
+
+using LinuxStudio::FileUtils;
+using LinuxStudio::Process;
+using LinuxStudio::PythonEnvManager;
+using LinuxStudio::SceneLock;
+using LinuxStudio::Sha256;
+
+namespace {
+
+const char* const kWheelScript =
+    "import sys, zipfile\n"
+    "name, path = sys.argv[1], sys.argv[2]\n"
+    "def add(wheel, member, data, mode):\n"
+    "    info = zipfile.ZipInfo(member)\n"
+    "    info.external_attr = (0o100000 | mode) << 16\n"
+    "    wheel.writestr(info, data)\n"
+    "with zipfile.ZipFile(path, 'w') as wheel:\n"
+    "    add(wheel, name + '/__init__.py', 'def main():\\n    print(\"' + name + '\")\\n', 0o644)\n"
+    "    add(wheel, name + '/_native.so', b'\\x7fELF' + name.encode(), 0o755)\n"
+    "    add(wheel, name + '-1.0.data/scripts/' + name + '-tool', '#!python\\nprint(\"tool\")\\n', 0o755)\n"
+    "    add(wheel, name + '-1.0.dist-info/METADATA', 'Name: ' + name + '\\nVersion: 1.0\\n', 0o644)\n"
+    "    add(wheel, name + '-1.0.dist-info/entry_points.txt',\n"
+    "        '[console_scripts]\\n' + name + ' = ' + name + ':main\\n', 0o644)\n";
+
+bool exists(const std::string& path) {
+    struct stat st;
+    return lstat(path.c_str(), &st) == 0;
+}
+
+bool executable(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && (st.st_mode & S_IXUSR) != 0;
+}
+
+/**
+ * @brief 生成名为 name 的 wheel 并收入仓库，返回 "文件名#sha256=摘要"
+ */
+std::string importWheel(PythonEnvManager& python, const LinuxStudioTest::TempDir& dir, const std::string& name) {
+    std::string file = dir.file(name + "-1.0-py3-none-any.whl");
+    if (Process::run("python3 -c " + Process::quote(kWheelScript) + " " + name + " " + Process::quote(file)) != 0) {
+        return "";
+    }
+    std::string digest;
+    std::string content;
+    if (!Sha256::hashFile(file, digest) || !FileUtils::readFile(file, content)) {
+        return "";
+    }
+    std::string entry = file.substr(file.rfind('/') + 1) + "#sha256=" + digest;
+    bool imported = python.importWheel(entry, [&content](const std::string& path) {
+        return FileUtils::writeFileAtomic(path, content);
+    });
+    unlink(file.c_str());
+    return imported ? entry : "";
+}
+
+std::string digestOf(const std::string& entry) {
+    return entry.substr(entry.rfind('=') + 1);
+}
+
+} // namespace
+
+int main() {
+    if (!Process::succeeded("python3 -m venv --help > /dev/null 2>&1")) {
+        std::printf("python_env_test: python3 venv unavailable, skipped\n");
+        return 0;
+    }
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const std::string root = dir.file("python");
+    const std::string locks = dir.file("locks");
+    setenv("XKL_PYTHON_ROOT", root.c_str(), 1);
+    setenv("XKL_LOCK_DIR", locks.c_str(), 1);
+    setenv("XKL_TRASH_DIR", dir.file("trash").c_str(), 1);
+
+    PythonEnvManager python;
+    const std::string a = importWheel(python, dir, "alpha");
+    const std::string b = importWheel(python, dir, "beta");
+    const std::string c = importWheel(python, dir, "gamma");
+    CHECK(!a.empty() && !b.empty() && !c.empty());
+    CHECK(python.fetch({a, b, c}));
+
+    // 解包保留可执行位
+    const std::string store = root + "/store/" + digestOf(a);
+    CHECK(executable(store + "/alpha/_native.so"));
+    CHECK(executable(store + "/alpha-1.0.data/scripts/alpha-tool"));
+    CHECK(!executable(store + "/alpha/__init__.py"));
+
+    // 环境名不能跳出 envs/
+    for (const char* name : {"../escape", "a/b", "..", ".hidden", ""}) {
+        CHECK(!PythonEnvManager::validEnvName(name));
+        CHECK(!python.createEnv(name, {a}));
+    }
+    CHECK(!exists(root + "/escape") && !exists(dir.file("escape")));
+
+    // 创建环境：文件硬链接到仓库，脚本与入口可执行
+    CHECK(python.createEnv("demo", {a}));
+    const std::string env = python.envPath("demo");
+    std::string purelib;
+    CHECK(Process::capture(Process::quote(env + "/bin/python") +
+                               " -c 'import sysconfig; print(sysconfig.get_paths()[\"purelib\"])'",
+                           purelib));
+    purelib.erase(purelib.find_last_not_of("\n") + 1);
+    struct stat stored;
+    struct stat placed;
+    CHECK(stat((store + "/alpha/_native.so").c_str(), &stored) == 0);
+    CHECK(stat((purelib + "/alpha/_native.so").c_str(), &placed) == 0);
+    CHECK(stored.st_ino == placed.st_ino && stored.st_dev == placed.st_dev);
+    CHECK(executable(purelib + "/alpha/_native.so"));
+    CHECK(executable(env + "/bin/alpha-tool"));
+    std::string output;
+    CHECK(Process::capture(Process::quote(env + "/bin/alpha"), output) && output == "alpha\n");
+    CHECK(!python.removeEnv("../envs/demo"));
+    CHECK(exists(env));
+
+    // 跨文件系统：退回 reflink 或复制，内容与权限不变
+    struct stat shm;
+    struct stat tmp;
+    if (stat("/dev/shm", &shm) == 0 && stat(dir.path().c_str(), &tmp) == 0 && shm.st_dev != tmp.st_dev) {
+        const std::string target = "/dev/shm/xkl-test-placed." + std::to_string(getpid());
+        FileUtils::Placement placement = FileUtils::placeFile(store + "/alpha/_native.so", target, 0755);
+        CHECK(placement == FileUtils::Placement::Reflinked || placement == FileUtils::Placement::Copied);
+        std::string original;
+        std::string copy;
+        CHECK(FileUtils::readFile(store + "/alpha/_native.so", original) && FileUtils::readFile(target, copy));
+        CHECK(original == copy && executable(target));
+        unlink(target.c_str());
+    }
+    CHECK(FileUtils::placeFile(store + "/alpha/__init__.py", dir.file("linked.py"), 0644) ==
+          FileUtils::Placement::Hardlinked);
+    unlink(dir.file("linked.py").c_str());
+
+    // gc：环境引用 a，锁文件固定 b，c 无人引用
+    SceneLock lock;
+    lock.scene = "gc-test";
+    lock.wheels["beta-plugin"] = {b};
+    CHECK(lock.save(SceneLock::defaultPath("gc-test")));
+    CHECK(python.collectGarbage() == 1);
+    CHECK(exists(root + "/wheels/" + digestOf(a) + ".whl") && exists(root + "/wheels/" + digestOf(b) + ".whl"));
+    CHECK(!exists(root + "/wheels/" + digestOf(c) + ".whl") && !exists(root + "/store/" + digestOf(c)));
+
+    CHECK(python.removeEnv("demo"));
+    CHECK(!exists(env));
+    CHECK(python.collectGarbage() == 1);
+    CHECK(exists(root + "/wheels/" + digestOf(b) + ".whl"));
+    unlink(SceneLock::defaultPath("gc-test").c_str());
+    CHECK(python.collectGarbage() == 1);
+    CHECK(!exists(root + "/wheels/" + digestOf(b) + ".whl"));
+
+    FileUtils::removeTree(root);
+    FileUtils::removeTree(locks);
+    FileUtils::removeTree(dir.file("trash"));
+    std::printf("python_env_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+#include "linuxstudio/registry_store.hpp"
+#include "test_support.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief RegistryStore 多进程压力测试
+ *
+ * 数百个进程在同一个（起初不存在的）注册表文件上并发提交和读取：
+ * - 读者在第一个写者创建文件的窗口内调用 version()/read() 不得崩溃（SIGBUS），
+ *   该窗口很窄，另用一个空文件确定性地复现；
+ * - 每个写者提交后立即能读到自己的最新值，版本号单调递增；
+ * - 值的总量超过初始容量，覆盖扩容时 rename 替换文件的路径；
+ * - 全部结束后版本号等于提交总数，每个键都是其写者的最后一个值。
+ */
+
+using LinuxStudio::RegistryStore;
+
+namespace {
+
+// ThreadSanitizer 看不到跨进程的竞争，每个进程的启动开销又很大，TSAN 构建下缩小规模
+#if defined(__SANITIZE_THREAD__)
+const int kWriters = 40;
+const int kReaders = 10;
+#else
+const int kWriters = 200;
+const int kReaders = 60;
+#endif
+const int kCommits = 10;
+const std::uint64_t kTotalCommits = static_cast<std::uint64_t>(kWriters) * kCommits;
+
+std::string keyFor(int writer) {
+    return "writer-" + std::to_string(writer);
+}
+
+std::string valueFor(int writer, int commit) {
+    // 每个值约 100 字节，200 个键合计超过 16 KiB 初始容量
+    return std::to_string(commit) + ":" + std::string(80 + writer % 16, 'v');
+}
+
+int commitOf(const std::string& value) {
+    return std::atoi(value.c_str());
+}
+
+/**
+ * @brief 写者进程：返回非零表示检查失败
+ */
+int runWriter(const std::string& path, int writer) {
+    RegistryStore store(path);
+    std::uint64_t lastVersion = 0;
+    for (int commit = 0; commit < kCommits; ++commit) {
+        RegistryStore::Changes changes;
+        changes[keyFor(writer)] = valueFor(writer, commit);
+        std::uint64_t version = 0;
+        RegistryStore::Entries merged;
+        if (!store.commit(changes, &merged, &version)) {
+            return 1;
+        }
+        if (version <= lastVersion || merged[keyFor(writer)] != valueFor(writer, commit)) {
+            return 2;
+        }
+        lastVersion = version;
+
+        RegistryStore::Entries entries;
+        std::uint64_t readVersion = 0;
+        if (!store.read(entries, &readVersion) || readVersion < version) {
+            return 3;
+        }
+        auto it = entries.find(keyFor(writer));
+        if (it == entries.end() || it->second != valueFor(writer, commit)) {
+            return 4;
+        }
+        if (store.version() < version) {
+            return 5;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 读者进程：版本号不回退，读到的快照内容完整；读到最终版本后退出
+ */
+int runReader(const std::string& path) {
+    RegistryStore store(path);
+    std::uint64_t lastVersion = 0;
+    for (;;) {
+        std::uint64_t version = store.version();
+        if (version < lastVersion) {
+            return 11;
+        }
+        lastVersion = version;
+
+        // 文件尚未初始化完成时 read 返回 false，之后必须成功
+        RegistryStore::Entries entries;
+        std::uint64_t readVersion = 0;
+        if (!store.read(entries, &readVersion)) {
+            if (version > 0) {
+                return 12;
+            }
+            continue;
+        }
+        if (readVersion < lastVersion) {
+            return 13;
+        }
+        lastVersion = readVersion;
+        if (entries.size() > static_cast<std::size_t>(kWriters)) {
+            return 14;
+        }
+        for (const auto& entry : entries) {
+            int commit = commitOf(entry.second);
+            if (commit < 0 || commit >= kCommits) {
+                return 15;
+            }
+        }
+        if (readVersion >= kTotalCommits) {
+            return 0;
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    if (!dir.valid()) {
+        return 1;
+    }
+    const std::string path = dir.file("registry");
+
+    // 写者 open(O_CREAT) 之后、ftruncate 之前的空文件
+    {
+        const std::string empty = dir.file("empty");
+        int fd = open(empty.c_str(), O_RDWR | O_CREAT, 0644);
+        CHECK(fd >= 0);
+        close(fd);
+        RegistryStore store(empty);
+        RegistryStore::Entries entries;
+        CHECK(store.version() == 0);
+        CHECK(!store.read(entries));
+    }
+
+    // 所有子进程阻塞在管道上，父进程关闭写端后同时开始
+    int gate[2];
+    CHECK(pipe(gate) == 0);
+
+    std::vector<pid_t> children;
+    for (int i = 0; i < kReaders + kWriters; ++i) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(gate[1]);
+            char byte;
+            while (read(gate[0], &byte, 1) < 0) {
+            }
+            int code = i < kReaders ? runReader(path) : runWriter(path, i - kReaders);
+            _exit(code);
+        }
+        CHECK(pid > 0);
+        if (pid > 0) {
+            children.push_back(pid);
+        }
+    }
+    close(gate[0]);
+    close(gate[1]);
+
+    // 先等写者；有写者失败时读者等不到最终版本，直接终止
+    int crashed = 0;
+    int failed = 0;
+    auto reap = [&crashed, &failed](pid_t pid) {
+        int status = 0;
+        if (waitpid(pid, &status, 0) != pid) {
+            ++failed;
+        } else if (WIFSIGNALED(status)) {
+            std::fprintf(stderr, "process %d killed by signal %d\n", pid, WTERMSIG(status));
+            ++crashed;
+        } else if (WEXITSTATUS(status) != 0) {
+            std::fprintf(stderr, "process %d failed with code %d\n", pid, WEXITSTATUS(status));
+            ++failed;
+        }
+    };
+    for (std::size_t i = kReaders; i < children.size(); ++i) {
+        reap(children[i]);
+    }
+    for (std::size_t i = 0; i < static_cast<std::size_t>(kReaders) && i < children.size(); ++i) {
+        if (crashed + failed > 0) {
+            kill(children[i], SIGKILL);
+        }
+        reap(children[i]);
+    }
+    CHECK(crashed == 0);
+    CHECK(failed == 0);
+
+    RegistryStore store(path);
+    RegistryStore::Entries entries;
+    std::uint64_t version = 0;
+    CHECK(store.read(entries, &version));
+    CHECK(version == kTotalCommits);
+    CHECK(store.version() == kTotalCommits);
+    CHECK(entries.size() == static_cast<std::size_t>(kWriters));
+    for (int writer = 0; writer < kWriters; ++writer) {
+        auto it = entries.find(keyFor(writer));
+        CHECK(it != entries.end() && it->second == valueFor(writer, kCommits - 1));
+    }
+
+    std::printf("registry_store_stress: %d writers x %d commits, %d readers, version %llu, %d failures\n",
+                kWriters, kCommits, kReaders, static_cast<unsigned long long>(version),
+                LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+#include "linuxstudio/core.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/managers.hpp"
+#include "linuxstudio/registry_watcher.hpp"
+#include "test_support.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * @brief 注册表增量刷新测试
+ *
+ * 插件目录、组件目录、dpkg 状态文件与监视锁分别由 XKL_PLUGINS_DIR、XKL_COMPONENTS_DIR、
+ * XKL_DPKG_STATUS、XKL_WATCH_LOCK 指到临时目录（其余路径同样重定向，不触碰 /opt）：
+ * - catchUp 只报告变更标记变化的插件与组件，无变化时再次调用为空；
+ * - run 期间新增、修改、删除插件与改写 dpkg 状态文件都在去抖后同步到内存视图并回调；
+ * - 监视期间其他进程看到 active()，停止后释放锁。
+ */
+
+using LinuxStudio::CoreEngine;
+using LinuxStudio::FileUtils;
+using LinuxStudio::RegistryWatcher;
+
+namespace {
+
+std::string metadata(const std::string& name, const std::string& version) {
+    return "{\n  \"name\": \"" + name + "\",\n  \"version\": \"" + version +
+           "\",\n  \"enabled\": true,\n  \"installedAt\": \"2024-01-31T08:00:00\"\n}\n";
+}
+
+std::string dpkgStatus(bool installed, const std::string& version) {
+    return std::string("Package: demo-tool\n") +
+           (installed ? "Status: install ok installed\n" : "Status: deinstall ok config-files\n") +
+           "Version: " + version + "\n\nPackage: unrelated\nStatus: install ok installed\nVersion: 1.0\n\n";
+}
+
+/**
+ * @brief 在另一个进程中查询 active()（fcntl 锁对持有进程自身不可见）
+ */
+bool activeElsewhere() {
+    pid_t pid = fork();
+    if (pid == 0) {
+        _exit(RegistryWatcher::active() ? 0 : 1);
+    }
+    int status = 0;
+    return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * @brief 收集监视回调报告的变化
+ */
+class Collected {
+public:
+    void add(const RegistryWatcher::Changes& changes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        plugins_.insert(plugins_.end(), changes.plugins.begin(), changes.plugins.end());
+        packages_.insert(packages_.end(), changes.packages.begin(), changes.packages.end());
+    }
+
+    /**
+     * @brief 等到 name 出现在插件（或组件）变化中，最多 5 秒；出现后清空已收集的记录
+     */
+    bool waitFor(const std::string& name, bool package) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                const auto& list = package ? packages_ : plugins_;
+                if (std::find(list.begin(), list.end(), name) != list.end()) {
+                    plugins_.clear();
+                    packages_.clear();
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        return false;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::string> plugins_;
+    std::vector<std::string> packages_;
+};
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const std::string plugins = dir.file("plugins");
+    const std::string components = dir.file("components");
+    const std::string status = dir.file("status");
+    setenv("XKL_PLUGINS_DIR", plugins.c_str(), 1);
+    setenv("XKL_COMPONENTS_DIR", components.c_str(), 1);
+    setenv("XKL_DPKG_STATUS", status.c_str(), 1);
+    setenv("XKL_WATCH_LOCK", dir.file("watch.lock").c_str(), 1);
+    setenv("XKL_COMPLETION_INDEX", dir.file("completion").c_str(), 1);
+    setenv("XKL_PYTHON_ROOT", dir.file("python").c_str(), 1);
+    setenv("XKL_MIRRORS_CONF", dir.file("mirrors.conf").c_str(), 1);
+    setenv("XKL_MIRRORS_CACHE", dir.file("mirrors.cache").c_str(), 1);
+    setenv("XKL_TRASH_DIR", dir.file("trash").c_str(), 1);
+
+    // 组件注册表只跟踪 demo-tool（由旧版 registry.json 迁移）
+    mkdir(components.c_str(), 0755);
+    CHECK(FileUtils::writeFileAtomic(components + "/registry.json",
+                                     "{\n  \"components\": [\n    {\n      \"name\": \"demo-tool\",\n"
+                                     "      \"version\": \"\",\n      \"installed\": false\n    }\n  ]\n}\n"));
+    CHECK(FileUtils::writeFileAtomic(status, dpkgStatus(false, "1.0")));
+
+    auto& engine = CoreEngine::getInstance();
+    auto& pluginManager = engine.getPluginManager();
+    auto& componentManager = engine.getComponentManager();
+    CHECK(pluginManager.pluginsPath() == plugins);
+    CHECK(RegistryWatcher::catchUp().empty());
+
+    // 一次性追赶
+    mkdir((plugins + "/alpha").c_str(), 0755);
+    CHECK(FileUtils::writeFileAtomic(plugins + "/alpha/metadata.json", metadata("alpha", "1.0")));
+    CHECK(FileUtils::writeFileAtomic(status, dpkgStatus(true, "2.0")));
+    RegistryWatcher::Changes changes = RegistryWatcher::catchUp();
+    CHECK((changes.plugins == std::vector<std::string>{"alpha"}));
+    CHECK((changes.packages == std::vector<std::string>{"demo-tool"}));
+    CHECK(pluginManager.isInstalled("alpha") && pluginManager.getInfo("alpha").version == "1.0");
+    CHECK(componentManager.getInfo("demo-tool").installed && componentManager.getInfo("demo-tool").version == "2.0");
+    CHECK(RegistryWatcher::catchUp().empty());
+
+    // 长驻监视
+    std::atomic<bool> stop(false);
+    Collected collected;
+    bool ran = false;
+    std::thread watcher([&]() {
+        ran = RegistryWatcher::run(stop, [&collected](const RegistryWatcher::Changes& batch) {
+            collected.add(batch);
+        });
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!activeElsewhere() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    CHECK(activeElsewhere());
+
+    // 新增：在旁边写好再整体移入插件目录
+    const std::string staging = dir.file("beta");
+    mkdir(staging.c_str(), 0755);
+    CHECK(FileUtils::writeFileAtomic(staging + "/metadata.json", metadata("beta", "0.1")));
+    CHECK(rename(staging.c_str(), (plugins + "/beta").c_str()) == 0);
+    CHECK(collected.waitFor("beta", false));
+    CHECK(pluginManager.isInstalled("beta"));
+
+    // 修改
+    CHECK(FileUtils::writeFileAtomic(plugins + "/alpha/metadata.json", metadata("alpha", "1.1")));
+    CHECK(collected.waitFor("alpha", false));
+    CHECK(pluginManager.getInfo("alpha").version == "1.1");
+
+    // 删除
+    CHECK(FileUtils::removeTree(plugins + "/beta"));
+    CHECK(collected.waitFor("beta", false));
+    CHECK(!pluginManager.isInstalled("beta"));
+
+    // dpkg 改写状态文件
+    CHECK(FileUtils::writeFileAtomic(status, dpkgStatus(false, "2.0")));
+    CHECK(collected.waitFor("demo-tool", true));
+    CHECK(!componentManager.getInfo("demo-tool").installed);
+
+    stop = true;
+    watcher.join();
+    CHECK(ran);
+    CHECK(!activeElsewhere());
+    CHECK(RegistryWatcher::catchUp().empty());
+
+    FileUtils::removeTree(plugins);
+    FileUtils::removeTree(components);
+    FileUtils::removeTree(dir.file("python"));
+    FileUtils::removeTree(dir.file("trash"));
+    std::printf("registry_watcher_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+#include "linuxstudio/repo_index.hpp"
+#include "linuxstudio/file_utils.hpp"
+#include "http_server.hpp"
+#include "test_support.hpp"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief RepoIndex 增量更新测试
+ *
+ * 本机 HTTP 服务器发布 index.xri 与 index.xri.sums，客户端用 curl 取回：
+ * - 本地没有索引时整个下载；
+ * - 仓库小改动后只用 Range 请求取回变化的块，结果与新映像逐字节一致；已是最新时只取校验文件；
+ * - 本地副本过旧（差异超过一半）或已损坏时退回整个下载；
+ * - 区间内容被篡改时摘要校验失败，拒绝更新并保留原有副本；
+ *   区间响应被截断或服务器忽略 Range 时不拼接，退回整个下载。
+ */
+
+using LinuxStudio::FileUtils;
+using LinuxStudio::RepoIndex;
+using LinuxStudioTest::HttpServer;
+
+namespace {
+
+/**
+ * @brief 生成仓库文本源
+ * @param prefix 改变全部场景名与说明，模拟与旧副本差异很大的新版本
+ * @param changed 只改动这一个场景的简介（小改动）
+ */
+std::string source(unsigned version, const std::string& prefix, int changed = -1) {
+    std::string text = "xkl-repo-1\t" + std::to_string(version) + "\n";
+    for (int i = 0; i < 200; ++i) {
+        std::string name = prefix + "scene-" + std::to_string(i);
+        std::string highlights = "Highlights of " + name + ": toolchain, debugger and board support packages";
+        if (i == changed) {
+            highlights += " (updated in version " + std::to_string(version) + ")";
+        }
+        text += "S\t" + name + "\t场景 " + std::to_string(i) + "\tScene " + std::to_string(i) + "\t" + highlights +
+                "\tgcc cmake gdb " + prefix + "component-" + std::to_string(i) + "\n";
+    }
+    for (int i = 0; i < 50; ++i) {
+        text += "A\t" + prefix + "component-" + std::to_string(i) + "\tlib" + prefix + std::to_string(i) + "-dev\n";
+        text += "P\t" + prefix + "plugin-" + std::to_string(i) + "\tPlugin number " + std::to_string(i) +
+                "\tpython3-" + prefix + std::to_string(i) + "\tnumpy requests\n";
+    }
+    return text;
+}
+
+std::string compile(const std::string& text) {
+    std::string image;
+    std::string error;
+    CHECK(RepoIndex::compile(text, image, error));
+    return image;
+}
+
+/**
+ * @brief 仓库的当前内容与故障注入方式（服务器线程与测试线程共享）
+ */
+struct Repository {
+    enum class Fault { None, CorruptRanges, TruncateRanges };
+
+    std::mutex mutex;
+    std::string image;
+    std::string sums;
+    Fault fault = Fault::None;
+
+    void publish(const std::string& next) {
+        std::lock_guard<std::mutex> lock(mutex);
+        image = next;
+        sums = RepoIndex::sums(next);
+    }
+
+    void inject(Fault next) {
+        std::lock_guard<std::mutex> lock(mutex);
+        fault = next;
+    }
+
+    HttpServer::Response serve(const HttpServer::Request& request) {
+        std::lock_guard<std::mutex> lock(mutex);
+        HttpServer::Response response;
+        if (request.path == std::string("/") + RepoIndex::kSumsName) {
+            response.body = sums;
+        } else if (request.path == std::string("/") + RepoIndex::kIndexName) {
+            response.body = image;
+            if (!request.range.empty() && fault == Fault::CorruptRanges) {
+                for (std::size_t i = 0; i < response.body.size(); i += 97) {
+                    response.body[i] ^= 0x5A;
+                }
+            } else if (!request.range.empty() && fault == Fault::TruncateRanges) {
+                response.truncate = 16;
+            }
+        } else {
+            response.status = 404;
+        }
+        return response;
+    }
+};
+
+std::string readLocal(const std::string& path) {
+    std::string content;
+    FileUtils::readFile(path, content);
+    return content;
+}
+
+std::size_t rangeRequests(const HttpServer& server) {
+    std::size_t count = 0;
+    for (const auto& request : server.requests()) {
+        count += request.range.empty() ? 0 : 1;
+    }
+    return count;
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const std::string path = dir.file("index.xri");
+
+    Repository repo;
+    HttpServer server([&repo](const HttpServer::Request& request) { return repo.serve(request); });
+    CHECK(server.valid());
+    const std::string url = server.url("/");
+
+    // 整个下载：本地没有索引
+    const std::string v1 = compile(source(1, ""));
+    repo.publish(v1);
+    RepoIndex::UpdateReport report;
+    CHECK(RepoIndex::update(url, path, report));
+    CHECK(report.full && report.fromVersion == 0 && report.toVersion == 1);
+    CHECK(readLocal(path) == v1);
+    {
+        RepoIndex index;
+        CHECK(index.open(path) && index.version() == 1 && index.scenes().size() == 200);
+    }
+
+    // 增量：改动一个场景，只取回变化的块
+    const std::string v2 = compile(source(2, "", 42));
+    repo.publish(v2);
+    server.clearRequests();
+    CHECK(RepoIndex::update(url, path, report));
+    CHECK(!report.full && !report.upToDate);
+    CHECK(report.fromVersion == 1 && report.toVersion == 2);
+    CHECK(report.ranges > 0 && report.matchedBlocks > 0 && report.matchedBlocks < report.blocks);
+    CHECK(report.fetched < report.length / 2);
+    CHECK(rangeRequests(server) == report.ranges);
+    CHECK(readLocal(path) == v2);
+
+    // 已是最新：只取校验文件
+    server.clearRequests();
+    CHECK(RepoIndex::update(url, path, report));
+    CHECK(report.upToDate && server.requests().size() == 1);
+
+    // 旧副本过旧：差异超过一半，退回整个下载
+    const std::string v3 = compile(source(3, "renamed-"));
+    repo.publish(v3);
+    CHECK(RepoIndex::update(url, path, report));
+    CHECK(report.full && report.fromVersion == 2 && report.toVersion == 3);
+    CHECK(readLocal(path) == v3);
+
+    // 本地副本损坏：不作为增量基础
+    CHECK(FileUtils::writeFileAtomic(path, v2.substr(0, v2.size() / 2)));
+    CHECK(RepoIndex::update(url, path, report));
+    CHECK(report.full && report.fromVersion == 0);
+    CHECK(readLocal(path) == v3);
+
+    // 区间内容被篡改：拒绝更新，保留原副本
+    const std::string v4 = compile(source(4, "renamed-", 7));
+    repo.publish(v4);
+    repo.inject(Repository::Fault::CorruptRanges);
+    CHECK(!RepoIndex::update(url, path, report));
+    CHECK(report.error == "digest mismatch");
+    CHECK(readLocal(path) == v3);
+
+    // 区间响应被截断：不拼接，退回整个下载
+    repo.inject(Repository::Fault::TruncateRanges);
+    CHECK(RepoIndex::update(url, path, report));
+    CHECK(report.full);
+    CHECK(readLocal(path) == v4);
+
+    // 服务器忽略 Range：返回整个文件时长度对不上，退回整个下载
+    repo.inject(Repository::Fault::None);
+    repo.publish(compile(source(5, "renamed-", 9)));
+    server.setRanges(false);
+    CHECK(RepoIndex::update(url, path, report));
+    CHECK(report.full && report.toVersion == 5);
+    {
+        RepoIndex index;
+        CHECK(index.open(path) && index.version() == 5);
+    }
+
+    std::printf("repo_index_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
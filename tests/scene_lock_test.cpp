@@ -0,0 +1,120 @@
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/scene_lock.hpp"
+#include "test_support.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+/**
+ * @brief 场景锁文件的读写测试
+ *
+ * 锁文件目录由 XKL_LOCK_DIR 指到临时目录：
+ * - save 自动创建目录，load 往返后场景、软件包（各字段，未知摘要与路径）与 wheel 集合一致；
+ * - 读取时按层稳定排序，忽略空行与注释行；
+ * - 文件头、字段数或记录类型不符时 parse 失败；
+ * 不安全的名字与摘要由 bundle_test 覆盖。
+ */
+
+using LinuxStudio::FileUtils;
+using LinuxStudio::SceneLock;
+
+namespace {
+
+const char* const kDigestA = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+const char* const kDigestB = "fedcba9876543210fedcba9876543210fedcba9876543210fedcba9876543210";
+
+SceneLock::Package package(unsigned level, bool root, const std::string& name, const std::string& version,
+                           const std::string& sha256, const std::string& filename) {
+    SceneLock::Package p;
+    p.level = level;
+    p.root = root;
+    p.name = name;
+    p.version = version;
+    p.sha256 = sha256;
+    p.filename = filename;
+    return p;
+}
+
+bool samePackage(const SceneLock::Package& a, const SceneLock::Package& b) {
+    return a.level == b.level && a.root == b.root && a.name == b.name && a.version == b.version &&
+           a.sha256 == b.sha256 && a.filename == b.filename;
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const std::string locks = dir.file("locks");
+    setenv("XKL_LOCK_DIR", locks.c_str(), 1);
+    CHECK(SceneLock::directory() == locks);
+    CHECK(SceneLock::defaultPath("ml-dev") == locks + "/ml-dev.lock");
+
+    SceneLock lock;
+    lock.scene = "ml-dev";
+    lock.packages = {
+        package(0, false, "libc6", "2.36-9+deb12u4", kDigestA, "pool/main/g/glibc/libc6_2.36-9+deb12u4_amd64.deb"),
+        package(1, false, "libpython3.11", "3.11.2-6", "", ""),
+        package(2, true, "python3", "3.11.2-1+b1", kDigestB, "pool/main/p/python3-defaults/python3_3.11.2-1+b1_amd64.deb"),
+        package(0, false, "tzdata", "2024a-0+deb12u1", "", "pool/main/t/tzdata/tzdata_2024a-0+deb12u1_all.deb"),
+    };
+    lock.wheels["pytorch"] = {"torch-2.2.0-cp311-cp311-manylinux1_x86_64.whl#sha256=" + std::string(kDigestA),
+                              "numpy-1.26.4-cp311-cp311-manylinux_2_17_x86_64.whl#sha256=" + std::string(kDigestB)};
+    lock.wheels["tensorflow"] = {"tensorflow-2.15.0-cp311-cp311-manylinux_2_17_x86_64.whl#sha256=" +
+                                 std::string(kDigestB)};
+    CHECK(lock.levelCount() == 3);
+
+    // 往返：目录自动创建，软件包按层稳定排序
+    CHECK(lock.save(SceneLock::defaultPath("ml-dev")));
+    SceneLock loaded;
+    CHECK(loaded.load(SceneLock::defaultPath("ml-dev")));
+    CHECK(loaded.scene == "ml-dev");
+    CHECK(loaded.packages.size() == 4);
+    if (loaded.packages.size() == 4) {
+        CHECK(samePackage(loaded.packages[0], lock.packages[0]));
+        CHECK(samePackage(loaded.packages[1], lock.packages[3]));
+        CHECK(samePackage(loaded.packages[2], lock.packages[1]));
+        CHECK(samePackage(loaded.packages[3], lock.packages[2]));
+    }
+    CHECK(loaded.wheels == lock.wheels);
+    CHECK(loaded.levelCount() == 3);
+
+    // 读出后再保存、再读出，内容逐字节相同
+    CHECK(loaded.save(dir.file("again.lock")));
+    SceneLock resaved;
+    CHECK(resaved.load(dir.file("again.lock")) && resaved.save(dir.file("third.lock")));
+    std::string second;
+    std::string third;
+    CHECK(FileUtils::readFile(dir.file("again.lock"), second) && FileUtils::readFile(dir.file("third.lock"), third));
+    CHECK(!second.empty() && second == third);
+    CHECK(second.compare(0, second.find('\n'), "xkl-lock-1\tml-dev") == 0);
+
+    // 空行与注释
+    CHECK(loaded.parse("xkl-lock-1\tbase\n\n# comment line\nP\t0\t1\tvim\t2:9.0.1378-2\t-\t-\n"));
+    CHECK(loaded.scene == "base" && loaded.packages.size() == 1 && loaded.packages[0].root &&
+          loaded.packages[0].sha256.empty() && loaded.packages[0].filename.empty() && loaded.wheels.empty());
+    CHECK(loaded.levelCount() == 1);
+
+    // 格式不符
+    for (const std::string& content : {
+             std::string(""),
+             std::string("xkl-lock-2\tbase\n"),
+             std::string("xkl-lock-1\n"),
+             std::string("xkl-lock-1\tbase\textra\n"),
+             std::string("xkl-lock-1\tbase\nP\t0\t1\tvim\t1.0\t-\n"),
+             std::string("xkl-lock-1\tbase\nW\tpytorch\n"),
+             std::string("xkl-lock-1\tbase\nX\tsomething\n")}) {
+        CHECK(!loaded.parse(content));
+    }
+    CHECK(!loaded.load(dir.file("absent.lock")));
+
+    unlink(dir.file("again.lock").c_str());
+    unlink(dir.file("third.lock").c_str());
+    FileUtils::removeTree(locks);
+    std::printf("scene_lock_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
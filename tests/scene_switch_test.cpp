@@ -0,0 +1,152 @@
+#include "linuxstudio/file_utils.hpp"
+#include "linuxstudio/scenes.hpp"
+#include "test_support.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 场景切换差异测试（xkl scene switch）
+ *
+ * 场景记录与状态文件由 XKL_SCENES_DIR 指到临时目录：
+ * - 记录与状态的保存、合并与读取往返，activate 不重复加入；
+ * - 不带 --from 时新场景替换所有当前场景，带 --from 时只离开该场景，目标场景不会被“离开”；
+ * - 卸载候选只来自离开场景的记录与此前保留的包，仍被保留场景闭包需要的为 shared，其余为 orphans；
+ * - 卸载后从离开场景的记录中去掉已卸载的包，--keep-warm 或卸载失败时孤立且未卸载的包记为 warm，
+ *   没有卸载又不是 warm 的包作为“仍被需要”返回。
+ */
+
+using LinuxStudio::FileUtils;
+using LinuxStudio::SceneRecord;
+using LinuxStudio::SceneState;
+using LinuxStudio::SceneSwitch;
+
+namespace {
+
+using Names = std::set<std::string>;
+using List = std::vector<std::string>;
+
+SceneRecord record(const Names& packages, const Names& plugins = {}) {
+    SceneRecord r;
+    r.packages = packages;
+    r.plugins = plugins;
+    return r;
+}
+
+SceneState loadState() {
+    SceneState state;
+    state.load();
+    return state;
+}
+
+Names loadPackages(const std::string& scene) {
+    SceneRecord r;
+    r.load(scene);
+    return r.packages;
+}
+
+/**
+ * @brief 每个场景开始前的磁盘状态：ai-ml 与 robotics 已应用，共用 opencv
+ */
+void seed() {
+    SceneState state;
+    state.active = {"ai-ml", "robotics"};
+    state.warm = {"old-warm", "libprotobuf"};
+    state.save();
+    record({"python3", "jupyter", "libopencv-dev", "libgomp1"}, {"pytorch"}).save("ai-ml");
+    record({"ros-humble-desktop", "libopencv-dev"}).save("robotics");
+}
+
+} // namespace
+
+int main() {
+    LinuxStudioTest::TempDir dir;
+    CHECK(dir.valid());
+    const std::string scenes = dir.file("scenes");
+    setenv("XKL_SCENES_DIR", scenes.c_str(), 1);
+    CHECK(SceneRecord::directory() == scenes);
+    CHECK(SceneState::path() == scenes + "/state");
+
+    // 记录与状态
+    SceneState empty;
+    CHECK(!empty.load() && empty.active.empty() && empty.warm.empty());
+    CHECK(SceneState::activate("embedded") && SceneState::activate("embedded") && SceneState::activate("iot"));
+    CHECK((loadState().active == Names{"embedded", "iot"}));
+    SceneRecord loaded;
+    CHECK(!loaded.load("embedded"));
+    CHECK(record({"gdb"}).merge("embedded") && record({"openocd"}, {"platformio"}).merge("embedded"));
+    CHECK(loaded.load("embedded") && loaded.packages == (Names{"gdb", "openocd"}) &&
+          loaded.plugins == Names{"platformio"});
+    CHECK(record({"minicom"}).save("embedded") && loadPackages("embedded") == Names{"minicom"});
+
+    // 离开与保留的场景
+    seed();
+    {
+        SceneSwitch all(loadState(), "devops", "");
+        CHECK((all.leaving == Names{"ai-ml", "robotics"}) && all.staying == Names{"devops"});
+        SceneSwitch one(loadState(), "devops", "robotics");
+        CHECK(one.leaving == Names{"robotics"} && (one.staying == Names{"ai-ml", "devops"}));
+        SceneSwitch already(loadState(), "robotics", "");
+        CHECK(already.leaving == Names{"ai-ml"} && already.staying == Names{"robotics"});
+        SceneSwitch self(loadState(), "robotics", "robotics");
+        CHECK(self.leaving.empty() && (self.staying == Names{"ai-ml", "robotics"}));
+        SceneSwitch inactive(loadState(), "devops", "web-development");
+        CHECK(inactive.leaving == Names{"web-development"} && (inactive.staying == Names{"ai-ml", "devops", "robotics"}));
+    }
+
+    // 从 ai-ml 切到 robotics：opencv 与 protobuf 仍被 robotics 的闭包需要
+    const Names needed = {"ros-humble-desktop", "libopencv-dev", "libprotobuf", "libc6"};
+    {
+        SceneState state = loadState();
+        SceneSwitch change(state, "robotics", "");
+        change.classify(state, needed);
+        CHECK((change.shared == List{"libopencv-dev", "libprotobuf"}));
+        CHECK((change.orphans == List{"jupyter", "libgomp1", "old-warm", "python3"}));
+        CHECK(change.records.size() == 1 && change.records.count("ai-ml") == 1);
+
+        // 卸载了 python3 与 old-warm，jupyter、libgomp1 仍被场景之外的软件需要
+        List required = change.finish(state, {"python3", "old-warm"}, false, true);
+        CHECK((required == List{"jupyter", "libgomp1"}));
+        CHECK((loadPackages("ai-ml") == Names{"jupyter", "libopencv-dev", "libgomp1"}));
+        CHECK(loadPackages("robotics") == (Names{"ros-humble-desktop", "libopencv-dev"}));
+        SceneState after = loadState();
+        CHECK(after.active == Names{"robotics"} && after.warm.empty());
+        SceneRecord plugins;
+        CHECK(plugins.load("ai-ml") && plugins.plugins == Names{"pytorch"});
+    }
+
+    // --keep-warm：不卸载，孤立的包记为 warm，下次切换时仍是候选
+    seed();
+    {
+        SceneState state = loadState();
+        SceneSwitch change(state, "devops", "ai-ml");
+        change.classify(state, needed);
+        CHECK(change.finish(state, {}, true, true).empty());
+        SceneState after = loadState();
+        CHECK((after.active == Names{"devops", "robotics"}));
+        CHECK((after.warm == Names{"jupyter", "libgomp1", "old-warm", "python3"}));
+        CHECK(loadPackages("ai-ml").size() == 4);
+
+        SceneSwitch back(after, "ai-ml", "devops");
+        back.classify(after, {"python3", "jupyter", "libgomp1"});
+        CHECK((back.shared == List{"jupyter", "libgomp1", "python3"}) && back.orphans == List{"old-warm"});
+    }
+
+    // 卸载失败：已卸载的从记录与 warm 中去掉，其余孤立的包留作 warm，不报告为“仍被需要”
+    seed();
+    {
+        SceneState state = loadState();
+        SceneSwitch change(state, "robotics", "ai-ml");
+        change.classify(state, needed);
+        CHECK(change.finish(state, {"python3"}, false, false).empty());
+        CHECK(loadPackages("ai-ml").count("python3") == 0);
+        CHECK((loadState().warm == Names{"jupyter", "libgomp1", "old-warm"}));
+    }
+
+    FileUtils::removeTree(scenes);
+    std::printf("scene_switch_test: %d failures\n", LinuxStudioTest::failures());
+    return LinuxStudioTest::failures() == 0 ? 0 : 1;
+}
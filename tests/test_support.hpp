@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+
+/**
+ * @brief 测试公用工具：断言与临时目录
+ *
+ * 测试程序不依赖测试框架，失败时打印位置并计数，main 以失败数作为退出码。
+ */
+
+namespace LinuxStudioTest {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+#define CHECK(cond)                                                                    \
+    do {                                                                               \
+        if (!(cond)) {                                                                 \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++LinuxStudioTest::failures();                                             \
+        }                                                                              \
+    } while (0)
+
+/**
+ * @brief 临时目录（RAII），析构时连同其中的文件一起删除（不递归子目录）
+ */
+class TempDir {
+public:
+    TempDir() {
+        char pattern[] = "/tmp/xkl-test-XXXXXX";
+        if (mkdtemp(pattern)) {
+            path_ = pattern;
+        }
+    }
+
+    ~TempDir() {
+        if (path_.empty()) {
+            return;
+        }
+        if (DIR* dir = opendir(path_.c_str())) {
+            while (dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name != "." && name != "..") {
+                    unlink((path_ + "/" + name).c_str());
+                }
+            }
+            closedir(dir);
+        }
+        rmdir(path_.c_str());
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    bool valid() const { return !path_.empty(); }
+    const std::string& path() const { return path_; }
+    std::string file(const std::string& name) const { return path_ + "/" + name; }
+
+private:
+    std::string path_;
+};
+
+} // namespace LinuxStudioTest